@@ -0,0 +1,238 @@
+/*  This file is part of SAIL (https://github.com/smoked-herring/sail)
+
+    Copyright (c) 2020 Dmitry Baryshev
+
+    The MIT License
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef SAIL_WIN32
+    #include <windows.h>
+    #include <psapi.h>
+#else
+    #include <sys/resource.h>
+    #include <time.h>
+#endif
+
+#include "sail-common.h"
+
+#include "bench_utils.h"
+
+/* Counters of the allocator installed by bench_install_counting_allocator(). Benchmarks are single-threaded. */
+static uint64_t bench_allocations;
+static uint64_t bench_allocated_bytes;
+
+static void* counting_malloc(void *context, size_t size) {
+
+    (void)context;
+
+    bench_allocations++;
+    bench_allocated_bytes += size;
+
+    return malloc(size);
+}
+
+static void* counting_realloc(void *context, void *ptr, size_t size) {
+
+    (void)context;
+
+    bench_allocations++;
+    bench_allocated_bytes += size;
+
+    return realloc(ptr, size);
+}
+
+static void counting_free(void *context, void *ptr) {
+
+    (void)context;
+
+    free(ptr);
+}
+
+uint64_t bench_now_us(void) {
+
+#ifdef SAIL_WIN32
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+
+    return (uint64_t)(counter.QuadPart * 1000000 / frequency.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+#endif
+}
+
+sail_status_t bench_read_file(const char *path, void **data, size_t *data_length) {
+
+    SAIL_CHECK_PATH_PTR(path);
+    SAIL_CHECK_PTR(data);
+    SAIL_CHECK_PTR(data_length);
+
+    FILE *f = fopen(path, "rb");
+
+    if (f == NULL) {
+        fprintf(stderr, "Failed to open '%s'\n", path);
+        return SAIL_ERROR_OPEN_FILE;
+    }
+
+    fseek(f, 0, SEEK_END);
+    const long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    if (size <= 0) {
+        fclose(f);
+        return SAIL_ERROR_READ_IO;
+    }
+
+    void *ptr;
+    SAIL_TRY_OR_CLEANUP(sail_malloc((size_t)size, &ptr),
+                        /* cleanup */ fclose(f));
+
+    if (fread(ptr, 1, (size_t)size, f) != (size_t)size) {
+        sail_free(ptr);
+        fclose(f);
+        return SAIL_ERROR_READ_IO;
+    }
+
+    fclose(f);
+
+    *data        = ptr;
+    *data_length = (size_t)size;
+
+    return SAIL_OK;
+}
+
+sail_status_t bench_write_file(const char *path, const void *data, size_t data_length) {
+
+    SAIL_CHECK_PATH_PTR(path);
+    SAIL_CHECK_PTR(data);
+
+    FILE *f = fopen(path, "wb");
+
+    if (f == NULL) {
+        fprintf(stderr, "Failed to open '%s'\n", path);
+        return SAIL_ERROR_OPEN_FILE;
+    }
+
+    if (fwrite(data, 1, data_length, f) != data_length) {
+        fclose(f);
+        return SAIL_ERROR_WRITE_IO;
+    }
+
+    fclose(f);
+
+    return SAIL_OK;
+}
+
+sail_status_t bench_install_counting_allocator(void) {
+
+    const struct sail_allocator allocator = {
+        counting_malloc,
+        counting_realloc,
+        counting_free,
+        NULL
+    };
+
+    SAIL_TRY(sail_set_allocator(&allocator));
+
+    return SAIL_OK;
+}
+
+void bench_reset_allocation_counters(void) {
+
+    bench_allocations     = 0;
+    bench_allocated_bytes = 0;
+}
+
+void bench_allocation_counters(uint64_t *allocations, uint64_t *allocated_bytes) {
+
+    *allocations     = bench_allocations;
+    *allocated_bytes = bench_allocated_bytes;
+}
+
+void bench_reset_peak_rss(void) {
+
+#ifdef __linux__
+    /* "5" resets the peak RSS reported in VmHWM. Available since Linux 4.0. */
+    FILE *f = fopen("/proc/self/clear_refs", "w");
+
+    if (f != NULL) {
+        fputs("5", f);
+        fclose(f);
+    }
+#endif
+}
+
+uint64_t bench_peak_rss_kb(void) {
+
+#if defined SAIL_WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return 0;
+    }
+
+    return (uint64_t)counters.PeakWorkingSetSize / 1024;
+#elif defined __linux__
+    FILE *f = fopen("/proc/self/status", "r");
+
+    if (f == NULL) {
+        return 0;
+    }
+
+    char line[256];
+    uint64_t peak_rss_kb = 0;
+
+    while (fgets(line, sizeof(line), f) != NULL) {
+        if (strncmp(line, "VmHWM:", 6) == 0) {
+            peak_rss_kb = strtoull(line + 6, NULL, 10);
+            break;
+        }
+    }
+
+    fclose(f);
+
+    return peak_rss_kb;
+#else
+    struct rusage usage;
+
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+
+    /* Bytes on macOS, kilobytes elsewhere. */
+#ifdef __APPLE__
+    return (uint64_t)usage.ru_maxrss / 1024;
+#else
+    return (uint64_t)usage.ru_maxrss;
+#endif
+#endif
+}
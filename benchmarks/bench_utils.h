@@ -0,0 +1,88 @@
+/*  This file is part of SAIL (https://github.com/smoked-herring/sail)
+
+    Copyright (c) 2020 Dmitry Baryshev
+
+    The MIT License
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#ifndef SAIL_BENCH_UTILS_H
+#define SAIL_BENCH_UTILS_H
+
+#include <stddef.h> /* size_t */
+#include <stdint.h>
+
+#include "sail-common.h"
+
+/*
+ * Helpers shared by SAIL benchmarks.
+ */
+
+/*
+ * Returns the monotonic time in microseconds.
+ */
+uint64_t bench_now_us(void);
+
+/*
+ * Reads the whole specified file into a memory buffer. The assigned buffer MUST be destroyed later
+ * with sail_free().
+ *
+ * Returns SAIL_OK on success.
+ */
+sail_status_t bench_read_file(const char *path, void **data, size_t *data_length);
+
+/*
+ * Writes the specified memory buffer into the specified file.
+ *
+ * Returns SAIL_OK on success.
+ */
+sail_status_t bench_write_file(const char *path, const void *data, size_t data_length);
+
+/*
+ * Installs an allocator that counts SAIL allocations with sail_set_allocator(). Must be called
+ * before any other SAIL function. Allocations made by the underlying codec libraries are not counted.
+ *
+ * Returns SAIL_OK on success.
+ */
+sail_status_t bench_install_counting_allocator(void);
+
+/*
+ * Resets the allocation counters.
+ */
+void bench_reset_allocation_counters(void);
+
+/*
+ * Assigns the number of allocations and reallocations, and the total number of bytes requested
+ * since the last bench_reset_allocation_counters() call.
+ */
+void bench_allocation_counters(uint64_t *allocations, uint64_t *allocated_bytes);
+
+/*
+ * Resets the peak resident set size of the process where supported (Linux). On other platforms
+ * the peak is measured since the process start.
+ */
+void bench_reset_peak_rss(void);
+
+/*
+ * Returns the peak resident set size of the process in kilobytes, or 0 if it's unknown.
+ */
+uint64_t bench_peak_rss_kb(void);
+
+#endif
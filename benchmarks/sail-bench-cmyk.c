@@ -0,0 +1,264 @@
+/*  This file is part of SAIL (https://github.com/smoked-herring/sail)
+
+    Copyright (c) 2020 Dmitry Baryshev
+
+    The MIT License
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "config.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sail-common.h"
+#include "sail.h"
+
+#include "bench_utils.h"
+
+/*
+ * Measures the CMYK to RGB conversion used when decoding CMYK and YCCK JPEG files. Compares the fixed point
+ * kernel with a floating point per-pixel conversion, and decoding a CMYK JPEG with decoding a YCbCr JPEG
+ * of the same size. The JPEG files are generated in memory.
+ */
+
+static const unsigned DEFAULT_ITERATIONS = 10;
+static const unsigned DEFAULT_WIDTH      = 6000;
+static const unsigned DEFAULT_HEIGHT     = 4016;
+
+/* Inverted CMYK as written by Adobe applications. */
+static void convert_cmyk_row_float(const uint8_t *cmyk, unsigned width, uint8_t *rgba) {
+
+    for (unsigned x = 0; x < width; x++, cmyk += 4, rgba += 4) {
+        const double k = cmyk[3] / 255.0;
+
+        rgba[0] = (uint8_t)(255 * (cmyk[0] / 255.0) * k + 0.5);
+        rgba[1] = (uint8_t)(255 * (cmyk[1] / 255.0) * k + 0.5);
+        rgba[2] = (uint8_t)(255 * (cmyk[2] / 255.0) * k + 0.5);
+        rgba[3] = 255;
+    }
+}
+
+static sail_status_t alloc_cmyk_image(unsigned width, unsigned height, struct sail_image **image) {
+
+    struct sail_image *image_local;
+    SAIL_TRY(sail_alloc_image(&image_local));
+
+    image_local->width          = width;
+    image_local->height         = height;
+    image_local->pixel_format   = SAIL_PIXEL_FORMAT_BPP32_CMYK;
+    image_local->bytes_per_line = width * 4;
+
+    SAIL_TRY_OR_CLEANUP(sail_malloc_pixels((size_t)image_local->bytes_per_line * height, &image_local->pixels),
+                        /* cleanup */ sail_destroy_image(image_local));
+
+    /* Smooth gradients compress like photos rather than like noise. */
+    for (unsigned y = 0; y < height; y++) {
+        uint8_t *pixel = (uint8_t *)image_local->pixels + (size_t)y * image_local->bytes_per_line;
+
+        for (unsigned x = 0; x < width; x++, pixel += 4) {
+            pixel[0] = (uint8_t)(x * 255 / width);
+            pixel[1] = (uint8_t)(y * 255 / height);
+            pixel[2] = (uint8_t)((x + y) * 127 / (width + height) + 64);
+            pixel[3] = (uint8_t)(255 - (x ^ y) % 64);
+        }
+    }
+
+    *image = image_local;
+
+    return SAIL_OK;
+}
+
+static sail_status_t bench_kernels(const struct sail_image *image, unsigned iterations,
+                                   uint64_t *fixed_point_us, uint64_t *floating_point_us) {
+
+    void *ptr;
+    SAIL_TRY(sail_malloc((size_t)image->width * 4, &ptr));
+    uint8_t *rgba = ptr;
+
+    uint64_t start_time = bench_now_us();
+
+    for (unsigned i = 0; i < iterations; i++) {
+        for (unsigned y = 0; y < image->height; y++) {
+            SAIL_TRY_OR_CLEANUP(sail_convert_cmyk_row((const uint8_t *)image->pixels + (size_t)y * image->bytes_per_line,
+                                                      /* inverted */ true,
+                                                      image->width,
+                                                      SAIL_PIXEL_FORMAT_BPP32_RGBA,
+                                                      rgba),
+                                /* cleanup */ sail_free(rgba));
+        }
+    }
+
+    *fixed_point_us = bench_now_us() - start_time;
+
+    start_time = bench_now_us();
+
+    for (unsigned i = 0; i < iterations; i++) {
+        for (unsigned y = 0; y < image->height; y++) {
+            convert_cmyk_row_float((const uint8_t *)image->pixels + (size_t)y * image->bytes_per_line, image->width, rgba);
+        }
+    }
+
+    *floating_point_us = bench_now_us() - start_time;
+
+    sail_free(rgba);
+
+    return SAIL_OK;
+}
+
+static sail_status_t bench_decode(const void *data, size_t data_length, const struct sail_codec_info *codec_info,
+                                  enum SailPixelFormat pixel_format, unsigned iterations, uint64_t *total_us) {
+
+    struct sail_read_options *read_options;
+    SAIL_TRY(sail_alloc_read_options_from_features(codec_info->read_features, &read_options));
+
+    read_options->output_pixel_format = pixel_format;
+
+    const uint64_t start_time = bench_now_us();
+
+    for (unsigned i = 0; i < iterations; i++) {
+        void *state;
+        SAIL_TRY_OR_CLEANUP(sail_start_reading_mem_with_options(data, data_length, codec_info, read_options, &state),
+                            /* cleanup */ sail_destroy_read_options(read_options));
+
+        struct sail_image *image;
+        SAIL_TRY_OR_CLEANUP(sail_read_next_frame(state, &image),
+                            /* cleanup */ sail_stop_reading(state),
+                                          sail_destroy_read_options(read_options));
+
+        sail_destroy_image(image);
+        SAIL_TRY_OR_CLEANUP(sail_stop_reading(state),
+                            /* cleanup */ sail_destroy_read_options(read_options));
+    }
+
+    *total_us = bench_now_us() - start_time;
+
+    sail_destroy_read_options(read_options);
+
+    return SAIL_OK;
+}
+
+static sail_status_t bench(unsigned width, unsigned height, unsigned iterations) {
+
+    const struct sail_codec_info *codec_info;
+    SAIL_TRY(sail_codec_info_from_extension("jpg", &codec_info));
+
+    struct sail_image *cmyk_image;
+    SAIL_TRY(alloc_cmyk_image(width, height, &cmyk_image));
+
+    /* The same picture in RGB to compare with the regular YCbCr decoding. */
+    struct sail_image *rgb_image;
+    SAIL_TRY_OR_CLEANUP(sail_convert_image(cmyk_image, SAIL_PIXEL_FORMAT_BPP24_RGB, &rgb_image),
+                        /* cleanup */ sail_destroy_image(cmyk_image));
+
+    void *cmyk_data = NULL;
+    size_t cmyk_data_length;
+    void *ycbcr_data = NULL;
+    size_t ycbcr_data_length;
+
+    SAIL_TRY_OR_CLEANUP(sail_write_growable_mem(&cmyk_data, &cmyk_data_length, cmyk_image, codec_info),
+                        /* cleanup */ sail_free(cmyk_data),
+                                      sail_destroy_image(rgb_image),
+                                      sail_destroy_image(cmyk_image));
+    SAIL_TRY_OR_CLEANUP(sail_write_growable_mem(&ycbcr_data, &ycbcr_data_length, rgb_image, codec_info),
+                        /* cleanup */ sail_free(ycbcr_data),
+                                      sail_free(cmyk_data),
+                                      sail_destroy_image(rgb_image),
+                                      sail_destroy_image(cmyk_image));
+
+    uint64_t fixed_point_us;
+    uint64_t floating_point_us;
+    uint64_t ycbcr_rgba_us;
+    uint64_t cmyk_rgba_us;
+    uint64_t cmyk_rgb_us;
+
+    sail_status_t status = bench_kernels(cmyk_image, iterations, &fixed_point_us, &floating_point_us);
+
+    if (status == SAIL_OK) {
+        status = bench_decode(ycbcr_data, ycbcr_data_length, codec_info, SAIL_PIXEL_FORMAT_BPP32_RGBA, iterations, &ycbcr_rgba_us);
+    }
+    if (status == SAIL_OK) {
+        status = bench_decode(cmyk_data, cmyk_data_length, codec_info, SAIL_PIXEL_FORMAT_BPP32_RGBA, iterations, &cmyk_rgba_us);
+    }
+    if (status == SAIL_OK) {
+        status = bench_decode(cmyk_data, cmyk_data_length, codec_info, SAIL_PIXEL_FORMAT_BPP24_RGB, iterations, &cmyk_rgb_us);
+    }
+
+    sail_free(ycbcr_data);
+    sail_free(cmyk_data);
+    sail_destroy_image(rgb_image);
+    sail_destroy_image(cmyk_image);
+
+    SAIL_TRY(status);
+
+    const double megapixels = (double)width * height / 1e6 * iterations;
+
+    printf("%ux%u CMYK to BPP32-RGBA conversion: fixed point %.1f MP/s, floating point %.1f MP/s\n",
+            width, height,
+            megapixels / ((double)fixed_point_us / 1e6),
+            megapixels / ((double)floating_point_us / 1e6));
+    printf("%ux%u JPEG decoding: YCbCr to BPP32-RGBA %.2f ms, CMYK to BPP32-RGBA %.2f ms, CMYK to BPP24-RGB %.2f ms\n",
+            width, height,
+            (double)ycbcr_rgba_us / iterations / 1000,
+            (double)cmyk_rgba_us / iterations / 1000,
+            (double)cmyk_rgb_us / iterations / 1000);
+
+    return SAIL_OK;
+}
+
+int main(int argc, char *argv[]) {
+
+    unsigned iterations = DEFAULT_ITERATIONS;
+    unsigned width = DEFAULT_WIDTH;
+    unsigned height = DEFAULT_HEIGHT;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            iterations = (unsigned)atoi(argv[++i]);
+
+            if (iterations == 0) {
+                iterations = DEFAULT_ITERATIONS;
+            }
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%ux%u", &width, &height) != 2 || width == 0 || height == 0) {
+                fprintf(stderr, "Invalid size '%s'\n", argv[i]);
+                return 1;
+            }
+        } else {
+            fprintf(stderr, "Usage: %s [-n ITERATIONS] [-s WIDTHxHEIGHT]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    sail_set_log_barrier(SAIL_LOG_LEVEL_ERROR);
+
+    /* Preload codecs to exclude loading them from the measurements. */
+    SAIL_TRY(sail_init_with_flags(SAIL_FLAG_PRELOAD_CODECS));
+
+    SAIL_TRY_OR_CLEANUP(bench(width, height, iterations),
+                        /* cleanup */ sail_finish());
+
+    sail_finish();
+
+    return 0;
+}
@@ -0,0 +1,539 @@
+/*  This file is part of SAIL (https://github.com/smoked-herring/sail)
+
+    Copyright (c) 2020 Dmitry Baryshev
+
+    The MIT License
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#include "config.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sail-common.h"
+#include "sail.h"
+
+#include "bench_utils.h"
+
+/*
+ * Measures probing, decoding, and encoding with every codec that can write images. Synthetic images
+ * are generated at the BENCHMARKS.md sizes and encoded in memory to build the corpus, so no image files
+ * are needed. Decoding is measured for every output pixel format of the codec, encoding for every
+ * output pixel format of the source pixel format. Results are printed as JSON.
+ */
+
+/* Iterations are chosen to process about this number of pixels per measurement. */
+static const double PIXELS_PER_MEASUREMENT = 50e6;
+static const unsigned MAX_AUTO_ITERATIONS  = 100;
+static const unsigned PROBE_ITERATIONS     = 100;
+
+static const unsigned DEFAULT_SIZES[][2] = {
+    { 100,   67    },
+    { 1000,  669   },
+    { 6000,  4016  },
+    { 15000, 10040 },
+};
+
+/* Pixel formats of the synthetic source images. Codecs get the ones they can write. */
+static const enum SailPixelFormat SOURCE_PIXEL_FORMATS[] = {
+    SAIL_PIXEL_FORMAT_BPP8_GRAYSCALE,
+    SAIL_PIXEL_FORMAT_BPP24_RGB,
+    SAIL_PIXEL_FORMAT_BPP32_RGBA,
+};
+
+struct bench_config {
+    unsigned iterations; /* 0 means auto. */
+    unsigned sizes[32][2];
+    unsigned sizes_length;
+    const char *codecs[32];
+    unsigned codecs_length;
+    const char *corpus_dir;
+};
+
+struct bench_measurement {
+    unsigned iterations;
+    uint64_t total_us;
+    uint64_t peak_rss_kb;
+    uint64_t allocations;
+    uint64_t allocated_bytes;
+};
+
+struct bench_output {
+    FILE *f;
+    bool first_record;
+};
+
+/*
+ * The operation to measure. Called the specified number of times.
+ */
+typedef sail_status_t (*bench_operation_t)(void *context);
+
+struct encode_context {
+    const struct sail_codec_info *codec_info;
+    const struct sail_image *image;
+    const struct sail_write_options *write_options;
+    size_t encoded_length;
+};
+
+struct decode_context {
+    const struct sail_codec_info *codec_info;
+    const void *data;
+    size_t data_length;
+    const struct sail_read_options *read_options;
+};
+
+static sail_status_t encode_operation(void *context) {
+
+    struct encode_context *encode_context = context;
+
+    void *buffer = NULL;
+    void *state = NULL;
+
+    SAIL_TRY_OR_CLEANUP(sail_start_writing_growable_mem_with_options(&buffer,
+                                                                     &encode_context->encoded_length,
+                                                                     encode_context->codec_info,
+                                                                     encode_context->write_options,
+                                                                     &state),
+                        /* cleanup */ sail_free(buffer));
+    SAIL_TRY_OR_CLEANUP(sail_write_next_frame(state, encode_context->image),
+                        /* cleanup */ sail_stop_writing(state),
+                                      sail_free(buffer));
+    SAIL_TRY_OR_CLEANUP(sail_stop_writing(state),
+                        /* cleanup */ sail_free(buffer));
+
+    sail_free(buffer);
+
+    return SAIL_OK;
+}
+
+static sail_status_t probe_operation(void *context) {
+
+    struct decode_context *decode_context = context;
+
+    struct sail_image *image;
+    SAIL_TRY(sail_probe_mem(decode_context->data, decode_context->data_length, &image, NULL));
+    sail_destroy_image(image);
+
+    return SAIL_OK;
+}
+
+static sail_status_t decode_operation(void *context) {
+
+    struct decode_context *decode_context = context;
+
+    void *state;
+    SAIL_TRY(sail_start_reading_mem_with_options(decode_context->data,
+                                                 decode_context->data_length,
+                                                 decode_context->codec_info,
+                                                 decode_context->read_options,
+                                                 &state));
+
+    struct sail_image *image;
+    SAIL_TRY_OR_CLEANUP(sail_read_next_frame(state, &image),
+                        /* cleanup */ sail_stop_reading(state));
+
+    sail_destroy_image(image);
+
+    SAIL_TRY(sail_stop_reading(state));
+
+    return SAIL_OK;
+}
+
+static sail_status_t measure(bench_operation_t operation, void *context, unsigned iterations,
+                             struct bench_measurement *measurement) {
+
+    bench_reset_peak_rss();
+    bench_reset_allocation_counters();
+
+    const uint64_t start_time = bench_now_us();
+
+    for (unsigned i = 0; i < iterations; i++) {
+        SAIL_TRY(operation(context));
+    }
+
+    measurement->total_us    = bench_now_us() - start_time;
+    measurement->iterations  = iterations;
+    measurement->peak_rss_kb = bench_peak_rss_kb();
+
+    bench_allocation_counters(&measurement->allocations, &measurement->allocated_bytes);
+
+    return SAIL_OK;
+}
+
+static unsigned auto_iterations(unsigned width, unsigned height) {
+
+    const double iterations = PIXELS_PER_MEASUREMENT / ((double)width * height);
+
+    if (iterations < 1) {
+        return 1;
+    } else if (iterations > MAX_AUTO_ITERATIONS) {
+        return MAX_AUTO_ITERATIONS;
+    } else {
+        return (unsigned)iterations;
+    }
+}
+
+static const char* pixel_format_name(enum SailPixelFormat pixel_format) {
+
+    const char *result;
+
+    if (sail_pixel_format_to_string(pixel_format, &result) != SAIL_OK) {
+        return "UNKNOWN";
+    }
+
+    return result;
+}
+
+static void print_record(struct bench_output *output, const char *codec, const char *operation,
+                         const struct sail_image *image, enum SailPixelFormat pixel_format, size_t data_length,
+                         const struct bench_measurement *measurement) {
+
+    const double wall_time_us = (double)measurement->total_us / measurement->iterations;
+    const double pixels = (double)image->width * image->height;
+
+    fprintf(output->f, "%s\n    {\n", output->first_record ? "" : ",");
+    fprintf(output->f, "      \"codec\": \"%s\",\n", codec);
+    fprintf(output->f, "      \"operation\": \"%s\",\n", operation);
+    fprintf(output->f, "      \"width\": %u,\n", image->width);
+    fprintf(output->f, "      \"height\": %u,\n", image->height);
+    fprintf(output->f, "      \"source_pixel_format\": \"%s\",\n", pixel_format_name(image->pixel_format));
+    fprintf(output->f, "      \"pixel_format\": \"%s\",\n", pixel_format_name(pixel_format));
+    fprintf(output->f, "      \"data_size\": %lu,\n", (unsigned long)data_length);
+    fprintf(output->f, "      \"iterations\": %u,\n", measurement->iterations);
+    fprintf(output->f, "      \"wall_time_us\": %.2f,\n", wall_time_us);
+    fprintf(output->f, "      \"megapixels_per_second\": %.2f,\n", wall_time_us > 0 ? pixels / wall_time_us : 0.0);
+    fprintf(output->f, "      \"peak_rss_kb\": %lu,\n", (unsigned long)measurement->peak_rss_kb);
+    fprintf(output->f, "      \"allocations\": %.1f,\n", (double)measurement->allocations / measurement->iterations);
+    fprintf(output->f, "      \"allocated_bytes\": %.0f\n", (double)measurement->allocated_bytes / measurement->iterations);
+    fprintf(output->f, "    }");
+
+    fflush(output->f);
+
+    output->first_record = false;
+}
+
+/* Fills the image with gradients and some noise, so the data compresses like a photo rather than a flat fill. */
+static sail_status_t alloc_synthetic_image(unsigned width, unsigned height, enum SailPixelFormat pixel_format,
+                                           struct sail_image **image) {
+
+    unsigned bits_per_pixel;
+    SAIL_TRY(sail_bits_per_pixel(pixel_format, &bits_per_pixel));
+    const unsigned channels = bits_per_pixel / 8;
+
+    struct sail_image *image_local;
+    SAIL_TRY(sail_alloc_image(&image_local));
+
+    image_local->width        = width;
+    image_local->height       = height;
+    image_local->pixel_format = pixel_format;
+
+    SAIL_TRY_OR_CLEANUP(sail_bytes_per_line(width, pixel_format, &image_local->bytes_per_line),
+                        /* cleanup */ sail_destroy_image(image_local));
+
+    void *ptr;
+    SAIL_TRY_OR_CLEANUP(sail_malloc_pixels((size_t)image_local->bytes_per_line * height, &ptr),
+                        /* cleanup */ sail_destroy_image(image_local));
+    image_local->pixels = ptr;
+
+    uint32_t seed = 2463534242U;
+
+    for (unsigned row = 0; row < height; row++) {
+        unsigned char *scan = (unsigned char *)image_local->pixels + (size_t)image_local->bytes_per_line * row;
+
+        for (unsigned column = 0; column < width; column++) {
+            /* xorshift32 */
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+
+            const unsigned gradient = (column * 255 / width + row * 255 / height) / 2;
+
+            for (unsigned channel = 0; channel < channels; channel++) {
+                /* Opaque alpha. */
+                if (channels == 4 && channel == 3) {
+                    *scan++ = 255;
+                } else {
+                    const unsigned value = gradient + channel * 40 + ((seed >> (channel * 4)) & 15);
+                    *scan++ = (unsigned char)(value > 255 ? 510 - value : value);
+                }
+            }
+        }
+    }
+
+    *image = image_local;
+
+    return SAIL_OK;
+}
+
+static bool codec_selected(const struct bench_config *config, const struct sail_codec_info *codec_info) {
+
+    if (config->codecs_length == 0) {
+        return true;
+    }
+
+    for (unsigned i = 0; i < config->codecs_length; i++) {
+        if (strcmp(config->codecs[i], codec_info->name) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static const struct sail_pixel_formats_mapping_node* find_mapping(const struct sail_write_features *write_features,
+                                                                  enum SailPixelFormat pixel_format) {
+
+    for (const struct sail_pixel_formats_mapping_node *node = write_features->pixel_formats_mapping_node;
+            node != NULL;
+            node = node->next) {
+        if (node->input_pixel_format == pixel_format) {
+            return node;
+        }
+    }
+
+    return NULL;
+}
+
+static sail_status_t save_corpus(const struct bench_config *config, const struct sail_codec_info *codec_info,
+                                 const struct sail_image *image, const void *data, size_t data_length) {
+
+    if (config->corpus_dir == NULL) {
+        return SAIL_OK;
+    }
+
+    const char *extension = codec_info->extension_node != NULL ? codec_info->extension_node->value : "bin";
+
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/%s-%s-%ux%u.%s",
+                config->corpus_dir, codec_info->name, pixel_format_name(image->pixel_format),
+                image->width, image->height, extension);
+
+    SAIL_TRY(bench_write_file(path, data, data_length));
+
+    return SAIL_OK;
+}
+
+/* Benchmarks one codec with one synthetic image. */
+static sail_status_t bench_image(const struct bench_config *config, struct bench_output *output,
+                                 const struct sail_codec_info *codec_info,
+                                 const struct sail_pixel_formats_mapping_node *mapping,
+                                 const struct sail_image *image) {
+
+    const unsigned iterations = config->iterations > 0 ? config->iterations : auto_iterations(image->width, image->height);
+
+    struct sail_write_options *write_options;
+    SAIL_TRY(sail_alloc_write_options_from_features(codec_info->write_features, &write_options));
+
+    /* Build the corpus with the default write options. Also serves as a warm-up. */
+    void *data = NULL;
+    size_t data_length;
+    SAIL_TRY_OR_CLEANUP(sail_write_growable_mem(&data, &data_length, image, codec_info),
+                        /* cleanup */ sail_free(data),
+                                      sail_destroy_write_options(write_options));
+
+    SAIL_TRY_OR_CLEANUP(save_corpus(config, codec_info, image, data, data_length),
+                        /* cleanup */ sail_free(data),
+                                      sail_destroy_write_options(write_options));
+
+    struct bench_measurement measurement;
+
+    /* Encoding. */
+    for (unsigned i = 0; i < mapping->output_pixel_formats_length; i++) {
+        write_options->output_pixel_format = mapping->output_pixel_formats[i];
+
+        struct encode_context encode_context = { codec_info, image, write_options, 0 };
+
+        SAIL_TRY_OR_CLEANUP(measure(encode_operation, &encode_context, iterations, &measurement),
+                            /* cleanup */ sail_free(data),
+                                          sail_destroy_write_options(write_options));
+
+        print_record(output, codec_info->name, "encode", image, write_options->output_pixel_format,
+                        encode_context.encoded_length, &measurement);
+    }
+
+    sail_destroy_write_options(write_options);
+
+    struct sail_read_options *read_options;
+    SAIL_TRY_OR_CLEANUP(sail_alloc_read_options_from_features(codec_info->read_features, &read_options),
+                        /* cleanup */ sail_free(data));
+
+    struct decode_context decode_context = { codec_info, data, data_length, read_options };
+
+    /* Probing. */
+    SAIL_TRY_OR_CLEANUP(measure(probe_operation, &decode_context,
+                                config->iterations > 0 ? config->iterations : PROBE_ITERATIONS, &measurement),
+                        /* cleanup */ sail_destroy_read_options(read_options),
+                                      sail_free(data));
+
+    print_record(output, codec_info->name, "probe", image, image->pixel_format, data_length, &measurement);
+
+    /* Decoding. */
+    for (unsigned i = 0; i < codec_info->read_features->output_pixel_formats_length; i++) {
+        read_options->output_pixel_format = codec_info->read_features->output_pixel_formats[i];
+
+        SAIL_TRY_OR_CLEANUP(measure(decode_operation, &decode_context, iterations, &measurement),
+                            /* cleanup */ sail_destroy_read_options(read_options),
+                                          sail_free(data));
+
+        print_record(output, codec_info->name, "decode", image, read_options->output_pixel_format,
+                        data_length, &measurement);
+    }
+
+    sail_destroy_read_options(read_options);
+    sail_free(data);
+
+    return SAIL_OK;
+}
+
+static sail_status_t bench_codec(const struct bench_config *config, struct bench_output *output,
+                                 const struct sail_codec_info *codec_info) {
+
+    if (codec_info->write_features->pixel_formats_mapping_node == NULL) {
+        fprintf(stderr, "%s: the codec cannot write images, skipping\n", codec_info->name);
+        return SAIL_OK;
+    }
+
+    for (size_t f = 0; f < sizeof(SOURCE_PIXEL_FORMATS) / sizeof(SOURCE_PIXEL_FORMATS[0]); f++) {
+        const struct sail_pixel_formats_mapping_node *mapping = find_mapping(codec_info->write_features,
+                                                                             SOURCE_PIXEL_FORMATS[f]);
+
+        if (mapping == NULL) {
+            continue;
+        }
+
+        for (unsigned s = 0; s < config->sizes_length; s++) {
+            struct sail_image *image;
+            SAIL_TRY(alloc_synthetic_image(config->sizes[s][0], config->sizes[s][1], SOURCE_PIXEL_FORMATS[f], &image));
+
+            const sail_status_t status = bench_image(config, output, codec_info, mapping, image);
+
+            sail_destroy_image(image);
+
+            /* Report and go on with the other codecs. */
+            if (status != SAIL_OK) {
+                fprintf(stderr, "%s: failed to benchmark %s %ux%u, error %d\n",
+                        codec_info->name, pixel_format_name(SOURCE_PIXEL_FORMATS[f]),
+                        config->sizes[s][0], config->sizes[s][1], status);
+            }
+        }
+    }
+
+    return SAIL_OK;
+}
+
+static void print_usage(const char *program) {
+
+    fprintf(stderr, "Usage: %s [-n ITERATIONS] [-s WIDTHxHEIGHT]... [-c CODEC]... [-d CORPUS DIR] [-o OUTPUT.json]\n"
+                    "\n"
+                    "  -n  Number of iterations per measurement. Chosen automatically by default\n"
+                    "  -s  Image size to benchmark. Default: 100x67, 1000x669, 6000x4016, and 15000x10040\n"
+                    "  -c  Codec name to benchmark, e.g. JPEG. Default: all codecs that can write images\n"
+                    "  -d  Directory to save the synthetic corpus to\n"
+                    "  -o  File to write the JSON results to. Default: stdout\n",
+                    program);
+}
+
+int main(int argc, char *argv[]) {
+
+    struct bench_config config;
+    memset(&config, 0, sizeof(config));
+
+    const char *output_path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc) {
+            print_usage(argv[0]);
+            return 1;
+        }
+
+        const char *option = argv[i];
+        const char *value = argv[++i];
+
+        if (strcmp(option, "-n") == 0) {
+            config.iterations = (unsigned)atoi(value);
+        } else if (strcmp(option, "-s") == 0 && config.sizes_length < sizeof(config.sizes) / sizeof(config.sizes[0])) {
+            if (sscanf(value, "%ux%u", &config.sizes[config.sizes_length][0], &config.sizes[config.sizes_length][1]) != 2 ||
+                    config.sizes[config.sizes_length][0] == 0 || config.sizes[config.sizes_length][1] == 0) {
+                fprintf(stderr, "Invalid size '%s'\n", value);
+                return 1;
+            }
+
+            config.sizes_length++;
+        } else if (strcmp(option, "-c") == 0 && config.codecs_length < sizeof(config.codecs) / sizeof(config.codecs[0])) {
+            config.codecs[config.codecs_length++] = value;
+        } else if (strcmp(option, "-d") == 0) {
+            config.corpus_dir = value;
+        } else if (strcmp(option, "-o") == 0) {
+            output_path = value;
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (config.sizes_length == 0) {
+        for (size_t s = 0; s < sizeof(DEFAULT_SIZES) / sizeof(DEFAULT_SIZES[0]); s++) {
+            config.sizes[s][0] = DEFAULT_SIZES[s][0];
+            config.sizes[s][1] = DEFAULT_SIZES[s][1];
+        }
+
+        config.sizes_length = sizeof(DEFAULT_SIZES) / sizeof(DEFAULT_SIZES[0]);
+    }
+
+    /* Must be installed before any other SAIL call. */
+    SAIL_TRY(bench_install_counting_allocator());
+
+    sail_set_log_barrier(SAIL_LOG_LEVEL_ERROR);
+
+    /* Preload codecs to exclude loading them from the measurements. */
+    SAIL_TRY(sail_init_with_flags(SAIL_FLAG_PRELOAD_CODECS));
+
+    struct bench_output output = { stdout, true };
+
+    if (output_path != NULL) {
+        output.f = fopen(output_path, "w");
+
+        if (output.f == NULL) {
+            fprintf(stderr, "Failed to open '%s'\n", output_path);
+            sail_finish();
+            return 1;
+        }
+    }
+
+    fprintf(output.f, "{\n  \"sail_version\": \"%s\",\n  \"results\": [", SAIL_VERSION_STRING);
+
+    for (const struct sail_codec_info_node *node = sail_codec_info_list(); node != NULL; node = node->next) {
+        if (codec_selected(&config, node->codec_info)) {
+            bench_codec(&config, &output, node->codec_info);
+        }
+    }
+
+    fprintf(output.f, "\n  ]\n}\n");
+
+    if (output.f != stdout) {
+        fclose(output.f);
+    }
+
+    sail_finish();
+
+    return 0;
+}
@@ -0,0 +1,180 @@
+/*  This file is part of SAIL (https://github.com/smoked-herring/sail)
+
+    Copyright (c) 2020 Dmitry Baryshev
+
+    The MIT License
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "config.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef SAIL_WIN32
+    #include <windows.h>
+#else
+    #include <pthread.h>
+#endif
+
+#include "sail-common.h"
+#include "sail.h"
+
+#include "bench_utils.h"
+
+/*
+ * Measures the cost of initializing SAIL contexts. In the thread-local mode every thread enumerates
+ * and loads codecs on its own. In the shared mode the main thread initializes a single process-wide context,
+ * and worker threads just attach to it.
+ */
+
+static const unsigned DEFAULT_THREADS = 8;
+static const unsigned MAX_THREADS     = 256;
+
+struct thread_data {
+    int flags;
+    uint64_t first_call_us;
+    sail_status_t status;
+};
+
+static void run_thread(struct thread_data *data) {
+
+    const uint64_t start_time = bench_now_us();
+
+    /* The first SAIL call in a thread. Loads codecs in the thread-local mode, attaches in the shared mode. */
+    data->status = sail_init_with_flags(data->flags);
+
+    data->first_call_us = bench_now_us() - start_time;
+
+    sail_finish();
+}
+
+#ifdef SAIL_WIN32
+static DWORD WINAPI thread_func(LPVOID arg) {
+
+    run_thread(arg);
+    return 0;
+}
+#else
+static void* thread_func(void *arg) {
+
+    run_thread(arg);
+    return NULL;
+}
+#endif
+
+static sail_status_t bench(const char *name, int flags, unsigned threads_count) {
+
+    /* Cold start in the main thread. */
+    const uint64_t start_time = bench_now_us();
+    SAIL_TRY(sail_init_with_flags(flags));
+    const uint64_t cold_start_us = bench_now_us() - start_time;
+
+    struct thread_data data[MAX_THREADS];
+#ifdef SAIL_WIN32
+    HANDLE threads[MAX_THREADS];
+#else
+    pthread_t threads[MAX_THREADS];
+#endif
+
+    const uint64_t threads_start_time = bench_now_us();
+
+    for (unsigned i = 0; i < threads_count; i++) {
+        data[i].flags         = flags;
+        data[i].first_call_us = 0;
+        data[i].status        = SAIL_OK;
+
+#ifdef SAIL_WIN32
+        threads[i] = CreateThread(NULL, 0, thread_func, &data[i], 0, NULL);
+
+        if (threads[i] == NULL) {
+            threads_count = i;
+            break;
+        }
+#else
+        if (pthread_create(&threads[i], NULL, thread_func, &data[i]) != 0) {
+            threads_count = i;
+            break;
+        }
+#endif
+    }
+
+    for (unsigned i = 0; i < threads_count; i++) {
+#ifdef SAIL_WIN32
+        WaitForSingleObject(threads[i], INFINITE);
+        CloseHandle(threads[i]);
+#else
+        pthread_join(threads[i], NULL);
+#endif
+    }
+
+    const uint64_t threads_total_us = bench_now_us() - threads_start_time;
+
+    sail_finish();
+
+    uint64_t min_us = UINT64_MAX;
+    uint64_t max_us = 0;
+    uint64_t sum_us = 0;
+
+    for (unsigned i = 0; i < threads_count; i++) {
+        SAIL_TRY(data[i].status);
+
+        min_us = data[i].first_call_us < min_us ? data[i].first_call_us : min_us;
+        max_us = data[i].first_call_us > max_us ? data[i].first_call_us : max_us;
+        sum_us += data[i].first_call_us;
+    }
+
+    if (threads_count == 0) {
+        min_us = 0;
+    }
+
+    printf("%-13s: cold start %8lu us, first call per thread min/avg/max %8lu/%8lu/%8lu us, %u threads total %8lu us\n",
+            name,
+            (unsigned long)cold_start_us,
+            (unsigned long)min_us,
+            (unsigned long)(threads_count == 0 ? 0 : sum_us / threads_count),
+            (unsigned long)max_us,
+            threads_count,
+            (unsigned long)threads_total_us);
+
+    return SAIL_OK;
+}
+
+int main(int argc, char *argv[]) {
+
+    unsigned threads_count = DEFAULT_THREADS;
+
+    if (argc > 1) {
+        threads_count = (unsigned)atoi(argv[1]);
+
+        if (threads_count == 0 || threads_count > MAX_THREADS) {
+            fprintf(stderr, "Usage: %s [threads, 1-%u]\n", argv[0], MAX_THREADS);
+            return 1;
+        }
+    }
+
+    sail_set_log_barrier(SAIL_LOG_LEVEL_ERROR);
+
+    SAIL_TRY(bench("thread-local", SAIL_FLAG_PRELOAD_CODECS, threads_count));
+    SAIL_TRY(bench("shared", SAIL_FLAG_PRELOAD_CODECS | SAIL_FLAG_SHARED_CONTEXT, threads_count));
+
+    return 0;
+}
@@ -0,0 +1,134 @@
+/*  This file is part of SAIL (https://github.com/smoked-herring/sail)
+
+    Copyright (c) 2020 Dmitry Baryshev
+
+    The MIT License
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "config.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sail-common.h"
+#include "sail.h"
+
+#include "bench_utils.h"
+
+/*
+ * Compares probing images with the codec's header-only probe against the full decoder initialization
+ * that libsail used to probe images before. Files are read into memory first to exclude disk I/O.
+ */
+
+static const unsigned DEFAULT_ITERATIONS = 1000;
+
+static sail_status_t bench_probe(const void *data, size_t data_length, unsigned iterations, uint64_t *total_us) {
+
+    const uint64_t start_time = bench_now_us();
+
+    for (unsigned i = 0; i < iterations; i++) {
+        struct sail_image *image;
+        SAIL_TRY(sail_probe_mem(data, data_length, &image, NULL));
+        sail_destroy_image(image);
+    }
+
+    *total_us = bench_now_us() - start_time;
+
+    return SAIL_OK;
+}
+
+static sail_status_t bench_decoder_init(const void *data, size_t data_length, unsigned iterations, uint64_t *total_us) {
+
+    const uint64_t start_time = bench_now_us();
+
+    for (unsigned i = 0; i < iterations; i++) {
+        /* sail_probe_mem() detects the codec by magic number too. */
+        const struct sail_codec_info *codec_info;
+        SAIL_TRY(sail_codec_info_by_magic_number_from_mem(data, data_length, &codec_info));
+
+        void *state;
+        SAIL_TRY(sail_start_reading_mem(data, data_length, codec_info, &state));
+        SAIL_TRY(sail_stop_reading(state));
+    }
+
+    *total_us = bench_now_us() - start_time;
+
+    return SAIL_OK;
+}
+
+static sail_status_t bench(const char *path, unsigned iterations) {
+
+    void *data;
+    size_t data_length;
+    SAIL_TRY(bench_read_file(path, &data, &data_length));
+
+    uint64_t probe_us;
+    uint64_t decoder_init_us;
+
+    SAIL_TRY_OR_CLEANUP(bench_probe(data, data_length, iterations, &probe_us),
+                        /* cleanup */ sail_free(data));
+    SAIL_TRY_OR_CLEANUP(bench_decoder_init(data, data_length, iterations, &decoder_init_us),
+                        /* cleanup */ sail_free(data));
+
+    sail_free(data);
+
+    printf("%s: probe %.2f us, decoder init %.2f us per image\n",
+            path,
+            (double)probe_us / iterations,
+            (double)decoder_init_us / iterations);
+
+    return SAIL_OK;
+}
+
+int main(int argc, char *argv[]) {
+
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s [-n ITERATIONS] <PATH TO IMAGE> [<PATH TO IMAGE> ...]\n", argv[0]);
+        return 1;
+    }
+
+    unsigned iterations = DEFAULT_ITERATIONS;
+    int first_path = 1;
+
+    if (strcmp(argv[1], "-n") == 0 && argc > 3) {
+        iterations = (unsigned)atoi(argv[2]);
+        first_path = 3;
+
+        if (iterations == 0) {
+            iterations = DEFAULT_ITERATIONS;
+        }
+    }
+
+    sail_set_log_barrier(SAIL_LOG_LEVEL_ERROR);
+
+    /* Preload codecs to exclude loading them from the measurements. */
+    SAIL_TRY(sail_init_with_flags(SAIL_FLAG_PRELOAD_CODECS));
+
+    for (int i = first_path; i < argc; i++) {
+        SAIL_TRY(bench(argv[i], iterations));
+    }
+
+    sail_finish();
+
+    return 0;
+}
@@ -0,0 +1,26 @@
+# Intended to be included by every benchmark.
+#
+macro(sail_benchmark)
+    cmake_parse_arguments(SAIL_BENCHMARK "" "TARGET" "SOURCES" ${ARGN})
+
+    # Add a benchmark
+    #
+    add_executable(${SAIL_BENCHMARK_TARGET} ${SAIL_BENCHMARK_SOURCES} ${PROJECT_SOURCE_DIR}/benchmarks/bench_utils.c)
+
+    # clock_gettime
+    sail_enable_posix_source(TARGET ${SAIL_BENCHMARK_TARGET} VERSION 200112L)
+
+    # Depend on sail
+    #
+    target_link_libraries(${SAIL_BENCHMARK_TARGET} sail)
+
+    if (UNIX)
+        target_link_libraries(${SAIL_BENCHMARK_TARGET} pthread)
+    endif()
+
+    # Peak working set size
+    #
+    if (WIN32)
+        target_link_libraries(${SAIL_BENCHMARK_TARGET} psapi)
+    endif()
+endmacro()
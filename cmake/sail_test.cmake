@@ -1,19 +1,42 @@
 # Intended to be included by every test.
 #
+# CODECS lists the codecs the test reads or writes images with. The test is not added
+# when any of them is disabled. LIBRARIES lists extra libraries to link, like sail-c++.
+#
 macro(sail_test)
-    cmake_parse_arguments(SAIL_TEST "" "TARGET" "SOURCES" ${ARGN})
+    cmake_parse_arguments(SAIL_TEST "" "TARGET" "SOURCES;CODECS;LIBRARIES" ${ARGN})
+
+    set(SAIL_TEST_CODECS_ENABLED ON)
+
+    foreach(codec ${SAIL_TEST_CODECS})
+        list(FIND ENABLED_CODECS ${codec} SAIL_TEST_CODEC_INDEX)
+
+        if (SAIL_TEST_CODEC_INDEX EQUAL -1)
+            message(STATUS "Skipping the ${SAIL_TEST_TARGET} test as the ${codec} codec is disabled")
+            set(SAIL_TEST_CODECS_ENABLED OFF)
+        endif()
+    endforeach()
+
+    if (SAIL_TEST_CODECS_ENABLED)
+        # Add a test
+        #
+        add_executable(${SAIL_TEST_TARGET} ${SAIL_TEST_SOURCES})
 
-    # Add a test
-    #
-    add_executable(${SAIL_TEST_TARGET} ${SAIL_TEST_SOURCES})
+        add_test(NAME ${SAIL_TEST_TARGET} COMMAND ${SAIL_TEST_TARGET})
 
-    add_test(NAME ${SAIL_TEST_TARGET} COMMAND ${SAIL_TEST_TARGET})
+        # Load the codecs built in this tree
+        #
+        if (SAIL_TEST_CODECS AND TARGET sail-test-codecs)
+            add_dependencies(${SAIL_TEST_TARGET} sail-test-codecs)
+            set_tests_properties(${SAIL_TEST_TARGET} PROPERTIES ENVIRONMENT "SAIL_CODECS_PATH=${SAIL_TEST_CODECS_PATH}")
+        endif()
 
-    # Depend on sail
-    #
-    target_link_libraries(${SAIL_TEST_TARGET} sail)
+        # Depend on sail
+        #
+        target_link_libraries(${SAIL_TEST_TARGET} sail ${SAIL_TEST_LIBRARIES})
 
-    # Depend on sail-munit
-    #
-    target_link_libraries(${SAIL_TEST_TARGET} sail-munit)
+        # Depend on sail-munit
+        #
+        target_link_libraries(${SAIL_TEST_TARGET} sail-munit)
+    endif()
 endmacro()
@@ -29,15 +29,43 @@
 #include <stdio.h>
 #include <string.h>
 
+#ifdef SAIL_WIN32
+    #include <windows.h>
+#else
+    #include <time.h>
+#endif
+
 #include "sail-common.h"
 #include "sail.h"
 
+/* Probing is usually faster than a millisecond, so use a precise timer. */
+static uint64_t now_us(void) {
+
+#ifdef SAIL_WIN32
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+
+    return (uint64_t)(counter.QuadPart * 1000000 / frequency.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+#endif
+}
+
 static sail_status_t probe(const char *path) {
 
     SAIL_CHECK_PATH_PTR(path);
 
+    /* Load codecs before measuring. */
+    SAIL_TRY(sail_init_with_flags(SAIL_FLAG_PRELOAD_CODECS));
+
     /* Time counter. */
-    uint64_t start_time = sail_now();
+    uint64_t start_time = now_us();
 
     struct sail_image *image;
     const struct sail_codec_info *codec_info;
@@ -45,7 +73,7 @@ static sail_status_t probe(const char *path) {
     SAIL_TRY(sail_probe_file(path, &image, &codec_info));
 
     printf("File          : %s\n", path);
-    printf("Probe time    : %lu ms.\n", (unsigned long)(sail_now() - start_time));
+    printf("Probe time    : %lu us.\n", (unsigned long)(now_us() - start_time));
     printf("Codec         : %s [%s]\n", codec_info->name, codec_info->description);
     printf("Codec version : %s\n", codec_info->version);
     printf("Size          : %ux%u\n", image->width, image->height);
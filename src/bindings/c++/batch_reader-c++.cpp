@@ -0,0 +1,153 @@
+/*  This file is part of SAIL (https://github.com/smoked-herring/sail)
+
+    Copyright (c) 2020 Dmitry Baryshev
+
+    The MIT License
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "sail-common.h"
+#include "sail.h"
+#include "sail-c++.h"
+
+namespace sail
+{
+
+class SAIL_HIDDEN batch_reader::pimpl
+{
+public:
+    pimpl()
+        : batch_reader(nullptr)
+    {
+    }
+
+    static void callback(unsigned index, sail_status_t status, sail_image *sail_image, void *user_data)
+    {
+        const callback_t *scallback = reinterpret_cast<const callback_t *>(user_data);
+
+        image simage(sail_image);
+
+        if (sail_image != nullptr) {
+            sail_image->pixels = NULL;
+            sail_destroy_image(sail_image);
+        }
+
+        (*scallback)(index, status, std::move(simage));
+    }
+
+    sail_status_t read(const std::vector<sail_batch_item> &items,
+                       const sail_read_options *sail_read_options,
+                       const callback_t &scallback)
+    {
+        SAIL_CHECK_PTR(batch_reader);
+
+        if (items.empty()) {
+            return SAIL_OK;
+        }
+
+        SAIL_TRY(sail_read_batch(batch_reader,
+                                 items.data(),
+                                 static_cast<unsigned>(items.size()),
+                                 sail_read_options,
+                                 callback,
+                                 const_cast<callback_t *>(&scallback)));
+
+        return SAIL_OK;
+    }
+
+    static std::vector<sail_batch_item> items_from_paths(const std::vector<std::string> &paths)
+    {
+        std::vector<sail_batch_item> items(paths.size(), sail_batch_item{nullptr, nullptr, 0, nullptr});
+
+        for (std::size_t i = 0; i < paths.size(); i++) {
+            items[i].path = paths[i].c_str();
+        }
+
+        return items;
+    }
+
+    static std::vector<sail_batch_item> items_from_buffers(const std::vector<std::pair<const void *, size_t>> &buffers)
+    {
+        std::vector<sail_batch_item> items(buffers.size(), sail_batch_item{nullptr, nullptr, 0, nullptr});
+
+        for (std::size_t i = 0; i < buffers.size(); i++) {
+            items[i].buffer        = buffers[i].first;
+            items[i].buffer_length = buffers[i].second;
+        }
+
+        return items;
+    }
+
+    sail_batch_reader *batch_reader;
+};
+
+batch_reader::batch_reader(unsigned threads)
+    : d(new pimpl)
+{
+    SAIL_TRY_OR_EXECUTE(sail_alloc_batch_reader(threads, &d->batch_reader),
+                        /* on error */ d->batch_reader = nullptr);
+}
+
+batch_reader::~batch_reader()
+{
+    sail_destroy_batch_reader(d->batch_reader);
+    delete d;
+}
+
+bool batch_reader::is_valid() const
+{
+    return d->batch_reader != nullptr;
+}
+
+sail_status_t batch_reader::read(const std::vector<std::string> &paths, const callback_t &callback)
+{
+    SAIL_TRY(d->read(pimpl::items_from_paths(paths), nullptr, callback));
+
+    return SAIL_OK;
+}
+
+sail_status_t batch_reader::read(const std::vector<std::string> &paths, const read_options &sread_options, const callback_t &callback)
+{
+    sail_read_options sail_read_options;
+    SAIL_TRY(sread_options.to_sail_read_options(&sail_read_options));
+
+    SAIL_TRY(d->read(pimpl::items_from_paths(paths), &sail_read_options, callback));
+
+    return SAIL_OK;
+}
+
+sail_status_t batch_reader::read(const std::vector<std::pair<const void *, size_t>> &buffers, const callback_t &callback)
+{
+    SAIL_TRY(d->read(pimpl::items_from_buffers(buffers), nullptr, callback));
+
+    return SAIL_OK;
+}
+
+sail_status_t batch_reader::read(const std::vector<std::pair<const void *, size_t>> &buffers, const read_options &sread_options, const callback_t &callback)
+{
+    sail_read_options sail_read_options;
+    SAIL_TRY(sread_options.to_sail_read_options(&sail_read_options));
+
+    SAIL_TRY(d->read(pimpl::items_from_buffers(buffers), &sail_read_options, callback));
+
+    return SAIL_OK;
+}
+
+}
@@ -0,0 +1,96 @@
+/*  This file is part of SAIL (https://github.com/smoked-herring/sail)
+
+    Copyright (c) 2020 Dmitry Baryshev
+
+    The MIT License
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#ifndef SAIL_BATCH_READER_CPP_H
+#define SAIL_BATCH_READER_CPP_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef SAIL_BUILD
+    #include "error.h"
+    #include "export.h"
+#else
+    #include <sail-common/error.h>
+    #include <sail-common/export.h>
+#endif
+
+namespace sail
+{
+
+class image;
+class read_options;
+
+/*
+ * A C++ interface to the SAIL batch reading functions. See struct sail_batch_reader for more.
+ */
+class SAIL_EXPORT batch_reader
+{
+public:
+    /*
+     * Receives the result of reading the item with the specified index. On error, the image is invalid.
+     * The callback is called from the worker threads concurrently, so it MUST be thread-safe.
+     */
+    typedef std::function<void(unsigned index, sail_status_t status, image &&simage)> callback_t;
+
+    /*
+     * Starts the specified number of worker threads. 0 means the number of online processors.
+     * See sail_alloc_batch_reader() for more.
+     */
+    explicit batch_reader(unsigned threads = 0);
+    ~batch_reader();
+
+    /*
+     * Returns true if the worker threads have been started successfully.
+     */
+    bool is_valid() const;
+
+    /*
+     * An interface to sail_read_batch(). See sail_read_batch() for more.
+     */
+    sail_status_t read(const std::vector<std::string> &paths, const callback_t &callback);
+    sail_status_t read(const std::vector<std::string> &paths, const read_options &sread_options, const callback_t &callback);
+
+    /*
+     * An interface to sail_read_batch(). Reads images from the specified memory buffers.
+     * See sail_read_batch() for more.
+     */
+    sail_status_t read(const std::vector<std::pair<const void *, size_t>> &buffers, const callback_t &callback);
+    sail_status_t read(const std::vector<std::pair<const void *, size_t>> &buffers, const read_options &sread_options, const callback_t &callback);
+
+private:
+    batch_reader(const batch_reader&) = delete;
+    batch_reader& operator=(const batch_reader&) = delete;
+
+    class pimpl;
+    pimpl * const d;
+};
+
+}
+
+#endif
@@ -44,6 +44,9 @@
  *
  * If you call SAIL functions from three different threads, three different contexts are allocated.
  * You can destroy them with calling sail_finish() in each thread.
+ *
+ * Alternatively, call init(SAIL_FLAG_SHARED_CONTEXT) once before spawning worker threads to allocate
+ * a single process-wide context shared between threads. See SAIL_FLAG_SHARED_CONTEXT.
  */
 
 namespace sail
@@ -52,14 +52,14 @@ public:
     ~pimpl()
     {
         if (!shallow_pixels) {
-            sail_free(pixels);
+            sail_free_pixels(pixels);
         }
     }
 
     void reset_pixels()
     {
         if (!shallow_pixels) {
-            sail_free(pixels);
+            sail_free_pixels(pixels);
         }
 
         pixels         = nullptr;
@@ -288,7 +288,7 @@ image& image::with_pixels(const void *pixels, unsigned pixels_size)
         return *this;
     }
 
-    SAIL_TRY_OR_EXECUTE(sail_malloc(pixels_size, &d->pixels),
+    SAIL_TRY_OR_EXECUTE(sail_malloc_pixels(pixels_size, &d->pixels),
                         /* on error */ return *this);
 
     memcpy(d->pixels, pixels, pixels_size);
@@ -330,6 +330,37 @@ image& image::with_iccp(const sail::iccp &ic)
     return *this;
 }
 
+sail_status_t image::convert_to(SailPixelFormat pixel_format, image *simage) const
+{
+    SAIL_CHECK_IMAGE_PTR(simage);
+
+    sail_image *sail_image;
+    SAIL_TRY(sail_alloc_image(&sail_image));
+
+    SAIL_TRY_OR_CLEANUP(to_sail_image(sail_image),
+                        /* cleanup */ sail_image->pixels = NULL,
+                                      sail_destroy_image(sail_image));
+
+    struct sail_image *sail_image_converted;
+    SAIL_TRY_OR_CLEANUP(sail_convert_image(sail_image, pixel_format, &sail_image_converted),
+                        /* cleanup */ sail_image->pixels = NULL,
+                                      sail_destroy_image(sail_image));
+
+    sail_image->pixels = NULL;
+    sail_destroy_image(sail_image);
+
+    *simage = image(sail_image_converted);
+    sail_image_converted->pixels = NULL;
+    sail_destroy_image(sail_image_converted);
+
+    return SAIL_OK;
+}
+
+bool image::can_convert(SailPixelFormat input_pixel_format, SailPixelFormat output_pixel_format)
+{
+    return sail_can_convert(input_pixel_format, output_pixel_format);
+}
+
 sail_status_t image::bits_per_pixel(SailPixelFormat pixel_format, unsigned *result)
 {
     SAIL_TRY(sail_bits_per_pixel(pixel_format, result));
@@ -442,11 +473,7 @@ sail_status_t image::transfer_pixels_pointer(const sail_image *sail_image)
 {
     SAIL_CHECK_IMAGE_PTR(sail_image);
 
-    sail_free(d->pixels);
-
-    d->pixels         = nullptr;
-    d->pixels_size    = 0;
-    d->shallow_pixels = false;
+    d->reset_pixels();
 
     if (sail_image->pixels == nullptr) {
         return SAIL_OK;
@@ -61,6 +61,7 @@ namespace sail
  */
 class SAIL_EXPORT image
 {
+    friend class batch_reader;
     friend class image_reader;
     friend class image_writer;
 
@@ -288,6 +289,19 @@ public:
      */
     image& with_iccp(const sail::iccp &ic);
 
+    /*
+     * Converts the image to the specified pixel format and assigns the converted image.
+     * See sail_convert_image() for the list of supported pixel formats.
+     *
+     * Returns SAIL_OK on success.
+     */
+    sail_status_t convert_to(SailPixelFormat pixel_format, image *simage) const;
+
+    /*
+     * Returns true if the conversion from the input pixel format to the output pixel format is supported.
+     */
+    static bool can_convert(SailPixelFormat input_pixel_format, SailPixelFormat output_pixel_format);
+
     /*
      * Calculates the number of bits per pixel in the specified pixel format.
      * For example, for SAIL_PIXEL_FORMAT_RGB 24 is assigned.
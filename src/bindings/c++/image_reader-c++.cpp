@@ -38,7 +38,7 @@ class SAIL_HIDDEN image_reader::pimpl
 public:
     pimpl()
         : state(nullptr)
-        , sail_io{0, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr}
+        , sail_io{0, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr}
     {
     }
 
@@ -290,6 +290,31 @@ sail_status_t image_reader::start_reading(const io &sio, const codec_info &scode
     return SAIL_OK;
 }
 
+sail_status_t image_reader::reset_reading(const std::string &path)
+{
+    SAIL_TRY(reset_reading(path.c_str()));
+
+    return SAIL_OK;
+}
+
+sail_status_t image_reader::reset_reading(const char *path)
+{
+    SAIL_CHECK_PATH_PTR(path);
+
+    SAIL_TRY(sail_reset_reading_file(d->state, path));
+
+    return SAIL_OK;
+}
+
+sail_status_t image_reader::reset_reading(const void *buffer, size_t buffer_length)
+{
+    SAIL_CHECK_BUFFER_PTR(buffer);
+
+    SAIL_TRY(sail_reset_reading_mem(d->state, buffer, buffer_length));
+
+    return SAIL_OK;
+}
+
 sail_status_t image_reader::read_next_frame(image *simage)
 {
     SAIL_CHECK_IMAGE_PTR(simage);
@@ -308,6 +333,43 @@ sail_status_t image_reader::read_next_frame(image *simage)
     return SAIL_OK;
 }
 
+sail_status_t image_reader::read_next_frame(image *simage, void *pixels, unsigned pixels_size, unsigned bytes_per_line)
+{
+    SAIL_CHECK_IMAGE_PTR(simage);
+
+    sail_image *sail_image;
+    SAIL_TRY(sail_read_next_frame_into_buffer(d->state, pixels, pixels_size, bytes_per_line, &sail_image));
+
+    const unsigned bytes_per_image = sail_image->bytes_per_line * sail_image->height;
+
+    *simage = image(sail_image);
+    sail_destroy_image(sail_image);
+
+    simage->with_shallow_pixels(pixels, bytes_per_image);
+
+    return SAIL_OK;
+}
+
+sail_status_t image_reader::start_reading_rows(image *simage)
+{
+    SAIL_CHECK_IMAGE_PTR(simage);
+
+    sail_image *sail_image;
+    SAIL_TRY(sail_start_reading_rows(d->state, &sail_image));
+
+    *simage = image(sail_image);
+    sail_destroy_image(sail_image);
+
+    return SAIL_OK;
+}
+
+sail_status_t image_reader::read_next_rows(void *rows, unsigned row_count, unsigned *read_rows)
+{
+    SAIL_TRY(sail_read_next_rows(d->state, rows, row_count, read_rows));
+
+    return SAIL_OK;
+}
+
 sail_status_t image_reader::stop_reading()
 {
     SAIL_TRY(sail_stop_reading(d->state));
@@ -117,11 +117,38 @@ public:
     sail_status_t start_reading(const io &sio, const codec_info &scodec_info);
     sail_status_t start_reading(const io &sio, const codec_info &scodec_info, const read_options &sread_options);
 
+    /*
+     * An interface to sail_reset_reading_file(). See sail_reset_reading_file() for more.
+     */
+    sail_status_t reset_reading(const std::string &path);
+    sail_status_t reset_reading(const char *path);
+
+    /*
+     * An interface to sail_reset_reading_mem(). See sail_reset_reading_mem() for more.
+     */
+    sail_status_t reset_reading(const void *buffer, size_t buffer_length);
+
     /*
      * An interface to sail_read_next_frame(). See sail_read_next_frame() for more.
      */
     sail_status_t read_next_frame(image *simage);
 
+    /*
+     * An interface to sail_read_next_frame_into_buffer(). See sail_read_next_frame_into_buffer() for more.
+     * The assigned image holds shallow pixels pointing to the specified buffer.
+     */
+    sail_status_t read_next_frame(image *simage, void *pixels, unsigned pixels_size, unsigned bytes_per_line);
+
+    /*
+     * An interface to sail_start_reading_rows(). See sail_start_reading_rows() for more.
+     */
+    sail_status_t start_reading_rows(image *simage);
+
+    /*
+     * An interface to sail_read_next_rows(). See sail_read_next_rows() for more.
+     */
+    sail_status_t read_next_rows(void *rows, unsigned row_count, unsigned *read_rows);
+
     /*
      * An interface to sail_stop_reading(). See sail_stop_reading() for more.
      */
@@ -23,6 +23,8 @@
     SOFTWARE.
 */
 
+#include <cstdint>
+#include <cstdio>
 #include <cstdlib>
 #include <cstring>
 
@@ -33,12 +35,168 @@
 namespace sail
 {
 
+namespace
+{
+
+/*
+ * I/O stream writing into a vector in place. Writing past the end grows the vector.
+ */
+struct vector_stream
+{
+    std::vector<uint8_t> *buffer;
+    size_t pos;
+};
+
+sail_status_t vector_tolerant_read(void *stream, void *buf, size_t size_to_read, size_t *read_size)
+{
+    SAIL_CHECK_STREAM_PTR(stream);
+    SAIL_CHECK_BUFFER_PTR(buf);
+    SAIL_CHECK_RESULT_PTR(read_size);
+
+    vector_stream *vstream = reinterpret_cast<vector_stream *>(stream);
+
+    *read_size = 0;
+
+    if (vstream->pos >= vstream->buffer->size()) {
+        return SAIL_OK;
+    }
+
+    const size_t available = vstream->buffer->size() - vstream->pos;
+    *read_size = size_to_read < available ? size_to_read : available;
+
+    memcpy(buf, vstream->buffer->data() + vstream->pos, *read_size);
+    vstream->pos += *read_size;
+
+    return SAIL_OK;
+}
+
+sail_status_t vector_strict_read(void *stream, void *buf, size_t size_to_read)
+{
+    size_t read_size;
+    SAIL_TRY(vector_tolerant_read(stream, buf, size_to_read, &read_size));
+
+    if (read_size != size_to_read) {
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_READ_IO);
+    }
+
+    return SAIL_OK;
+}
+
+sail_status_t vector_seek(void *stream, long offset, int whence)
+{
+    SAIL_CHECK_STREAM_PTR(stream);
+
+    vector_stream *vstream = reinterpret_cast<vector_stream *>(stream);
+
+    size_t base;
+
+    switch (whence) {
+        case SEEK_SET: base = 0;                       break;
+        case SEEK_CUR: base = vstream->pos;            break;
+        case SEEK_END: base = vstream->buffer->size(); break;
+
+        default: {
+            SAIL_LOG_AND_RETURN(SAIL_ERROR_UNSUPPORTED_SEEK_WHENCE);
+        }
+    }
+
+    /* Don't seek before the beginning. -(offset + 1) avoids overflowing on LONG_MIN. */
+    if (offset < 0 && static_cast<size_t>(-(offset + 1)) >= base) {
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_WRITE_IO);
+    }
+
+    vstream->pos = base + offset;
+
+    return SAIL_OK;
+}
+
+sail_status_t vector_tell(void *stream, size_t *offset)
+{
+    SAIL_CHECK_STREAM_PTR(stream);
+    SAIL_CHECK_RESULT_PTR(offset);
+
+    *offset = reinterpret_cast<vector_stream *>(stream)->pos;
+
+    return SAIL_OK;
+}
+
+sail_status_t vector_tolerant_write(void *stream, const void *buf, size_t size_to_write, size_t *written_size)
+{
+    SAIL_CHECK_STREAM_PTR(stream);
+    SAIL_CHECK_BUFFER_PTR(buf);
+    SAIL_CHECK_RESULT_PTR(written_size);
+
+    vector_stream *vstream = reinterpret_cast<vector_stream *>(stream);
+
+    *written_size = 0;
+
+    if (size_to_write > SIZE_MAX - vstream->pos) {
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_WRITE_IO);
+    }
+
+    /* Codecs are C code, so never let exceptions through. The gap left by seeking past the end is zeroed. */
+    if (vstream->pos + size_to_write > vstream->buffer->size()) {
+        try {
+            vstream->buffer->resize(vstream->pos + size_to_write);
+        } catch (...) {
+            SAIL_LOG_AND_RETURN(SAIL_ERROR_MEMORY_ALLOCATION);
+        }
+    }
+
+    memcpy(vstream->buffer->data() + vstream->pos, buf, size_to_write);
+    vstream->pos += size_to_write;
+
+    *written_size = size_to_write;
+
+    return SAIL_OK;
+}
+
+sail_status_t vector_strict_write(void *stream, const void *buf, size_t size_to_write)
+{
+    size_t written_size;
+    SAIL_TRY(vector_tolerant_write(stream, buf, size_to_write, &written_size));
+
+    if (written_size != size_to_write) {
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_WRITE_IO);
+    }
+
+    return SAIL_OK;
+}
+
+sail_status_t vector_flush(void *stream)
+{
+    SAIL_CHECK_STREAM_PTR(stream);
+
+    return SAIL_OK;
+}
+
+sail_status_t vector_close(void *stream)
+{
+    SAIL_CHECK_STREAM_PTR(stream);
+
+    return SAIL_OK;
+}
+
+sail_status_t vector_eof(void *stream, bool *result)
+{
+    SAIL_CHECK_STREAM_PTR(stream);
+    SAIL_CHECK_RESULT_PTR(result);
+
+    vector_stream *vstream = reinterpret_cast<vector_stream *>(stream);
+
+    *result = vstream->pos >= vstream->buffer->size();
+
+    return SAIL_OK;
+}
+
+}
+
 class SAIL_HIDDEN image_writer::pimpl
 {
 public:
     pimpl()
         : state(nullptr)
-        , sail_io{0, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr}
+        , sail_io{0, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr}
     {
     }
 
@@ -117,6 +275,48 @@ sail_status_t image_writer::write(void *buffer, size_t buffer_length, const imag
     return SAIL_OK;
 }
 
+sail_status_t image_writer::write(const image &simage, const codec_info &scodec_info, std::vector<uint8_t> *buffer)
+{
+    SAIL_CHECK_BUFFER_PTR(buffer);
+
+    sail_image *sail_image;
+    SAIL_TRY(sail_alloc_image(&sail_image));
+
+    SAIL_TRY_OR_CLEANUP(simage.to_sail_image(sail_image),
+                        /* cleanup */ sail_image->pixels = NULL,
+                                      sail_destroy_image(sail_image));
+
+    buffer->clear();
+
+    vector_stream vstream{buffer, 0};
+
+    struct sail_io sail_io{0, &vstream,
+                            vector_tolerant_read, vector_strict_read,
+                            vector_seek, vector_tell,
+                            vector_tolerant_write, vector_strict_write,
+                            vector_flush, vector_close, vector_eof,
+                            nullptr};
+
+    void *state = nullptr;
+
+    SAIL_TRY_OR_CLEANUP(sail_start_writing_io(&sail_io, scodec_info.sail_codec_info_c(), &state),
+                        /* cleanup */ sail_stop_writing(state),
+                                      sail_image->pixels = NULL,
+                                      sail_destroy_image(sail_image));
+
+    SAIL_TRY_OR_CLEANUP(sail_write_next_frame(state, sail_image),
+                        /* cleanup */ sail_stop_writing(state),
+                                      sail_image->pixels = NULL,
+                                      sail_destroy_image(sail_image));
+
+    sail_image->pixels = NULL;
+    sail_destroy_image(sail_image);
+
+    SAIL_TRY(sail_stop_writing(state));
+
+    return SAIL_OK;
+}
+
 sail_status_t image_writer::start_writing(const std::string &path)
 {
     SAIL_TRY(start_writing(path.c_str()));
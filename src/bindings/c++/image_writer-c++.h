@@ -27,7 +27,9 @@
 #define SAIL_IMAGE_WRITER_CPP_H
 
 #include <cstddef>
+#include <cstdint>
 #include <string>
+#include <vector>
 
 #ifdef SAIL_BUILD
     #include "error.h"
@@ -66,6 +68,13 @@ public:
     sail_status_t write(void *buffer, size_t buffer_length, const image &simage);
     sail_status_t write(void *buffer, size_t buffer_length, const image &simage, size_t *written);
 
+    /*
+     * Writes the image into the specified vector with the specified codec. Replaces the contents
+     * of the vector with the encoded image. The vector grows as the image is encoded, so no copy
+     * of the encoded image is made. See sail_write_growable_mem() for more.
+     */
+    sail_status_t write(const image &simage, const codec_info &scodec_info, std::vector<uint8_t> *buffer);
+
     /*
      * An interface to sail_start_writing(). See sail_start_writing() for more.
      */
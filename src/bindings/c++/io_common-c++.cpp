@@ -59,6 +59,7 @@ void io::pimpl::empty_sail_io()
     sail_io.flush          = nullptr;
     sail_io.close          = nullptr;
     sail_io.eof            = nullptr;
+    sail_io.buffer         = nullptr;
 }
 
 io::io()
@@ -175,6 +176,12 @@ io& io::with_eof(sail_io_eof_t eof)
     return *this;
 }
 
+io& io::with_buffer(sail_io_buffer_t buffer)
+{
+    d->sail_io.buffer = buffer;
+    return *this;
+}
+
 sail_status_t io::is_valid_private() const
 {
     sail_io *sail_io = &d->sail_io;
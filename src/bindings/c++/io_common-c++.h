@@ -69,6 +69,7 @@ public:
     io& with_flush(sail_io_flush_t flush);
     io& with_close(sail_io_close_t close);
     io& with_eof(sail_io_eof_t eof);
+    io& with_buffer(sail_io_buffer_t buffer);
 
 private:
     sail_status_t is_valid_private() const;
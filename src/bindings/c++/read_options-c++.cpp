@@ -36,10 +36,24 @@ public:
     pimpl()
         : output_pixel_format(SAIL_PIXEL_FORMAT_UNKNOWN)
         , io_options(0)
+        , target_width(0)
+        , target_height(0)
+        , threads(0)
+        , crop_x(0)
+        , crop_y(0)
+        , crop_width(0)
+        , crop_height(0)
     {}
 
     SailPixelFormat output_pixel_format;
     int io_options;
+    unsigned target_width;
+    unsigned target_height;
+    unsigned threads;
+    unsigned crop_x;
+    unsigned crop_y;
+    unsigned crop_width;
+    unsigned crop_height;
 };
 
 read_options::read_options()
@@ -56,7 +70,10 @@ read_options::read_options(const sail_read_options *ro)
     }
 
     with_output_pixel_format(ro->output_pixel_format)
-        .with_io_options(ro->io_options);
+        .with_io_options(ro->io_options)
+        .with_target_size(ro->target_width, ro->target_height)
+        .with_threads(ro->threads)
+        .with_crop(ro->crop_x, ro->crop_y, ro->crop_width, ro->crop_height);
 }
 
 read_options::read_options(const read_options &ro)
@@ -68,7 +85,10 @@ read_options::read_options(const read_options &ro)
 read_options& read_options::operator=(const read_options &ro)
 {
     with_output_pixel_format(ro.output_pixel_format())
-        .with_io_options(ro.io_options());
+        .with_io_options(ro.io_options())
+        .with_target_size(ro.target_width(), ro.target_height())
+        .with_threads(ro.threads())
+        .with_crop(ro.crop_x(), ro.crop_y(), ro.crop_width(), ro.crop_height());
 
     return *this;
 }
@@ -103,6 +123,41 @@ int read_options::io_options() const
     return d->io_options;
 }
 
+unsigned read_options::target_width() const
+{
+    return d->target_width;
+}
+
+unsigned read_options::target_height() const
+{
+    return d->target_height;
+}
+
+unsigned read_options::threads() const
+{
+    return d->threads;
+}
+
+unsigned read_options::crop_x() const
+{
+    return d->crop_x;
+}
+
+unsigned read_options::crop_y() const
+{
+    return d->crop_y;
+}
+
+unsigned read_options::crop_width() const
+{
+    return d->crop_width;
+}
+
+unsigned read_options::crop_height() const
+{
+    return d->crop_height;
+}
+
 read_options& read_options::with_output_pixel_format(SailPixelFormat output_pixel_format)
 {
     d->output_pixel_format = output_pixel_format;
@@ -115,12 +170,41 @@ read_options& read_options::with_io_options(int io_options)
     return *this;
 }
 
+read_options& read_options::with_target_size(unsigned target_width, unsigned target_height)
+{
+    d->target_width  = target_width;
+    d->target_height = target_height;
+    return *this;
+}
+
+read_options& read_options::with_threads(unsigned threads)
+{
+    d->threads = threads;
+    return *this;
+}
+
+read_options& read_options::with_crop(unsigned crop_x, unsigned crop_y, unsigned crop_width, unsigned crop_height)
+{
+    d->crop_x      = crop_x;
+    d->crop_y      = crop_y;
+    d->crop_width  = crop_width;
+    d->crop_height = crop_height;
+    return *this;
+}
+
 sail_status_t read_options::to_sail_read_options(sail_read_options *read_options) const
 {
     SAIL_CHECK_READ_OPTIONS_PTR(read_options);
 
     read_options->output_pixel_format = d->output_pixel_format;
     read_options->io_options          = d->io_options;
+    read_options->target_width        = d->target_width;
+    read_options->target_height       = d->target_height;
+    read_options->threads             = d->threads;
+    read_options->crop_x              = d->crop_x;
+    read_options->crop_y              = d->crop_y;
+    read_options->crop_width          = d->crop_width;
+    read_options->crop_height         = d->crop_height;
 
     return SAIL_OK;
 }
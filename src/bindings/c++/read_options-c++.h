@@ -46,6 +46,7 @@ namespace sail
  */
 class SAIL_EXPORT read_options
 {
+    friend class batch_reader;
     friend class image_reader;
     friend class read_features;
 
@@ -59,9 +60,19 @@ public:
 
     SailPixelFormat output_pixel_format() const;
     int io_options() const;
+    unsigned target_width() const;
+    unsigned target_height() const;
+    unsigned threads() const;
+    unsigned crop_x() const;
+    unsigned crop_y() const;
+    unsigned crop_width() const;
+    unsigned crop_height() const;
 
     read_options& with_output_pixel_format(SailPixelFormat output_pixel_format);
     read_options& with_io_options(int io_options);
+    read_options& with_target_size(unsigned target_width, unsigned target_height);
+    read_options& with_threads(unsigned threads);
+    read_options& with_crop(unsigned crop_x, unsigned crop_y, unsigned crop_width, unsigned crop_height);
 
 private:
     /*
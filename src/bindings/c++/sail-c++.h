@@ -32,6 +32,7 @@
     #include "sail-common.h"
 
     #include "at_scope_exit-c++.h"
+    #include "batch_reader-c++.h"
     #include "context-c++.h"
     #include "iccp-c++.h"
     #include "image-c++.h"
@@ -53,6 +54,7 @@
     #include <sail-common/sail-common.h>
 
     #include <sail-c++/at_scope_exit-c++.h>
+    #include <sail-c++/batch_reader-c++.h>
     #include <sail-c++/context-c++.h>
     #include <sail-c++/iccp-c++.h>
     #include <sail-c++/image-c++.h>
@@ -38,12 +38,22 @@ public:
         , io_options(0)
         , compression(SAIL_COMPRESSION_UNSUPPORTED)
         , compression_level(0)
+        , dithering(SAIL_DITHERING_NONE)
+        , threads(0)
+        , tile_width(0)
+        , tile_height(0)
+        , filter(SAIL_FILTER_DEFAULT)
     {}
 
     SailPixelFormat output_pixel_format;
     int io_options;
     SailCompression compression;
     double compression_level;
+    SailDithering dithering;
+    unsigned threads;
+    unsigned tile_width;
+    unsigned tile_height;
+    SailFilter filter;
 };
 
 write_options::write_options()
@@ -62,7 +72,11 @@ write_options::write_options(const sail_write_options *wo)
     with_output_pixel_format(wo->output_pixel_format)
         .with_io_options(wo->io_options)
         .with_compression(wo->compression)
-        .with_compression_level(wo->compression_level);
+        .with_compression_level(wo->compression_level)
+        .with_dithering(wo->dithering)
+        .with_threads(wo->threads)
+        .with_tile_size(wo->tile_width, wo->tile_height)
+        .with_filter(wo->filter);
 }
 
 write_options::write_options(const write_options &wo)
@@ -76,7 +90,11 @@ write_options& write_options::operator=(const write_options &wo)
     with_output_pixel_format(wo.output_pixel_format())
         .with_io_options(wo.io_options())
         .with_compression(wo.compression())
-        .with_compression_level(wo.compression_level());
+        .with_compression_level(wo.compression_level())
+        .with_dithering(wo.dithering())
+        .with_threads(wo.threads())
+        .with_tile_size(wo.tile_width(), wo.tile_height())
+        .with_filter(wo.filter());
 
     return *this;
 }
@@ -121,6 +139,31 @@ double write_options::compression_level() const
     return d->compression_level;
 }
 
+SailDithering write_options::dithering() const
+{
+    return d->dithering;
+}
+
+unsigned write_options::threads() const
+{
+    return d->threads;
+}
+
+unsigned write_options::tile_width() const
+{
+    return d->tile_width;
+}
+
+unsigned write_options::tile_height() const
+{
+    return d->tile_height;
+}
+
+SailFilter write_options::filter() const
+{
+    return d->filter;
+}
+
 write_options& write_options::with_output_pixel_format(SailPixelFormat output_pixel_format)
 {
     d->output_pixel_format = output_pixel_format;
@@ -145,6 +188,31 @@ write_options& write_options::with_compression_level(double compression_level)
     return *this;
 }
 
+write_options& write_options::with_dithering(SailDithering dithering)
+{
+    d->dithering = dithering;
+    return *this;
+}
+
+write_options& write_options::with_threads(unsigned threads)
+{
+    d->threads = threads;
+    return *this;
+}
+
+write_options& write_options::with_tile_size(unsigned tile_width, unsigned tile_height)
+{
+    d->tile_width  = tile_width;
+    d->tile_height = tile_height;
+    return *this;
+}
+
+write_options& write_options::with_filter(SailFilter filter)
+{
+    d->filter = filter;
+    return *this;
+}
+
 sail_status_t write_options::to_sail_write_options(sail_write_options *write_options) const
 {
     SAIL_CHECK_WRITE_OPTIONS_PTR(write_options);
@@ -153,6 +221,11 @@ sail_status_t write_options::to_sail_write_options(sail_write_options *write_opt
     write_options->io_options          = d->io_options;
     write_options->compression         = d->compression;
     write_options->compression_level   = d->compression_level;
+    write_options->dithering           = d->dithering;
+    write_options->threads             = d->threads;
+    write_options->tile_width          = d->tile_width;
+    write_options->tile_height         = d->tile_height;
+    write_options->filter              = d->filter;
 
     return SAIL_OK;
 }
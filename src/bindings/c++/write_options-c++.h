@@ -61,11 +61,20 @@ public:
     int io_options() const;
     SailCompression compression() const;
     double compression_level() const;
+    SailDithering dithering() const;
+    unsigned threads() const;
+    unsigned tile_width() const;
+    unsigned tile_height() const;
+    SailFilter filter() const;
 
     write_options& with_output_pixel_format(SailPixelFormat output_pixel_format);
     write_options& with_io_options(int io_options);
     write_options& with_compression(SailCompression compression);
     write_options& with_compression_level(double compression_level);
+    write_options& with_dithering(SailDithering dithering);
+    write_options& with_threads(unsigned threads);
+    write_options& with_tile_size(unsigned tile_width, unsigned tile_height);
+    write_options& with_filter(SailFilter filter);
 
 private:
     /*
@@ -38,7 +38,11 @@
  * Common data structures and functions used across SAIL, both in libsail and in image codecs.
  */
 
-/* Pixel format */
+/*
+ * Pixel format. Formats with 16-bit channels, like BPP16-GRAYSCALE, BPP32-GRAYSCALE-ALPHA, BPP48-RGB,
+ * or BPP64-RGBA, store every channel as a 16-bit integer in the host byte order, regardless of the byte
+ * order of the image file.
+ */
 enum SailPixelFormat {
 
     /*
@@ -92,12 +96,12 @@ enum SailPixelFormat {
     SAIL_PIXEL_FORMAT_BPP2_GRAYSCALE,
     SAIL_PIXEL_FORMAT_BPP4_GRAYSCALE,
     SAIL_PIXEL_FORMAT_BPP8_GRAYSCALE,
-    SAIL_PIXEL_FORMAT_BPP16_GRAYSCALE,
+    SAIL_PIXEL_FORMAT_BPP16_GRAYSCALE,       /* 16-bit channel in the host byte order. */
 
     SAIL_PIXEL_FORMAT_BPP4_GRAYSCALE_ALPHA,
     SAIL_PIXEL_FORMAT_BPP8_GRAYSCALE_ALPHA,
     SAIL_PIXEL_FORMAT_BPP16_GRAYSCALE_ALPHA,
-    SAIL_PIXEL_FORMAT_BPP32_GRAYSCALE_ALPHA,
+    SAIL_PIXEL_FORMAT_BPP32_GRAYSCALE_ALPHA, /* 16-bit channels in the host byte order. */
 
     /*
      * Packed formats.
@@ -113,6 +117,7 @@ enum SailPixelFormat {
     SAIL_PIXEL_FORMAT_BPP24_RGB,
     SAIL_PIXEL_FORMAT_BPP24_BGR,
 
+    /* 16-bit channels in the host byte order. */
     SAIL_PIXEL_FORMAT_BPP48_RGB,
     SAIL_PIXEL_FORMAT_BPP48_BGR,
 
@@ -128,6 +133,7 @@ enum SailPixelFormat {
     SAIL_PIXEL_FORMAT_BPP32_ARGB,
     SAIL_PIXEL_FORMAT_BPP32_ABGR,
 
+    /* 16-bit channels in the host byte order. */
     SAIL_PIXEL_FORMAT_BPP64_RGBX,
     SAIL_PIXEL_FORMAT_BPP64_BGRX,
     SAIL_PIXEL_FORMAT_BPP64_XRGB,
@@ -141,7 +147,7 @@ enum SailPixelFormat {
      * CMYK formats.
      */
     SAIL_PIXEL_FORMAT_BPP32_CMYK,
-    SAIL_PIXEL_FORMAT_BPP64_CMYK,
+    SAIL_PIXEL_FORMAT_BPP64_CMYK,   /* 16-bit channels in the host byte order. */
 
     /*
      * YCbCr formats.
@@ -157,7 +163,7 @@ enum SailPixelFormat {
      * LAB formats.
      */
     SAIL_PIXEL_FORMAT_BPP24_CIE_LAB,
-    SAIL_PIXEL_FORMAT_BPP48_CIE_LAB,
+    SAIL_PIXEL_FORMAT_BPP48_CIE_LAB, /* 16-bit channels in the host byte order. */
 };
 
 /* Image properties. */
@@ -305,6 +311,56 @@ enum SailCodecFeature {
 
     /* Ability to read or write embedded ICC profiles. */
     SAIL_CODEC_FEATURE_ICCP        = 1 << 6,
+
+    /* Ability to read downscaled images. See sail_read_options.target_width. */
+    SAIL_CODEC_FEATURE_SCALING     = 1 << 7,
+
+    /* Ability to decode or encode images in multiple threads. See sail_read_options.threads and sail_write_options.threads. */
+    SAIL_CODEC_FEATURE_MULTI_THREADED = 1 << 8,
+
+    /* Ability to decode a region of interest only. See sail_read_options.crop_x. */
+    SAIL_CODEC_FEATURE_CROP        = 1 << 9,
+
+    /* Ability to write tiled images. See sail_write_options.tile_width. */
+    SAIL_CODEC_FEATURE_TILED       = 1 << 10,
+};
+
+/* Dithering methods used to reduce colors when writing to palette-based formats. */
+enum SailDithering {
+
+    /* Map every pixel to the nearest palette color. */
+    SAIL_DITHERING_NONE,
+
+    /* Ordered dithering with a Bayer matrix. Stable between animation frames. */
+    SAIL_DITHERING_ORDERED,
+
+    /* Floyd-Steinberg error diffusion. */
+    SAIL_DITHERING_FLOYD_STEINBERG,
+};
+
+/* Filters applied to rows before compression to make them more compressible. */
+enum SailFilter {
+
+    /* Codec-specific default. */
+    SAIL_FILTER_DEFAULT,
+
+    /* No filtering. */
+    SAIL_FILTER_NONE,
+
+    /* Difference with the previous pixel in the row. TIFF calls it the horizontal predictor. */
+    SAIL_FILTER_SUB,
+
+    /* Difference with the pixel above. */
+    SAIL_FILTER_UP,
+
+    /* Difference with the average of the pixels to the left and above. */
+    SAIL_FILTER_AVERAGE,
+
+    /* Difference with the Paeth predictor of the pixels to the left, above, and above-left. */
+    SAIL_FILTER_PAETH,
+
+    /* The best filter chosen per row. Slower, but usually compresses better. */
+    SAIL_FILTER_ADAPTIVE,
 };
 
 /* Read or write options. */
@@ -321,6 +377,13 @@ enum SailIoOption {
 
     /* Instruction to read or write embedded ICC profile. */
     SAIL_IO_OPTION_ICCP       = 1 << 3,
+
+    /*
+     * Instruction to read files through memory mapping regardless of their size. Files larger than
+     * an internal threshold are memory-mapped automatically. Specifying this option for writing operations
+     * or for reading from memory buffers has no effect.
+     */
+    SAIL_IO_OPTION_MMAP       = 1 << 4,
 };
 
 #endif
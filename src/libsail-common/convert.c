@@ -0,0 +1,577 @@
+/*  This file is part of SAIL (https://github.com/smoked-herring/sail)
+
+    Copyright (c) 2020 Dmitry Baryshev
+
+    The MIT License
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "sail-common.h"
+
+#include "convert_private.h"
+
+/*
+ * Private functions.
+ */
+
+struct pixel_layout {
+
+    enum SailPixelFormat pixel_format;
+    unsigned channels;
+    unsigned bytes_per_channel;
+
+    /* Channel indexes. Grayscale layouts have the same red, green, and blue indexes. -1 if there is no alpha. */
+    int red;
+    int green;
+    int blue;
+    int alpha;
+};
+
+static const struct pixel_layout LAYOUTS[] = {
+
+    { SAIL_PIXEL_FORMAT_BPP8_GRAYSCALE,        1, 1, 0, 0, 0, -1 },
+    { SAIL_PIXEL_FORMAT_BPP16_GRAYSCALE,       1, 2, 0, 0, 0, -1 },
+    { SAIL_PIXEL_FORMAT_BPP16_GRAYSCALE_ALPHA, 2, 1, 0, 0, 0,  1 },
+    { SAIL_PIXEL_FORMAT_BPP32_GRAYSCALE_ALPHA, 2, 2, 0, 0, 0,  1 },
+
+    { SAIL_PIXEL_FORMAT_BPP24_RGB,             3, 1, 0, 1, 2, -1 },
+    { SAIL_PIXEL_FORMAT_BPP24_BGR,             3, 1, 2, 1, 0, -1 },
+    { SAIL_PIXEL_FORMAT_BPP48_RGB,             3, 2, 0, 1, 2, -1 },
+    { SAIL_PIXEL_FORMAT_BPP48_BGR,             3, 2, 2, 1, 0, -1 },
+
+    { SAIL_PIXEL_FORMAT_BPP32_RGBX,            4, 1, 0, 1, 2, -1 },
+    { SAIL_PIXEL_FORMAT_BPP32_BGRX,            4, 1, 2, 1, 0, -1 },
+    { SAIL_PIXEL_FORMAT_BPP32_XRGB,            4, 1, 1, 2, 3, -1 },
+    { SAIL_PIXEL_FORMAT_BPP32_XBGR,            4, 1, 3, 2, 1, -1 },
+    { SAIL_PIXEL_FORMAT_BPP32_RGBA,            4, 1, 0, 1, 2,  3 },
+    { SAIL_PIXEL_FORMAT_BPP32_BGRA,            4, 1, 2, 1, 0,  3 },
+    { SAIL_PIXEL_FORMAT_BPP32_ARGB,            4, 1, 1, 2, 3,  0 },
+    { SAIL_PIXEL_FORMAT_BPP32_ABGR,            4, 1, 3, 2, 1,  0 },
+
+    { SAIL_PIXEL_FORMAT_BPP64_RGBX,            4, 2, 0, 1, 2, -1 },
+    { SAIL_PIXEL_FORMAT_BPP64_BGRX,            4, 2, 2, 1, 0, -1 },
+    { SAIL_PIXEL_FORMAT_BPP64_XRGB,            4, 2, 1, 2, 3, -1 },
+    { SAIL_PIXEL_FORMAT_BPP64_XBGR,            4, 2, 3, 2, 1, -1 },
+    { SAIL_PIXEL_FORMAT_BPP64_RGBA,            4, 2, 0, 1, 2,  3 },
+    { SAIL_PIXEL_FORMAT_BPP64_BGRA,            4, 2, 2, 1, 0,  3 },
+    { SAIL_PIXEL_FORMAT_BPP64_ARGB,            4, 2, 1, 2, 3,  0 },
+    { SAIL_PIXEL_FORMAT_BPP64_ABGR,            4, 2, 3, 2, 1,  0 },
+};
+
+/* Indexed and CMYK images are expanded into BPP32-RGBA rows first. */
+static const struct pixel_layout EXPANDED_LAYOUT = { SAIL_PIXEL_FORMAT_BPP32_RGBA, 4, 1, 0, 1, 2, 3 };
+
+/* Number of pixels converted from CMYK at once by sail_convert_cmyk_row(). */
+#define CMYK_CHUNK_PIXELS 256
+
+enum conversion_mode {
+
+    /* Rows are copied as is. */
+    CONVERSION_COPY,
+
+    /* 8-bit channels are reordered with a byte map. */
+    CONVERSION_SHUFFLE8,
+
+    /* Channels are converted one by one. Handles grayscale and 8 to 16 bit conversions. */
+    CONVERSION_GENERIC,
+};
+
+struct conversion {
+
+    const struct pixel_layout *input;
+    const struct pixel_layout *output;
+    enum conversion_mode mode;
+
+    /* 16-bit input is reduced to 8 bits before shuffling. */
+    bool narrow;
+    uint8_t map[4];
+
+    /* Bits per index if the input image is indexed, 0 otherwise. */
+    unsigned index_bits;
+    uint8_t palette[256][4];
+
+    /* The input image is BPP32-CMYK. */
+    bool cmyk;
+
+    /* Temporary rows for indexed or CMYK expansion and 16 to 8 bit reduction. */
+    uint8_t *expanded_row;
+    uint8_t *narrowed_row;
+
+    struct convert_kernels kernels;
+};
+
+static const struct pixel_layout *find_layout(enum SailPixelFormat pixel_format) {
+
+    for (size_t i = 0; i < sizeof(LAYOUTS) / sizeof(LAYOUTS[0]); i++) {
+        if (LAYOUTS[i].pixel_format == pixel_format) {
+            return &LAYOUTS[i];
+        }
+    }
+
+    return NULL;
+}
+
+static unsigned index_bits(enum SailPixelFormat pixel_format) {
+
+    switch (pixel_format) {
+        case SAIL_PIXEL_FORMAT_BPP1_INDEXED: return 1;
+        case SAIL_PIXEL_FORMAT_BPP2_INDEXED: return 2;
+        case SAIL_PIXEL_FORMAT_BPP4_INDEXED: return 4;
+        case SAIL_PIXEL_FORMAT_BPP8_INDEXED: return 8;
+
+        default: return 0;
+    }
+}
+
+static inline bool is_grayscale(const struct pixel_layout *layout) {
+
+    return layout->red == layout->green && layout->green == layout->blue;
+}
+
+static sail_status_t load_palette(const struct sail_palette *palette, uint8_t output[256][4]) {
+
+    SAIL_CHECK_PALETTE_PTR(palette);
+    SAIL_CHECK_DATA_PTR(palette->data);
+
+    unsigned bpp;
+    int red, green, blue, alpha;
+
+    switch (palette->pixel_format) {
+        case SAIL_PIXEL_FORMAT_BPP24_RGB:  bpp = 3; red = 0; green = 1; blue = 2; alpha = -1; break;
+        case SAIL_PIXEL_FORMAT_BPP24_BGR:  bpp = 3; red = 2; green = 1; blue = 0; alpha = -1; break;
+        case SAIL_PIXEL_FORMAT_BPP32_RGBA: bpp = 4; red = 0; green = 1; blue = 2; alpha =  3; break;
+        case SAIL_PIXEL_FORMAT_BPP32_BGRA: bpp = 4; red = 2; green = 1; blue = 0; alpha =  3; break;
+
+        default: {
+            const char *pixel_format_str = NULL;
+            SAIL_TRY_OR_SUPPRESS(sail_pixel_format_to_string(palette->pixel_format, &pixel_format_str));
+            SAIL_LOG_ERROR("Palette pixel format %s is not supported by the conversion", pixel_format_str);
+            SAIL_LOG_AND_RETURN(SAIL_ERROR_UNSUPPORTED_PIXEL_FORMAT);
+        }
+    }
+
+    /* Out of range indexes produce opaque black. */
+    for (unsigned i = 0; i < 256; i++) {
+        output[i][0] = output[i][1] = output[i][2] = 0;
+        output[i][3] = 255;
+    }
+
+    const unsigned color_count = palette->color_count < 256 ? palette->color_count : 256;
+    const uint8_t *data = palette->data;
+
+    for (unsigned i = 0; i < color_count; i++, data += bpp) {
+        output[i][0] = data[red];
+        output[i][1] = data[green];
+        output[i][2] = data[blue];
+        output[i][3] = alpha < 0 ? 255 : data[alpha];
+    }
+
+    return SAIL_OK;
+}
+
+static void build_map(const struct pixel_layout *input, const struct pixel_layout *output, uint8_t map[4]) {
+
+    for (int i = 0; i < 4; i++) {
+        int source;
+
+        if (i == output->alpha) {
+            source = input->alpha;
+        } else if (i == output->red) {
+            source = input->red;
+        } else if (i == output->green) {
+            source = input->green;
+        } else if (i == output->blue) {
+            source = input->blue;
+        } else {
+            source = -1;
+        }
+
+        map[i] = source < 0 ? CONVERT_FILL : (uint8_t)source;
+    }
+}
+
+static bool is_identity_map(const struct pixel_layout *input, const struct pixel_layout *output, const uint8_t map[4]) {
+
+    if (input->channels != output->channels) {
+        return false;
+    }
+
+    for (unsigned i = 0; i < output->channels; i++) {
+        if (map[i] != i) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static sail_status_t init_conversion(const struct sail_image *image, enum SailPixelFormat output_pixel_format,
+                                     struct conversion *conversion) {
+
+    conversion->index_bits   = index_bits(image->pixel_format);
+    conversion->cmyk         = image->pixel_format == SAIL_PIXEL_FORMAT_BPP32_CMYK;
+    conversion->input        = conversion->index_bits > 0 || conversion->cmyk ? &EXPANDED_LAYOUT : find_layout(image->pixel_format);
+    conversion->output       = find_layout(output_pixel_format);
+    conversion->expanded_row = NULL;
+    conversion->narrowed_row = NULL;
+
+    if (conversion->input == NULL || conversion->output == NULL) {
+        const char *input_pixel_format_str = NULL;
+        const char *output_pixel_format_str = NULL;
+        SAIL_TRY_OR_SUPPRESS(sail_pixel_format_to_string(image->pixel_format, &input_pixel_format_str));
+        SAIL_TRY_OR_SUPPRESS(sail_pixel_format_to_string(output_pixel_format, &output_pixel_format_str));
+        SAIL_LOG_ERROR("Conversion from %s to %s is not supported", input_pixel_format_str, output_pixel_format_str);
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_UNSUPPORTED_PIXEL_FORMAT);
+    }
+
+    const struct pixel_layout *input = conversion->input;
+    const struct pixel_layout *output = conversion->output;
+
+    if (conversion->index_bits > 0) {
+        SAIL_TRY(load_palette(image->palette, conversion->palette));
+    }
+
+    build_map(input, output, conversion->map);
+
+    if (output->bytes_per_channel == 1 && (is_grayscale(input) || !is_grayscale(output))) {
+        conversion->narrow = input->bytes_per_channel == 2;
+        conversion->mode   = is_identity_map(input, output, conversion->map) ? CONVERSION_COPY : CONVERSION_SHUFFLE8;
+    } else {
+        conversion->narrow = false;
+        conversion->mode   = input->bytes_per_channel == output->bytes_per_channel &&
+                                is_identity_map(input, output, conversion->map) ? CONVERSION_COPY : CONVERSION_GENERIC;
+    }
+
+    convert_select_kernels(&conversion->kernels);
+
+    void *ptr;
+
+    if (conversion->index_bits > 0 || conversion->cmyk) {
+        SAIL_TRY(sail_malloc((size_t)image->width * 4, &ptr));
+        conversion->expanded_row = ptr;
+    }
+
+    if (conversion->narrow) {
+        SAIL_TRY_OR_CLEANUP(sail_malloc((size_t)image->width * input->channels, &ptr),
+                            /* cleanup */ sail_free(conversion->expanded_row));
+        conversion->narrowed_row = ptr;
+    }
+
+    return SAIL_OK;
+}
+
+static void destroy_conversion(struct conversion *conversion) {
+
+    sail_free(conversion->narrowed_row);
+    sail_free(conversion->expanded_row);
+}
+
+static void expand_indexed_row(const struct conversion *conversion, const uint8_t *src, uint8_t *dst, unsigned width) {
+
+    const unsigned bits = conversion->index_bits;
+
+    if (bits == 8) {
+        for (unsigned x = 0; x < width; x++, dst += 4) {
+            memcpy(dst, conversion->palette[src[x]], 4);
+        }
+    } else {
+        const unsigned mask = (1U << bits) - 1;
+
+        /* The leftmost pixel is stored in the most significant bits. */
+        for (unsigned x = 0; x < width; x++, dst += 4) {
+            const unsigned bit = x * bits;
+            const unsigned index = (src[bit / 8] >> (8 - bits - bit % 8)) & mask;
+
+            memcpy(dst, conversion->palette[index], 4);
+        }
+    }
+}
+
+static inline unsigned read_channel16(const uint8_t *pixel, unsigned bytes_per_channel, int index) {
+
+    if (bytes_per_channel == 1) {
+        return pixel[index] * 257U;
+    } else {
+        return ((const uint16_t *)pixel)[index];
+    }
+}
+
+static inline void write_channel16(uint8_t *pixel, unsigned bytes_per_channel, unsigned index, unsigned value) {
+
+    if (bytes_per_channel == 1) {
+        pixel[index] = (uint8_t)(value >> 8);
+    } else {
+        ((uint16_t *)pixel)[index] = (uint16_t)value;
+    }
+}
+
+static void convert_generic_row(const struct pixel_layout *input, const struct pixel_layout *output,
+                                const uint8_t *src, uint8_t *dst, unsigned width) {
+
+    const unsigned src_bpp = input->channels * input->bytes_per_channel;
+    const unsigned dst_bpp = output->channels * output->bytes_per_channel;
+    const bool to_grayscale = is_grayscale(output) && !is_grayscale(input);
+
+    for (unsigned x = 0; x < width; x++, src += src_bpp, dst += dst_bpp) {
+        const unsigned red   = read_channel16(src, input->bytes_per_channel, input->red);
+        const unsigned green = read_channel16(src, input->bytes_per_channel, input->green);
+        const unsigned blue  = read_channel16(src, input->bytes_per_channel, input->blue);
+        const unsigned alpha = input->alpha < 0 ? 65535 : read_channel16(src, input->bytes_per_channel, input->alpha);
+
+        /* BT.601 luma weights scaled to 65536. */
+        const unsigned gray = to_grayscale ? (19595U * red + 38470U * green + 7471U * blue + 32768U) >> 16 : red;
+
+        for (unsigned i = 0; i < output->channels; i++) {
+            unsigned value;
+
+            if ((int)i == output->alpha) {
+                value = alpha;
+            } else if (is_grayscale(output)) {
+                value = gray;
+            } else if ((int)i == output->red) {
+                value = red;
+            } else if ((int)i == output->green) {
+                value = green;
+            } else if ((int)i == output->blue) {
+                value = blue;
+            } else {
+                value = 65535;
+            }
+
+            write_channel16(dst, output->bytes_per_channel, i, value);
+        }
+    }
+}
+
+static void convert_row(const struct conversion *conversion, const uint8_t *src, uint8_t *dst, unsigned width) {
+
+    const struct pixel_layout *input = conversion->input;
+    const struct pixel_layout *output = conversion->output;
+
+    if (conversion->index_bits > 0) {
+        expand_indexed_row(conversion, src, conversion->expanded_row, width);
+        src = conversion->expanded_row;
+    } else if (conversion->cmyk) {
+        conversion->kernels.cmyk(src, conversion->expanded_row, /* inverted */ false, width);
+        src = conversion->expanded_row;
+    }
+
+    if (conversion->narrow) {
+        conversion->kernels.narrow16((const uint16_t *)src, conversion->narrowed_row, (size_t)width * input->channels);
+        src = conversion->narrowed_row;
+    }
+
+    switch (conversion->mode) {
+        case CONVERSION_COPY: {
+            memcpy(dst, src, (size_t)width * output->channels * output->bytes_per_channel);
+            break;
+        }
+        case CONVERSION_SHUFFLE8: {
+            conversion->kernels.shuffle8(src, input->channels, dst, output->channels, conversion->map, width);
+            break;
+        }
+        case CONVERSION_GENERIC: {
+            convert_generic_row(input, output, src, dst, width);
+            break;
+        }
+    }
+}
+
+static sail_status_t alpha_index(const struct sail_image *image, unsigned *result) {
+
+    switch (image->pixel_format) {
+        case SAIL_PIXEL_FORMAT_BPP32_RGBA:
+        case SAIL_PIXEL_FORMAT_BPP32_BGRA: *result = 3; return SAIL_OK;
+        case SAIL_PIXEL_FORMAT_BPP32_ARGB:
+        case SAIL_PIXEL_FORMAT_BPP32_ABGR: *result = 0; return SAIL_OK;
+
+        default: {
+            const char *pixel_format_str = NULL;
+            SAIL_TRY_OR_SUPPRESS(sail_pixel_format_to_string(image->pixel_format, &pixel_format_str));
+            SAIL_LOG_ERROR("Alpha premultiplication of %s images is not supported", pixel_format_str);
+            SAIL_LOG_AND_RETURN(SAIL_ERROR_UNSUPPORTED_PIXEL_FORMAT);
+        }
+    }
+}
+
+static void unpremultiply_row(uint8_t *pixels, unsigned alpha_index, unsigned width) {
+
+    for (unsigned x = 0; x < width; x++, pixels += 4) {
+        const unsigned alpha = pixels[alpha_index];
+
+        if (alpha == 255) {
+            continue;
+        }
+
+        for (unsigned i = 0; i < 4; i++) {
+            if (i == alpha_index) {
+                continue;
+            }
+
+            if (alpha == 0) {
+                pixels[i] = 0;
+            } else {
+                const unsigned value = (pixels[i] * 255U + alpha / 2) / alpha;
+                pixels[i] = (uint8_t)(value > 255 ? 255 : value);
+            }
+        }
+    }
+}
+
+/*
+ * Public functions.
+ */
+
+bool sail_can_convert(enum SailPixelFormat input_pixel_format, enum SailPixelFormat output_pixel_format) {
+
+    return (index_bits(input_pixel_format) > 0 ||
+                input_pixel_format == SAIL_PIXEL_FORMAT_BPP32_CMYK ||
+                find_layout(input_pixel_format) != NULL) &&
+            find_layout(output_pixel_format) != NULL;
+}
+
+sail_status_t sail_convert_image(const struct sail_image *image, enum SailPixelFormat output_pixel_format,
+                                 struct sail_image **image_output) {
+
+    SAIL_CHECK_IMAGE(image);
+    SAIL_CHECK_PIXELS_PTR(image->pixels);
+    SAIL_CHECK_IMAGE_PTR(image_output);
+
+    struct conversion conversion;
+    SAIL_TRY(init_conversion(image, output_pixel_format, &conversion));
+
+    /* Copy everything except pixels. */
+    struct sail_image image_skeleton = *image;
+    image_skeleton.pixels = NULL;
+
+    struct sail_image *image_local;
+    SAIL_TRY_OR_CLEANUP(sail_copy_image(&image_skeleton, &image_local),
+                        /* cleanup */ destroy_conversion(&conversion));
+
+    sail_destroy_palette(image_local->palette);
+    image_local->palette = NULL;
+    image_local->pixel_format = output_pixel_format;
+
+    SAIL_TRY_OR_CLEANUP(sail_bytes_per_line(image_local->width, image_local->pixel_format, &image_local->bytes_per_line),
+                        /* cleanup */ destroy_conversion(&conversion),
+                                      sail_destroy_image(image_local));
+    SAIL_TRY_OR_CLEANUP(sail_malloc_pixels((size_t)image_local->bytes_per_line * image_local->height, &image_local->pixels),
+                        /* cleanup */ destroy_conversion(&conversion),
+                                      sail_destroy_image(image_local));
+
+    for (unsigned row = 0; row < image->height; row++) {
+        convert_row(&conversion,
+                    (const uint8_t *)image->pixels + (size_t)row * image->bytes_per_line,
+                    (uint8_t *)image_local->pixels + (size_t)row * image_local->bytes_per_line,
+                    image->width);
+    }
+
+    destroy_conversion(&conversion);
+
+    *image_output = image_local;
+
+    return SAIL_OK;
+}
+
+sail_status_t sail_convert_cmyk_row(const void *cmyk, bool inverted, unsigned width,
+                                   enum SailPixelFormat output_pixel_format, void *output) {
+
+    SAIL_CHECK_BUFFER_PTR(cmyk);
+    SAIL_CHECK_BUFFER_PTR(output);
+
+    const struct pixel_layout *output_layout = find_layout(output_pixel_format);
+
+    if (output_layout == NULL) {
+        const char *pixel_format_str = NULL;
+        SAIL_TRY_OR_SUPPRESS(sail_pixel_format_to_string(output_pixel_format, &pixel_format_str));
+        SAIL_LOG_ERROR("Conversion from CMYK to %s is not supported", pixel_format_str);
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_UNSUPPORTED_PIXEL_FORMAT);
+    }
+
+    struct convert_kernels kernels;
+    convert_select_kernels(&kernels);
+
+    if (output_pixel_format == SAIL_PIXEL_FORMAT_BPP32_RGBA) {
+        kernels.cmyk(cmyk, output, inverted, width);
+        return SAIL_OK;
+    }
+
+    uint8_t map[4];
+    build_map(&EXPANDED_LAYOUT, output_layout, map);
+
+    const bool shuffle = output_layout->bytes_per_channel == 1 && !is_grayscale(output_layout);
+    const unsigned output_bpp = output_layout->channels * output_layout->bytes_per_channel;
+
+    /* Convert through a small RGBA buffer so the output may overwrite the input. */
+    uint8_t rgba[CMYK_CHUNK_PIXELS * 4];
+
+    for (unsigned x = 0; x < width; x += CMYK_CHUNK_PIXELS) {
+        const unsigned chunk = width - x < CMYK_CHUNK_PIXELS ? width - x : CMYK_CHUNK_PIXELS;
+        uint8_t *output_chunk = (uint8_t *)output + (size_t)x * output_bpp;
+
+        kernels.cmyk((const uint8_t *)cmyk + (size_t)x * 4, rgba, inverted, chunk);
+
+        if (shuffle) {
+            kernels.shuffle8(rgba, 4, output_chunk, output_layout->channels, map, chunk);
+        } else {
+            convert_generic_row(&EXPANDED_LAYOUT, output_layout, rgba, output_chunk, chunk);
+        }
+    }
+
+    return SAIL_OK;
+}
+
+sail_status_t sail_premultiply_alpha(struct sail_image *image) {
+
+    SAIL_CHECK_IMAGE(image);
+    SAIL_CHECK_PIXELS_PTR(image->pixels);
+
+    unsigned alpha;
+    SAIL_TRY(alpha_index(image, &alpha));
+
+    struct convert_kernels kernels;
+    convert_select_kernels(&kernels);
+
+    for (unsigned row = 0; row < image->height; row++) {
+        kernels.premultiply((uint8_t *)image->pixels + (size_t)row * image->bytes_per_line, alpha, image->width);
+    }
+
+    return SAIL_OK;
+}
+
+sail_status_t sail_unpremultiply_alpha(struct sail_image *image) {
+
+    SAIL_CHECK_IMAGE(image);
+    SAIL_CHECK_PIXELS_PTR(image->pixels);
+
+    unsigned alpha;
+    SAIL_TRY(alpha_index(image, &alpha));
+
+    for (unsigned row = 0; row < image->height; row++) {
+        unpremultiply_row((uint8_t *)image->pixels + (size_t)row * image->bytes_per_line, alpha, image->width);
+    }
+
+    return SAIL_OK;
+}
@@ -0,0 +1,119 @@
+/*  This file is part of SAIL (https://github.com/smoked-herring/sail)
+
+    Copyright (c) 2020 Dmitry Baryshev
+
+    The MIT License
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#ifndef SAIL_CONVERT_H
+#define SAIL_CONVERT_H
+
+#include <stdbool.h>
+
+#ifdef SAIL_BUILD
+    #include "common.h"
+    #include "error.h"
+    #include "export.h"
+#else
+    #include <sail-common/common.h>
+    #include <sail-common/error.h>
+    #include <sail-common/export.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct sail_image;
+
+/*
+ * Pixel format conversion.
+ *
+ * Supported input pixel formats:
+ *   - BPP1-INDEXED, BPP2-INDEXED, BPP4-INDEXED, and BPP8-INDEXED with BPP24-RGB, BPP24-BGR,
+ *     BPP32-RGBA, or BPP32-BGRA palettes
+ *   - BPP32-CMYK, where 0 means no ink
+ *   - all the output pixel formats listed below
+ *
+ * Supported output pixel formats:
+ *   - BPP8-GRAYSCALE, BPP16-GRAYSCALE, BPP16-GRAYSCALE-ALPHA, BPP32-GRAYSCALE-ALPHA
+ *   - BPP24-RGB, BPP24-BGR, BPP48-RGB, BPP48-BGR
+ *   - BPP32-RGBX, BPP32-BGRX, BPP32-XRGB, BPP32-XBGR, BPP32-RGBA, BPP32-BGRA, BPP32-ARGB, BPP32-ABGR
+ *   - BPP64-RGBX, BPP64-BGRX, BPP64-XRGB, BPP64-XBGR, BPP64-RGBA, BPP64-BGRA, BPP64-ARGB, BPP64-ABGR
+ *
+ * Color is converted to grayscale with the BT.601 luma weights. Missing alpha and X channels are filled
+ * with the maximum value. Alpha is dropped as is when the output pixel format has no alpha channel.
+ * 16-bit channels are stored in the native byte order and are reduced to 8 bits by dropping the low byte.
+ *
+ * Common conversions between 8-bit pixel formats (channel reordering, adding or removing alpha, grayscale
+ * expansion), CMYK to RGB, and 16 to 8 bit reduction use SSE2, AVX2, or NEON kernels selected at runtime by the CPU
+ * features, and fall back to scalar code otherwise.
+ */
+
+/*
+ * Returns true if the conversion from the input pixel format to the output pixel format is supported.
+ */
+SAIL_EXPORT bool sail_can_convert(enum SailPixelFormat input_pixel_format, enum SailPixelFormat output_pixel_format);
+
+/*
+ * Converts the specified image to the specified pixel format and assigns the resulting image. The input image
+ * rows may be padded. The output image has no padding. All the other image properties are copied as is,
+ * except the palette which is dropped. The assigned image MUST be destroyed later with sail_destroy_image().
+ *
+ * Returns SAIL_OK on success or SAIL_ERROR_UNSUPPORTED_PIXEL_FORMAT if the conversion is not supported.
+ */
+SAIL_EXPORT sail_status_t sail_convert_image(const struct sail_image *image, enum SailPixelFormat output_pixel_format,
+                                            struct sail_image **image_output);
+
+/*
+ * Converts width BPP32-CMYK pixels to the specified output pixel format. The output pixel formats are the same
+ * as in sail_convert_image(). Color channels are computed in fixed point as (255 - C) * (255 - K) / 255.
+ * If inverted is true, the input stores 255 for no ink, as Adobe applications write CMYK JPEG files.
+ *
+ * The input and the output may point to the same buffer if the output pixel format has 32 bits per pixel
+ * or less.
+ *
+ * Returns SAIL_OK on success or SAIL_ERROR_UNSUPPORTED_PIXEL_FORMAT if the conversion is not supported.
+ */
+SAIL_EXPORT sail_status_t sail_convert_cmyk_row(const void *cmyk, bool inverted, unsigned width,
+                                               enum SailPixelFormat output_pixel_format, void *output);
+
+/*
+ * Multiplies the color channels of the specified image by alpha in place. Supports BPP32-RGBA, BPP32-BGRA,
+ * BPP32-ARGB, and BPP32-ABGR images.
+ *
+ * Returns SAIL_OK on success.
+ */
+SAIL_EXPORT sail_status_t sail_premultiply_alpha(struct sail_image *image);
+
+/*
+ * Divides the color channels of the specified premultiplied image by alpha in place. Fully transparent pixels
+ * become black. Supports BPP32-RGBA, BPP32-BGRA, BPP32-ARGB, and BPP32-ABGR images.
+ *
+ * Returns SAIL_OK on success.
+ */
+SAIL_EXPORT sail_status_t sail_unpremultiply_alpha(struct sail_image *image);
+
+/* extern "C" */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,170 @@
+/*  This file is part of SAIL (https://github.com/smoked-herring/sail)
+
+    Copyright (c) 2020 Dmitry Baryshev
+
+    The MIT License
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <immintrin.h>
+
+#include "convert_private.h"
+
+/*
+ * Private functions.
+ */
+
+static inline __m256i premultiply16x16(__m256i color, __m256i alpha) {
+
+    const __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(color, alpha), _mm256_set1_epi16(128));
+
+    return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+static inline __m256i broadcast_alpha(__m256i pixels, unsigned alpha_index) {
+
+    if (alpha_index == 0) {
+        return _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(pixels, 0x00), 0x00);
+    } else {
+        return _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(pixels, 0xFF), 0xFF);
+    }
+}
+
+/*
+ * Public functions.
+ */
+
+void convert_shuffle8_avx2(const uint8_t *src, unsigned src_bpp, uint8_t *dst, unsigned dst_bpp,
+                           const uint8_t *map, unsigned width) {
+
+    /*
+     * Every 128-bit lane converts as many whole pixels as fit into 16 bytes of both the input and
+     * the output. The two lanes are loaded and stored separately, so the bytes past the converted
+     * pixels are overwritten by the next iteration.
+     */
+    const unsigned pixels_per_lane = 16 / (src_bpp > dst_bpp ? src_bpp : dst_bpp);
+    const size_t src_lane = (size_t)pixels_per_lane * src_bpp;
+    const size_t dst_lane = (size_t)pixels_per_lane * dst_bpp;
+
+    uint8_t shuffle[16];
+    uint8_t fill[16];
+
+    for (unsigned i = 0; i < 16; i++) {
+        shuffle[i] = 0x80;
+        fill[i]    = 0;
+    }
+
+    for (unsigned p = 0; p < pixels_per_lane; p++) {
+        for (unsigned i = 0; i < dst_bpp; i++) {
+            if (map[i] == CONVERT_FILL) {
+                fill[p * dst_bpp + i] = 0xFF;
+            } else {
+                shuffle[p * dst_bpp + i] = (uint8_t)(p * src_bpp + map[i]);
+            }
+        }
+    }
+
+    const __m256i shuffle_mask = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)shuffle));
+    const __m256i fill_mask    = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)fill));
+
+    const size_t src_length = (size_t)width * src_bpp;
+    const size_t dst_length = (size_t)width * dst_bpp;
+    unsigned x = 0;
+
+    for (; (size_t)x * src_bpp + src_lane + 16 <= src_length && (size_t)x * dst_bpp + dst_lane + 16 <= dst_length;
+            x += pixels_per_lane * 2) {
+        const uint8_t *input = src + (size_t)x * src_bpp;
+        uint8_t *output = dst + (size_t)x * dst_bpp;
+
+        __m256i pixels = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)input)),
+                                                 _mm_loadu_si128((const __m128i *)(input + src_lane)), 1);
+        pixels = _mm256_or_si256(_mm256_shuffle_epi8(pixels, shuffle_mask), fill_mask);
+
+        _mm_storeu_si128((__m128i *)output, _mm256_castsi256_si128(pixels));
+        _mm_storeu_si128((__m128i *)(output + dst_lane), _mm256_extracti128_si256(pixels, 1));
+    }
+
+    convert_shuffle8_scalar(src + (size_t)x * src_bpp, src_bpp, dst + (size_t)x * dst_bpp, dst_bpp, map, width - x);
+}
+
+void convert_narrow16_avx2(const uint16_t *src, uint8_t *dst, size_t count) {
+
+    size_t i = 0;
+
+    for (; i + 32 <= count; i += 32) {
+        const __m256i a = _mm256_srli_epi16(_mm256_loadu_si256((const __m256i *)(src + i)), 8);
+        const __m256i b = _mm256_srli_epi16(_mm256_loadu_si256((const __m256i *)(src + i + 16)), 8);
+
+        /* Packing works within lanes, so restore the order of the 64-bit halves. */
+        const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8);
+
+        _mm256_storeu_si256((__m256i *)(dst + i), packed);
+    }
+
+    convert_narrow16_scalar(src + i, dst + i, count - i);
+}
+
+void convert_premultiply_avx2(uint8_t *pixels, unsigned alpha_index, unsigned width) {
+
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i alpha_mask = _mm256_set1_epi32((int)(0xFFU << (alpha_index * 8)));
+    unsigned x = 0;
+
+    for (; x + 8 <= width; x += 8) {
+        const __m256i rgba = _mm256_loadu_si256((const __m256i *)(pixels + x * 4));
+        const __m256i lo = _mm256_unpacklo_epi8(rgba, zero);
+        const __m256i hi = _mm256_unpackhi_epi8(rgba, zero);
+
+        const __m256i result = _mm256_packus_epi16(premultiply16x16(lo, broadcast_alpha(lo, alpha_index)),
+                                                   premultiply16x16(hi, broadcast_alpha(hi, alpha_index)));
+
+        /* Keep the original alpha. */
+        _mm256_storeu_si256((__m256i *)(pixels + x * 4),
+                            _mm256_or_si256(_mm256_andnot_si256(alpha_mask, result), _mm256_and_si256(alpha_mask, rgba)));
+    }
+
+    convert_premultiply_scalar(pixels + x * 4, alpha_index, width - x);
+}
+
+void convert_cmyk_avx2(const uint8_t *src, uint8_t *dst, bool inverted, unsigned width) {
+
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i flip = inverted ? _mm256_setzero_si256() : _mm256_set1_epi8((char)0xFF);
+    const __m256i alpha_mask = _mm256_set1_epi32((int)0xFF000000U);
+    unsigned x = 0;
+
+    /* Multiplying C, M, and Y by K is premultiplication by alpha stored in the last byte. */
+    for (; x + 8 <= width; x += 8) {
+        const __m256i cmyk = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(src + x * 4)), flip);
+        const __m256i lo = _mm256_unpacklo_epi8(cmyk, zero);
+        const __m256i hi = _mm256_unpackhi_epi8(cmyk, zero);
+
+        const __m256i result = _mm256_packus_epi16(premultiply16x16(lo, broadcast_alpha(lo, 3)),
+                                                   premultiply16x16(hi, broadcast_alpha(hi, 3)));
+
+        _mm256_storeu_si256((__m256i *)(dst + x * 4), _mm256_or_si256(result, alpha_mask));
+    }
+
+    convert_cmyk_scalar(src + x * 4, dst + x * 4, inverted, width - x);
+}
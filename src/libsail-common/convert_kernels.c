@@ -0,0 +1,159 @@
+/*  This file is part of SAIL (https://github.com/smoked-herring/sail)
+
+    Copyright (c) 2020 Dmitry Baryshev
+
+    The MIT License
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined SAIL_HAVE_X86_KERNELS && defined _MSC_VER
+    #include <intrin.h>
+#endif
+
+#include "convert_private.h"
+
+/*
+ * Public functions.
+ */
+
+#ifdef SAIL_HAVE_X86_KERNELS
+#ifdef _MSC_VER
+bool convert_cpu_has_sse2(void) {
+
+    int info[4];
+    __cpuid(info, 1);
+
+    return (info[3] & (1 << 26)) != 0;
+}
+
+bool convert_cpu_has_avx2(void) {
+
+    int info[4];
+    __cpuid(info, 0);
+
+    if (info[0] < 7) {
+        return false;
+    }
+
+    /* OSXSAVE and AVX, then the OS must save the YMM state. */
+    __cpuid(info, 1);
+
+    if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0 || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+
+    __cpuidex(info, 7, 0);
+
+    return (info[1] & (1 << 5)) != 0;
+}
+#else
+bool convert_cpu_has_sse2(void) {
+
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2");
+}
+
+bool convert_cpu_has_avx2(void) {
+
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+#endif
+#endif
+
+void convert_select_kernels(struct convert_kernels *kernels) {
+
+    kernels->shuffle8    = convert_shuffle8_scalar;
+    kernels->narrow16    = convert_narrow16_scalar;
+    kernels->premultiply = convert_premultiply_scalar;
+    kernels->cmyk        = convert_cmyk_scalar;
+
+#if defined SAIL_HAVE_X86_KERNELS
+    if (convert_cpu_has_avx2()) {
+        kernels->shuffle8    = convert_shuffle8_avx2;
+        kernels->narrow16    = convert_narrow16_avx2;
+        kernels->premultiply = convert_premultiply_avx2;
+        kernels->cmyk        = convert_cmyk_avx2;
+    } else if (convert_cpu_has_sse2()) {
+        kernels->shuffle8    = convert_shuffle8_sse2;
+        kernels->narrow16    = convert_narrow16_sse2;
+        kernels->premultiply = convert_premultiply_sse2;
+        kernels->cmyk        = convert_cmyk_sse2;
+    }
+#elif defined SAIL_HAVE_NEON_KERNELS
+    kernels->shuffle8    = convert_shuffle8_neon;
+    kernels->narrow16    = convert_narrow16_neon;
+    kernels->premultiply = convert_premultiply_neon;
+    kernels->cmyk        = convert_cmyk_neon;
+#endif
+}
+
+void convert_shuffle8_scalar(const uint8_t *src, unsigned src_bpp, uint8_t *dst, unsigned dst_bpp,
+                             const uint8_t *map, unsigned width) {
+
+    for (unsigned x = 0; x < width; x++, src += src_bpp, dst += dst_bpp) {
+        for (unsigned i = 0; i < dst_bpp; i++) {
+            dst[i] = map[i] == CONVERT_FILL ? 255 : src[map[i]];
+        }
+    }
+}
+
+void convert_narrow16_scalar(const uint16_t *src, uint8_t *dst, size_t count) {
+
+    for (size_t i = 0; i < count; i++) {
+        dst[i] = (uint8_t)(src[i] >> 8);
+    }
+}
+
+void convert_premultiply_scalar(uint8_t *pixels, unsigned alpha_index, unsigned width) {
+
+    for (unsigned x = 0; x < width; x++, pixels += 4) {
+        const unsigned alpha = pixels[alpha_index];
+
+        for (unsigned i = 0; i < 4; i++) {
+            if (i != alpha_index) {
+                /* Rounded division by 255. */
+                const unsigned t = pixels[i] * alpha + 128;
+                pixels[i] = (uint8_t)((t + (t >> 8)) >> 8);
+            }
+        }
+    }
+}
+
+void convert_cmyk_scalar(const uint8_t *src, uint8_t *dst, bool inverted, unsigned width) {
+
+    const unsigned flip = inverted ? 0 : 255;
+
+    for (unsigned x = 0; x < width; x++, src += 4, dst += 4) {
+        const unsigned k = src[3] ^ flip;
+
+        for (unsigned i = 0; i < 3; i++) {
+            /* Rounded division by 255. */
+            const unsigned t = (src[i] ^ flip) * k + 128;
+            dst[i] = (uint8_t)((t + (t >> 8)) >> 8);
+        }
+
+        dst[3] = 255;
+    }
+}
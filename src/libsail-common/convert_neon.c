@@ -0,0 +1,165 @@
+/*  This file is part of SAIL (https://github.com/smoked-herring/sail)
+
+    Copyright (c) 2020 Dmitry Baryshev
+
+    The MIT License
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <arm_neon.h>
+
+#include "convert_private.h"
+
+/*
+ * Private functions.
+ */
+
+static inline uint8x16_t premultiply16x8(uint8x16_t color, uint8x16_t alpha) {
+
+    const uint16x8_t lo = vmull_u8(vget_low_u8(color),  vget_low_u8(alpha));
+    const uint16x8_t hi = vmull_u8(vget_high_u8(color), vget_high_u8(alpha));
+
+    /* Rounded division by 255 as in the scalar kernel. */
+    return vcombine_u8(vraddhn_u16(lo, vrshrq_n_u16(lo, 8)), vraddhn_u16(hi, vrshrq_n_u16(hi, 8)));
+}
+
+/*
+ * Public functions.
+ */
+
+void convert_shuffle8_neon(const uint8_t *src, unsigned src_bpp, uint8_t *dst, unsigned dst_bpp,
+                           const uint8_t *map, unsigned width) {
+
+    const uint8x16_t fill = vdupq_n_u8(0xFF);
+    unsigned x = 0;
+
+    for (; x + 16 <= width; x += 16) {
+        const uint8_t *input = src + (size_t)x * src_bpp;
+        uint8_t *output = dst + (size_t)x * dst_bpp;
+        uint8x16_t channels[4];
+
+        /* Deinterleave the channels. */
+        switch (src_bpp) {
+            case 1: {
+                channels[0] = vld1q_u8(input);
+                break;
+            }
+            case 2: {
+                const uint8x16x2_t v = vld2q_u8(input);
+                channels[0] = v.val[0]; channels[1] = v.val[1];
+                break;
+            }
+            case 3: {
+                const uint8x16x3_t v = vld3q_u8(input);
+                channels[0] = v.val[0]; channels[1] = v.val[1]; channels[2] = v.val[2];
+                break;
+            }
+            default: {
+                const uint8x16x4_t v = vld4q_u8(input);
+                channels[0] = v.val[0]; channels[1] = v.val[1]; channels[2] = v.val[2]; channels[3] = v.val[3];
+                break;
+            }
+        }
+
+        #define SAIL_CHANNEL(i) (map[i] == CONVERT_FILL ? fill : channels[map[i]])
+
+        switch (dst_bpp) {
+            case 1: {
+                vst1q_u8(output, SAIL_CHANNEL(0));
+                break;
+            }
+            case 2: {
+                const uint8x16x2_t v = { { SAIL_CHANNEL(0), SAIL_CHANNEL(1) } };
+                vst2q_u8(output, v);
+                break;
+            }
+            case 3: {
+                const uint8x16x3_t v = { { SAIL_CHANNEL(0), SAIL_CHANNEL(1), SAIL_CHANNEL(2) } };
+                vst3q_u8(output, v);
+                break;
+            }
+            default: {
+                const uint8x16x4_t v = { { SAIL_CHANNEL(0), SAIL_CHANNEL(1), SAIL_CHANNEL(2), SAIL_CHANNEL(3) } };
+                vst4q_u8(output, v);
+                break;
+            }
+        }
+
+        #undef SAIL_CHANNEL
+    }
+
+    convert_shuffle8_scalar(src + (size_t)x * src_bpp, src_bpp, dst + (size_t)x * dst_bpp, dst_bpp, map, width - x);
+}
+
+void convert_narrow16_neon(const uint16_t *src, uint8_t *dst, size_t count) {
+
+    size_t i = 0;
+
+    for (; i + 16 <= count; i += 16) {
+        vst1q_u8(dst + i, vcombine_u8(vshrn_n_u16(vld1q_u16(src + i), 8), vshrn_n_u16(vld1q_u16(src + i + 8), 8)));
+    }
+
+    convert_narrow16_scalar(src + i, dst + i, count - i);
+}
+
+void convert_premultiply_neon(uint8_t *pixels, unsigned alpha_index, unsigned width) {
+
+    unsigned x = 0;
+
+    for (; x + 16 <= width; x += 16) {
+        uint8x16x4_t rgba = vld4q_u8(pixels + x * 4);
+        const uint8x16_t alpha = rgba.val[alpha_index];
+
+        for (unsigned i = 0; i < 4; i++) {
+            if (i != alpha_index) {
+                rgba.val[i] = premultiply16x8(rgba.val[i], alpha);
+            }
+        }
+
+        vst4q_u8(pixels + x * 4, rgba);
+    }
+
+    convert_premultiply_scalar(pixels + x * 4, alpha_index, width - x);
+}
+
+void convert_cmyk_neon(const uint8_t *src, uint8_t *dst, bool inverted, unsigned width) {
+
+    const uint8x16_t flip = vdupq_n_u8(inverted ? 0 : 0xFF);
+    unsigned x = 0;
+
+    for (; x + 16 <= width; x += 16) {
+        uint8x16x4_t cmyk = vld4q_u8(src + x * 4);
+        const uint8x16_t k = veorq_u8(cmyk.val[3], flip);
+
+        for (unsigned i = 0; i < 3; i++) {
+            cmyk.val[i] = premultiply16x8(veorq_u8(cmyk.val[i], flip), k);
+        }
+
+        cmyk.val[3] = vdupq_n_u8(0xFF);
+
+        vst4q_u8(dst + x * 4, cmyk);
+    }
+
+    convert_cmyk_scalar(src + x * 4, dst + x * 4, inverted, width - x);
+}
@@ -0,0 +1,113 @@
+/*  This file is part of SAIL (https://github.com/smoked-herring/sail)
+
+    Copyright (c) 2020 Dmitry Baryshev
+
+    The MIT License
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#ifndef SAIL_CONVERT_PRIVATE_H
+#define SAIL_CONVERT_PRIVATE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "export.h"
+
+/* Byte map entry which fills the output byte with 0xFF instead of copying a source byte. */
+#define CONVERT_FILL 0x80
+
+/*
+ * Copies width pixels of src_bpp bytes into pixels of dst_bpp bytes. Output byte i of every pixel
+ * is the source byte map[i] of the same pixel, or 0xFF if map[i] is CONVERT_FILL. Pixels are up to 4 bytes.
+ */
+typedef void (*convert_shuffle8_t)(const uint8_t *src, unsigned src_bpp, uint8_t *dst, unsigned dst_bpp,
+                                   const uint8_t *map, unsigned width);
+
+/* Reduces count 16-bit channels to 8 bits by dropping the low byte. */
+typedef void (*convert_narrow16_t)(const uint16_t *src, uint8_t *dst, size_t count);
+
+/* Multiplies the color channels of width 32-bit pixels by alpha stored in the byte alpha_index in place. */
+typedef void (*convert_premultiply_t)(uint8_t *pixels, unsigned alpha_index, unsigned width);
+
+/*
+ * Converts width CMYK pixels to RGBA with opaque alpha. Inverted CMYK stores 255 for no ink.
+ * src and dst may point to the same buffer.
+ */
+typedef void (*convert_cmyk_t)(const uint8_t *src, uint8_t *dst, bool inverted, unsigned width);
+
+struct convert_kernels {
+
+    convert_shuffle8_t shuffle8;
+    convert_narrow16_t narrow16;
+    convert_premultiply_t premultiply;
+    convert_cmyk_t cmyk;
+};
+
+/* Fills kernels with the fastest implementations the CPU supports. */
+SAIL_HIDDEN void convert_select_kernels(struct convert_kernels *kernels);
+
+/* Scalar kernels. Also used by the SIMD kernels to process the remaining pixels. */
+SAIL_HIDDEN void convert_shuffle8_scalar(const uint8_t *src, unsigned src_bpp, uint8_t *dst, unsigned dst_bpp,
+                                         const uint8_t *map, unsigned width);
+
+SAIL_HIDDEN void convert_narrow16_scalar(const uint16_t *src, uint8_t *dst, size_t count);
+
+SAIL_HIDDEN void convert_premultiply_scalar(uint8_t *pixels, unsigned alpha_index, unsigned width);
+
+SAIL_HIDDEN void convert_cmyk_scalar(const uint8_t *src, uint8_t *dst, bool inverted, unsigned width);
+
+#ifdef SAIL_HAVE_X86_KERNELS
+SAIL_HIDDEN bool convert_cpu_has_sse2(void);
+
+SAIL_HIDDEN bool convert_cpu_has_avx2(void);
+
+SAIL_HIDDEN void convert_shuffle8_sse2(const uint8_t *src, unsigned src_bpp, uint8_t *dst, unsigned dst_bpp,
+                                       const uint8_t *map, unsigned width);
+
+SAIL_HIDDEN void convert_narrow16_sse2(const uint16_t *src, uint8_t *dst, size_t count);
+
+SAIL_HIDDEN void convert_premultiply_sse2(uint8_t *pixels, unsigned alpha_index, unsigned width);
+
+SAIL_HIDDEN void convert_cmyk_sse2(const uint8_t *src, uint8_t *dst, bool inverted, unsigned width);
+
+SAIL_HIDDEN void convert_shuffle8_avx2(const uint8_t *src, unsigned src_bpp, uint8_t *dst, unsigned dst_bpp,
+                                       const uint8_t *map, unsigned width);
+
+SAIL_HIDDEN void convert_narrow16_avx2(const uint16_t *src, uint8_t *dst, size_t count);
+
+SAIL_HIDDEN void convert_premultiply_avx2(uint8_t *pixels, unsigned alpha_index, unsigned width);
+
+SAIL_HIDDEN void convert_cmyk_avx2(const uint8_t *src, uint8_t *dst, bool inverted, unsigned width);
+#endif
+
+#ifdef SAIL_HAVE_NEON_KERNELS
+SAIL_HIDDEN void convert_shuffle8_neon(const uint8_t *src, unsigned src_bpp, uint8_t *dst, unsigned dst_bpp,
+                                       const uint8_t *map, unsigned width);
+
+SAIL_HIDDEN void convert_narrow16_neon(const uint16_t *src, uint8_t *dst, size_t count);
+
+SAIL_HIDDEN void convert_premultiply_neon(uint8_t *pixels, unsigned alpha_index, unsigned width);
+
+SAIL_HIDDEN void convert_cmyk_neon(const uint8_t *src, uint8_t *dst, bool inverted, unsigned width);
+#endif
+
+#endif
@@ -0,0 +1,181 @@
+/*  This file is part of SAIL (https://github.com/smoked-herring/sail)
+
+    Copyright (c) 2020 Dmitry Baryshev
+
+    The MIT License
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <emmintrin.h>
+
+#include "convert_private.h"
+
+/*
+ * Private functions.
+ */
+
+/* Multiplies 16-bit color channels by the matching 16-bit alpha with rounded division by 255. */
+static inline __m128i premultiply8x16(__m128i color, __m128i alpha) {
+
+    const __m128i t = _mm_add_epi16(_mm_mullo_epi16(color, alpha), _mm_set1_epi16(128));
+
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+static inline __m128i broadcast_alpha(__m128i pixels, unsigned alpha_index) {
+
+    if (alpha_index == 0) {
+        return _mm_shufflehi_epi16(_mm_shufflelo_epi16(pixels, 0x00), 0x00);
+    } else {
+        return _mm_shufflehi_epi16(_mm_shufflelo_epi16(pixels, 0xFF), 0xFF);
+    }
+}
+
+/*
+ * Public functions.
+ */
+
+void convert_shuffle8_sse2(const uint8_t *src, unsigned src_bpp, uint8_t *dst, unsigned dst_bpp,
+                           const uint8_t *map, unsigned width) {
+
+    unsigned x = 0;
+
+    /* Without a byte shuffle instruction, only 4 to 4 and 1 to 4 byte pixels are vectorized. */
+    if (src_bpp == 4 && dst_bpp == 4) {
+        uint32_t fill = 0;
+
+        for (unsigned i = 0; i < 4; i++) {
+            if (map[i] == CONVERT_FILL) {
+                fill |= 0xFFU << (i * 8);
+            }
+        }
+
+        const __m128i fill_mask = _mm_set1_epi32((int)fill);
+        const __m128i byte_mask = _mm_set1_epi32(0xFF);
+        __m128i shift_in[4];
+        __m128i shift_out[4];
+
+        for (unsigned i = 0; i < 4; i++) {
+            shift_in[i]  = _mm_cvtsi32_si128(map[i] == CONVERT_FILL ? 0 : map[i] * 8);
+            shift_out[i] = _mm_cvtsi32_si128((int)i * 8);
+        }
+
+        for (; x + 4 <= width; x += 4) {
+            const __m128i pixels = _mm_loadu_si128((const __m128i *)(src + x * 4));
+            __m128i result = fill_mask;
+
+            for (unsigned i = 0; i < 4; i++) {
+                if (map[i] != CONVERT_FILL) {
+                    const __m128i channel = _mm_and_si128(_mm_srl_epi32(pixels, shift_in[i]), byte_mask);
+                    result = _mm_or_si128(result, _mm_sll_epi32(channel, shift_out[i]));
+                }
+            }
+
+            _mm_storeu_si128((__m128i *)(dst + x * 4), result);
+        }
+    } else if (src_bpp == 1 && dst_bpp == 4) {
+        uint32_t fill = 0;
+
+        for (unsigned i = 0; i < 4; i++) {
+            if (map[i] == CONVERT_FILL) {
+                fill |= 0xFFU << (i * 8);
+            }
+        }
+
+        const __m128i fill_mask = _mm_set1_epi32((int)fill);
+
+        for (; x + 16 <= width; x += 16) {
+            const __m128i gray = _mm_loadu_si128((const __m128i *)(src + x));
+            const __m128i gray2_lo = _mm_unpacklo_epi8(gray, gray);
+            const __m128i gray2_hi = _mm_unpackhi_epi8(gray, gray);
+
+            uint8_t *output = dst + x * 4;
+
+            _mm_storeu_si128((__m128i *)(output +  0), _mm_or_si128(_mm_unpacklo_epi16(gray2_lo, gray2_lo), fill_mask));
+            _mm_storeu_si128((__m128i *)(output + 16), _mm_or_si128(_mm_unpackhi_epi16(gray2_lo, gray2_lo), fill_mask));
+            _mm_storeu_si128((__m128i *)(output + 32), _mm_or_si128(_mm_unpacklo_epi16(gray2_hi, gray2_hi), fill_mask));
+            _mm_storeu_si128((__m128i *)(output + 48), _mm_or_si128(_mm_unpackhi_epi16(gray2_hi, gray2_hi), fill_mask));
+        }
+    }
+
+    convert_shuffle8_scalar(src + x * src_bpp, src_bpp, dst + x * dst_bpp, dst_bpp, map, width - x);
+}
+
+void convert_narrow16_sse2(const uint16_t *src, uint8_t *dst, size_t count) {
+
+    size_t i = 0;
+
+    for (; i + 16 <= count; i += 16) {
+        const __m128i a = _mm_srli_epi16(_mm_loadu_si128((const __m128i *)(src + i)), 8);
+        const __m128i b = _mm_srli_epi16(_mm_loadu_si128((const __m128i *)(src + i + 8)), 8);
+
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_packus_epi16(a, b));
+    }
+
+    convert_narrow16_scalar(src + i, dst + i, count - i);
+}
+
+void convert_premultiply_sse2(uint8_t *pixels, unsigned alpha_index, unsigned width) {
+
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alpha_mask = _mm_set1_epi32((int)(0xFFU << (alpha_index * 8)));
+    unsigned x = 0;
+
+    for (; x + 4 <= width; x += 4) {
+        const __m128i rgba = _mm_loadu_si128((const __m128i *)(pixels + x * 4));
+        const __m128i lo = _mm_unpacklo_epi8(rgba, zero);
+        const __m128i hi = _mm_unpackhi_epi8(rgba, zero);
+
+        const __m128i result = _mm_packus_epi16(premultiply8x16(lo, broadcast_alpha(lo, alpha_index)),
+                                                premultiply8x16(hi, broadcast_alpha(hi, alpha_index)));
+
+        /* Keep the original alpha. */
+        _mm_storeu_si128((__m128i *)(pixels + x * 4),
+                         _mm_or_si128(_mm_andnot_si128(alpha_mask, result), _mm_and_si128(alpha_mask, rgba)));
+    }
+
+    convert_premultiply_scalar(pixels + x * 4, alpha_index, width - x);
+}
+
+void convert_cmyk_sse2(const uint8_t *src, uint8_t *dst, bool inverted, unsigned width) {
+
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i flip = inverted ? _mm_setzero_si128() : _mm_set1_epi8((char)0xFF);
+    const __m128i alpha_mask = _mm_set1_epi32((int)0xFF000000U);
+    unsigned x = 0;
+
+    /* Multiplying C, M, and Y by K is premultiplication by alpha stored in the last byte. */
+    for (; x + 4 <= width; x += 4) {
+        const __m128i cmyk = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(src + x * 4)), flip);
+        const __m128i lo = _mm_unpacklo_epi8(cmyk, zero);
+        const __m128i hi = _mm_unpackhi_epi8(cmyk, zero);
+
+        const __m128i result = _mm_packus_epi16(premultiply8x16(lo, broadcast_alpha(lo, 3)),
+                                                premultiply8x16(hi, broadcast_alpha(hi, 3)));
+
+        _mm_storeu_si128((__m128i *)(dst + x * 4), _mm_or_si128(result, alpha_mask));
+    }
+
+    convert_cmyk_scalar(src + x * 4, dst + x * 4, inverted, width - x);
+}
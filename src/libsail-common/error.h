@@ -54,6 +54,7 @@ enum SailStatus {
     SAIL_ERROR_NOT_IMPLEMENTED,
     SAIL_ERROR_UNSUPPORTED_SEEK_WHENCE,
     SAIL_ERROR_EMPTY_STRING,
+    SAIL_ERROR_ALLOCATOR_IN_USE,
 
     /*
      * Encoding/decoding common errors.
@@ -119,6 +120,8 @@ enum SailStatus {
     SAIL_ERROR_ENV_UPDATE,
     SAIL_ERROR_CONTEXT_UNINITIALIZED,
     SAIL_ERROR_GET_DLL_PATH,
+    SAIL_ERROR_SHARED_CONTEXT_READ_ONLY,
+    SAIL_ERROR_START_THREAD,
 };
 
 typedef enum SailStatus sail_status_t;
@@ -61,7 +61,7 @@ void sail_destroy_image(struct sail_image *image) {
         return;
     }
 
-    sail_free(image->pixels);
+    sail_free_pixels(image->pixels);
 
     sail_destroy_resolution(image->resolution);
     sail_destroy_palette(image->palette);
@@ -83,7 +83,7 @@ sail_status_t sail_copy_image(const struct sail_image *source, struct sail_image
     SAIL_TRY(sail_alloc_image(target));
 
     if (source->pixels != NULL) {
-        SAIL_TRY_OR_CLEANUP(sail_malloc(pixels_size, &(*target)->pixels),
+        SAIL_TRY_OR_CLEANUP(sail_malloc_pixels(pixels_size, &(*target)->pixels),
                             /* cleanup */ sail_destroy_image(*target));
 
         memcpy((*target)->pixels, source->pixels, pixels_size);
@@ -127,3 +127,59 @@ sail_status_t sail_copy_image(const struct sail_image *source, struct sail_image
 
     return SAIL_OK;
 }
+
+sail_status_t sail_crop_image(const struct sail_image *source, unsigned x, unsigned y,
+                              unsigned width, unsigned height, struct sail_image **target) {
+
+    SAIL_CHECK_IMAGE(source);
+    SAIL_CHECK_PIXELS_PTR(source->pixels);
+    SAIL_CHECK_IMAGE_PTR(target);
+
+    if (width == 0 || height == 0 || x >= source->width || y >= source->height ||
+            width > source->width - x || height > source->height - y) {
+        SAIL_LOG_ERROR("Crop rectangle %u,%u %ux%u is outside of the %ux%u image", x, y, width, height, source->width, source->height);
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_INCORRECT_IMAGE_DIMENSIONS);
+    }
+
+    unsigned bits_per_pixel;
+    SAIL_TRY(sail_bits_per_pixel(source->pixel_format, &bits_per_pixel));
+
+    /* Copy everything except pixels. */
+    struct sail_image image_skeleton = *source;
+    image_skeleton.pixels = NULL;
+
+    struct sail_image *image_local;
+    SAIL_TRY(sail_copy_image(&image_skeleton, &image_local));
+
+    image_local->width  = width;
+    image_local->height = height;
+
+    SAIL_TRY_OR_CLEANUP(sail_bytes_per_line(width, image_local->pixel_format, &image_local->bytes_per_line),
+                        /* cleanup */ sail_destroy_image(image_local));
+    SAIL_TRY_OR_CLEANUP(sail_malloc_pixels((size_t)image_local->bytes_per_line * height, &image_local->pixels),
+                        /* cleanup */ sail_destroy_image(image_local));
+
+    const size_t first_bit = (size_t)x * bits_per_pixel;
+
+    for (unsigned row = 0; row < height; row++) {
+        const unsigned char *src = (const unsigned char *)source->pixels + (size_t)(y + row) * source->bytes_per_line + first_bit / 8;
+        unsigned char *dst = (unsigned char *)image_local->pixels + (size_t)row * image_local->bytes_per_line;
+
+        if (first_bit % 8 == 0) {
+            memcpy(dst, src, image_local->bytes_per_line);
+        } else {
+            /* Pixels smaller than a byte starting in the middle of a byte. Shift them to the left. */
+            const unsigned shift = (unsigned)(first_bit % 8);
+            const size_t src_length = ((size_t)(x + width) * bits_per_pixel + 7) / 8 - first_bit / 8;
+
+            for (unsigned i = 0; i < image_local->bytes_per_line; i++) {
+                const unsigned next = (i + 1 < src_length) ? src[i + 1] : 0;
+                dst[i] = (unsigned char)((src[i] << shift) | (next >> (8 - shift)));
+            }
+        }
+    }
+
+    *target = image_local;
+
+    return SAIL_OK;
+}
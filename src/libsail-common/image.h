@@ -55,8 +55,9 @@ struct sail_image {
     /*
      * Image pixels.
      *
-     * READ:  Set by SAIL to an allocated array of pixels.
-     * WRITE: Must be set by a caller to an allocated array of pixels.
+     * READ:  Set by SAIL to an array of pixels allocated with sail_malloc_pixels().
+     * WRITE: Must be set by a caller to an allocated array of pixels. sail_destroy_image() frees it
+     *        with sail_free_pixels(), so allocate it with sail_malloc_pixels().
      */
     void *pixels;
 
@@ -203,6 +204,16 @@ SAIL_EXPORT void sail_destroy_image(struct sail_image *image);
  */
 SAIL_EXPORT sail_status_t sail_copy_image(const struct sail_image *source, struct sail_image **target);
 
+/*
+ * Copies the specified rectangle of the image into a new image. The rectangle must lie within the image.
+ * The output image has no padding. All the other image properties are copied as is. The assigned image
+ * MUST be destroyed later with sail_destroy_image().
+ *
+ * Returns SAIL_OK on success.
+ */
+SAIL_EXPORT sail_status_t sail_crop_image(const struct sail_image *source, unsigned x, unsigned y,
+                                          unsigned width, unsigned height, struct sail_image **target);
+
 /* extern "C" */
 #ifdef __cplusplus
 }
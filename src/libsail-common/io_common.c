@@ -48,6 +48,7 @@ sail_status_t sail_alloc_io(struct sail_io **io) {
     (*io)->flush          = NULL;
     (*io)->close          = NULL;
     (*io)->eof            = NULL;
+    (*io)->buffer         = NULL;
 
     return SAIL_OK;
 }
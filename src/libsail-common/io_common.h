@@ -115,16 +115,27 @@ typedef sail_status_t (*sail_io_close_t)(void *stream);
 typedef sail_status_t (*sail_io_eof_t)(void *stream, bool *result);
 
 /*
- * Well-known I/O ids used in libsail for file and memory I/O classes.
+ * Assigns the whole underlying contiguous memory buffer and its length. Codecs may use it
+ * to consume the data directly without intermediate copies. The buffer is owned by the I/O object
+ * and is valid until the I/O object is closed.
+ *
+ * Returns SAIL_OK on success.
+ */
+typedef sail_status_t (*sail_io_buffer_t)(void *stream, const void **buffer, size_t *buffer_length);
+
+/*
+ * Well-known I/O ids used in libsail for file, memory, and memory-mapped file I/O classes.
  *
  * You MUST use your own unique id for custom I/O classes. For example, you can use sail_hash()
  * to generate a unique id and store it in the source code.
  *
  * SAIL_FILE_IO_ID   = sail_hash("sail-file-io-id")
  * SAIL_MEMORY_IO_ID = sail_hash("sail-memory-io-id")
+ * SAIL_MMAP_IO_ID   = sail_hash("sail-mmap-io-id")
  */
 static const uint64_t SAIL_FILE_IO_ID   = UINT64_C(5820790535323209114);
 static const uint64_t SAIL_MEMORY_IO_ID = UINT64_C(11955407548648566675);
+static const uint64_t SAIL_MMAP_IO_ID   = UINT64_C(5821120586751770661);
 
 /*
  * A structure representing an input/output abstraction. Use sail_alloc_io_read_file() and brothers to
@@ -191,6 +202,12 @@ struct sail_io {
      * EOF callback.
      */
     sail_io_eof_t eof;
+
+    /*
+     * Contiguous buffer callback. Optional. Set by memory and memory-mapped file I/O classes only.
+     * Custom I/O classes may leave it NULL.
+     */
+    sail_io_buffer_t buffer;
 };
 
 typedef struct sail_io sail_io_t;
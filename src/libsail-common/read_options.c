@@ -39,6 +39,13 @@ sail_status_t sail_alloc_read_options(struct sail_read_options **read_options) {
 
     (*read_options)->output_pixel_format = SAIL_PIXEL_FORMAT_UNKNOWN;
     (*read_options)->io_options          = 0;
+    (*read_options)->target_width        = 0;
+    (*read_options)->target_height       = 0;
+    (*read_options)->threads             = 0;
+    (*read_options)->crop_x              = 0;
+    (*read_options)->crop_y              = 0;
+    (*read_options)->crop_width          = 0;
+    (*read_options)->crop_height         = 0;
 
     return SAIL_OK;
 }
@@ -73,6 +80,14 @@ sail_status_t sail_read_options_from_features(const struct sail_read_features *r
         read_options->io_options |= SAIL_IO_OPTION_ICCP;
     }
 
+    read_options->target_width  = 0;
+    read_options->target_height = 0;
+    read_options->threads       = 0;
+    read_options->crop_x        = 0;
+    read_options->crop_y        = 0;
+    read_options->crop_width    = 0;
+    read_options->crop_height   = 0;
+
     return SAIL_OK;
 }
 
@@ -100,3 +115,30 @@ sail_status_t sail_copy_read_options(const struct sail_read_options *source, str
 
     return SAIL_OK;
 }
+
+sail_status_t sail_read_options_crop_rectangle(const struct sail_read_options *read_options,
+                                                unsigned width, unsigned height,
+                                                unsigned *x, unsigned *y,
+                                                unsigned *crop_width, unsigned *crop_height) {
+
+    SAIL_CHECK_READ_OPTIONS_PTR(read_options);
+    SAIL_CHECK_RESULT_PTR(x);
+    SAIL_CHECK_RESULT_PTR(y);
+    SAIL_CHECK_RESULT_PTR(crop_width);
+    SAIL_CHECK_RESULT_PTR(crop_height);
+
+    if (read_options->crop_x >= width || read_options->crop_y >= height) {
+        SAIL_LOG_ERROR("Crop origin %u,%u is outside of the %ux%u image", read_options->crop_x, read_options->crop_y, width, height);
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_INCORRECT_IMAGE_DIMENSIONS);
+    }
+
+    const unsigned max_width  = width - read_options->crop_x;
+    const unsigned max_height = height - read_options->crop_y;
+
+    *x           = read_options->crop_x;
+    *y           = read_options->crop_y;
+    *crop_width  = (read_options->crop_width == 0 || read_options->crop_width > max_width) ? max_width : read_options->crop_width;
+    *crop_height = (read_options->crop_height == 0 || read_options->crop_height > max_height) ? max_height : read_options->crop_height;
+
+    return SAIL_OK;
+}
@@ -48,11 +48,43 @@ struct sail_read_options {
      * can be obtained from sail_read_features.output_pixel_formats.
      *
      * The BPP32-RGBA and BPP32-BGRA output pixel formats are always supported.
+     *
+     * Other pixel formats supported by sail_convert_image() are also accepted. The codec reads them as BPP32-RGBA,
+     * and SAIL converts every frame after reading. Such frames cannot be streamed with sail_start_reading_rows()
+     * or read into a caller buffer with sail_read_next_frame_into_buffer().
      */
     enum SailPixelFormat output_pixel_format;
 
     /* Or-ed IO manipulation options. See SailIoOption. */
     int io_options;
+
+    /*
+     * Request to decode a downscaled image. Codecs with the SAIL_CODEC_FEATURE_SCALING read feature
+     * decode images at the smallest supported scale that still covers the target size, so the output
+     * image may be larger than requested. Other codecs ignore the target size. 0 means no limit
+     * for the dimension. The default is 0x0, i.e. no downscaling.
+     */
+    unsigned target_width;
+    unsigned target_height;
+
+    /*
+     * Number of threads codecs with the SAIL_CODEC_FEATURE_MULTI_THREADED read feature may use
+     * to decode a frame. Other codecs ignore it. 0 and 1 mean decoding in the calling thread only.
+     * The default is 0.
+     */
+    unsigned threads;
+
+    /*
+     * Request to decode a region of interest. The rectangle is applied to the output image, i.e. after
+     * downscaling, and is clipped to the image. 0 width or height means up to the right or bottom edge.
+     * Codecs with the SAIL_CODEC_FEATURE_CROP read feature decode only the data covering the rectangle.
+     * For other codecs SAIL decodes whole frames and crops them after reading. Such frames cannot be read
+     * into a caller buffer with sail_read_next_frame_into_buffer(). The default is 0,0 0x0, i.e. no cropping.
+     */
+    unsigned crop_x;
+    unsigned crop_y;
+    unsigned crop_width;
+    unsigned crop_height;
 };
 
 typedef struct sail_read_options sail_read_options_t;
@@ -94,6 +126,17 @@ SAIL_EXPORT sail_status_t sail_alloc_read_options_from_features(const struct sai
  */
 SAIL_EXPORT sail_status_t sail_copy_read_options(const struct sail_read_options *source, struct sail_read_options **target);
 
+/*
+ * Clips the crop rectangle of the specified read options to the image dimensions and assigns
+ * the resulting rectangle. Assigns the whole image when no cropping is requested.
+ *
+ * Returns SAIL_OK on success or SAIL_ERROR_INCORRECT_IMAGE_DIMENSIONS when the rectangle is outside of the image.
+ */
+SAIL_EXPORT sail_status_t sail_read_options_crop_rectangle(const struct sail_read_options *read_options,
+                                                            unsigned width, unsigned height,
+                                                            unsigned *x, unsigned *y,
+                                                            unsigned *crop_width, unsigned *crop_height);
+
 /* extern "C" */
 #ifdef __cplusplus
 }
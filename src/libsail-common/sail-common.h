@@ -32,6 +32,7 @@
     #include "config.h"
 
     #include "common.h"
+    #include "convert.h"
     #include "error.h"
     #include "export.h"
     #include "iccp.h"
@@ -45,6 +46,7 @@
     #include "read_options.h"
     #include "resolution.h"
     #include "source_image.h"
+    #include "thread_pool.h"
     #include "utils.h"
     #include "write_features.h"
     #include "write_options.h"
@@ -52,6 +54,7 @@
     #include <sail-common/config.h>
 
     #include <sail-common/common.h>
+    #include <sail-common/convert.h>
     #include <sail-common/error.h>
     #include <sail-common/export.h>
     #include <sail-common/iccp.h>
@@ -65,6 +68,7 @@
     #include <sail-common/read_options.h>
     #include <sail-common/resolution.h>
     #include <sail-common/source_image.h>
+    #include <sail-common/thread_pool.h>
     #include <sail-common/utils.h>
     #include <sail-common/write_features.h>
     #include <sail-common/write_options.h>
@@ -0,0 +1,556 @@
+/*  This file is part of SAIL (https://github.com/smoked-herring/sail)
+
+    Copyright (c) 2020 Dmitry Baryshev
+
+    The MIT License
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "config.h"
+
+#include <stdbool.h>
+
+#ifdef SAIL_WIN32
+    #include <windows.h>
+#else
+    #include <pthread.h>
+#endif
+
+#include "sail-common.h"
+
+/* Upper limit of pool threads. */
+#define SAIL_THREAD_POOL_MAX_THREADS 256
+
+/* Initial number of task slots. The ring grows when it's full. */
+#define SAIL_THREAD_POOL_INITIAL_SLOTS 16
+
+#ifdef SAIL_WIN32
+typedef SRWLOCK pool_lock_t;
+typedef CONDITION_VARIABLE pool_condition_t;
+typedef HANDLE pool_thread_t;
+#else
+typedef pthread_mutex_t pool_lock_t;
+typedef pthread_cond_t pool_condition_t;
+typedef pthread_t pool_thread_t;
+#endif
+
+struct pool_worker {
+    struct sail_thread_pool *pool;
+    pool_thread_t thread;
+    /* Index passed to jobs. 0 is reserved for the calling thread. */
+    unsigned index;
+};
+
+struct pool_slot {
+    sail_thread_pool_task_t run_task;
+    void *task;
+    sail_status_t status;
+    bool finished;
+};
+
+struct sail_thread_pool {
+    struct pool_worker *workers;
+    unsigned threads;
+
+    sail_thread_pool_hook_t thread_started;
+    sail_thread_pool_hook_t thread_stopped;
+    void *user_data;
+
+    /* Protects the fields below. */
+    pool_lock_t lock;
+    /* Signaled when a batch is started, a task is submitted, or the threads must quit. */
+    pool_condition_t work_available;
+    /* Signaled when a task is finished, or the last thread has finished the current batch. */
+    pool_condition_t work_finished;
+    bool quit;
+
+    /* Current batch of jobs. */
+    unsigned long batch;
+    unsigned active_workers;
+    sail_thread_pool_job_t job;
+    void *context;
+    unsigned job_count;
+    unsigned next_job;
+    sail_status_t batch_status;
+
+    /*
+     * Ring of tasks. Tasks [taken, started) are being executed or finished, [started, submitted) are waiting.
+     * Task N is stored in the slot N % slots_count.
+     */
+    struct pool_slot *slots;
+    unsigned slots_count;
+    unsigned long submitted;
+    unsigned long started;
+    unsigned long taken;
+};
+
+/*
+ * Private functions.
+ */
+
+static void init_lock(pool_lock_t *lock) {
+
+#ifdef SAIL_WIN32
+    InitializeSRWLock(lock);
+#else
+    pthread_mutex_init(lock, NULL);
+#endif
+}
+
+static void destroy_lock(pool_lock_t *lock) {
+
+#ifdef SAIL_WIN32
+    (void)lock;
+#else
+    pthread_mutex_destroy(lock);
+#endif
+}
+
+static void lock(pool_lock_t *lock) {
+
+#ifdef SAIL_WIN32
+    AcquireSRWLockExclusive(lock);
+#else
+    pthread_mutex_lock(lock);
+#endif
+}
+
+static void unlock(pool_lock_t *lock) {
+
+#ifdef SAIL_WIN32
+    ReleaseSRWLockExclusive(lock);
+#else
+    pthread_mutex_unlock(lock);
+#endif
+}
+
+static void init_condition(pool_condition_t *condition) {
+
+#ifdef SAIL_WIN32
+    InitializeConditionVariable(condition);
+#else
+    pthread_cond_init(condition, NULL);
+#endif
+}
+
+static void destroy_condition(pool_condition_t *condition) {
+
+#ifdef SAIL_WIN32
+    (void)condition;
+#else
+    pthread_cond_destroy(condition);
+#endif
+}
+
+static void wait_condition(pool_condition_t *condition, pool_lock_t *lock) {
+
+#ifdef SAIL_WIN32
+    SleepConditionVariableSRW(condition, lock, INFINITE, 0);
+#else
+    pthread_cond_wait(condition, lock);
+#endif
+}
+
+static void signal_condition(pool_condition_t *condition) {
+
+#ifdef SAIL_WIN32
+    WakeAllConditionVariable(condition);
+#else
+    pthread_cond_broadcast(condition);
+#endif
+}
+
+/* Executes jobs of the current batch until there are no more jobs or some job has failed. */
+static void run_jobs(struct sail_thread_pool *pool, unsigned worker) {
+
+    for (;;) {
+        lock(&pool->lock);
+
+        if (pool->batch_status != SAIL_OK || pool->next_job == pool->job_count) {
+            unlock(&pool->lock);
+            break;
+        }
+
+        const unsigned job = pool->next_job++;
+
+        unlock(&pool->lock);
+
+        const sail_status_t status = pool->job(pool->context, job, worker);
+
+        if (status != SAIL_OK) {
+            lock(&pool->lock);
+
+            if (pool->batch_status == SAIL_OK) {
+                pool->batch_status = status;
+            }
+
+            unlock(&pool->lock);
+            break;
+        }
+    }
+}
+
+static void run_worker(struct pool_worker *worker) {
+
+    struct sail_thread_pool *pool = worker->pool;
+    unsigned long batch = 0;
+
+    if (pool->thread_started != NULL) {
+        pool->thread_started(pool->user_data);
+    }
+
+    lock(&pool->lock);
+
+    for (;;) {
+        while (!pool->quit && pool->batch == batch && pool->started == pool->submitted) {
+            wait_condition(&pool->work_available, &pool->lock);
+        }
+
+        if (pool->quit) {
+            break;
+        }
+
+        if (pool->batch != batch) {
+            batch = pool->batch;
+
+            unlock(&pool->lock);
+            run_jobs(pool, worker->index);
+            lock(&pool->lock);
+
+            if (--pool->active_workers == 0) {
+                signal_condition(&pool->work_finished);
+            }
+
+            continue;
+        }
+
+        /* The ring may be reallocated while the task is executed, so keep its number and not the slot. */
+        const unsigned long task_number = pool->started++;
+        const struct pool_slot *slot = &pool->slots[task_number % pool->slots_count];
+        const sail_thread_pool_task_t run_task = slot->run_task;
+        void *task = slot->task;
+
+        unlock(&pool->lock);
+        const sail_status_t status = run_task(task);
+        lock(&pool->lock);
+
+        struct pool_slot *finished_slot = &pool->slots[task_number % pool->slots_count];
+        finished_slot->status   = status;
+        finished_slot->finished = true;
+
+        signal_condition(&pool->work_finished);
+    }
+
+    unlock(&pool->lock);
+
+    if (pool->thread_stopped != NULL) {
+        pool->thread_stopped(pool->user_data);
+    }
+}
+
+#ifdef SAIL_WIN32
+static DWORD WINAPI worker_thread(LPVOID arg) {
+
+    run_worker(arg);
+
+    return 0;
+}
+#else
+static void *worker_thread(void *arg) {
+
+    run_worker(arg);
+
+    return NULL;
+}
+#endif
+
+/* Stops and joins the first started threads. */
+static void stop_threads(struct sail_thread_pool *pool, unsigned started) {
+
+    lock(&pool->lock);
+    pool->quit = true;
+    signal_condition(&pool->work_available);
+    unlock(&pool->lock);
+
+    for (unsigned i = 0; i < started; i++) {
+#ifdef SAIL_WIN32
+        WaitForSingleObject(pool->workers[i].thread, INFINITE);
+        CloseHandle(pool->workers[i].thread);
+#else
+        pthread_join(pool->workers[i].thread, NULL);
+#endif
+    }
+}
+
+static void destroy_pool(struct sail_thread_pool *pool) {
+
+    destroy_lock(&pool->lock);
+    destroy_condition(&pool->work_available);
+    destroy_condition(&pool->work_finished);
+
+    sail_free(pool->slots);
+    sail_free(pool->workers);
+    sail_free(pool);
+}
+
+/* Doubles the ring of tasks. Must be called under the lock. */
+static sail_status_t grow_slots(struct sail_thread_pool *pool) {
+
+    const unsigned slots_count = pool->slots_count * 2;
+
+    void *ptr;
+    SAIL_TRY(sail_malloc(sizeof(struct pool_slot) * slots_count, &ptr));
+    struct pool_slot *slots = ptr;
+
+    for (unsigned long i = pool->taken; i < pool->submitted; i++) {
+        slots[i % slots_count] = pool->slots[i % pool->slots_count];
+    }
+
+    sail_free(pool->slots);
+
+    pool->slots       = slots;
+    pool->slots_count = slots_count;
+
+    return SAIL_OK;
+}
+
+/*
+ * Public functions.
+ */
+
+sail_status_t sail_alloc_thread_pool(unsigned threads, struct sail_thread_pool **pool) {
+
+    SAIL_TRY(sail_alloc_thread_pool_with_hooks(threads, NULL, NULL, NULL, pool));
+
+    return SAIL_OK;
+}
+
+sail_status_t sail_alloc_thread_pool_with_hooks(unsigned threads,
+                                                sail_thread_pool_hook_t thread_started,
+                                                sail_thread_pool_hook_t thread_stopped,
+                                                void *user_data,
+                                                struct sail_thread_pool **pool) {
+
+    SAIL_CHECK_PTR(pool);
+
+    if (threads > SAIL_THREAD_POOL_MAX_THREADS) {
+        threads = SAIL_THREAD_POOL_MAX_THREADS;
+    }
+
+    void *ptr;
+    SAIL_TRY(sail_malloc(sizeof(struct sail_thread_pool), &ptr));
+    struct sail_thread_pool *pool_local = ptr;
+
+    pool_local->workers = NULL;
+
+    if (threads > 0) {
+        SAIL_TRY_OR_CLEANUP(sail_malloc(sizeof(struct pool_worker) * threads, &ptr),
+                            /* cleanup */ sail_free(pool_local));
+        pool_local->workers = ptr;
+    }
+
+    SAIL_TRY_OR_CLEANUP(sail_malloc(sizeof(struct pool_slot) * SAIL_THREAD_POOL_INITIAL_SLOTS, &ptr),
+                        /* cleanup */ sail_free(pool_local->workers),
+                                      sail_free(pool_local));
+    pool_local->slots = ptr;
+
+    pool_local->threads        = threads;
+    pool_local->thread_started = thread_started;
+    pool_local->thread_stopped = thread_stopped;
+    pool_local->user_data      = user_data;
+    pool_local->quit           = false;
+    pool_local->batch          = 0;
+    pool_local->active_workers = 0;
+    pool_local->job            = NULL;
+    pool_local->context        = NULL;
+    pool_local->job_count      = 0;
+    pool_local->next_job       = 0;
+    pool_local->batch_status   = SAIL_OK;
+    pool_local->slots_count    = SAIL_THREAD_POOL_INITIAL_SLOTS;
+    pool_local->submitted      = 0;
+    pool_local->started        = 0;
+    pool_local->taken          = 0;
+
+    init_lock(&pool_local->lock);
+    init_condition(&pool_local->work_available);
+    init_condition(&pool_local->work_finished);
+
+    for (unsigned i = 0; i < threads; i++) {
+        struct pool_worker *worker = &pool_local->workers[i];
+
+        worker->pool  = pool_local;
+        worker->index = i + 1;
+
+#ifdef SAIL_WIN32
+        worker->thread = CreateThread(NULL, 0, worker_thread, worker, 0, NULL);
+        const bool started = worker->thread != NULL;
+#else
+        const bool started = pthread_create(&worker->thread, NULL, worker_thread, worker) == 0;
+#endif
+
+        if (!started) {
+            SAIL_LOG_ERROR("Failed to start thread pool thread #%u", i);
+            stop_threads(pool_local, i);
+            destroy_pool(pool_local);
+            SAIL_LOG_AND_RETURN(SAIL_ERROR_START_THREAD);
+        }
+    }
+
+    SAIL_LOG_DEBUG("Started thread pool with %u threads", threads);
+
+    *pool = pool_local;
+
+    return SAIL_OK;
+}
+
+void sail_destroy_thread_pool(struct sail_thread_pool *pool) {
+
+    if (pool == NULL) {
+        return;
+    }
+
+    stop_threads(pool, pool->threads);
+    destroy_pool(pool);
+}
+
+unsigned sail_thread_pool_threads(const struct sail_thread_pool *pool) {
+
+    return pool->threads;
+}
+
+sail_status_t sail_thread_pool_run(struct sail_thread_pool *pool, unsigned job_count,
+                                   sail_thread_pool_job_t job, void *context) {
+
+    SAIL_CHECK_PTR(pool);
+    SAIL_CHECK_PTR(job);
+
+    lock(&pool->lock);
+
+    if (pool->submitted != pool->taken) {
+        unlock(&pool->lock);
+        SAIL_LOG_ERROR("Thread pool cannot run jobs while submitted tasks are not taken back");
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_INVALID_ARGUMENT);
+    }
+
+    pool->job          = job;
+    pool->context      = context;
+    pool->job_count    = job_count;
+    pool->next_job     = 0;
+    pool->batch_status = SAIL_OK;
+
+    /* A single job is executed by the calling thread without waking up the pool. */
+    if (pool->threads > 0 && job_count > 1) {
+        pool->active_workers = pool->threads;
+        pool->batch++;
+
+        signal_condition(&pool->work_available);
+    }
+
+    unlock(&pool->lock);
+
+    run_jobs(pool, 0);
+
+    lock(&pool->lock);
+
+    while (pool->active_workers > 0) {
+        wait_condition(&pool->work_finished, &pool->lock);
+    }
+
+    const sail_status_t status = pool->batch_status;
+
+    unlock(&pool->lock);
+
+    return status;
+}
+
+sail_status_t sail_thread_pool_submit(struct sail_thread_pool *pool, sail_thread_pool_task_t run_task, void *task) {
+
+    SAIL_CHECK_PTR(pool);
+    SAIL_CHECK_PTR(run_task);
+
+    /* No threads to execute the task. */
+    const bool run_now = pool->threads == 0;
+    const sail_status_t status = run_now ? run_task(task) : SAIL_OK;
+
+    lock(&pool->lock);
+
+    if (pool->submitted - pool->taken == pool->slots_count) {
+        SAIL_TRY_OR_CLEANUP(grow_slots(pool),
+                            /* cleanup */ unlock(&pool->lock));
+    }
+
+    struct pool_slot *slot = &pool->slots[pool->submitted++ % pool->slots_count];
+
+    slot->run_task = run_task;
+    slot->task     = task;
+    slot->status   = status;
+    slot->finished = run_now;
+
+    if (run_now) {
+        pool->started++;
+    } else {
+        signal_condition(&pool->work_available);
+    }
+
+    unlock(&pool->lock);
+
+    return SAIL_OK;
+}
+
+sail_status_t sail_thread_pool_take(struct sail_thread_pool *pool, bool wait, void **task) {
+
+    SAIL_CHECK_PTR(pool);
+    SAIL_CHECK_PTR(task);
+
+    *task = NULL;
+
+    lock(&pool->lock);
+
+    if (pool->taken == pool->submitted) {
+        unlock(&pool->lock);
+        return SAIL_OK;
+    }
+
+    const unsigned long task_number = pool->taken;
+
+    while (wait && !pool->slots[task_number % pool->slots_count].finished) {
+        wait_condition(&pool->work_finished, &pool->lock);
+    }
+
+    struct pool_slot *slot = &pool->slots[task_number % pool->slots_count];
+    sail_status_t status = SAIL_OK;
+
+    if (slot->finished) {
+        *task  = slot->task;
+        status = slot->status;
+
+        slot->finished = false;
+        pool->taken++;
+    }
+
+    unlock(&pool->lock);
+
+    return status;
+}
+
+unsigned sail_thread_pool_queued(const struct sail_thread_pool *pool) {
+
+    return (unsigned)(pool->submitted - pool->taken);
+}
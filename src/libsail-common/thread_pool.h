@@ -0,0 +1,139 @@
+/*  This file is part of SAIL (https://github.com/smoked-herring/sail)
+
+    Copyright (c) 2020 Dmitry Baryshev
+
+    The MIT License
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#ifndef SAIL_THREAD_POOL_H
+#define SAIL_THREAD_POOL_H
+
+#include <stdbool.h>
+
+#ifdef SAIL_BUILD
+    #include "error.h"
+    #include "export.h"
+#else
+    #include <sail-common/error.h>
+    #include <sail-common/export.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Pool of worker threads. The threads are started once and stay alive until the pool is destroyed,
+ * so the pool could be reused by many runs without spawning new threads.
+ *
+ * The pool executes either batches of indexed jobs with sail_thread_pool_run(), or tasks submitted
+ * with sail_thread_pool_submit() and taken back in order with sail_thread_pool_take().
+ * A pool MUST NOT be used by multiple threads simultaneously, and MUST NOT run a batch while
+ * submitted tasks are not taken back.
+ */
+struct sail_thread_pool;
+
+/*
+ * Job executed by sail_thread_pool_run(). The worker is the index of the thread executing the job:
+ * 0 for the calling thread, and [1, threads] for the pool threads. Workers never execute jobs
+ * concurrently with themselves, so the index could be used to access per-thread data.
+ */
+typedef sail_status_t (*sail_thread_pool_job_t)(void *context, unsigned job, unsigned worker);
+
+/*
+ * Task executed by sail_thread_pool_submit().
+ */
+typedef sail_status_t (*sail_thread_pool_task_t)(void *task);
+
+/*
+ * Called in every pool thread when it's started or stopped.
+ */
+typedef void (*sail_thread_pool_hook_t)(void *user_data);
+
+/*
+ * Allocates a new thread pool and starts the specified number of threads. 0 threads is allowed,
+ * then jobs and tasks are executed by the calling thread. The assigned pool MUST be destroyed later
+ * with sail_destroy_thread_pool().
+ *
+ * Returns SAIL_OK on success.
+ */
+SAIL_EXPORT sail_status_t sail_alloc_thread_pool(unsigned threads, struct sail_thread_pool **pool);
+
+/*
+ * Allocates a new thread pool like sail_alloc_thread_pool(). Additionally, every pool thread calls
+ * thread_started when it's started, and thread_stopped before it exits. The hooks could be NULL.
+ *
+ * Returns SAIL_OK on success.
+ */
+SAIL_EXPORT sail_status_t sail_alloc_thread_pool_with_hooks(unsigned threads,
+                                                            sail_thread_pool_hook_t thread_started,
+                                                            sail_thread_pool_hook_t thread_stopped,
+                                                            void *user_data,
+                                                            struct sail_thread_pool **pool);
+
+/*
+ * Stops the threads and destroys the specified thread pool. Tasks not taken back are discarded.
+ * Does nothing if the pool is NULL.
+ */
+SAIL_EXPORT void sail_destroy_thread_pool(struct sail_thread_pool *pool);
+
+/*
+ * Returns the number of the pool threads.
+ */
+SAIL_EXPORT unsigned sail_thread_pool_threads(const struct sail_thread_pool *pool);
+
+/*
+ * Executes jobs [0, job_count) in the pool threads and the calling thread. Blocks until all the jobs
+ * are finished. Stops taking new jobs when a job fails.
+ *
+ * Returns SAIL_OK on success. Returns the status of the first failed job otherwise.
+ */
+SAIL_EXPORT sail_status_t sail_thread_pool_run(struct sail_thread_pool *pool, unsigned job_count,
+                                               sail_thread_pool_job_t job, void *context);
+
+/*
+ * Queues the task to be executed by the pool threads. Tasks are started in the order they were
+ * submitted and executed concurrently. Executes the task in the calling thread if the pool
+ * has no threads.
+ *
+ * Returns SAIL_OK on success.
+ */
+SAIL_EXPORT sail_status_t sail_thread_pool_submit(struct sail_thread_pool *pool, sail_thread_pool_task_t run_task, void *task);
+
+/*
+ * Takes back the oldest submitted task. When wait is false and the task is not finished yet,
+ * or when there are no submitted tasks, sets the task to NULL.
+ *
+ * Returns the status of the task.
+ */
+SAIL_EXPORT sail_status_t sail_thread_pool_take(struct sail_thread_pool *pool, bool wait, void **task);
+
+/*
+ * Returns the number of submitted tasks not taken back.
+ */
+SAIL_EXPORT unsigned sail_thread_pool_queued(const struct sail_thread_pool *pool);
+
+/* extern "C" */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
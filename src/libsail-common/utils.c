@@ -45,6 +45,99 @@
 
 #include "sail-common.h"
 
+/*
+ * Private functions.
+ */
+
+static void* default_malloc(void *context, size_t size) {
+
+    (void)context;
+
+    return malloc(size);
+}
+
+static void* default_realloc(void *context, void *ptr, size_t size) {
+
+    (void)context;
+
+    return realloc(ptr, size);
+}
+
+static void default_free(void *context, void *ptr) {
+
+    (void)context;
+
+    free(ptr);
+}
+
+static struct sail_allocator sail_current_allocator = { default_malloc, default_realloc, default_free, NULL };
+
+static struct sail_allocator sail_current_pixels_allocator = { default_malloc, default_realloc, default_free, NULL };
+static bool sail_custom_pixels_allocator = false;
+
+/*
+ * Set by the first allocation. Memory allocated by one allocator cannot be freed by another one,
+ * so the allocators cannot be changed after that. Allocations happen in any thread, so the flag
+ * is accessed atomically. Relaxed ordering is enough as it guards no other data.
+ */
+#ifdef SAIL_WIN32
+static volatile LONG sail_allocators_in_use = 0;
+
+static bool allocators_in_use(void) {
+
+    return InterlockedCompareExchange(&sail_allocators_in_use, 0, 0) != 0;
+}
+
+static void store_allocators_in_use(void) {
+
+    InterlockedExchange(&sail_allocators_in_use, 1);
+}
+#else
+static bool sail_allocators_in_use = false;
+
+static bool allocators_in_use(void) {
+
+    return __atomic_load_n(&sail_allocators_in_use, __ATOMIC_RELAXED);
+}
+
+static void store_allocators_in_use(void) {
+
+    __atomic_store_n(&sail_allocators_in_use, true, __ATOMIC_RELAXED);
+}
+#endif
+
+static void mark_allocators_in_use(void) {
+
+    /* Don't write the shared flag on every allocation. */
+    if (!allocators_in_use()) {
+        store_allocators_in_use();
+    }
+}
+
+static sail_status_t check_allocators_not_in_use(void) {
+
+    if (allocators_in_use()) {
+        SAIL_LOG_ERROR("Allocators cannot be changed after SAIL has allocated memory");
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_ALLOCATOR_IN_USE);
+    }
+
+    return SAIL_OK;
+}
+
+static sail_status_t check_allocator(const struct sail_allocator *allocator) {
+
+    if (allocator->malloc_func == NULL || allocator->realloc_func == NULL || allocator->free_func == NULL) {
+        SAIL_LOG_ERROR("All the allocator functions must be set");
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_INVALID_ARGUMENT);
+    }
+
+    return SAIL_OK;
+}
+
+/*
+ * Public functions.
+ */
+
 sail_status_t sail_memdup(const void *input, size_t input_size, void **output) {
 
     if (input == NULL) {
@@ -604,6 +697,10 @@ sail_status_t sail_codec_feature_to_string(enum SailCodecFeature codec_feature,
         case SAIL_CODEC_FEATURE_EXIF:        *result = "EXIF";        return SAIL_OK;
         case SAIL_CODEC_FEATURE_INTERLACED:  *result = "INTERLACED";  return SAIL_OK;
         case SAIL_CODEC_FEATURE_ICCP:        *result = "ICCP";        return SAIL_OK;
+        case SAIL_CODEC_FEATURE_SCALING:     *result = "SCALING";     return SAIL_OK;
+        case SAIL_CODEC_FEATURE_MULTI_THREADED: *result = "MULTI-THREADED"; return SAIL_OK;
+        case SAIL_CODEC_FEATURE_CROP:        *result = "CROP";        return SAIL_OK;
+        case SAIL_CODEC_FEATURE_TILED:       *result = "TILED";       return SAIL_OK;
     }
 
     SAIL_LOG_AND_RETURN(SAIL_ERROR_UNSUPPORTED_CODEC_FEATURE);
@@ -629,6 +726,10 @@ sail_status_t sail_codec_feature_from_string(const char *str, enum SailCodecFeat
         case UINT64_C(6384018865):           *result = SAIL_CODEC_FEATURE_EXIF;        return SAIL_OK;
         case UINT64_C(8244927930303708800):  *result = SAIL_CODEC_FEATURE_INTERLACED;  return SAIL_OK;
         case UINT64_C(6384139556):           *result = SAIL_CODEC_FEATURE_ICCP;        return SAIL_OK;
+        case UINT64_C(229439735470214):      *result = SAIL_CODEC_FEATURE_SCALING;     return SAIL_OK;
+        case UINT64_C(17446445482155656766): *result = SAIL_CODEC_FEATURE_MULTI_THREADED; return SAIL_OK;
+        case UINT64_C(6383940665):           *result = SAIL_CODEC_FEATURE_CROP;        return SAIL_OK;
+        case UINT64_C(210689875607):         *result = SAIL_CODEC_FEATURE_TILED;       return SAIL_OK;
     }
 
     SAIL_LOG_AND_RETURN(SAIL_ERROR_UNSUPPORTED_CODEC_FEATURE);
@@ -766,11 +867,53 @@ sail_status_t sail_print_errno(const char *format) {
     return SAIL_OK;
 }
 
+sail_status_t sail_set_allocator(const struct sail_allocator *allocator) {
+
+    SAIL_TRY(check_allocators_not_in_use());
+
+    if (allocator == NULL) {
+        sail_current_allocator.malloc_func  = default_malloc;
+        sail_current_allocator.realloc_func = default_realloc;
+        sail_current_allocator.free_func    = default_free;
+        sail_current_allocator.context      = NULL;
+    } else {
+        SAIL_TRY(check_allocator(allocator));
+
+        sail_current_allocator = *allocator;
+    }
+
+    /* Pixels follow the general allocator unless they have their own one. */
+    if (!sail_custom_pixels_allocator) {
+        sail_current_pixels_allocator = sail_current_allocator;
+    }
+
+    return SAIL_OK;
+}
+
+sail_status_t sail_set_pixels_allocator(const struct sail_allocator *allocator) {
+
+    SAIL_TRY(check_allocators_not_in_use());
+
+    if (allocator == NULL) {
+        sail_current_pixels_allocator = sail_current_allocator;
+        sail_custom_pixels_allocator  = false;
+    } else {
+        SAIL_TRY(check_allocator(allocator));
+
+        sail_current_pixels_allocator = *allocator;
+        sail_custom_pixels_allocator  = true;
+    }
+
+    return SAIL_OK;
+}
+
 sail_status_t sail_malloc(size_t size, void **ptr) {
 
     SAIL_CHECK_PTR(ptr);
 
-    *ptr = malloc(size);
+    mark_allocators_in_use();
+
+    *ptr = sail_current_allocator.malloc_func(sail_current_allocator.context, size);
 
     if (*ptr == NULL) {
         SAIL_LOG_AND_RETURN(SAIL_ERROR_MEMORY_ALLOCATION);
@@ -783,7 +926,9 @@ sail_status_t sail_realloc(size_t size, void **ptr) {
 
     SAIL_CHECK_PTR(ptr);
 
-    *ptr = realloc(*ptr, size);
+    mark_allocators_in_use();
+
+    *ptr = sail_current_allocator.realloc_func(sail_current_allocator.context, *ptr, size);
 
     if (*ptr == NULL) {
         SAIL_LOG_AND_RETURN(SAIL_ERROR_MEMORY_ALLOCATION);
@@ -796,18 +941,53 @@ sail_status_t sail_calloc(size_t nmemb, size_t size, void **ptr) {
 
     SAIL_CHECK_PTR(ptr);
 
-    *ptr = calloc(nmemb, size);
+    /* libc calloc() could get zeroed pages from the OS directly. */
+    if (sail_current_allocator.malloc_func == default_malloc) {
+        mark_allocators_in_use();
 
-    if (*ptr == NULL) {
+        *ptr = calloc(nmemb, size);
+
+        if (*ptr == NULL) {
+            SAIL_LOG_AND_RETURN(SAIL_ERROR_MEMORY_ALLOCATION);
+        }
+
+        return SAIL_OK;
+    }
+
+    if (size != 0 && nmemb > SIZE_MAX / size) {
         SAIL_LOG_AND_RETURN(SAIL_ERROR_MEMORY_ALLOCATION);
     }
 
+    SAIL_TRY(sail_malloc(nmemb * size, ptr));
+
+    memset(*ptr, 0, nmemb * size);
+
     return SAIL_OK;
 }
 
 void sail_free(void *ptr) {
 
-    free(ptr);
+    sail_current_allocator.free_func(sail_current_allocator.context, ptr);
+}
+
+sail_status_t sail_malloc_pixels(size_t size, void **ptr) {
+
+    SAIL_CHECK_PTR(ptr);
+
+    mark_allocators_in_use();
+
+    *ptr = sail_current_pixels_allocator.malloc_func(sail_current_pixels_allocator.context, size);
+
+    if (*ptr == NULL) {
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_MEMORY_ALLOCATION);
+    }
+
+    return SAIL_OK;
+}
+
+void sail_free_pixels(void *ptr) {
+
+    sail_current_pixels_allocator.free_func(sail_current_pixels_allocator.context, ptr);
 }
 
 uint64_t sail_now(void) {
@@ -44,6 +44,23 @@ struct sail_image;
 extern "C" {
 #endif
 
+/*
+ * Custom memory allocator. All the functions receive the user context as the first argument.
+ * The functions have the semantics of malloc(), realloc(), and free(). malloc_func and realloc_func
+ * must return NULL on failure. free_func must accept NULL pointers.
+ */
+struct sail_allocator {
+
+    void *(*malloc_func)(void *context, size_t size);
+    void *(*realloc_func)(void *context, void *ptr, size_t size);
+    void (*free_func)(void *context, void *ptr);
+
+    /* User context passed to the functions above. */
+    void *context;
+};
+
+typedef struct sail_allocator sail_allocator_t;
+
 /*
  * Duplicates the specified memory buffer and stores a new buffer in the specified output.
  *
@@ -218,6 +235,32 @@ SAIL_EXPORT sail_status_t sail_bytes_per_image(const struct sail_image *image, u
  */
 SAIL_EXPORT sail_status_t sail_print_errno(const char *format);
 
+/*
+ * Installs a custom allocator used by sail_malloc(), sail_realloc(), sail_calloc(), and sail_free().
+ * The allocator is copied. Pass NULL to restore the default libc allocator.
+ *
+ * Pixel buffers are allocated with the pixels allocator if it's installed. See sail_set_pixels_allocator().
+ *
+ * This function is not thread-safe. It MUST be called in the main thread before initializing SAIL
+ * and before any other SAIL function allocates memory.
+ *
+ * Returns SAIL_OK on success. Returns SAIL_ERROR_ALLOCATOR_IN_USE if SAIL has already allocated memory
+ * with sail_malloc(), sail_realloc(), sail_calloc(), or sail_malloc_pixels(), as memory allocated
+ * by one allocator cannot be freed by another one.
+ */
+SAIL_EXPORT sail_status_t sail_set_allocator(const struct sail_allocator *allocator);
+
+/*
+ * Installs a custom allocator used by sail_malloc_pixels() and sail_free_pixels() to allocate
+ * large image pixel buffers, so they could be served by a huge-page or an arena allocator, for example.
+ * The allocator is copied. Pass NULL to allocate pixels with the allocator set by sail_set_allocator().
+ *
+ * This function is not thread-safe and has the same restrictions as sail_set_allocator().
+ *
+ * Returns SAIL_OK on success. Returns SAIL_ERROR_ALLOCATOR_IN_USE if SAIL has already allocated memory.
+ */
+SAIL_EXPORT sail_status_t sail_set_pixels_allocator(const struct sail_allocator *allocator);
+
 /*
  * Interface to malloc().
  *
@@ -246,6 +289,19 @@ SAIL_EXPORT sail_status_t sail_calloc(size_t nmemb, size_t size, void **ptr);
  */
 SAIL_EXPORT void sail_free(void *ptr);
 
+/*
+ * Allocates a pixel buffer. Image pixels MUST be allocated with this function as sail_destroy_image()
+ * frees them with sail_free_pixels().
+ *
+ * Returns SAIL_OK on success.
+ */
+SAIL_EXPORT sail_status_t sail_malloc_pixels(size_t size, void **ptr);
+
+/*
+ * Frees the pixel buffer allocated with sail_malloc_pixels(). Does nothing if the pointer is NULL.
+ */
+SAIL_EXPORT void sail_free_pixels(void *ptr);
+
 /*
  * Assigns the current number of milliseconds since Epoch.
  *
@@ -41,6 +41,11 @@ sail_status_t sail_alloc_write_options(struct sail_write_options **write_options
     (*write_options)->io_options          = 0;
     (*write_options)->compression         = SAIL_COMPRESSION_UNSUPPORTED;
     (*write_options)->compression_level   = 0;
+    (*write_options)->dithering           = SAIL_DITHERING_NONE;
+    (*write_options)->threads             = 0;
+    (*write_options)->tile_width          = 0;
+    (*write_options)->tile_height         = 0;
+    (*write_options)->filter              = SAIL_FILTER_DEFAULT;
 
     return SAIL_OK;
 }
@@ -76,6 +81,11 @@ sail_status_t sail_write_options_from_features(const struct sail_write_features
 
     write_options->compression = write_features->default_compression;
     write_options->compression_level = write_features->compression_level_default;
+    write_options->dithering = SAIL_DITHERING_NONE;
+    write_options->threads = 0;
+    write_options->tile_width = 0;
+    write_options->tile_height = 0;
+    write_options->filter = SAIL_FILTER_DEFAULT;
 
     return SAIL_OK;
 }
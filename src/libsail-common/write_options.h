@@ -74,6 +74,33 @@ struct sail_write_options {
      * in sail_write_features. If compression_level < compression_level_min, compression_level_default will be used.
      */
     double compression_level;
+
+    /*
+     * Dithering method used by codecs that reduce colors to a palette, like GIF. Other codecs ignore it.
+     * See SailDithering.
+     */
+    enum SailDithering dithering;
+
+    /*
+     * Number of threads codecs with the SAIL_CODEC_FEATURE_MULTI_THREADED write feature may use
+     * to encode. Other codecs ignore it. 0 and 1 mean encoding in the calling thread only.
+     * The default is 0.
+     */
+    unsigned threads;
+
+    /*
+     * Tile size used by codecs with the SAIL_CODEC_FEATURE_TILED write feature. Codecs may round it up
+     * to the nearest supported size. 0x0 means writing strips or rows. Other codecs ignore it.
+     * The default is 0x0.
+     */
+    unsigned tile_width;
+    unsigned tile_height;
+
+    /*
+     * Filter applied to rows before compression. Codecs fall back to SAIL_FILTER_DEFAULT when the filter
+     * is not supported with the selected compression. See SailFilter.
+     */
+    enum SailFilter filter;
 };
 
 typedef struct sail_write_options sail_write_options_t;
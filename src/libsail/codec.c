@@ -38,6 +38,24 @@
 #include "sail-common.h"
 #include "sail.h"
 
+/* The only place where a resolved symbol is turned into a function pointer. */
+typedef void (*codec_func_t)(void);
+
+static codec_func_t resolve_func(void *handle, const char *symbol) {
+
+#ifdef SAIL_WIN32
+    return (codec_func_t)GetProcAddress((HMODULE)handle, symbol);
+#else
+    /* ISO C doesn't convert object pointers to function pointers, POSIX makes them compatible. */
+    void *ptr = dlsym(handle, symbol);
+
+    codec_func_t func;
+    memcpy(&func, &ptr, sizeof(func));
+
+    return func;
+#endif
+}
+
 sail_status_t alloc_and_load_codec(const struct sail_codec_info *codec_info, struct sail_codec **codec) {
 
     SAIL_CHECK_CODEC_INFO_PTR(codec_info);
@@ -100,7 +118,6 @@ sail_status_t alloc_and_load_codec(const struct sail_codec_info *codec_info, str
     codec_local->handle = handle;
 
 #ifdef SAIL_WIN32
-    #define SAIL_RESOLVE_FUNC GetProcAddress
     #ifdef SAIL_COMBINE_CODECS
         #define SAIL_RESOLVE_LOG_ERROR(symbol) \
             SAIL_LOG_ERROR("Failed to resolve '%s'. Error: %d", symbol, GetLastError())
@@ -109,8 +126,6 @@ sail_status_t alloc_and_load_codec(const struct sail_codec_info *codec_info, str
             SAIL_LOG_ERROR("Failed to resolve '%s' in '%s'. Error: %d", symbol, codec_info->path, GetLastError())
     #endif
 #else
-    #define SAIL_RESOLVE_FUNC dlsym
-
     #ifdef SAIL_COMBINE_CODECS
         #define SAIL_RESOLVE_LOG_ERROR(symbol) \
             SAIL_LOG_ERROR("Failed to resolve '%s': %s", symbol, dlerror())
@@ -120,7 +135,8 @@ sail_status_t alloc_and_load_codec(const struct sail_codec_info *codec_info, str
     #endif
 #endif
 
-#define SAIL_RESOLVE(target, handle, symbol, name)                                 \
+/* Missing required functions fail loading the codec. Missing optional functions are set to NULL. */
+#define SAIL_RESOLVE_SYMBOL(target, handle, symbol, name, required)                \
     {                                                                              \
         char *full_symbol_name;                                                    \
         SAIL_TRY_OR_CLEANUP(sail_concat(&full_symbol_name, 3, #symbol, "_", name), \
@@ -129,18 +145,25 @@ sail_status_t alloc_and_load_codec(const struct sail_codec_info *codec_info, str
         /* To avoid copying name, make the whole string lower-case. */             \
         sail_to_lower(full_symbol_name);                                           \
                                                                                    \
-        target = (symbol##_t)SAIL_RESOLVE_FUNC(handle, full_symbol_name);          \
+        target = (symbol##_t)resolve_func(handle, full_symbol_name);               \
                                                                                    \
         if (target == NULL) {                                                      \
-            SAIL_RESOLVE_LOG_ERROR(full_symbol_name);                              \
-            sail_free(full_symbol_name);                                           \
-            destroy_codec(codec_local);                                            \
-            SAIL_LOG_AND_RETURN(SAIL_ERROR_CODEC_SYMBOL_RESOLVE);                  \
+            if (required) {                                                        \
+                SAIL_RESOLVE_LOG_ERROR(full_symbol_name);                          \
+                sail_free(full_symbol_name);                                       \
+                destroy_codec(codec_local);                                        \
+                SAIL_LOG_AND_RETURN(SAIL_ERROR_CODEC_SYMBOL_RESOLVE);              \
+            }                                                                      \
+                                                                                   \
+            SAIL_LOG_DEBUG("Optional '%s' is not implemented", full_symbol_name);  \
         }                                                                          \
                                                                                    \
         sail_free(full_symbol_name);                                               \
     } do{} while(0)
 
+#define SAIL_RESOLVE(target, handle, symbol, name)          SAIL_RESOLVE_SYMBOL(target, handle, symbol, name, true)
+#define SAIL_RESOLVE_OPTIONAL(target, handle, symbol, name) SAIL_RESOLVE_SYMBOL(target, handle, symbol, name, false)
+
     if (codec_local->layout == SAIL_CODEC_LAYOUT_V4) {
         SAIL_TRY_OR_CLEANUP(sail_malloc(sizeof(struct sail_codec_layout_v4), &ptr),
                             /* cleanup */ destroy_codec(codec_local));
@@ -157,6 +180,20 @@ sail_status_t alloc_and_load_codec(const struct sail_codec_info *codec_info, str
         SAIL_RESOLVE(codec_local->v4->write_seek_next_pass,  handle, sail_codec_write_seek_next_pass_v4,  codec_info->name);
         SAIL_RESOLVE(codec_local->v4->write_frame,           handle, sail_codec_write_frame_v4,           codec_info->name);
         SAIL_RESOLVE(codec_local->v4->write_finish,          handle, sail_codec_write_finish_v4,          codec_info->name);
+
+        SAIL_RESOLVE_OPTIONAL(codec_local->v4->probe,      handle, sail_codec_probe_v4,      codec_info->name);
+        SAIL_RESOLVE_OPTIONAL(codec_local->v4->read_rows,  handle, sail_codec_read_rows_v4,  codec_info->name);
+        SAIL_RESOLVE_OPTIONAL(codec_local->v4->read_reset, handle, sail_codec_read_reset_v4, codec_info->name);
+
+        SAIL_RESOLVE_OPTIONAL(codec_local->v4->feed_init,   handle, sail_codec_feed_init_v4,   codec_info->name);
+        SAIL_RESOLVE_OPTIONAL(codec_local->v4->feed,        handle, sail_codec_feed_v4,        codec_info->name);
+        SAIL_RESOLVE_OPTIONAL(codec_local->v4->feed_finish, handle, sail_codec_feed_finish_v4, codec_info->name);
+
+        if (codec_local->v4->feed_init == NULL || codec_local->v4->feed == NULL || codec_local->v4->feed_finish == NULL) {
+            codec_local->v4->feed_init   = NULL;
+            codec_local->v4->feed        = NULL;
+            codec_local->v4->feed_finish = NULL;
+        }
     } else {
         destroy_codec(codec_local);
         SAIL_LOG_AND_RETURN(SAIL_ERROR_UNSUPPORTED_CODEC_LAYOUT);
@@ -26,6 +26,8 @@
 #ifndef SAIL_CODEC_H
 #define SAIL_CODEC_H
 
+#include <stddef.h> /* size_t */
+
 #ifdef SAIL_BUILD
     #include "error.h"
     #include "export.h"
@@ -55,6 +57,16 @@ typedef sail_status_t (*sail_codec_read_seek_next_pass_v4_t) (void *state, struc
 typedef sail_status_t (*sail_codec_read_frame_v4_t)          (void *state, struct sail_io *io, const struct sail_image *image);
 typedef sail_status_t (*sail_codec_read_finish_v4_t)         (void **state, struct sail_io *io);
 
+/* Optional. */
+typedef sail_status_t (*sail_codec_probe_v4_t)    (struct sail_io *io, const struct sail_read_options *read_options, struct sail_image **image);
+typedef sail_status_t (*sail_codec_read_rows_v4_t)(void *state, struct sail_io *io, const struct sail_image *image,
+                                                    unsigned first_row, unsigned row_count, void *rows);
+typedef sail_status_t (*sail_codec_read_reset_v4_t)(void *state, struct sail_io *io);
+typedef sail_status_t (*sail_codec_feed_init_v4_t)  (const struct sail_read_options *read_options, void **state);
+typedef sail_status_t (*sail_codec_feed_v4_t)       (void *state, const void *buffer, size_t buffer_length,
+                                                      const struct sail_image **image, unsigned *valid_rows);
+typedef sail_status_t (*sail_codec_feed_finish_v4_t)(void **state);
+
 typedef sail_status_t (*sail_codec_write_init_v4_t)           (struct sail_io *io, const struct sail_write_options *write_options, void **state);
 typedef sail_status_t (*sail_codec_write_seek_next_frame_v4_t)(void *state, struct sail_io *io, const struct sail_image *image);
 typedef sail_status_t (*sail_codec_write_seek_next_pass_v4_t) (void *state, struct sail_io *io, const struct sail_image *image);
@@ -73,6 +85,16 @@ struct sail_codec_layout_v4 {
     sail_codec_write_seek_next_pass_v4_t  write_seek_next_pass;
     sail_codec_write_frame_v4_t           write_frame;
     sail_codec_write_finish_v4_t          write_finish;
+
+    /* Optional functions. NULL if not implemented by the codec. */
+    sail_codec_probe_v4_t      probe;
+    sail_codec_read_rows_v4_t  read_rows;
+    sail_codec_read_reset_v4_t read_reset;
+
+    /* Incremental decoding. Either all or none of these are implemented. */
+    sail_codec_feed_init_v4_t   feed_init;
+    sail_codec_feed_v4_t        feed;
+    sail_codec_feed_finish_v4_t feed_finish;
 };
 
 /*
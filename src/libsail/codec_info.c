@@ -97,43 +97,21 @@ sail_status_t sail_codec_info_by_magic_number_from_io(struct sail_io *io, const
     /* Seek back. */
     SAIL_TRY(io->seek(io->stream, 0, SEEK_SET));
 
-    /* \xFF\xDD => "FF DD" + string terminator. */
-    char hex_numbers[SAIL_MAGIC_BUFFER_SIZE * 3 + 1];
-    char *hex_numbers_ptr = hex_numbers;
-
-    for (size_t i = 0; i < sizeof(buffer); i++, hex_numbers_ptr += 3) {
-#ifdef SAIL_WIN32
-        sprintf_s(hex_numbers_ptr, 4, "%02x ", buffer[i]);
-#else
-        sprintf(hex_numbers_ptr, "%02x ", buffer[i]);
-#endif
-    }
-
-    hex_numbers_ptr--;
-    *hex_numbers_ptr = '\0';
-
-    SAIL_LOG_DEBUG("Read magic number: '%s'", hex_numbers);
-
     /* Find the codec info. */
-    struct sail_codec_info_node *node = context->codec_info_node;
-
-    while (node != NULL) {
-        struct sail_string_node *string_node = node->codec_info->magic_number_node;
-
-        while (string_node != NULL) {
-            if (strncmp(hex_numbers, string_node->value, strlen(string_node->value)) == 0) {
-                *codec_info = node->codec_info;
-                SAIL_LOG_DEBUG("Found codec info: '%s'", (*codec_info)->name);
-                return SAIL_OK;
-            }
+    const struct sail_codec_info *found_codec_info = NULL;
 
-            string_node = string_node->next;
-        }
+    if (context->codec_info_index != NULL) {
+        found_codec_info = codec_info_index_by_magic_number(context->codec_info_index, buffer, sizeof(buffer));
+    }
 
-        node = node->next;
+    if (found_codec_info == NULL) {
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_CODEC_NOT_FOUND);
     }
 
-    SAIL_LOG_AND_RETURN(SAIL_ERROR_CODEC_NOT_FOUND);
+    *codec_info = found_codec_info;
+    SAIL_LOG_DEBUG("Found codec info: '%s'", (*codec_info)->name);
+
+    return SAIL_OK;
 }
 
 sail_status_t sail_codec_info_from_extension(const char *extension, const struct sail_codec_info **codec_info) {
@@ -146,33 +124,21 @@ sail_status_t sail_codec_info_from_extension(const char *extension, const struct
     struct sail_context *context;
     SAIL_TRY(current_tls_context(&context));
 
-    char *extension_copy;
-    SAIL_TRY(sail_strdup(extension, &extension_copy));
-
-    /* Will compare in lower case. */
-    sail_to_lower(extension_copy);
-
-    struct sail_codec_info_node *node = context->codec_info_node;
-
-    while (node != NULL) {
-        struct sail_string_node *string_node = node->codec_info->extension_node;
+    /* Compared case-insensitively. */
+    const struct sail_codec_info *found_codec_info = NULL;
 
-        while (string_node != NULL) {
-            if (strcmp(string_node->value, extension_copy) == 0) {
-                sail_free(extension_copy);
-                *codec_info = node->codec_info;
-                SAIL_LOG_DEBUG("Found codec info: '%s'", (*codec_info)->name);
-                return SAIL_OK;
-            }
-
-            string_node = string_node->next;
-        }
+    if (context->codec_info_index != NULL) {
+        found_codec_info = codec_info_index_by_extension(context->codec_info_index, extension);
+    }
 
-        node = node->next;
+    if (found_codec_info == NULL) {
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_CODEC_NOT_FOUND);
     }
 
-    sail_free(extension_copy);
-    SAIL_LOG_AND_RETURN(SAIL_ERROR_CODEC_NOT_FOUND);
+    *codec_info = found_codec_info;
+    SAIL_LOG_DEBUG("Found codec info: '%s'", (*codec_info)->name);
+
+    return SAIL_OK;
 }
 
 sail_status_t sail_codec_info_from_mime_type(const char *mime_type, const struct sail_codec_info **codec_info) {
@@ -185,31 +151,19 @@ sail_status_t sail_codec_info_from_mime_type(const char *mime_type, const struct
     struct sail_context *context;
     SAIL_TRY(current_tls_context(&context));
 
-    char *mime_type_copy;
-    SAIL_TRY(sail_strdup(mime_type, &mime_type_copy));
-
-    /* Will compare in lower case. */
-    sail_to_lower(mime_type_copy);
-
-    struct sail_codec_info_node *node = context->codec_info_node;
+    /* Compared case-insensitively. */
+    const struct sail_codec_info *found_codec_info = NULL;
 
-    while (node != NULL) {
-        struct sail_string_node *string_node = node->codec_info->mime_type_node;
-
-        while (string_node != NULL) {
-            if (strcmp(string_node->value, mime_type_copy) == 0) {
-                sail_free(mime_type_copy);
-                *codec_info = node->codec_info;
-                SAIL_LOG_DEBUG("Found codec info: '%s'", (*codec_info)->name);
-                return SAIL_OK;
-            }
-
-            string_node = string_node->next;
-        }
+    if (context->codec_info_index != NULL) {
+        found_codec_info = codec_info_index_by_mime_type(context->codec_info_index, mime_type);
+    }
 
-        node = node->next;
+    if (found_codec_info == NULL) {
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_CODEC_NOT_FOUND);
     }
 
-    sail_free(mime_type_copy);
-    SAIL_LOG_AND_RETURN(SAIL_ERROR_CODEC_NOT_FOUND);
+    *codec_info = found_codec_info;
+    SAIL_LOG_DEBUG("Found codec info: '%s'", (*codec_info)->name);
+
+    return SAIL_OK;
 }
@@ -0,0 +1,338 @@
+/*  This file is part of SAIL (https://github.com/smoked-herring/sail)
+
+    Copyright (c) 2020 Dmitry Baryshev
+
+    The MIT License
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "config.h"
+
+#include <ctype.h>
+#include <stdbool.h>
+#include <stddef.h> /* offsetof */
+#include <stdlib.h>
+#include <string.h>
+
+#include "sail-common.h"
+#include "sail.h"
+
+/*
+ * Private functions.
+ */
+
+/* djb2 hash of the lower-cased string. Same as sail_string_hash() for lower-case strings. */
+static uint64_t lower_string_hash(const char *str) {
+
+    const unsigned char *ustr = (const unsigned char *)str;
+
+    uint64_t hash = 5381;
+    unsigned c;
+
+    while ((c = *ustr++) != 0) {
+        hash = ((hash << 5) + hash) + (unsigned)tolower(c); /* hash * 33 + c */
+    }
+
+    return hash;
+}
+
+/* Compares the specified string with the lower-case key case-insensitively. */
+static bool equals_lower_key(const char *str, const char *lower_key) {
+
+    const unsigned char *ustr = (const unsigned char *)str;
+    const unsigned char *ukey = (const unsigned char *)lower_key;
+
+    for (; *ustr != '\0' && *ukey != '\0'; ustr++, ukey++) {
+        if (tolower(*ustr) != *ukey) {
+            return false;
+        }
+    }
+
+    return *ustr == *ukey;
+}
+
+static size_t count_strings(const struct sail_codec_info_node *codec_info_node, size_t offset) {
+
+    size_t count = 0;
+
+    for (; codec_info_node != NULL; codec_info_node = codec_info_node->next) {
+        const struct sail_string_node *string_node =
+            *(const struct sail_string_node * const *)((const char *)codec_info_node->codec_info + offset);
+
+        for (; string_node != NULL; string_node = string_node->next) {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+/*
+ * Builds a hash table from the string lists stored in codec info objects at the specified offset
+ * like offsetof(struct sail_codec_info, extension_node).
+ */
+static sail_status_t build_key_table(const struct sail_codec_info_node *codec_info_node,
+                                        size_t offset,
+                                        struct codec_info_key_entry **table,
+                                        size_t *capacity) {
+
+    /* Keep the load factor under 0.5. */
+    const size_t count = count_strings(codec_info_node, offset);
+    size_t local_capacity = 8;
+
+    while (local_capacity < count * 2) {
+        local_capacity *= 2;
+    }
+
+    void *ptr;
+    SAIL_TRY(sail_calloc(local_capacity, sizeof(struct codec_info_key_entry), &ptr));
+    struct codec_info_key_entry *local_table = ptr;
+
+    const size_t mask = local_capacity - 1;
+
+    for (; codec_info_node != NULL; codec_info_node = codec_info_node->next) {
+        const struct sail_string_node *string_node =
+            *(const struct sail_string_node * const *)((const char *)codec_info_node->codec_info + offset);
+
+        for (; string_node != NULL; string_node = string_node->next) {
+            const uint64_t hash = lower_string_hash(string_node->value);
+            size_t index = (size_t)hash & mask;
+            bool duplicate = false;
+
+            while (local_table[index].key != NULL) {
+                if (local_table[index].hash == hash && strcmp(local_table[index].key, string_node->value) == 0) {
+                    duplicate = true;
+                    break;
+                }
+
+                index = (index + 1) & mask;
+            }
+
+            /* The first codec wins. */
+            if (duplicate) {
+                SAIL_LOG_DEBUG("Key '%s' of the '%s' codec is already registered by the '%s' codec",
+                                string_node->value, codec_info_node->codec_info->name, local_table[index].codec_info->name);
+                continue;
+            }
+
+            local_table[index].hash       = hash;
+            local_table[index].key        = string_node->value;
+            local_table[index].codec_info = codec_info_node->codec_info;
+        }
+    }
+
+    *table    = local_table;
+    *capacity = local_capacity;
+
+    return SAIL_OK;
+}
+
+static const struct sail_codec_info* find_in_key_table(const struct codec_info_key_entry *table,
+                                                        size_t capacity,
+                                                        const char *key) {
+
+    const uint64_t hash = lower_string_hash(key);
+    const size_t mask = capacity - 1;
+
+    for (size_t index = (size_t)hash & mask; table[index].key != NULL; index = (index + 1) & mask) {
+        if (table[index].hash == hash && equals_lower_key(key, table[index].key)) {
+            return table[index].codec_info;
+        }
+    }
+
+    return NULL;
+}
+
+static int hex_digit_value(char c) {
+
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    } else {
+        return -1;
+    }
+}
+
+/* Parses "ff d8" into binary bytes. */
+static sail_status_t parse_magic_number(const char *str, struct codec_info_magic_entry *magic_entry) {
+
+    magic_entry->magic_length = 0;
+
+    while (*str != '\0') {
+        if (*str == ' ') {
+            str++;
+            continue;
+        }
+
+        const int high = hex_digit_value(str[0]);
+        const int low  = high < 0 ? -1 : hex_digit_value(str[1]);
+
+        if (low < 0 || magic_entry->magic_length == SAIL_MAGIC_BUFFER_SIZE) {
+            SAIL_LOG_AND_RETURN(SAIL_ERROR_PARSE_FILE);
+        }
+
+        magic_entry->magic[magic_entry->magic_length++] = (unsigned char)(high << 4 | low);
+        str += 2;
+    }
+
+    if (magic_entry->magic_length == 0) {
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_PARSE_FILE);
+    }
+
+    return SAIL_OK;
+}
+
+static sail_status_t build_magic_table(const struct sail_codec_info_node *codec_info_node,
+                                        struct codec_info_index *codec_info_index) {
+
+    const size_t count = count_strings(codec_info_node, offsetof(struct sail_codec_info, magic_number_node));
+
+    void *ptr;
+    SAIL_TRY(sail_malloc((count > 0 ? count : 1) * sizeof(struct codec_info_magic_entry), &ptr));
+    codec_info_index->magic_numbers = ptr;
+
+    /* Parse the magic numbers and count them per first byte. */
+    size_t parsed = 0;
+    size_t bucket_sizes[256] = { 0 };
+
+    SAIL_TRY(sail_malloc((count > 0 ? count : 1) * sizeof(struct codec_info_magic_entry), &ptr));
+    struct codec_info_magic_entry *parsed_entries = ptr;
+
+    for (; codec_info_node != NULL; codec_info_node = codec_info_node->next) {
+        const struct sail_string_node *string_node = codec_info_node->codec_info->magic_number_node;
+
+        for (; string_node != NULL; string_node = string_node->next) {
+            if (parse_magic_number(string_node->value, &parsed_entries[parsed]) != SAIL_OK) {
+                SAIL_LOG_ERROR("Failed to parse magic number '%s' of the '%s' codec. Ignoring it",
+                                string_node->value, codec_info_node->codec_info->name);
+                continue;
+            }
+
+            parsed_entries[parsed].codec_info = codec_info_node->codec_info;
+            bucket_sizes[parsed_entries[parsed].magic[0]]++;
+            parsed++;
+        }
+    }
+
+    /* Stable counting sort by the first byte. */
+    codec_info_index->magic_bucket[0] = 0;
+
+    for (unsigned i = 0; i < 256; i++) {
+        codec_info_index->magic_bucket[i + 1] = codec_info_index->magic_bucket[i] + bucket_sizes[i];
+    }
+
+    size_t positions[256];
+    memcpy(positions, codec_info_index->magic_bucket, sizeof(positions));
+
+    for (size_t i = 0; i < parsed; i++) {
+        codec_info_index->magic_numbers[positions[parsed_entries[i].magic[0]]++] = parsed_entries[i];
+    }
+
+    sail_free(parsed_entries);
+
+    return SAIL_OK;
+}
+
+/*
+ * Public functions.
+ */
+
+sail_status_t alloc_codec_info_index(const struct sail_codec_info_node *codec_info_node,
+                                        struct codec_info_index **codec_info_index) {
+
+    SAIL_CHECK_PTR(codec_info_index);
+
+    void *ptr;
+    SAIL_TRY(sail_malloc(sizeof(struct codec_info_index), &ptr));
+    struct codec_info_index *codec_info_index_local = ptr;
+
+    codec_info_index_local->extensions          = NULL;
+    codec_info_index_local->extensions_capacity = 0;
+    codec_info_index_local->mime_types          = NULL;
+    codec_info_index_local->mime_types_capacity = 0;
+    codec_info_index_local->magic_numbers       = NULL;
+
+    SAIL_TRY_OR_CLEANUP(build_key_table(codec_info_node,
+                                        offsetof(struct sail_codec_info, extension_node),
+                                        &codec_info_index_local->extensions,
+                                        &codec_info_index_local->extensions_capacity),
+                        /* cleanup */ destroy_codec_info_index(codec_info_index_local));
+    SAIL_TRY_OR_CLEANUP(build_key_table(codec_info_node,
+                                        offsetof(struct sail_codec_info, mime_type_node),
+                                        &codec_info_index_local->mime_types,
+                                        &codec_info_index_local->mime_types_capacity),
+                        /* cleanup */ destroy_codec_info_index(codec_info_index_local));
+    SAIL_TRY_OR_CLEANUP(build_magic_table(codec_info_node, codec_info_index_local),
+                        /* cleanup */ destroy_codec_info_index(codec_info_index_local));
+
+    *codec_info_index = codec_info_index_local;
+
+    return SAIL_OK;
+}
+
+void destroy_codec_info_index(struct codec_info_index *codec_info_index) {
+
+    if (codec_info_index == NULL) {
+        return;
+    }
+
+    sail_free(codec_info_index->extensions);
+    sail_free(codec_info_index->mime_types);
+    sail_free(codec_info_index->magic_numbers);
+
+    sail_free(codec_info_index);
+}
+
+const struct sail_codec_info* codec_info_index_by_extension(const struct codec_info_index *codec_info_index,
+                                                            const char *extension) {
+
+    return find_in_key_table(codec_info_index->extensions, codec_info_index->extensions_capacity, extension);
+}
+
+const struct sail_codec_info* codec_info_index_by_mime_type(const struct codec_info_index *codec_info_index,
+                                                            const char *mime_type) {
+
+    return find_in_key_table(codec_info_index->mime_types, codec_info_index->mime_types_capacity, mime_type);
+}
+
+const struct sail_codec_info* codec_info_index_by_magic_number(const struct codec_info_index *codec_info_index,
+                                                                const unsigned char *buffer,
+                                                                size_t buffer_length) {
+
+    if (buffer_length == 0) {
+        return NULL;
+    }
+
+    const size_t bucket_end = codec_info_index->magic_bucket[buffer[0] + 1];
+
+    for (size_t i = codec_info_index->magic_bucket[buffer[0]]; i < bucket_end; i++) {
+        const struct codec_info_magic_entry *magic_entry = &codec_info_index->magic_numbers[i];
+
+        if (magic_entry->magic_length <= buffer_length &&
+                memcmp(magic_entry->magic, buffer, magic_entry->magic_length) == 0) {
+            return magic_entry->codec_info;
+        }
+    }
+
+    return NULL;
+}
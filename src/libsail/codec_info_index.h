@@ -0,0 +1,134 @@
+/*  This file is part of SAIL (https://github.com/smoked-herring/sail)
+
+    Copyright (c) 2020 Dmitry Baryshev
+
+    The MIT License
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#ifndef SAIL_CODEC_INFO_INDEX_H
+#define SAIL_CODEC_INFO_INDEX_H
+
+#include <stddef.h> /* size_t */
+#include <stdint.h>
+
+#ifdef SAIL_BUILD
+    #include "config.h"
+    #include "error.h"
+    #include "export.h"
+#else
+    #include <sail-common/config.h>
+    #include <sail-common/error.h>
+    #include <sail-common/export.h>
+#endif
+
+struct sail_codec_info;
+struct sail_codec_info_node;
+
+/*
+ * Hash table entry mapping a lower-case string key to a codec info.
+ */
+struct codec_info_key_entry {
+
+    /* Hash of the key. */
+    uint64_t hash;
+
+    /* Points to the string owned by the codec info. NULL if the entry is empty. */
+    const char *key;
+
+    const struct sail_codec_info *codec_info;
+};
+
+/*
+ * Binary magic number.
+ */
+struct codec_info_magic_entry {
+
+    unsigned char magic[SAIL_MAGIC_BUFFER_SIZE];
+    size_t magic_length;
+
+    const struct sail_codec_info *codec_info;
+};
+
+/*
+ * Read-only lookup tables built from a list of codec info objects when a context is initialized.
+ * Lookups don't allocate memory. When several codecs declare the same key, the first codec
+ * in the list wins.
+ */
+struct codec_info_index {
+
+    /* Open-addressing hash tables. Capacities are powers of two. */
+    struct codec_info_key_entry *extensions;
+    size_t extensions_capacity;
+
+    struct codec_info_key_entry *mime_types;
+    size_t mime_types_capacity;
+
+    /*
+     * Magic numbers sorted by their first byte. Magic numbers starting with the byte N are stored
+     * in [magic_bucket[N], magic_bucket[N+1]). The codec info order is preserved within a bucket.
+     */
+    struct codec_info_magic_entry *magic_numbers;
+    size_t magic_bucket[257];
+};
+
+typedef struct codec_info_index codec_info_index_t;
+
+/*
+ * Builds a new codec info index from the specified codec info list. The assigned index MUST be destroyed later
+ * with destroy_codec_info_index(). The index points to the codec info objects, so it MUST be destroyed
+ * before them.
+ *
+ * Returns SAIL_OK on success.
+ */
+SAIL_HIDDEN sail_status_t alloc_codec_info_index(const struct sail_codec_info_node *codec_info_node,
+                                                    struct codec_info_index **codec_info_index);
+
+/*
+ * Destroys the specified codec info index.
+ */
+SAIL_HIDDEN void destroy_codec_info_index(struct codec_info_index *codec_info_index);
+
+/*
+ * Finds a codec info by the specified file extension. The comparison is case-insensitive.
+ *
+ * Returns NULL if no codec info is found.
+ */
+SAIL_HIDDEN const struct sail_codec_info* codec_info_index_by_extension(const struct codec_info_index *codec_info_index,
+                                                                        const char *extension);
+
+/*
+ * Finds a codec info by the specified mime type. The comparison is case-insensitive.
+ *
+ * Returns NULL if no codec info is found.
+ */
+SAIL_HIDDEN const struct sail_codec_info* codec_info_index_by_mime_type(const struct codec_info_index *codec_info_index,
+                                                                        const char *mime_type);
+
+/*
+ * Finds a codec info which magic number is a prefix of the specified buffer.
+ *
+ * Returns NULL if no codec info is found.
+ */
+SAIL_HIDDEN const struct sail_codec_info* codec_info_index_by_magic_number(const struct codec_info_index *codec_info_index,
+                                                                            const unsigned char *buffer,
+                                                                            size_t buffer_length);
+
+#endif
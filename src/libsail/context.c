@@ -44,7 +44,7 @@ void sail_finish(void) {
 
     SAIL_LOG_INFO("Finish");
 
-    control_tls_context(/* context - not needed */ NULL, SAIL_CONTEXT_DESTROY);
+    control_tls_context(/* context - not needed */ NULL, SAIL_CONTEXT_DESTROY, /* flags */ 0);
 }
 
 sail_status_t sail_unload_codecs(void) {
@@ -54,6 +54,12 @@ sail_status_t sail_unload_codecs(void) {
     struct sail_context *context;
     SAIL_TRY(current_tls_context(&context));
 
+    /* Other threads may use the codecs right now. */
+    if (context->shared) {
+        SAIL_LOG_ERROR("Codecs cannot be unloaded from the shared context");
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_SHARED_CONTEXT_READ_ONLY);
+    }
+
     struct sail_codec_info_node *node = context->codec_info_node;
     int counter = 0;
 
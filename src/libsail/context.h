@@ -46,6 +46,11 @@ extern "C" {
  *
  * If you call SAIL functions from three different threads, three different contexts are allocated.
  * You MUST destroy them with calling sail_finish() in each thread.
+ *
+ * Alternatively, call sail_init_with_flags(SAIL_FLAG_SHARED_CONTEXT) once before spawning worker threads.
+ * This allocates a single process-wide context. Threads calling SAIL functions afterwards attach to it
+ * instead of enumerating and loading codecs again. The shared context is reference-counted: every thread
+ * attached to it MUST still call sail_finish(), and the last call destroys it.
  */
 
 /*
@@ -57,6 +62,13 @@ enum SailInitFlags {
      * Preload all codecs in sail_init_with_flags(). Codecs are lazy-loaded by default.
      */
     SAIL_FLAG_PRELOAD_CODECS = 1 << 0,
+
+    /*
+     * Initialize a process-wide context shared between threads instead of a thread-local one.
+     * All codecs are preloaded, and the context is immutable afterwards, so attached threads read it
+     * without locking. sail_unload_codecs() is not supported with the shared context.
+     */
+    SAIL_FLAG_SHARED_CONTEXT = 1 << 1,
 };
 
 /*
@@ -87,7 +99,8 @@ SAIL_EXPORT sail_status_t sail_init_with_flags(int flags);
 
 /*
  * Finalizes working with the thread-local static context that was implicitly or explicitly allocated by
- * reading or writing functions.
+ * reading or writing functions. If the current thread is attached to the shared context, detaches it.
+ * The shared context is destroyed when the last attached thread calls sail_finish().
  *
  * Unloads all codecs. All pointers to codec info objects, read and write features get invalidated. 
  * Using them after calling sail_finish() will lead to a crash.
@@ -103,6 +116,7 @@ SAIL_EXPORT void sail_finish(void);
  *
  * Typical usage: This is a standalone function that can be called at any time.
  *
+ * Returns SAIL_ERROR_SHARED_CONTEXT_READ_ONLY if the current thread is attached to the shared context.
  * Returns SAIL_OK on success.
  */
 SAIL_EXPORT sail_status_t sail_unload_codecs(void);
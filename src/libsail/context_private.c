@@ -36,16 +36,50 @@
 #else
     #include <dlfcn.h> /* dlsym */
     #include <dirent.h> /* opendir */
+    #include <pthread.h>
     #include <sys/types.h>
 #endif
 
 #include "sail-common.h"
 #include "sail.h"
 
+/*
+ * Process-wide shared context. See SAIL_FLAG_SHARED_CONTEXT.
+ *
+ * The lock protects the pointer and the reference counter only. The context itself is immutable
+ * after initialization, so threads attached to it read it without locking.
+ */
+static struct sail_context *shared_context = NULL;
+static unsigned shared_context_references = 0;
+
+#ifdef SAIL_WIN32
+static SRWLOCK shared_context_lock = SRWLOCK_INIT;
+#else
+static pthread_mutex_t shared_context_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
 /*
  * Private functions.
  */
 
+static void lock_shared_context(void) {
+
+#ifdef SAIL_WIN32
+    AcquireSRWLockExclusive(&shared_context_lock);
+#else
+    pthread_mutex_lock(&shared_context_lock);
+#endif
+}
+
+static void unlock_shared_context(void) {
+
+#ifdef SAIL_WIN32
+    ReleaseSRWLockExclusive(&shared_context_lock);
+#else
+    pthread_mutex_unlock(&shared_context_lock);
+#endif
+}
+
 #ifdef SAIL_WIN32
 static sail_status_t add_dll_directory(const char *path) {
 
@@ -249,7 +283,9 @@ static sail_status_t alloc_context(struct sail_context **context) {
     *context = ptr;
 
     (*context)->initialized      = false;
-    (*context)->codec_info_node = NULL;
+    (*context)->shared           = false;
+    (*context)->codec_info_node  = NULL;
+    (*context)->codec_info_index = NULL;
 
     return SAIL_OK;
 }
@@ -322,6 +358,7 @@ static sail_status_t destroy_context(struct sail_context *context) {
         return SAIL_OK;
     }
 
+    destroy_codec_info_index(context->codec_info_index);
     destroy_codec_info_node_chain(context->codec_info_node);
     sail_free(context);
 
@@ -338,10 +375,15 @@ static sail_status_t preload_codecs(struct sail_context *context) {
     struct sail_codec_info_node *codec_info_node = context->codec_info_node;
 
     while (codec_info_node != NULL) {
-        const struct sail_codec *codec;
-
-        /* Ignore loading errors on purpose. */
-        load_codec_by_codec_info(codec_info_node->codec_info, &codec);
+        /*
+         * Load directly into the node. The context may be not published yet, so we cannot
+         * use load_codec_by_codec_info() that looks up the current context.
+         *
+         * Ignore loading errors on purpose.
+         */
+        if (codec_info_node->codec == NULL) {
+            alloc_and_load_codec(codec_info_node->codec_info, &codec_info_node->codec);
+        }
 
         codec_info_node = codec_info_node->next;
     }
@@ -670,7 +712,10 @@ static sail_status_t init_context(struct sail_context *context, int flags) {
 
     SAIL_TRY(print_enumerated_codecs(context));
 
-    if (flags & SAIL_FLAG_PRELOAD_CODECS) {
+    SAIL_TRY(alloc_codec_info_index(context->codec_info_node, &context->codec_info_index));
+
+    /* Shared contexts are never modified after initialization, so codecs cannot be lazy-loaded later. */
+    if (flags & SAIL_FLAG_PRELOAD_CODECS || context->shared) {
         SAIL_TRY(preload_codecs(context));
     }
 
@@ -683,7 +728,7 @@ static sail_status_t init_context(struct sail_context *context, int flags) {
  * Public functions.
  */
 
-sail_status_t control_tls_context(struct sail_context **context, enum SailContextAction action) {
+sail_status_t control_tls_context(struct sail_context **context, enum SailContextAction action, int flags) {
 
     SAIL_THREAD_LOCAL static struct sail_context *tls_context = NULL;
 
@@ -692,20 +737,88 @@ sail_status_t control_tls_context(struct sail_context **context, enum SailContex
             SAIL_CHECK_CONTEXT_PTR(context);
 
             if (tls_context == NULL) {
-                SAIL_TRY(alloc_context(&tls_context));
-                SAIL_LOG_DEBUG("Allocated a new thread-local context %p", tls_context);
+                /* Prefer the shared context when it exists. Only the first call in a thread takes the lock. */
+                lock_shared_context();
+
+                if (shared_context != NULL) {
+                    tls_context = shared_context;
+                    shared_context_references++;
+                }
+
+                unlock_shared_context();
+
+                if (tls_context == NULL) {
+                    SAIL_TRY(alloc_context(&tls_context));
+                    SAIL_LOG_DEBUG("Allocated a new thread-local context %p", tls_context);
+                } else {
+                    SAIL_LOG_DEBUG("Attached to the shared context %p", tls_context);
+                }
             }
 
             *context = tls_context;
             break;
         }
+        case SAIL_CONTEXT_ALLOCATE_SHARED: {
+            SAIL_CHECK_CONTEXT_PTR(context);
+
+            if (tls_context != NULL) {
+                if (!tls_context->shared) {
+                    SAIL_LOG_WARNING("The thread-local context %p already exists, not attaching to the shared context", tls_context);
+                }
+
+                *context = tls_context;
+                break;
+            }
+
+            lock_shared_context();
+
+            if (shared_context == NULL) {
+                struct sail_context *new_context;
+                SAIL_TRY_OR_CLEANUP(alloc_context(&new_context),
+                                    /* cleanup */ unlock_shared_context());
+
+                new_context->shared = true;
+
+                SAIL_TRY_OR_CLEANUP(init_context(new_context, flags),
+                                    /* cleanup */ destroy_context(new_context),
+                                                  unlock_shared_context());
+
+                shared_context = new_context;
+                SAIL_LOG_DEBUG("Allocated a new shared context %p", shared_context);
+            }
+
+            tls_context = shared_context;
+            shared_context_references++;
+
+            unlock_shared_context();
+
+            SAIL_LOG_DEBUG("Attached to the shared context %p", tls_context);
+
+            *context = tls_context;
+            break;
+        }
         case SAIL_CONTEXT_FETCH: {
             *context = tls_context;
             break;
         }
         case SAIL_CONTEXT_DESTROY: {
-            SAIL_LOG_DEBUG("Destroyed the thread-local context %p", tls_context);
-            destroy_context(tls_context);
+            if (tls_context != NULL && tls_context->shared) {
+                SAIL_LOG_DEBUG("Detached from the shared context %p", tls_context);
+
+                lock_shared_context();
+
+                if (--shared_context_references == 0) {
+                    SAIL_LOG_DEBUG("Destroyed the shared context %p", shared_context);
+                    destroy_context(shared_context);
+                    shared_context = NULL;
+                }
+
+                unlock_shared_context();
+            } else {
+                SAIL_LOG_DEBUG("Destroyed the thread-local context %p", tls_context);
+                destroy_context(tls_context);
+            }
+
             tls_context = NULL;
             break;
         }
@@ -725,7 +838,12 @@ sail_status_t current_tls_context_with_flags(struct sail_context **context, int
 
     SAIL_CHECK_CONTEXT_PTR(context);
 
-    SAIL_TRY(control_tls_context(context, SAIL_CONTEXT_ALLOCATE));
+    if (flags & SAIL_FLAG_SHARED_CONTEXT) {
+        SAIL_TRY(control_tls_context(context, SAIL_CONTEXT_ALLOCATE_SHARED, flags));
+    } else {
+        SAIL_TRY(control_tls_context(context, SAIL_CONTEXT_ALLOCATE, flags));
+    }
+
     SAIL_TRY(init_context(*context, flags));
 
     return SAIL_OK;
@@ -36,6 +36,7 @@
     #include <sail-common/export.h>
 #endif
 
+struct codec_info_index;
 struct sail_codec_info_node;
 
 /*
@@ -47,28 +48,50 @@ struct sail_context {
     /* Context is already initialized. */
     bool initialized;
 
+    /*
+     * Context is the process-wide context shared between threads. Shared contexts are immutable
+     * after initialization. See SAIL_FLAG_SHARED_CONTEXT.
+     */
+    bool shared;
+
     /* Linked list of found codec info objects. */
     struct sail_codec_info_node *codec_info_node;
+
+    /* Lookup tables to find codec info objects by extensions, mime types, and magic numbers. */
+    struct codec_info_index *codec_info_index;
 };
 
 typedef struct sail_context sail_context_t;
 
 enum SailContextAction {
-    /* Allocates a new TLS context if it's not allocated yet. */
+    /*
+     * Allocates a new TLS context if it's not allocated yet. If the process-wide shared context exists,
+     * attaches the current thread to it instead.
+     */
     SAIL_CONTEXT_ALLOCATE,
 
+    /*
+     * Allocates and initializes the process-wide shared context if it's not allocated yet, and attaches
+     * the current thread to it. Does nothing if the current thread already has a context.
+     */
+    SAIL_CONTEXT_ALLOCATE_SHARED,
+
     /* fetches the current TLS context or NULL if it's not allocated yet. */
     SAIL_CONTEXT_FETCH,
 
-    /* Destroys the currently existing TLS context. */
+    /*
+     * Destroys the currently existing TLS context. If the current thread is attached to the shared context,
+     * detaches it and destroys the shared context when no threads are attached anymore.
+     */
     SAIL_CONTEXT_DESTROY,
 };
 
 /*
  * Allocates or destroyes the current SAIL TLS context.
- * Doesn't re-allocate it if it's already allocated.
+ * Doesn't re-allocate it if it's already allocated. The specified flags are used to initialize
+ * the shared context. See SailInitFlags.
  */
-SAIL_HIDDEN sail_status_t control_tls_context(struct sail_context **context, enum SailContextAction action);
+SAIL_HIDDEN sail_status_t control_tls_context(struct sail_context **context, enum SailContextAction action, int flags);
 
 /* Returns the allocated and initialized TLS context. */
 SAIL_HIDDEN sail_status_t current_tls_context(struct sail_context **context);
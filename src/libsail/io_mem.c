@@ -26,6 +26,7 @@
 #include "config.h"
 
 #include <errno.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -33,41 +34,22 @@
 #include "sail-common.h"
 #include "sail.h"
 
-struct mem_io_buffer_info {
-
-    /* Total buffer size. */
-    size_t length;
-
-    /*
-     * The length of accessible buffer length.
-     *
-     * For example:
-     *
-     *   1. Reading
-     *      - open buffer of 10 Mb for reading
-     *      - accessible length now is 10 Mb
-     *
-     *   2. Writing
-     *      - open buffer of 10 Mb for writing
-     *      - write 100 Kb
-     *      - accessible length now is 100 Kb
-     */
-    size_t accessible_length;
-
-    /* Current stream position. */
-    size_t pos;
-};
-
-struct mem_io_read_stream {
-    struct mem_io_buffer_info mem_io_buffer_info;
-    const void *buffer;
-};
-
 struct mem_io_write_stream {
     struct mem_io_buffer_info mem_io_buffer_info;
     void *buffer;
 };
 
+/* The initial size of growable buffers. Grows geometrically from it. */
+#define MEM_IO_GROWABLE_MIN_LENGTH 16384
+
+struct mem_io_growable_write_stream {
+    struct mem_io_write_stream mem_io_write_stream;
+
+    /* Caller locations updated on every reallocation and write. */
+    void **result_buffer;
+    size_t *result_length;
+};
+
 /*
  * Private functions.
  */
@@ -239,6 +221,130 @@ static sail_status_t io_mem_eof(void *stream, bool *result) {
     return SAIL_OK;
 }
 
+static sail_status_t io_mem_buffer(void *stream, const void **buffer, size_t *buffer_length) {
+
+    SAIL_CHECK_STREAM_PTR(stream);
+    SAIL_CHECK_BUFFER_PTR(buffer);
+    SAIL_CHECK_RESULT_PTR(buffer_length);
+
+    struct mem_io_read_stream *mem_io_read_stream = (struct mem_io_read_stream *)stream;
+
+    *buffer        = mem_io_read_stream->buffer;
+    *buffer_length = mem_io_read_stream->mem_io_buffer_info.accessible_length;
+
+    return SAIL_OK;
+}
+
+static sail_status_t io_mem_growable_reserve(struct mem_io_growable_write_stream *mem_io_growable_write_stream, size_t size) {
+
+    struct mem_io_write_stream *mem_io_write_stream = &mem_io_growable_write_stream->mem_io_write_stream;
+    struct mem_io_buffer_info *mem_io_buffer_info = &mem_io_write_stream->mem_io_buffer_info;
+
+    if (size <= mem_io_buffer_info->length) {
+        return SAIL_OK;
+    }
+
+    size_t new_length = mem_io_buffer_info->length < MEM_IO_GROWABLE_MIN_LENGTH
+                            ? MEM_IO_GROWABLE_MIN_LENGTH
+                            : mem_io_buffer_info->length;
+
+    while (new_length < size) {
+        new_length = (new_length > SIZE_MAX / 2) ? size : new_length * 2;
+    }
+
+    /* sail_realloc() resets the pointer on failure. Keep the old buffer valid. */
+    void *ptr = mem_io_write_stream->buffer;
+    SAIL_TRY(sail_realloc(new_length, &ptr));
+
+    mem_io_write_stream->buffer                  = ptr;
+    mem_io_buffer_info->length                   = new_length;
+    *mem_io_growable_write_stream->result_buffer = ptr;
+
+    return SAIL_OK;
+}
+
+static sail_status_t io_mem_growable_tolerant_write(void *stream, const void *buf, size_t size_to_write, size_t *written_size) {
+
+    SAIL_CHECK_STREAM_PTR(stream);
+    SAIL_CHECK_BUFFER_PTR(buf);
+    SAIL_CHECK_RESULT_PTR(written_size);
+
+    struct mem_io_growable_write_stream *mem_io_growable_write_stream = (struct mem_io_growable_write_stream *)stream;
+    struct mem_io_write_stream *mem_io_write_stream = &mem_io_growable_write_stream->mem_io_write_stream;
+    struct mem_io_buffer_info *mem_io_buffer_info = &mem_io_write_stream->mem_io_buffer_info;
+
+    *written_size = 0;
+
+    if (size_to_write > SIZE_MAX - mem_io_buffer_info->pos) {
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_WRITE_IO);
+    }
+
+    SAIL_TRY(io_mem_growable_reserve(mem_io_growable_write_stream, mem_io_buffer_info->pos + size_to_write));
+
+    /* Zero the gap left by seeking past the end. */
+    if (mem_io_buffer_info->pos > mem_io_buffer_info->accessible_length) {
+        memset((char *)mem_io_write_stream->buffer + mem_io_buffer_info->accessible_length,
+                0,
+                mem_io_buffer_info->pos - mem_io_buffer_info->accessible_length);
+    }
+
+    memcpy((char *)mem_io_write_stream->buffer + mem_io_buffer_info->pos, buf, size_to_write);
+    mem_io_buffer_info->pos += size_to_write;
+
+    *written_size = size_to_write;
+
+    if (mem_io_buffer_info->pos > mem_io_buffer_info->accessible_length) {
+        mem_io_buffer_info->accessible_length = mem_io_buffer_info->pos;
+        *mem_io_growable_write_stream->result_length = mem_io_buffer_info->accessible_length;
+    }
+
+    return SAIL_OK;
+}
+
+static sail_status_t io_mem_growable_strict_write(void *stream, const void *buf, size_t size_to_write) {
+
+    size_t written_size;
+
+    SAIL_TRY(io_mem_growable_tolerant_write(stream, buf, size_to_write, &written_size));
+
+    if (written_size != size_to_write) {
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_WRITE_IO);
+    }
+
+    return SAIL_OK;
+}
+
+/*
+ * Like file I/O, seeking past the end doesn't grow the buffer. Only the next write does.
+ */
+static sail_status_t io_mem_growable_seek(void *stream, long offset, int whence) {
+
+    SAIL_CHECK_STREAM_PTR(stream);
+
+    struct mem_io_buffer_info *mem_io_buffer_info = (struct mem_io_buffer_info *)stream;
+
+    size_t base;
+
+    switch (whence) {
+        case SEEK_SET: base = 0;                                     break;
+        case SEEK_CUR: base = mem_io_buffer_info->pos;               break;
+        case SEEK_END: base = mem_io_buffer_info->accessible_length; break;
+
+        default: {
+            SAIL_LOG_AND_RETURN(SAIL_ERROR_UNSUPPORTED_SEEK_WHENCE);
+        }
+    }
+
+    /* Don't seek before the beginning. -(offset + 1) avoids overflowing on LONG_MIN. */
+    if (offset < 0 && (size_t)(-(offset + 1)) >= base) {
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_WRITE_IO);
+    }
+
+    mem_io_buffer_info->pos = base + offset;
+
+    return SAIL_OK;
+}
+
 /*
  * Public functions.
  */
@@ -257,24 +363,30 @@ sail_status_t alloc_io_read_mem(const void *buffer, size_t length, struct sail_i
                         /* cleanup */ sail_destroy_io(*io));
     struct mem_io_read_stream *mem_io_read_stream = ptr;
 
+    init_io_read_mem(buffer, length, mem_io_read_stream, *io);
+
+    return SAIL_OK;
+}
+
+void init_io_read_mem(const void *buffer, size_t length, struct mem_io_read_stream *mem_io_read_stream, struct sail_io *io) {
+
     mem_io_read_stream->mem_io_buffer_info.length            = length;
     mem_io_read_stream->mem_io_buffer_info.accessible_length = length;
     mem_io_read_stream->mem_io_buffer_info.pos               = 0;
     mem_io_read_stream->buffer                               = buffer;
 
-    (*io)->id             = SAIL_MEMORY_IO_ID;
-    (*io)->stream         = mem_io_read_stream;
-    (*io)->tolerant_read  = io_mem_tolerant_read;
-    (*io)->strict_read    = io_mem_strict_read;
-    (*io)->seek           = io_mem_seek;
-    (*io)->tell           = io_mem_tell;
-    (*io)->tolerant_write = io_noop_tolerant_write;
-    (*io)->strict_write   = io_noop_strict_write;
-    (*io)->flush          = io_noop_flush;
-    (*io)->close          = io_mem_close;
-    (*io)->eof            = io_mem_eof;
-
-    return SAIL_OK;
+    io->id             = SAIL_MEMORY_IO_ID;
+    io->stream         = mem_io_read_stream;
+    io->tolerant_read  = io_mem_tolerant_read;
+    io->strict_read    = io_mem_strict_read;
+    io->seek           = io_mem_seek;
+    io->tell           = io_mem_tell;
+    io->tolerant_write = io_noop_tolerant_write;
+    io->strict_write   = io_noop_strict_write;
+    io->flush          = io_noop_flush;
+    io->close          = io_mem_close;
+    io->eof            = io_mem_eof;
+    io->buffer         = io_mem_buffer;
 }
 
 sail_status_t alloc_io_write_mem(void *buffer, size_t length, struct sail_io **io) {
@@ -310,3 +422,43 @@ sail_status_t alloc_io_write_mem(void *buffer, size_t length, struct sail_io **i
 
     return SAIL_OK;
 }
+
+sail_status_t alloc_io_write_growable_mem(void **buffer, size_t *buffer_length, struct sail_io **io) {
+
+    SAIL_CHECK_BUFFER_PTR(buffer);
+    SAIL_CHECK_RESULT_PTR(buffer_length);
+    SAIL_CHECK_IO_PTR(io);
+
+    SAIL_LOG_DEBUG("Opening growable memory buffer for writing");
+
+    *buffer        = NULL;
+    *buffer_length = 0;
+
+    SAIL_TRY(sail_alloc_io(io));
+
+    void *ptr;
+    SAIL_TRY_OR_CLEANUP(sail_malloc(sizeof(struct mem_io_growable_write_stream), &ptr),
+                        /* cleanup */ sail_destroy_io(*io));
+    struct mem_io_growable_write_stream *mem_io_growable_write_stream = ptr;
+
+    mem_io_growable_write_stream->mem_io_write_stream.mem_io_buffer_info.length            = 0;
+    mem_io_growable_write_stream->mem_io_write_stream.mem_io_buffer_info.accessible_length = 0;
+    mem_io_growable_write_stream->mem_io_write_stream.mem_io_buffer_info.pos               = 0;
+    mem_io_growable_write_stream->mem_io_write_stream.buffer                               = NULL;
+    mem_io_growable_write_stream->result_buffer                                            = buffer;
+    mem_io_growable_write_stream->result_length                                            = buffer_length;
+
+    (*io)->id             = SAIL_MEMORY_IO_ID;
+    (*io)->stream         = mem_io_growable_write_stream;
+    (*io)->tolerant_read  = io_mem_tolerant_read;
+    (*io)->strict_read    = io_mem_strict_read;
+    (*io)->seek           = io_mem_growable_seek;
+    (*io)->tell           = io_mem_tell;
+    (*io)->tolerant_write = io_mem_growable_tolerant_write;
+    (*io)->strict_write   = io_mem_growable_strict_write;
+    (*io)->flush          = io_mem_flush;
+    (*io)->close          = io_mem_close;
+    (*io)->eof            = io_mem_eof;
+
+    return SAIL_OK;
+}
@@ -38,6 +38,40 @@
 
 struct sail_io;
 
+struct mem_io_buffer_info {
+
+    /* Total buffer size. */
+    size_t length;
+
+    /*
+     * The length of accessible buffer length.
+     *
+     * For example:
+     *
+     *   1. Reading
+     *      - open buffer of 10 Mb for reading
+     *      - accessible length now is 10 Mb
+     *
+     *   2. Writing
+     *      - open buffer of 10 Mb for writing
+     *      - write 100 Kb
+     *      - accessible length now is 100 Kb
+     */
+    size_t accessible_length;
+
+    /* Current stream position. */
+    size_t pos;
+};
+
+/*
+ * Memory read stream. Other read-only memory-based streams put it first in their own
+ * streams to share the memory reading callbacks.
+ */
+struct mem_io_read_stream {
+    struct mem_io_buffer_info mem_io_buffer_info;
+    const void *buffer;
+};
+
 /*
  * Opens the specified memory buffer for reading and allocates a new I/O object for it.
  * The assigned I/O object MUST be destroyed later with sail_destroy_io().
@@ -46,6 +80,13 @@ struct sail_io;
  */
 SAIL_HIDDEN sail_status_t alloc_io_read_mem(const void *buffer, size_t length, struct sail_io **io);
 
+/*
+ * Initializes the specified memory read stream with the buffer and sets up the I/O object
+ * to read from it with the memory reading callbacks. The close callback frees the stream with sail_free(),
+ * so callers with streams requiring extra cleanup must override it.
+ */
+SAIL_HIDDEN void init_io_read_mem(const void *buffer, size_t length, struct mem_io_read_stream *mem_io_read_stream, struct sail_io *io);
+
 /*
  * Opens the specified memory buffer for writing and allocates a new I/O object for it.
  * The assigned I/O object MUST be destroyed later with sail_destroy_io().
@@ -54,4 +95,14 @@ SAIL_HIDDEN sail_status_t alloc_io_read_mem(const void *buffer, size_t length, s
  */
 SAIL_HIDDEN sail_status_t alloc_io_write_mem(void *buffer, size_t length, struct sail_io **io);
 
+/*
+ * Opens a new memory buffer for writing that grows geometrically as data is written, and allocates
+ * a new I/O object for it. The buffer and its data length are published through the specified locations
+ * on every write, so they stay valid after the I/O object is destroyed. The buffer is owned by the caller
+ * and MUST be freed with sail_free(). The assigned I/O object MUST be destroyed later with sail_destroy_io().
+ *
+ * Returns SAIL_OK on success.
+ */
+SAIL_HIDDEN sail_status_t alloc_io_write_growable_mem(void **buffer, size_t *buffer_length, struct sail_io **io);
+
 #endif
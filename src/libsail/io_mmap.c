@@ -0,0 +1,242 @@
+/*  This file is part of SAIL (https://github.com/smoked-herring/sail)
+
+    Copyright (c) 2020 Dmitry Baryshev
+
+    The MIT License
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#include "config.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef SAIL_WIN32
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include "sail-common.h"
+#include "sail.h"
+
+struct mmap_io_read_stream {
+
+    /* Must be first to share the memory I/O callbacks. */
+    struct mem_io_read_stream mem_io_read_stream;
+
+    void *mapping;
+    size_t mapping_length;
+};
+
+/*
+ * Private functions.
+ */
+
+static void unmap_file(void *mapping, size_t mapping_length) {
+
+#ifdef SAIL_WIN32
+    (void)mapping_length;
+    UnmapViewOfFile(mapping);
+#else
+    munmap(mapping, mapping_length);
+#endif
+}
+
+static sail_status_t io_mmap_close(void *stream) {
+
+    SAIL_CHECK_STREAM_PTR(stream);
+
+    struct mmap_io_read_stream *mmap_io_read_stream = (struct mmap_io_read_stream *)stream;
+
+    unmap_file(mmap_io_read_stream->mapping, mmap_io_read_stream->mapping_length);
+
+    sail_free(mmap_io_read_stream);
+
+    return SAIL_OK;
+}
+
+#ifdef SAIL_WIN32
+static sail_status_t map_file(const char *path, void **mapping, size_t *mapping_length) {
+
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                                FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+
+    if (file == INVALID_HANDLE_VALUE) {
+        SAIL_LOG_ERROR("Failed to open the specified file. Error: 0x%X", GetLastError());
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_OPEN_FILE);
+    }
+
+    LARGE_INTEGER file_size;
+
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0 || (ULONGLONG)file_size.QuadPart > SIZE_MAX) {
+        CloseHandle(file);
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_READ_IO);
+    }
+
+    HANDLE file_mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+
+    if (file_mapping == NULL) {
+        SAIL_LOG_ERROR("Failed to map the specified file. Error: 0x%X", GetLastError());
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_READ_IO);
+    }
+
+    /* The view keeps the mapping object alive. */
+    *mapping = MapViewOfFile(file_mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(file_mapping);
+
+    if (*mapping == NULL) {
+        SAIL_LOG_ERROR("Failed to map the specified file. Error: 0x%X", GetLastError());
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_READ_IO);
+    }
+
+    *mapping_length = (size_t)file_size.QuadPart;
+
+    return SAIL_OK;
+}
+
+static bool file_size(const char *path, size_t *size) {
+
+    WIN32_FILE_ATTRIBUTE_DATA attrs;
+
+    if (!GetFileAttributesExA(path, GetFileExInfoStandard, &attrs)) {
+        return false;
+    }
+
+    const ULONGLONG size64 = ((ULONGLONG)attrs.nFileSizeHigh << 32) | attrs.nFileSizeLow;
+
+    if (size64 > SIZE_MAX) {
+        return false;
+    }
+
+    *size = (size_t)size64;
+
+    return true;
+}
+#else
+static sail_status_t map_file(const char *path, void **mapping, size_t *mapping_length) {
+
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0) {
+        sail_print_errno("Failed to open the specified file: %s");
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_OPEN_FILE);
+    }
+
+    struct stat attrs;
+
+    /* Empty files cannot be mapped. */
+    if (fstat(fd, &attrs) != 0 || !S_ISREG(attrs.st_mode) || attrs.st_size == 0) {
+        close(fd);
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_READ_IO);
+    }
+
+    *mapping = mmap(NULL, (size_t)attrs.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    /* The mapping stays valid after closing the descriptor. */
+    close(fd);
+
+    if (*mapping == MAP_FAILED) {
+        sail_print_errno("Failed to map the specified file: %s");
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_READ_IO);
+    }
+
+#ifdef MADV_SEQUENTIAL
+    madvise(*mapping, (size_t)attrs.st_size, MADV_SEQUENTIAL);
+#endif
+
+    *mapping_length = (size_t)attrs.st_size;
+
+    return SAIL_OK;
+}
+
+static bool file_size(const char *path, size_t *size) {
+
+    struct stat attrs;
+
+    if (stat(path, &attrs) != 0 || !S_ISREG(attrs.st_mode)) {
+        return false;
+    }
+
+    *size = (size_t)attrs.st_size;
+
+    return true;
+}
+#endif
+
+/*
+ * Public functions.
+ */
+
+sail_status_t alloc_io_read_mmap(const char *path, struct sail_io **io) {
+
+    SAIL_CHECK_PATH_PTR(path);
+    SAIL_CHECK_IO_PTR(io);
+
+    SAIL_LOG_DEBUG("Mapping file '%s' for reading", path);
+
+    void *mapping;
+    size_t mapping_length;
+    SAIL_TRY(map_file(path, &mapping, &mapping_length));
+
+    SAIL_TRY_OR_CLEANUP(sail_alloc_io(io),
+                        /* cleanup */ unmap_file(mapping, mapping_length));
+
+    void *ptr;
+    SAIL_TRY_OR_CLEANUP(sail_malloc(sizeof(struct mmap_io_read_stream), &ptr),
+                        /* cleanup */ unmap_file(mapping, mapping_length),
+                                      sail_destroy_io(*io));
+    struct mmap_io_read_stream *mmap_io_read_stream = ptr;
+
+    mmap_io_read_stream->mapping        = mapping;
+    mmap_io_read_stream->mapping_length = mapping_length;
+
+    init_io_read_mem(mapping, mapping_length, &mmap_io_read_stream->mem_io_read_stream, *io);
+
+    (*io)->id     = SAIL_MMAP_IO_ID;
+    (*io)->stream = mmap_io_read_stream;
+    (*io)->close  = io_mmap_close;
+
+    return SAIL_OK;
+}
+
+sail_status_t alloc_io_read_file_auto(const char *path, bool force_mmap, struct sail_io **io) {
+
+    SAIL_CHECK_PATH_PTR(path);
+    SAIL_CHECK_IO_PTR(io);
+
+    size_t size;
+
+    if (force_mmap || (file_size(path, &size) && size >= SAIL_MMAP_IO_THRESHOLD)) {
+        if (alloc_io_read_mmap(path, io) == SAIL_OK) {
+            return SAIL_OK;
+        }
+
+        SAIL_LOG_DEBUG("Failed to map '%s', falling back to file I/O", path);
+    }
+
+    SAIL_TRY(alloc_io_read_file(path, io));
+
+    return SAIL_OK;
+}
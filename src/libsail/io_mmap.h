@@ -0,0 +1,64 @@
+/*  This file is part of SAIL (https://github.com/smoked-herring/sail)
+
+    Copyright (c) 2020 Dmitry Baryshev
+
+    The MIT License
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#ifndef SAIL_IO_MMAP_H
+#define SAIL_IO_MMAP_H
+
+#include <stdbool.h>
+
+#ifdef SAIL_BUILD
+    #include "error.h"
+    #include "export.h"
+#else
+    #include <sail-common/error.h>
+    #include <sail-common/export.h>
+#endif
+
+struct sail_io;
+
+/*
+ * Files of this size and larger are memory-mapped automatically by alloc_io_read_file_auto().
+ */
+#define SAIL_MMAP_IO_THRESHOLD (1024 * 1024)
+
+/*
+ * Maps the specified image file into memory for reading and allocates a new I/O object for it.
+ * The I/O object reuses the memory I/O callbacks and exposes the whole mapping with the buffer callback.
+ * The assigned I/O object MUST be destroyed later with sail_destroy_io().
+ *
+ * Returns SAIL_OK on success.
+ */
+SAIL_HIDDEN sail_status_t alloc_io_read_mmap(const char *path, struct sail_io **io);
+
+/*
+ * Opens the specified image file for reading and allocates a new I/O object for it. Maps the file
+ * into memory if force_mmap is true or the file size is at least SAIL_MMAP_IO_THRESHOLD. Falls back
+ * to the regular file I/O if the file cannot be mapped.
+ * The assigned I/O object MUST be destroyed later with sail_destroy_io().
+ *
+ * Returns SAIL_OK on success.
+ */
+SAIL_HIDDEN sail_status_t alloc_io_read_file_auto(const char *path, bool force_mmap, struct sail_io **io);
+
+#endif
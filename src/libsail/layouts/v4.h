@@ -31,6 +31,8 @@
  * to simplify debugging.
  */
 
+#include <stddef.h> /* size_t */
+
 #ifdef SAIL_BUILD
 #include "error.h"
 #else
@@ -111,6 +113,89 @@ sail_status_t SAIL_CONSTRUCT_CODEC_FUNC(sail_codec_read_frame_v4)(void *state, s
  */
 sail_status_t SAIL_CONSTRUCT_CODEC_FUNC(sail_codec_read_finish_v4)(void **state, struct sail_io *io);
 
+/*
+ * Optional functions. libsail works without them, but codecs could implement them to work faster.
+ */
+
+/*
+ * Reads the first frame properties without decoding it. The specified read options are used the same way
+ * as in sail_codec_read_init_v4() + sail_codec_read_seek_next_frame_v4(), so the resulting image MUST be equal
+ * to the image returned by them. Codecs SHOULD parse just the headers and meta data and avoid allocating
+ * decoding buffers.
+ *
+ * If a codec doesn't implement this function, libsail probes images with sail_codec_read_init_v4()
+ * + sail_codec_read_seek_next_frame_v4() + sail_codec_read_finish_v4().
+ *
+ * The assigned image MUST be destroyed later with sail_destroy_image() by the client.
+ *
+ * Returns SAIL_OK on success.
+ */
+sail_status_t SAIL_CONSTRUCT_CODEC_FUNC(sail_codec_probe_v4)(struct sail_io *io, const struct sail_read_options *read_options, struct sail_image **image);
+
+/*
+ * Reads the next rows of the current frame into the specified buffer. The buffer holds row_count rows,
+ * image->bytes_per_line bytes each. first_row is the index of the first row to read. libsail calls this function
+ * sequentially after sail_codec_read_seek_next_pass_v4(), i.e. first_row always starts at 0 and continues right
+ * after the rows read by the previous call. It never requests rows beyond the image height. The image pixels
+ * are NOT allocated.
+ *
+ * libsail never calls this function for interlaced images.
+ *
+ * If a codec doesn't implement this function, libsail reads the whole frame with sail_codec_read_frame_v4()
+ * and copies the requested rows from it.
+ *
+ * Returns SAIL_OK on success.
+ */
+sail_status_t SAIL_CONSTRUCT_CODEC_FUNC(sail_codec_read_rows_v4)(void *state, struct sail_io *io, const struct sail_image *image,
+                                                                 unsigned first_row, unsigned row_count, void *rows);
+
+/*
+ * Resets the decoding state to decode a new image from the specified io stream with the same read options
+ * as passed to sail_codec_read_init_v4(). After that, the state behaves as returned by sail_codec_read_init_v4()
+ * for the new io stream. The previous io stream could be in any state and MUST NOT be accessed. Codecs SHOULD
+ * keep their decoders and internal buffers allocated to avoid the initialization costs.
+ *
+ * On error, libsail only calls sail_codec_read_finish_v4() with the state.
+ *
+ * If a codec doesn't implement this function, sail_reset_reading() returns SAIL_ERROR_NOT_IMPLEMENTED.
+ *
+ * Returns SAIL_OK on success.
+ */
+sail_status_t SAIL_CONSTRUCT_CODEC_FUNC(sail_codec_read_reset_v4)(void *state, struct sail_io *io);
+
+/*
+ * Incremental decoding. Codecs implement either all of these functions or none of them.
+ *
+ * Starts decoding the first frame of an image which data is pushed with sail_codec_feed_v4() in chunks
+ * as it arrives. No data is available at this point. The specified read options will be deep copied
+ * into an internal buffer. libsail never requests cropping from these functions.
+ *
+ * Returns SAIL_OK on success.
+ */
+sail_status_t SAIL_CONSTRUCT_CODEC_FUNC(sail_codec_feed_init_v4)(const struct sail_read_options *read_options, void **state);
+
+/*
+ * Decodes as much of the first frame as possible with the specified next chunk of data. The chunk is not used
+ * after the function returns, so codecs MUST keep the unconsumed bytes themselves. A NULL buffer means the end
+ * of the data.
+ *
+ * The image is NULL until the image header is decoded. After that, it points to the image held by the state
+ * with all the pixels allocated. Rows [0, valid_rows) hold final pixels. Codecs decoding interlaced or progressive
+ * images MAY also fill the other rows with coarser pixels of earlier passes. The image MUST NOT be changed by
+ * the client and remains valid until sail_codec_feed_finish_v4().
+ *
+ * Returns SAIL_OK on success. It's not an error to run out of data.
+ */
+sail_status_t SAIL_CONSTRUCT_CODEC_FUNC(sail_codec_feed_v4)(void *state, const void *buffer, size_t buffer_length,
+                                                             const struct sail_image **image, unsigned *valid_rows);
+
+/*
+ * Finishes incremental decoding and destroys the state with the image.
+ *
+ * Returns SAIL_OK on success.
+ */
+sail_status_t SAIL_CONSTRUCT_CODEC_FUNC(sail_codec_feed_finish_v4)(void **state);
+
 /*
  * Encoding functions.
  */
@@ -36,13 +36,17 @@
     #include "ini.h"
     #include "io_file.h"
     #include "io_mem.h"
+    #include "io_mmap.h"
     #include "io_noop.h"
     #include "codec.h"
     #include "codec_info.h"
+    #include "codec_info_index.h"
     #include "codec_info_node.h"
     #include "codec_info_private.h"
     #include "sail_advanced.h"
+    #include "sail_batch.h"
     #include "sail_deep_diver.h"
+    #include "sail_feed.h"
     #include "sail_junior.h"
     #include "sail_private.h"
     #include "sail_technical_diver.h"
@@ -55,7 +59,9 @@
     #include <sail/codec_info_node.h>
     #include <sail/context.h>
     #include <sail/sail_advanced.h>
+    #include <sail/sail_batch.h>
     #include <sail/sail_deep_diver.h>
+    #include <sail/sail_feed.h>
     #include <sail/sail_junior.h>
     #include <sail/sail_technical_diver.h>
     #include <sail/string_node.h>
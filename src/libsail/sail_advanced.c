@@ -26,10 +26,32 @@
 #include "config.h"
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "sail-common.h"
 #include "sail.h"
 
+/*
+ * Private functions.
+ */
+
+static sail_status_t read_frame_pixels(const struct hidden_state *state_of_mind, struct sail_image *image) {
+
+    /* Allocate pixels. */
+    unsigned pixels_size;
+    SAIL_TRY(sail_bytes_per_image(image, &pixels_size));
+
+    SAIL_TRY(sail_malloc_pixels(pixels_size, &image->pixels));
+
+    SAIL_TRY(read_frame_passes(state_of_mind, image));
+
+    return SAIL_OK;
+}
+
+/*
+ * Public functions.
+ */
+
 sail_status_t sail_probe_io(struct sail_io *io, struct sail_image **image, const struct sail_codec_info **codec_info) {
 
     SAIL_CHECK_IO_PTR(io);
@@ -48,6 +70,16 @@ sail_status_t sail_probe_io(struct sail_io *io, struct sail_image **image, const
     SAIL_TRY_OR_CLEANUP(sail_alloc_read_options_from_features((*codec_info_local)->read_features, &read_options_local),
                         /* cleanup */ sail_destroy_read_options(read_options_local));
 
+    /* Fast path. Parse just the headers. */
+    if (codec->v4->probe != NULL) {
+        SAIL_TRY_OR_CLEANUP(codec->v4->probe(io, read_options_local, image),
+                            /* cleanup */ sail_destroy_read_options(read_options_local));
+
+        sail_destroy_read_options(read_options_local);
+
+        return SAIL_OK;
+    }
+
     SAIL_TRY_OR_CLEANUP(codec->v4->read_init(io, read_options_local, &state),
                         /* cleanup */ codec->v4->read_finish(&state, io),
                                       sail_destroy_read_options(read_options_local));
@@ -90,6 +122,30 @@ sail_status_t sail_start_reading_mem(const void *buffer, size_t buffer_length, c
     return SAIL_OK;
 }
 
+sail_status_t sail_reset_reading_file(void *state, const char *path) {
+
+    SAIL_CHECK_PATH_PTR(path);
+
+    struct sail_io *io;
+    SAIL_TRY(alloc_io_read_file_auto(path, false /* force mmap */, &io));
+
+    SAIL_TRY(reset_reading_io(state, io, true));
+
+    return SAIL_OK;
+}
+
+sail_status_t sail_reset_reading_mem(void *state, const void *buffer, size_t buffer_length) {
+
+    SAIL_CHECK_BUFFER_PTR(buffer);
+
+    struct sail_io *io;
+    SAIL_TRY(alloc_io_read_mem(buffer, buffer_length, &io));
+
+    SAIL_TRY(reset_reading_io(state, io, true));
+
+    return SAIL_OK;
+}
+
 sail_status_t sail_read_next_frame(void *state, struct sail_image **image) {
 
     SAIL_CHECK_STATE_PTR(state);
@@ -101,39 +157,124 @@ sail_status_t sail_read_next_frame(void *state, struct sail_image **image) {
     SAIL_CHECK_STATE_PTR(state_of_mind->state);
     SAIL_CHECK_CODEC_PTR(state_of_mind->codec);
 
+    reset_rows_reading(state_of_mind);
+
     SAIL_TRY(state_of_mind->codec->v4->read_seek_next_frame(state_of_mind->state, state_of_mind->io, image));
 
-    /* Detect the number of passes needed to write an interlaced image. */
-    int interlaced_passes;
-    if ((*image)->source_image->properties & SAIL_IMAGE_PROPERTY_INTERLACED) {
-        interlaced_passes = (*image)->interlaced_passes;
+    SAIL_TRY_OR_CLEANUP(read_frame_pixels(state_of_mind, *image),
+                        /* cleanup */ sail_destroy_image(*image));
 
-        if (interlaced_passes < 1) {
-            sail_destroy_image(*image);
-            SAIL_LOG_AND_RETURN(SAIL_ERROR_INTERLACING_UNSUPPORTED);
-        }
-    } else {
-        interlaced_passes = 1;
+    /* The codec cannot crop itself. */
+    SAIL_TRY_OR_CLEANUP(crop_frame(state_of_mind, image),
+                        /* cleanup */ sail_destroy_image(*image));
+
+    /* The codec cannot output the requested pixel format itself. */
+    if (state_of_mind->convert_pixel_format != SAIL_PIXEL_FORMAT_UNKNOWN) {
+        struct sail_image *image_converted;
+        SAIL_TRY_OR_CLEANUP(sail_convert_image(*image, state_of_mind->convert_pixel_format, &image_converted),
+                            /* cleanup */ sail_destroy_image(*image));
+
+        sail_destroy_image(*image);
+        *image = image_converted;
     }
 
-    /* Allocate pixels. */
-    unsigned pixels_size;
-    SAIL_TRY_OR_CLEANUP(sail_bytes_per_image(*image, &pixels_size),
-                        /* cleanup */ sail_destroy_image(*image));
+    return SAIL_OK;
+}
+
+sail_status_t sail_start_reading_rows(void *state, struct sail_image **image) {
+
+    SAIL_CHECK_STATE_PTR(state);
+    SAIL_CHECK_IMAGE_PTR(image);
+
+    struct hidden_state *state_of_mind = (struct hidden_state *)state;
+
+    SAIL_CHECK_IO(state_of_mind->io);
+    SAIL_CHECK_STATE_PTR(state_of_mind->state);
+    SAIL_CHECK_CODEC_PTR(state_of_mind->codec);
+
+    reset_rows_reading(state_of_mind);
 
-    SAIL_TRY_OR_CLEANUP(sail_malloc(pixels_size, &(*image)->pixels),
+    if (state_of_mind->convert_pixel_format != SAIL_PIXEL_FORMAT_UNKNOWN) {
+        SAIL_LOG_ERROR("Row streaming is not supported with pixel formats the codec cannot output itself");
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_UNSUPPORTED_PIXEL_FORMAT);
+    }
+
+    SAIL_TRY(state_of_mind->codec->v4->read_seek_next_frame(state_of_mind->state, state_of_mind->io, image));
+
+    struct sail_image *rows_image;
+    SAIL_TRY_OR_CLEANUP(sail_copy_image(*image, &rows_image),
                         /* cleanup */ sail_destroy_image(*image));
 
-    for (int pass = 0; pass < interlaced_passes; pass++) {
-        SAIL_TRY_OR_CLEANUP(state_of_mind->codec->v4->read_seek_next_pass(state_of_mind->state, state_of_mind->io, *image),
-                            /* cleanup */ sail_destroy_image(*image));
+    const bool interlaced = rows_image->source_image->properties & SAIL_IMAGE_PROPERTY_INTERLACED;
 
-        SAIL_TRY_OR_CLEANUP(state_of_mind->codec->v4->read_frame(state_of_mind->state,
-                                                                    state_of_mind->io,
-                                                                    *image),
-                            /* cleanup */ sail_destroy_image(*image));
+    if (state_of_mind->codec->v4->read_rows != NULL && !interlaced && state_of_mind->crop_read_options == NULL) {
+        SAIL_TRY_OR_CLEANUP(state_of_mind->codec->v4->read_seek_next_pass(state_of_mind->state, state_of_mind->io, rows_image),
+                            /* cleanup */ sail_destroy_image(rows_image),
+                                          sail_destroy_image(*image));
+    } else {
+        /* The codec cannot deliver separate rows. Read the whole frame and serve the rows from it. */
+        SAIL_LOG_DEBUG("Codec '%s' cannot stream rows of this image, reading the whole frame", state_of_mind->codec_info->name);
+
+        SAIL_TRY_OR_CLEANUP(read_frame_pixels(state_of_mind, rows_image),
+                            /* cleanup */ sail_destroy_image(rows_image),
+                                          sail_destroy_image(*image));
+
+        /* The codec cannot crop itself. */
+        SAIL_TRY_OR_CLEANUP(crop_frame(state_of_mind, &rows_image),
+                            /* cleanup */ sail_destroy_image(rows_image),
+                                          sail_destroy_image(*image));
+
+        (*image)->width          = rows_image->width;
+        (*image)->height         = rows_image->height;
+        (*image)->bytes_per_line = rows_image->bytes_per_line;
+    }
+
+    state_of_mind->rows_image = rows_image;
+
+    return SAIL_OK;
+}
+
+sail_status_t sail_read_next_rows(void *state, void *rows, unsigned row_count, unsigned *read_rows) {
+
+    SAIL_CHECK_STATE_PTR(state);
+    SAIL_CHECK_BUFFER_PTR(rows);
+    SAIL_CHECK_RESULT_PTR(read_rows);
+
+    struct hidden_state *state_of_mind = (struct hidden_state *)state;
+
+    SAIL_CHECK_IO(state_of_mind->io);
+    SAIL_CHECK_STATE_PTR(state_of_mind->state);
+    SAIL_CHECK_CODEC_PTR(state_of_mind->codec);
+
+    const struct sail_image *rows_image = state_of_mind->rows_image;
+
+    if (rows_image == NULL) {
+        SAIL_LOG_ERROR("Rows are read before calling sail_start_reading_rows()");
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_INVALID_ARGUMENT);
+    }
+
+    const unsigned rows_left = rows_image->height - state_of_mind->next_row;
+    const unsigned rows_to_read = row_count < rows_left ? row_count : rows_left;
+
+    if (rows_to_read > 0) {
+        if (rows_image->pixels != NULL) {
+            memcpy(rows,
+                    (const unsigned char *)rows_image->pixels + (size_t)state_of_mind->next_row * rows_image->bytes_per_line,
+                    (size_t)rows_to_read * rows_image->bytes_per_line);
+        } else {
+            SAIL_TRY(state_of_mind->codec->v4->read_rows(state_of_mind->state,
+                                                            state_of_mind->io,
+                                                            rows_image,
+                                                            state_of_mind->next_row,
+                                                            rows_to_read,
+                                                            rows));
+        }
+
+        state_of_mind->next_row += rows_to_read;
     }
 
+    *read_rows = rows_to_read;
+
     return SAIL_OK;
 }
 
@@ -174,6 +315,13 @@ sail_status_t sail_start_writing_mem(void *buffer, size_t buffer_length, const s
     return SAIL_OK;
 }
 
+sail_status_t sail_start_writing_growable_mem(void **buffer, size_t *buffer_length, const struct sail_codec_info *codec_info, void **state) {
+
+    SAIL_TRY(sail_start_writing_growable_mem_with_options(buffer, buffer_length, codec_info, NULL, state));
+
+    return SAIL_OK;
+}
+
 sail_status_t sail_write_next_frame(void *state, const struct sail_image *image) {
 
     SAIL_CHECK_STATE_PTR(state);
@@ -119,6 +119,34 @@ SAIL_EXPORT sail_status_t sail_start_reading_file(const char *path, const struct
 SAIL_EXPORT sail_status_t sail_start_reading_mem(const void *buffer, size_t buffer_length,
                                                 const struct sail_codec_info *codec_info, void **state);
 
+/*
+ * Resets the reading state to read the specified image file with the same codec and read options.
+ * See sail_reset_reading() for more.
+ *
+ * Typical usage: sail_start_reading_file() ->
+ *                sail_read_next_frame()    ->
+ *                sail_reset_reading_file() ->
+ *                sail_read_next_frame()    ->
+ *                sail_stop_reading().
+ *
+ * Returns SAIL_OK on success.
+ */
+SAIL_EXPORT sail_status_t sail_reset_reading_file(void *state, const char *path);
+
+/*
+ * Resets the reading state to read the specified memory buffer with the same codec and read options.
+ * See sail_reset_reading() for more.
+ *
+ * Typical usage: sail_start_reading_mem() ->
+ *                sail_read_next_frame()   ->
+ *                sail_reset_reading_mem() ->
+ *                sail_read_next_frame()   ->
+ *                sail_stop_reading().
+ *
+ * Returns SAIL_OK on success.
+ */
+SAIL_EXPORT sail_status_t sail_reset_reading_mem(void *state, const void *buffer, size_t buffer_length);
+
 /*
  * Continues reading the file started by sail_start_reading_file() and brothers. The assigned image
  * MUST be destroyed later with sail_image_destroy().
@@ -128,6 +156,37 @@ SAIL_EXPORT sail_status_t sail_start_reading_mem(const void *buffer, size_t buff
  */
 SAIL_EXPORT sail_status_t sail_read_next_frame(void *state, struct sail_image **image);
 
+/*
+ * Continues reading the file started by sail_start_reading_file() and brothers. Seeks to the next frame
+ * and returns its properties without pixels like sail_read_next_frame() does. The pixels are read later
+ * in bands with sail_read_next_rows(). The assigned image MUST be destroyed later with sail_destroy_image().
+ *
+ * Streaming rows bounds the memory needed to read huge images by the band size. If the codec
+ * cannot stream rows or the image is interlaced, SAIL reads the whole frame into an internal buffer
+ * and copies the requested rows from it.
+ *
+ * Typical usage: sail_start_reading_file() ->
+ *                sail_start_reading_rows() ->
+ *                sail_read_next_rows()     ->
+ *                ...                       ->
+ *                sail_stop_reading().
+ *
+ * Returns SAIL_OK on success.
+ * Returns SAIL_ERROR_NO_MORE_FRAMES when no more frames are available.
+ */
+SAIL_EXPORT sail_status_t sail_start_reading_rows(void *state, struct sail_image **image);
+
+/*
+ * Reads up to row_count next rows of the frame started by sail_start_reading_rows() into the specified buffer.
+ * The buffer must hold row_count rows, image->bytes_per_line bytes each. Saves the number of rows actually read
+ * into read_rows. It's less than row_count for the last band and 0 when all the rows have been read already.
+ *
+ * The rows of the current frame must be read before seeking to the next frame.
+ *
+ * Returns SAIL_OK on success.
+ */
+SAIL_EXPORT sail_status_t sail_read_next_rows(void *state, void *rows, unsigned row_count, unsigned *read_rows);
+
 /*
  * Stops reading the file started by sail_start_reading_file() and brothers. Does nothing if the state is NULL.
  *
@@ -191,6 +250,28 @@ SAIL_EXPORT sail_status_t sail_start_writing_file(const char *path, const struct
 SAIL_EXPORT sail_status_t sail_start_writing_mem(void *buffer, size_t buffer_length,
                                                 const struct sail_codec_info *codec_info, void **state);
 
+/*
+ * Starts writing into a growable memory buffer allocated by SAIL. See sail_start_writing_growable_mem_with_options()
+ * for the buffer ownership rules.
+ *
+ * The subsequent calls to sail_write_next_frame() output pixels in pixel format
+ * as specified in sail_write_features.default_output_pixel_format.
+ *
+ * Typical usage: sail_codec_info_from_extension()  ->
+ *                sail_start_writing_growable_mem() ->
+ *                sail_write_next_frame()           ->
+ *                sail_stop_writing()               ->
+ *                sail_free(buffer).
+ *
+ * STATE explanation: Passes the address of a local void* pointer. SAIL will store an internal state
+ * in it and destroy it in sail_stop_writing. States must be used per image. DO NOT use the same state
+ * to start writing multiple images at the same time.
+ *
+ * Returns SAIL_OK on success.
+ */
+SAIL_EXPORT sail_status_t sail_start_writing_growable_mem(void **buffer, size_t *buffer_length,
+                                                         const struct sail_codec_info *codec_info, void **state);
+
 /*
  * Continues writing the file started by sail_start_writing_file() and brothers.
  *
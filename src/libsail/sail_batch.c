@@ -0,0 +1,442 @@
+/*  This file is part of SAIL (https://github.com/smoked-herring/sail)
+
+    Copyright (c) 2020 Dmitry Baryshev
+
+    The MIT License
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "config.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef SAIL_WIN32
+    #include <windows.h>
+#else
+    #include <pthread.h>
+    #include <unistd.h> /* sysconf */
+#endif
+
+#include "sail-common.h"
+#include "sail.h"
+
+/* Upper limit of worker threads. */
+#define SAIL_BATCH_MAX_THREADS 256
+
+#ifdef SAIL_WIN32
+typedef SRWLOCK batch_lock_t;
+#else
+typedef pthread_mutex_t batch_lock_t;
+#endif
+
+/* Task of the thread pool reading items of the current batch. */
+struct batch_worker {
+    struct sail_batch_reader *batch_reader;
+
+    /* Items [begin, end) of the current batch owned by the worker. Thieves take items from the end. */
+    batch_lock_t lock;
+    unsigned begin;
+    unsigned end;
+
+    /*
+     * Reading state of the last item. It's reset with sail_reset_reading() to read the next item
+     * of the same codec without creating a new decoder. Accessed by the thread executing the worker only.
+     */
+    void *state;
+    const struct sail_codec_info *codec_info;
+};
+
+struct sail_batch_reader {
+    struct sail_thread_pool *pool;
+    struct batch_worker *workers;
+    unsigned threads;
+
+    /* Current batch. */
+    const struct sail_batch_item *items;
+    const struct sail_read_options *read_options;
+    sail_batch_callback_t callback;
+    void *user_data;
+};
+
+/*
+ * Private functions.
+ */
+
+static void init_lock(batch_lock_t *lock) {
+
+#ifdef SAIL_WIN32
+    InitializeSRWLock(lock);
+#else
+    pthread_mutex_init(lock, NULL);
+#endif
+}
+
+static void destroy_lock(batch_lock_t *lock) {
+
+#ifdef SAIL_WIN32
+    (void)lock;
+#else
+    pthread_mutex_destroy(lock);
+#endif
+}
+
+static void lock(batch_lock_t *lock) {
+
+#ifdef SAIL_WIN32
+    AcquireSRWLockExclusive(lock);
+#else
+    pthread_mutex_lock(lock);
+#endif
+}
+
+static void unlock(batch_lock_t *lock) {
+
+#ifdef SAIL_WIN32
+    ReleaseSRWLockExclusive(lock);
+#else
+    pthread_mutex_unlock(lock);
+#endif
+}
+
+static unsigned online_processors(void) {
+
+#ifdef SAIL_WIN32
+    SYSTEM_INFO system_info;
+    GetSystemInfo(&system_info);
+
+    return system_info.dwNumberOfProcessors > 0 ? (unsigned)system_info.dwNumberOfProcessors : 1;
+#else
+    const long processors = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return processors > 0 ? (unsigned)processors : 1;
+#endif
+}
+
+/* Stops the reading state kept by the worker. */
+static void stop_worker_state(struct batch_worker *worker) {
+
+    SAIL_TRY_OR_SUPPRESS(sail_stop_reading(worker->state));
+
+    worker->state      = NULL;
+    worker->codec_info = NULL;
+}
+
+/* Returns the I/O stream and codec info of the item. The I/O stream is owned by the caller if own_io is true. */
+static sail_status_t open_item(const struct sail_batch_item *item, const struct sail_read_options *read_options,
+                                struct sail_io **io, bool *own_io, const struct sail_codec_info **codec_info) {
+
+    if (item->path != NULL) {
+        SAIL_TRY(sail_codec_info_from_path(item->path, codec_info));
+
+        const bool force_mmap = read_options != NULL && (read_options->io_options & SAIL_IO_OPTION_MMAP);
+        SAIL_TRY(alloc_io_read_file_auto(item->path, force_mmap, io));
+        *own_io = true;
+    } else if (item->buffer != NULL) {
+        SAIL_TRY(sail_codec_info_by_magic_number_from_mem(item->buffer, item->buffer_length, codec_info));
+        SAIL_TRY(alloc_io_read_mem(item->buffer, item->buffer_length, io));
+        *own_io = true;
+    } else if (item->io != NULL) {
+        SAIL_TRY(sail_codec_info_by_magic_number_from_io(item->io, codec_info));
+        *io = item->io;
+        *own_io = false;
+    } else {
+        SAIL_LOG_ERROR("Batch item has no path, buffer, or I/O object");
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_INVALID_ARGUMENT);
+    }
+
+    return SAIL_OK;
+}
+
+/*
+ * Reads the first frame of the item. Resets the reading state of the previous item when it has the same codec,
+ * and the codec supports it. Otherwise, starts a new reading state. The state is kept by the worker
+ * until the next item or the end of the batch.
+ */
+static sail_status_t read_item(struct batch_worker *worker, const struct sail_batch_item *item,
+                                const struct sail_read_options *read_options, struct sail_image **image) {
+
+    struct sail_io *io;
+    bool own_io;
+    const struct sail_codec_info *codec_info;
+    SAIL_TRY(open_item(item, read_options, &io, &own_io, &codec_info));
+
+    const struct hidden_state *state_of_mind = worker->state;
+
+    if (state_of_mind != NULL && worker->codec_info == codec_info && state_of_mind->codec->v4->read_reset != NULL) {
+        SAIL_TRY_OR_CLEANUP(reset_reading_io(worker->state, io, own_io),
+                            /* cleanup */ stop_worker_state(worker));
+    } else {
+        stop_worker_state(worker);
+
+        SAIL_TRY(start_reading_io_with_options(io, own_io, codec_info, read_options, &worker->state));
+        worker->codec_info = codec_info;
+    }
+
+    SAIL_TRY_OR_CLEANUP(sail_read_next_frame(worker->state, image),
+                        /* cleanup */ stop_worker_state(worker));
+
+    return SAIL_OK;
+}
+
+/* Takes the next item of the worker. Steals items from other workers when the worker has no items left. */
+static bool next_item(struct batch_worker *worker, unsigned *index) {
+
+    lock(&worker->lock);
+
+    if (worker->begin < worker->end) {
+        *index = worker->begin++;
+        unlock(&worker->lock);
+        return true;
+    }
+
+    unlock(&worker->lock);
+
+    struct sail_batch_reader *batch_reader = worker->batch_reader;
+    const unsigned self = (unsigned)(worker - batch_reader->workers);
+
+    for (unsigned i = 1; i < batch_reader->threads; i++) {
+        struct batch_worker *victim = &batch_reader->workers[(self + i) % batch_reader->threads];
+
+        lock(&victim->lock);
+
+        if (victim->begin == victim->end) {
+            unlock(&victim->lock);
+            continue;
+        }
+
+        /* Steal the second half. The victim keeps taking items from the beginning. */
+        const unsigned stolen_begin = victim->end - (victim->end - victim->begin + 1) / 2;
+        const unsigned stolen_end   = victim->end;
+        victim->end = stolen_begin;
+
+        unlock(&victim->lock);
+
+        lock(&worker->lock);
+        worker->begin = stolen_begin + 1;
+        worker->end   = stolen_end;
+        unlock(&worker->lock);
+
+        *index = stolen_begin;
+        return true;
+    }
+
+    return false;
+}
+
+/* Reads items until there are no items left in the batch. Executed by the pool threads. */
+static sail_status_t run_worker(void *task) {
+
+    struct batch_worker *worker = task;
+    struct sail_batch_reader *batch_reader = worker->batch_reader;
+    unsigned index;
+
+    while (next_item(worker, &index)) {
+        struct sail_image *image = NULL;
+        const sail_status_t status = read_item(worker, &batch_reader->items[index], batch_reader->read_options, &image);
+
+        batch_reader->callback(index, status, status == SAIL_OK ? image : NULL, batch_reader->user_data);
+    }
+
+    /* I/O objects and read options of the batch are not valid after it finishes. */
+    stop_worker_state(worker);
+
+    return SAIL_OK;
+}
+
+/* Attaches the pool thread to the shared context once, so the codecs stay loaded between batches. */
+static void attach_thread(void *user_data) {
+
+    (void)user_data;
+
+    SAIL_TRY_OR_SUPPRESS(sail_init_with_flags(SAIL_FLAG_SHARED_CONTEXT));
+}
+
+static void detach_thread(void *user_data) {
+
+    (void)user_data;
+
+    sail_finish();
+}
+
+static void destroy_batch_reader(struct sail_batch_reader *batch_reader) {
+
+    for (unsigned i = 0; i < batch_reader->threads; i++) {
+        destroy_lock(&batch_reader->workers[i].lock);
+    }
+
+    sail_free(batch_reader->workers);
+    sail_free(batch_reader);
+}
+
+/*
+ * Public functions.
+ */
+
+sail_status_t sail_alloc_batch_reader(unsigned threads, struct sail_batch_reader **batch_reader) {
+
+    SAIL_CHECK_PTR(batch_reader);
+
+    if (threads == 0) {
+        threads = online_processors();
+    }
+
+    if (threads > SAIL_BATCH_MAX_THREADS) {
+        threads = SAIL_BATCH_MAX_THREADS;
+    }
+
+    void *ptr;
+    SAIL_TRY(sail_malloc(sizeof(struct sail_batch_reader), &ptr));
+    struct sail_batch_reader *batch_reader_local = ptr;
+
+    SAIL_TRY_OR_CLEANUP(sail_malloc(sizeof(struct batch_worker) * threads, &ptr),
+                        /* cleanup */ sail_free(batch_reader_local));
+    batch_reader_local->workers = ptr;
+
+    batch_reader_local->pool         = NULL;
+    batch_reader_local->threads      = threads;
+    batch_reader_local->items        = NULL;
+    batch_reader_local->read_options = NULL;
+    batch_reader_local->callback     = NULL;
+    batch_reader_local->user_data    = NULL;
+
+    for (unsigned i = 0; i < threads; i++) {
+        struct batch_worker *worker = &batch_reader_local->workers[i];
+
+        worker->batch_reader = batch_reader_local;
+        worker->begin        = 0;
+        worker->end          = 0;
+        worker->state        = NULL;
+        worker->codec_info   = NULL;
+
+        init_lock(&worker->lock);
+    }
+
+    SAIL_TRY_OR_CLEANUP(sail_alloc_thread_pool_with_hooks(threads, attach_thread, detach_thread, NULL, &batch_reader_local->pool),
+                        /* cleanup */ destroy_batch_reader(batch_reader_local));
+
+    SAIL_LOG_DEBUG("Started batch reader with %u worker threads", threads);
+
+    *batch_reader = batch_reader_local;
+
+    return SAIL_OK;
+}
+
+void sail_destroy_batch_reader(struct sail_batch_reader *batch_reader) {
+
+    if (batch_reader == NULL) {
+        return;
+    }
+
+    sail_destroy_thread_pool(batch_reader->pool);
+    destroy_batch_reader(batch_reader);
+}
+
+sail_status_t sail_read_batch(struct sail_batch_reader *batch_reader,
+                              const struct sail_batch_item *items, unsigned item_count,
+                              const struct sail_read_options *read_options,
+                              sail_batch_callback_t callback, void *user_data) {
+
+    SAIL_CHECK_PTR(batch_reader);
+    SAIL_CHECK_PTR(items);
+    SAIL_CHECK_PTR(callback);
+
+    if (item_count == 0) {
+        return SAIL_OK;
+    }
+
+    batch_reader->items        = items;
+    batch_reader->read_options = read_options;
+    batch_reader->callback     = callback;
+    batch_reader->user_data    = user_data;
+
+    /* Split the items evenly. Workers rebalance them by stealing. */
+    for (unsigned i = 0; i < batch_reader->threads; i++) {
+        struct batch_worker *worker = &batch_reader->workers[i];
+
+        lock(&worker->lock);
+        worker->begin = (unsigned)((uint64_t)item_count * i / batch_reader->threads);
+        worker->end   = (unsigned)((uint64_t)item_count * (i + 1) / batch_reader->threads);
+        unlock(&worker->lock);
+    }
+
+    /* Items of workers failed to be submitted are stolen by the others. */
+    sail_status_t status = SAIL_OK;
+    unsigned submitted = 0;
+
+    for (; submitted < batch_reader->threads; submitted++) {
+        status = sail_thread_pool_submit(batch_reader->pool, run_worker, &batch_reader->workers[submitted]);
+
+        if (status != SAIL_OK) {
+            break;
+        }
+    }
+
+    for (unsigned i = 0; i < submitted; i++) {
+        void *task;
+        SAIL_TRY_OR_SUPPRESS(sail_thread_pool_take(batch_reader->pool, /* wait */ true, &task));
+    }
+
+    SAIL_TRY(status);
+
+    return SAIL_OK;
+}
+
+sail_status_t sail_read_files_batch(const char * const *paths, unsigned path_count, unsigned threads,
+                                    sail_batch_callback_t callback, void *user_data) {
+
+    SAIL_CHECK_PTR(paths);
+    SAIL_CHECK_PTR(callback);
+
+    if (path_count == 0) {
+        return SAIL_OK;
+    }
+
+    void *ptr;
+    SAIL_TRY(sail_malloc(sizeof(struct sail_batch_item) * path_count, &ptr));
+    struct sail_batch_item *items = ptr;
+
+    for (unsigned i = 0; i < path_count; i++) {
+        items[i].path          = paths[i];
+        items[i].buffer        = NULL;
+        items[i].buffer_length = 0;
+        items[i].io            = NULL;
+    }
+
+    /* Don't start more threads than files. */
+    if (threads == 0 || threads > path_count) {
+        const unsigned processors = (threads == 0) ? online_processors() : threads;
+        threads = (processors < path_count) ? processors : path_count;
+    }
+
+    struct sail_batch_reader *batch_reader;
+    SAIL_TRY_OR_CLEANUP(sail_alloc_batch_reader(threads, &batch_reader),
+                        /* cleanup */ sail_free(items));
+
+    SAIL_TRY_OR_CLEANUP(sail_read_batch(batch_reader, items, path_count, NULL /* read options */, callback, user_data),
+                        /* cleanup */ sail_destroy_batch_reader(batch_reader),
+                                      sail_free(items));
+
+    sail_destroy_batch_reader(batch_reader);
+    sail_free(items);
+
+    return SAIL_OK;
+}
@@ -0,0 +1,129 @@
+/*  This file is part of SAIL (https://github.com/smoked-herring/sail)
+
+    Copyright (c) 2020 Dmitry Baryshev
+
+    The MIT License
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+#ifndef SAIL_SAIL_BATCH_H
+#define SAIL_SAIL_BATCH_H
+
+#include <stddef.h>
+
+#ifdef SAIL_BUILD
+    #include "error.h"
+    #include "export.h"
+#else
+    #include <sail-common/error.h>
+    #include <sail-common/export.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct sail_image;
+struct sail_io;
+struct sail_read_options;
+
+/*
+ * A source of an image to read in a batch. Exactly one of path, buffer, or io must be set.
+ * The codec is detected by the file extension for paths and by magic numbers for buffers and I/O objects.
+ */
+struct sail_batch_item {
+
+    /* Path to an image file. */
+    const char *path;
+
+    /* Memory buffer with an image. */
+    const void *buffer;
+    size_t buffer_length;
+
+    /*
+     * I/O object to read an image from. It's not destroyed. The same I/O object MUST NOT
+     * be used by multiple items in a batch.
+     */
+    struct sail_io *io;
+};
+
+/*
+ * Receives the result of reading the item with the specified index. On success, the image is the first frame
+ * of the item and MUST be destroyed later with sail_destroy_image(). On error, the image is NULL.
+ *
+ * The callback is called from the worker threads concurrently, so it MUST be thread-safe.
+ */
+typedef void (*sail_batch_callback_t)(unsigned index, sail_status_t status, struct sail_image *image, void *user_data);
+
+/*
+ * Pool of threads reading independent images. Every worker thread attaches to the process-wide shared context,
+ * so all the workers share a single list of loaded codecs. See SAIL_FLAG_SHARED_CONTEXT. Workers stay alive
+ * between batches, so their contexts and loaded codecs remain warm.
+ *
+ * Items of a batch are split between workers evenly. A worker which has finished its items steals
+ * a half of the remaining items of another worker.
+ */
+struct sail_batch_reader;
+
+/*
+ * Allocates a new batch reader with the specified number of worker threads. 0 means the number
+ * of online processors. The assigned batch reader MUST be destroyed later with sail_destroy_batch_reader().
+ *
+ * Returns SAIL_OK on success.
+ */
+SAIL_EXPORT sail_status_t sail_alloc_batch_reader(unsigned threads, struct sail_batch_reader **batch_reader);
+
+/*
+ * Stops the worker threads and destroys the specified batch reader. Does nothing if the batch reader is NULL.
+ */
+SAIL_EXPORT void sail_destroy_batch_reader(struct sail_batch_reader *batch_reader);
+
+/*
+ * Reads the specified items in the worker threads and passes the results to the callback. Blocks until
+ * all the items are processed. The read options are optional and applied to all the items. Pass NULL
+ * to use the default read options of every codec.
+ *
+ * Batches of the same batch reader MUST NOT be started from multiple threads simultaneously.
+ *
+ * Returns SAIL_OK when all the items have been processed, even if some of them have failed to read.
+ * The status of every item is passed to the callback.
+ */
+SAIL_EXPORT sail_status_t sail_read_batch(struct sail_batch_reader *batch_reader,
+                                          const struct sail_batch_item *items, unsigned item_count,
+                                          const struct sail_read_options *read_options,
+                                          sail_batch_callback_t callback, void *user_data);
+
+/*
+ * Reads the specified image files in a temporary batch reader with the specified number of worker threads.
+ * 0 means the number of online processors. See sail_read_batch().
+ *
+ * Typical usage: This is a standalone function that could be called at any time. Keep a batch reader allocated
+ *                with sail_alloc_batch_reader() instead to read multiple batches.
+ *
+ * Returns SAIL_OK when all the files have been processed, even if some of them have failed to read.
+ */
+SAIL_EXPORT sail_status_t sail_read_files_batch(const char * const *paths, unsigned path_count, unsigned threads,
+                                                sail_batch_callback_t callback, void *user_data);
+
+/* extern "C" */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
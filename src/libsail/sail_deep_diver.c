@@ -25,6 +25,7 @@
 
 #include "config.h"
 
+#include <stdbool.h>
 #include <stdlib.h>
 
 #include "sail-common.h"
@@ -43,8 +44,10 @@ sail_status_t sail_start_reading_file_with_options(const char *path, const struc
         codec_info_local = codec_info;
     }
 
+    const bool force_mmap = read_options != NULL && (read_options->io_options & SAIL_IO_OPTION_MMAP);
+
     struct sail_io *io;
-    SAIL_TRY(alloc_io_read_file(path, &io));
+    SAIL_TRY(alloc_io_read_file_auto(path, force_mmap, &io));
 
     SAIL_TRY(start_reading_io_with_options(io, true, codec_info_local, read_options, state));
 
@@ -73,6 +76,73 @@ sail_status_t sail_start_reading_mem_with_options(const void *buffer, size_t buf
     return SAIL_OK;
 }
 
+sail_status_t sail_read_next_frame_into_buffer(void *state, void *pixels, unsigned pixels_size,
+                                               unsigned bytes_per_line, struct sail_image **image) {
+
+    SAIL_CHECK_STATE_PTR(state);
+    SAIL_CHECK_PIXELS_PTR(pixels);
+    SAIL_CHECK_IMAGE_PTR(image);
+
+    struct hidden_state *state_of_mind = (struct hidden_state *)state;
+
+    SAIL_CHECK_IO(state_of_mind->io);
+    SAIL_CHECK_STATE_PTR(state_of_mind->state);
+    SAIL_CHECK_CODEC_PTR(state_of_mind->codec);
+
+    reset_rows_reading(state_of_mind);
+
+    if (state_of_mind->convert_pixel_format != SAIL_PIXEL_FORMAT_UNKNOWN) {
+        SAIL_LOG_ERROR("Reading into a buffer is not supported with pixel formats the codec cannot output itself");
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_UNSUPPORTED_PIXEL_FORMAT);
+    }
+
+    if (state_of_mind->crop_read_options != NULL) {
+        SAIL_LOG_ERROR("Reading into a buffer is not supported with cropping by codecs that cannot crop themselves");
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_NOT_IMPLEMENTED);
+    }
+
+    SAIL_TRY(state_of_mind->codec->v4->read_seek_next_frame(state_of_mind->state, state_of_mind->io, image));
+
+    /* 0 means the natural bytes per line. */
+    if (bytes_per_line > 0) {
+        if (bytes_per_line < (*image)->bytes_per_line) {
+            SAIL_LOG_ERROR("Bytes per line %u is less than the frame bytes per line %u", bytes_per_line, (*image)->bytes_per_line);
+            sail_destroy_image(*image);
+            SAIL_LOG_AND_RETURN(SAIL_ERROR_INCORRECT_BYTES_PER_LINE);
+        }
+
+        (*image)->bytes_per_line = bytes_per_line;
+    }
+
+    unsigned bytes_per_image;
+    SAIL_TRY_OR_CLEANUP(sail_bytes_per_image(*image, &bytes_per_image),
+                        /* cleanup */ sail_destroy_image(*image));
+
+    /* sail_bytes_per_image() assumes packed rows. Account for the padding. */
+    const unsigned padded_bytes_per_image = (*image)->bytes_per_line * (*image)->height;
+
+    if (padded_bytes_per_image > bytes_per_image) {
+        bytes_per_image = padded_bytes_per_image;
+    }
+
+    if (pixels_size < bytes_per_image) {
+        SAIL_LOG_ERROR("The buffer size %u is less than the frame size %u", pixels_size, bytes_per_image);
+        sail_destroy_image(*image);
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_INVALID_ARGUMENT);
+    }
+
+    (*image)->pixels = pixels;
+
+    SAIL_TRY_OR_CLEANUP(read_frame_passes(state_of_mind, *image),
+                        /* cleanup */ (*image)->pixels = NULL,
+                                      sail_destroy_image(*image));
+
+    /* The pixels belong to the caller. */
+    (*image)->pixels = NULL;
+
+    return SAIL_OK;
+}
+
 sail_status_t sail_start_writing_file_with_options(const char *path, const struct sail_codec_info *codec_info,
                                                   const struct sail_write_options *write_options, void **state) {
 
@@ -110,6 +180,27 @@ sail_status_t sail_start_writing_mem_with_options(void *buffer, size_t buffer_le
     return SAIL_OK;
 }
 
+sail_status_t sail_start_writing_growable_mem_with_options(void **buffer, size_t *buffer_length,
+                                                          const struct sail_codec_info *codec_info,
+                                                          const struct sail_write_options *write_options, void **state) {
+    SAIL_CHECK_BUFFER_PTR(buffer);
+    SAIL_CHECK_RESULT_PTR(buffer_length);
+
+    /* Callers free the buffer even on errors. */
+    *buffer        = NULL;
+    *buffer_length = 0;
+
+    SAIL_CHECK_CODEC_INFO_PTR(codec_info);
+
+    struct sail_io *io;
+    SAIL_TRY(alloc_io_write_growable_mem(buffer, buffer_length, &io));
+
+    /* The I/O object will be destroyed in this function. */
+    SAIL_TRY(start_writing_io_with_options(io, true, codec_info, write_options, state));
+
+    return SAIL_OK;
+}
+
 sail_status_t sail_stop_writing_with_written(void *state, size_t *written) {
 
     SAIL_TRY(stop_writing(state, written));
@@ -41,6 +41,7 @@ extern "C" {
 #endif
 
 struct sail_io;
+struct sail_image;
 struct sail_codec_info;
 struct sail_read_options;
 struct sail_write_options;
@@ -95,6 +96,31 @@ SAIL_EXPORT sail_status_t sail_start_reading_mem_with_options(const void *buffer
                                                              const struct sail_codec_info *codec_info,
                                                              const struct sail_read_options *read_options, void **state);
 
+/*
+ * Continues reading the file started by sail_start_reading_file() and brothers. Decodes the next frame
+ * into the specified caller-owned buffer instead of allocating pixels. bytes_per_line is the distance
+ * between the starts of two consecutive rows in the buffer. It must be equal to or greater than the frame's
+ * natural bytes per line. Pass 0 to use the natural bytes per line.
+ *
+ * The buffer must hold at least the number of bytes returned by sail_bytes_per_image() for the frame
+ * or bytes_per_line * height bytes for padded rows, whichever is greater. The frame properties are
+ * unknown before reading it, so allocate the buffer after probing the image or for the largest
+ * expected frame.
+ *
+ * The assigned image MUST be destroyed later with sail_destroy_image(). Its pixels are NULL
+ * as they belong to the caller. Its bytes per line is set to the chosen value.
+ *
+ * Typical usage: sail_probe_file()                    ->
+ *                sail_start_reading_file()            ->
+ *                sail_read_next_frame_into_buffer()   ->
+ *                sail_stop_reading().
+ *
+ * Returns SAIL_OK on success.
+ * Returns SAIL_ERROR_NO_MORE_FRAMES when no more frames are available.
+ */
+SAIL_EXPORT sail_status_t sail_read_next_frame_into_buffer(void *state, void *pixels, unsigned pixels_size,
+                                                           unsigned bytes_per_line, struct sail_image **image);
+
 /*
  * Starts writing the specified image file with the specified write options. Pass codec info if you would like
  * to start writing with a specific codec. If not, just pass NULL. If you do not need specific write options,
@@ -148,6 +174,34 @@ SAIL_EXPORT sail_status_t sail_start_writing_mem_with_options(void *buffer, size
                                                              const struct sail_codec_info *codec_info,
                                                              const struct sail_write_options *write_options, void **state);
 
+/*
+ * Starts writing into a memory buffer allocated by SAIL with the specified write options. If you do not need
+ * specific write options, just pass NULL. Codec-specific defaults will be used in this case.
+ *
+ * The buffer grows geometrically as the codec writes data, so there is no need to guess the encoded size.
+ * SAIL assigns NULL and 0 to the buffer and its length on start and keeps them up to date while writing.
+ * After sail_stop_writing(), the buffer holds the encoded image of buffer_length bytes. The buffer may be
+ * larger than buffer_length. The buffer is owned by the caller and MUST be freed with sail_free()
+ * even if writing fails.
+ *
+ * The write options are deep copied.
+ *
+ * Typical usage: sail_codec_info_from_extension()              ->
+ *                sail_start_writing_growable_mem_with_options() ->
+ *                sail_write_next_frame()                        ->
+ *                sail_stop_writing()                            ->
+ *                sail_free(buffer).
+ *
+ * STATE explanation: Passes the address of a local void* pointer. SAIL will store an internal state
+ * in it and destroy it in sail_stop_writing. States must be used per image. DO NOT use the same state
+ * to start writing multiple images at the same time.
+ *
+ * Returns SAIL_OK on success.
+ */
+SAIL_EXPORT sail_status_t sail_start_writing_growable_mem_with_options(void **buffer, size_t *buffer_length,
+                                                                      const struct sail_codec_info *codec_info,
+                                                                      const struct sail_write_options *write_options, void **state);
+
 
 /*
  * Stops writing the file started by sail_start_writing_file() and brothers. Assigns the number of bytes written.
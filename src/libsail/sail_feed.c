@@ -0,0 +1,321 @@
+/*  This file is part of SAIL (https://github.com/smoked-herring/sail)
+
+    Copyright (c) 2020 Dmitry Baryshev
+
+    The MIT License
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "config.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sail-common.h"
+#include "sail.h"
+
+struct feed_state {
+
+    /* Pointers to internal data structures so no need to free these. */
+    const struct sail_codec_info *codec_info;
+    const struct sail_codec *codec;
+
+    /* Deep copy of the read options, or NULL to use the codec defaults. */
+    struct sail_read_options *read_options;
+
+    /* Codec state when the codec decodes incrementally, or NULL. */
+    void *state;
+
+    /*
+     * Data received before the codec is detected. When the codec cannot decode incrementally,
+     * all the data is accumulated here and decoded at the end of the data.
+     */
+    unsigned char *data;
+    size_t data_length;
+    size_t data_capacity;
+
+    /* The image being decoded. It's owned by the codec state unless the data is accumulated. */
+    const struct sail_image *image;
+    struct sail_image *own_image;
+    unsigned valid_rows;
+
+    bool finished;
+    sail_status_t error;
+};
+
+/*
+ * Private functions.
+ */
+
+static sail_status_t append_data(struct feed_state *feed_state, const void *buffer, size_t buffer_length) {
+
+    if (feed_state->data_length + buffer_length > feed_state->data_capacity) {
+        size_t data_capacity = feed_state->data_capacity > 0 ? feed_state->data_capacity : 4096;
+
+        while (data_capacity < feed_state->data_length + buffer_length) {
+            data_capacity *= 2;
+        }
+
+        void *ptr = feed_state->data;
+        SAIL_TRY(sail_realloc(data_capacity, &ptr));
+
+        feed_state->data          = ptr;
+        feed_state->data_capacity = data_capacity;
+    }
+
+    memcpy(feed_state->data + feed_state->data_length, buffer, buffer_length);
+    feed_state->data_length += buffer_length;
+
+    return SAIL_OK;
+}
+
+static void free_data(struct feed_state *feed_state) {
+
+    sail_free(feed_state->data);
+
+    feed_state->data          = NULL;
+    feed_state->data_length   = 0;
+    feed_state->data_capacity = 0;
+}
+
+/* Checks if the codec can decode incrementally with the read options. Codecs don't crop and convert incrementally. */
+static bool codec_feeds(const struct feed_state *feed_state) {
+
+    if (feed_state->codec->v4->feed_init == NULL) {
+        return false;
+    }
+
+    const struct sail_read_options *read_options = feed_state->read_options;
+
+    if (read_options == NULL) {
+        return true;
+    }
+
+    if (read_options->crop_x != 0 || read_options->crop_y != 0 || read_options->crop_width != 0 || read_options->crop_height != 0) {
+        return false;
+    }
+
+    const struct sail_read_features *read_features = feed_state->codec_info->read_features;
+
+    for (unsigned i = 0; i < read_features->output_pixel_formats_length; i++) {
+        if (read_features->output_pixel_formats[i] == read_options->output_pixel_format) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static sail_status_t start_codec(struct feed_state *feed_state) {
+
+    SAIL_TRY(load_codec_by_codec_info(feed_state->codec_info, &feed_state->codec));
+
+    if (!codec_feeds(feed_state)) {
+        SAIL_LOG_DEBUG("Codec '%s' cannot decode this image incrementally, accumulating the data", feed_state->codec_info->name);
+        return SAIL_OK;
+    }
+
+    if (feed_state->read_options == NULL) {
+        struct sail_read_options *read_options_local;
+        SAIL_TRY(sail_alloc_read_options_from_features(feed_state->codec_info->read_features, &read_options_local));
+
+        SAIL_TRY_OR_CLEANUP(feed_state->codec->v4->feed_init(read_options_local, &feed_state->state),
+                            /* cleanup */ sail_destroy_read_options(read_options_local));
+
+        sail_destroy_read_options(read_options_local);
+    } else {
+        SAIL_TRY(feed_state->codec->v4->feed_init(feed_state->read_options, &feed_state->state));
+    }
+
+    return SAIL_OK;
+}
+
+static sail_status_t feed_codec(struct feed_state *feed_state, const void *buffer, size_t buffer_length) {
+
+    SAIL_TRY(feed_state->codec->v4->feed(feed_state->state, buffer, buffer_length, &feed_state->image, &feed_state->valid_rows));
+
+    return SAIL_OK;
+}
+
+/* Decodes the accumulated data when the codec cannot decode incrementally. */
+static sail_status_t read_data(struct feed_state *feed_state) {
+
+    void *state = NULL;
+    SAIL_TRY_OR_CLEANUP(sail_start_reading_mem_with_options(feed_state->data, feed_state->data_length,
+                                                            feed_state->codec_info, feed_state->read_options, &state),
+                        /* cleanup */ sail_stop_reading(state));
+
+    struct sail_image *image;
+    SAIL_TRY_OR_CLEANUP(sail_read_next_frame(state, &image),
+                        /* cleanup */ sail_stop_reading(state));
+
+    SAIL_TRY_OR_CLEANUP(sail_stop_reading(state),
+                        /* cleanup */ sail_destroy_image(image));
+
+    free_data(feed_state);
+
+    feed_state->own_image  = image;
+    feed_state->image      = image;
+    feed_state->valid_rows = image->height;
+
+    return SAIL_OK;
+}
+
+static sail_status_t feed(struct feed_state *feed_state, const void *buffer, size_t buffer_length) {
+
+    const bool end_of_data = buffer == NULL;
+
+    if (end_of_data) {
+        feed_state->finished = true;
+    }
+
+    /* Codec is started on the first chunk, or when enough data is received to detect it. */
+    if (feed_state->codec == NULL) {
+        if (!end_of_data) {
+            SAIL_TRY(append_data(feed_state, buffer, buffer_length));
+        }
+
+        if (feed_state->codec_info == NULL) {
+            if (!end_of_data && feed_state->data_length < SAIL_MAGIC_BUFFER_SIZE) {
+                return SAIL_OK;
+            }
+
+            SAIL_TRY(sail_codec_info_by_magic_number_from_mem(feed_state->data, feed_state->data_length, &feed_state->codec_info));
+        }
+
+        SAIL_TRY(start_codec(feed_state));
+
+        if (feed_state->state != NULL) {
+            SAIL_TRY(feed_codec(feed_state, feed_state->data, feed_state->data_length));
+            free_data(feed_state);
+
+            if (end_of_data) {
+                SAIL_TRY(feed_codec(feed_state, NULL, 0));
+            }
+        } else if (end_of_data) {
+            SAIL_TRY(read_data(feed_state));
+        }
+
+        return SAIL_OK;
+    }
+
+    if (feed_state->state != NULL) {
+        SAIL_TRY(feed_codec(feed_state, buffer, buffer_length));
+    } else if (end_of_data) {
+        SAIL_TRY(read_data(feed_state));
+    } else {
+        SAIL_TRY(append_data(feed_state, buffer, buffer_length));
+    }
+
+    return SAIL_OK;
+}
+
+/*
+ * Public functions.
+ */
+
+sail_status_t sail_start_feeding(const struct sail_codec_info *codec_info,
+                                 const struct sail_read_options *read_options, void **state) {
+
+    SAIL_CHECK_STATE_PTR(state);
+    *state = NULL;
+
+    void *ptr;
+    SAIL_TRY(sail_malloc(sizeof(struct feed_state), &ptr));
+    struct feed_state *feed_state = ptr;
+
+    feed_state->codec_info    = codec_info;
+    feed_state->codec         = NULL;
+    feed_state->read_options  = NULL;
+    feed_state->state         = NULL;
+    feed_state->data          = NULL;
+    feed_state->data_length   = 0;
+    feed_state->data_capacity = 0;
+    feed_state->image         = NULL;
+    feed_state->own_image     = NULL;
+    feed_state->valid_rows    = 0;
+    feed_state->finished      = false;
+    feed_state->error         = SAIL_OK;
+
+    if (read_options != NULL) {
+        SAIL_TRY_OR_CLEANUP(sail_copy_read_options(read_options, &feed_state->read_options),
+                            /* cleanup */ sail_free(feed_state));
+    }
+
+    *state = feed_state;
+
+    return SAIL_OK;
+}
+
+sail_status_t sail_feed(void *state, const void *buffer, size_t buffer_length,
+                        const struct sail_image **image, unsigned *valid_rows) {
+
+    SAIL_CHECK_STATE_PTR(state);
+    SAIL_CHECK_IMAGE_PTR(image);
+    SAIL_CHECK_RESULT_PTR(valid_rows);
+
+    struct feed_state *feed_state = state;
+
+    /* Fail permanently after an error. */
+    if (feed_state->error != SAIL_OK) {
+        SAIL_LOG_AND_RETURN(feed_state->error);
+    }
+
+    if (!feed_state->finished) {
+        feed_state->error = feed(feed_state, buffer, buffer_length);
+
+        if (feed_state->error != SAIL_OK) {
+            return feed_state->error;
+        }
+    }
+
+    *image      = feed_state->image;
+    *valid_rows = feed_state->valid_rows;
+
+    return SAIL_OK;
+}
+
+sail_status_t sail_stop_feeding(void *state) {
+
+    /* Not an error. */
+    if (state == NULL) {
+        return SAIL_OK;
+    }
+
+    struct feed_state *feed_state = state;
+
+    sail_status_t status = SAIL_OK;
+
+    if (feed_state->state != NULL) {
+        status = feed_state->codec->v4->feed_finish(&feed_state->state);
+    }
+
+    sail_destroy_image(feed_state->own_image);
+    sail_destroy_read_options(feed_state->read_options);
+    sail_free(feed_state->data);
+    sail_free(feed_state);
+
+    if (status != SAIL_OK) {
+        SAIL_LOG_AND_RETURN(status);
+    }
+
+    return SAIL_OK;
+}
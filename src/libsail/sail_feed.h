@@ -0,0 +1,99 @@
+/*  This file is part of SAIL (https://github.com/smoked-herring/sail)
+
+    Copyright (c) 2020 Dmitry Baryshev
+
+    The MIT License
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#ifndef SAIL_SAIL_FEED_H
+#define SAIL_SAIL_FEED_H
+
+#include <stddef.h>
+
+#ifdef SAIL_BUILD
+    #include "error.h"
+    #include "export.h"
+#else
+    #include <sail-common/error.h>
+    #include <sail-common/export.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct sail_codec_info;
+struct sail_image;
+struct sail_read_options;
+
+/*
+ * Starts incremental reading of the first frame of an image which data arrives in chunks. Data is pushed
+ * with sail_feed(). Pass codec info if you know the image format. If not, just pass NULL. The codec
+ * is detected by magic numbers from the first bytes in this case. Pass NULL read options to use
+ * the codec-specific defaults. The read options are deep copied.
+ *
+ * Codecs supporting incremental decoding decode rows as data arrives. With other codecs, and when
+ * the read options need cropping or pixel format conversion the codec cannot do itself, the image
+ * is only decoded at the end of the data.
+ *
+ * Typical usage: sail_start_feeding() ->
+ *                sail_feed()          ->
+ *                ...                  ->
+ *                sail_feed(NULL)      ->
+ *                sail_stop_feeding().
+ *
+ * STATE explanation: Pass the address of a local void* pointer. SAIL will store an internal state
+ * in it and destroy it in sail_stop_feeding(). States must be used per image.
+ *
+ * Returns SAIL_OK on success.
+ */
+SAIL_EXPORT sail_status_t sail_start_feeding(const struct sail_codec_info *codec_info,
+                                             const struct sail_read_options *read_options, void **state);
+
+/*
+ * Pushes the next chunk of the image data and decodes as much as possible. The chunk is copied if needed,
+ * so it could be freed right after the call. Pass a NULL buffer to signal the end of the data.
+ *
+ * The image is NULL until the image header is received. After that, it points to the image being decoded
+ * with all the pixels allocated. Rows [0, valid_rows) hold final pixels. Interlaced and progressive images
+ * could also have coarser pixels of earlier passes in the other rows, which is suitable for previews.
+ * The image MUST NOT be changed or destroyed. It's valid until the next call to sail_feed() or sail_stop_feeding().
+ *
+ * Returns SAIL_OK on success. It's not an error to run out of data. Running out of data after
+ * the end of the data is signaled is not an error too. Check valid_rows to find out if the whole image
+ * has been received.
+ */
+SAIL_EXPORT sail_status_t sail_feed(void *state, const void *buffer, size_t buffer_length,
+                                    const struct sail_image **image, unsigned *valid_rows);
+
+/*
+ * Stops incremental reading and destroys the state and the image. Does nothing if the state is NULL.
+ *
+ * Returns SAIL_OK on success.
+ */
+SAIL_EXPORT sail_status_t sail_stop_feeding(void *state);
+
+/* extern "C" */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
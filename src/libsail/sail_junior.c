@@ -35,7 +35,7 @@ sail_status_t sail_probe_file(const char *path, struct sail_image **image, const
     SAIL_CHECK_PATH_PTR(path);
 
     struct sail_io *io;
-    SAIL_TRY(alloc_io_read_file(path, &io));
+    SAIL_TRY(alloc_io_read_file_auto(path, false /* force mmap */, &io));
 
     SAIL_TRY_OR_CLEANUP(sail_probe_io(io, image, codec_info),
                         /* cleanup */ sail_destroy_io(io));
@@ -122,3 +122,28 @@ sail_status_t sail_write_mem(void *buffer, size_t buffer_length, const struct sa
 
     return SAIL_OK;
 }
+
+sail_status_t sail_write_growable_mem(void **buffer, size_t *buffer_length, const struct sail_image *image,
+                                      const struct sail_codec_info *codec_info) {
+
+    SAIL_CHECK_BUFFER_PTR(buffer);
+    SAIL_CHECK_RESULT_PTR(buffer_length);
+
+    /* Callers free the buffer even on errors. */
+    *buffer        = NULL;
+    *buffer_length = 0;
+
+    SAIL_CHECK_IMAGE(image);
+
+    void *state = NULL;
+
+    SAIL_TRY_OR_CLEANUP(sail_start_writing_growable_mem(buffer, buffer_length, codec_info, &state),
+                        sail_stop_writing(state));
+
+    SAIL_TRY_OR_CLEANUP(sail_write_next_frame(state, image),
+                        sail_stop_writing(state));
+
+    SAIL_TRY(sail_stop_writing(state));
+
+    return SAIL_OK;
+}
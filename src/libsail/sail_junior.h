@@ -103,6 +103,23 @@ SAIL_EXPORT sail_status_t sail_write_file(const char *path, const struct sail_im
  */
 SAIL_EXPORT sail_status_t sail_write_mem(void *buffer, size_t buffer_length, const struct sail_image *image, size_t *written);
 
+/*
+ * Writes the pixels of the specified image with the specified codec into a memory buffer allocated by SAIL.
+ * The buffer grows as needed, so there is no need to guess the encoded size.
+ *
+ * Outputs pixels in the pixel format as specified in sail_write_features.default_output_pixel_format.
+ *
+ * Assigns the encoded data and its length to the 'buffer' and 'buffer_length' parameters. The buffer
+ * may be larger than buffer_length. The buffer is owned by the caller and MUST be freed with sail_free()
+ * even if writing fails.
+ *
+ * Typical usage: This is a standalone function that could be called at any time.
+ *
+ * Returns SAIL_OK on success.
+ */
+SAIL_EXPORT sail_status_t sail_write_growable_mem(void **buffer, size_t *buffer_length, const struct sail_image *image,
+                                                 const struct sail_codec_info *codec_info);
+
 /* extern "C" */
 #ifdef __cplusplus
 }
@@ -105,6 +105,12 @@ sail_status_t load_codec_by_codec_info(const struct sail_codec_info *codec_info,
         SAIL_LOG_AND_RETURN(SAIL_ERROR_CODEC_NOT_FOUND);
     }
 
+    /* Shared contexts are immutable. All their codecs are preloaded, so this one failed to load. */
+    if (context->shared) {
+        SAIL_LOG_ERROR("Codec '%s' is not loaded into the shared context", codec_info->name);
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_CODEC_LOAD);
+    }
+
     SAIL_TRY(load_codec(found_node));
 
     *codec = found_node->codec;
@@ -123,6 +129,8 @@ void destroy_hidden_state(struct hidden_state *state) {
     }
 
     sail_destroy_write_options(state->write_options);
+    sail_destroy_read_options(state->crop_read_options);
+    sail_destroy_image(state->rows_image);
 
     /* This state must be freed and zeroed by codecs. We free it just in case to avoid memory leaks. */
     sail_free(state->state);
@@ -130,6 +138,65 @@ void destroy_hidden_state(struct hidden_state *state) {
     sail_free(state);
 }
 
+sail_status_t read_frame_passes(const struct hidden_state *state_of_mind, struct sail_image *image) {
+
+    /* Detect the number of passes needed to read an interlaced image. */
+    int interlaced_passes;
+    if (image->source_image->properties & SAIL_IMAGE_PROPERTY_INTERLACED) {
+        interlaced_passes = image->interlaced_passes;
+
+        if (interlaced_passes < 1) {
+            SAIL_LOG_AND_RETURN(SAIL_ERROR_INTERLACING_UNSUPPORTED);
+        }
+    } else {
+        interlaced_passes = 1;
+    }
+
+    for (int pass = 0; pass < interlaced_passes; pass++) {
+        SAIL_TRY(state_of_mind->codec->v4->read_seek_next_pass(state_of_mind->state, state_of_mind->io, image));
+
+        SAIL_TRY(state_of_mind->codec->v4->read_frame(state_of_mind->state,
+                                                        state_of_mind->io,
+                                                        image));
+    }
+
+    return SAIL_OK;
+}
+
+sail_status_t crop_frame(const struct hidden_state *state_of_mind, struct sail_image **image) {
+
+    if (state_of_mind->crop_read_options == NULL) {
+        return SAIL_OK;
+    }
+
+    unsigned x;
+    unsigned y;
+    unsigned width;
+    unsigned height;
+    SAIL_TRY(sail_read_options_crop_rectangle(state_of_mind->crop_read_options, (*image)->width, (*image)->height,
+                                                &x, &y, &width, &height));
+
+    if (width == (*image)->width && height == (*image)->height) {
+        return SAIL_OK;
+    }
+
+    struct sail_image *image_cropped;
+    SAIL_TRY(sail_crop_image(*image, x, y, width, height, &image_cropped));
+
+    sail_destroy_image(*image);
+    *image = image_cropped;
+
+    return SAIL_OK;
+}
+
+void reset_rows_reading(struct hidden_state *state_of_mind) {
+
+    sail_destroy_image(state_of_mind->rows_image);
+
+    state_of_mind->rows_image = NULL;
+    state_of_mind->next_row   = 0;
+}
+
 sail_status_t stop_writing(void *state, size_t *written) {
 
     if (written != NULL) {
@@ -58,6 +58,22 @@ struct hidden_state {
     /* Local state passed to codec reading and writing functions. */
     void *state;
 
+    /*
+     * Row streaming. A copy of the frame being streamed by sail_read_next_rows() without pixels and the index
+     * of the next row to read. If the codec cannot stream rows, the copy holds the whole decoded frame.
+     */
+    struct sail_image *rows_image;
+    unsigned next_row;
+
+    /*
+     * Pixel format to convert read frames to when the codec cannot output the requested pixel format
+     * itself, or SAIL_PIXEL_FORMAT_UNKNOWN.
+     */
+    enum SailPixelFormat convert_pixel_format;
+
+    /* Read options with the crop rectangle to apply to read frames when the codec cannot crop itself, or NULL. */
+    struct sail_read_options *crop_read_options;
+
     /* Pointers to internal data structures so no need to free these. */
     const struct sail_codec_info *codec_info;
     const struct sail_codec *codec;
@@ -68,6 +84,23 @@ SAIL_HIDDEN sail_status_t load_codec_by_codec_info(const struct sail_codec_info
 
 SAIL_HIDDEN void destroy_hidden_state(struct hidden_state *state);
 
+/*
+ * Reads all the passes of the current frame into the pre-allocated image pixels.
+ *
+ * Returns SAIL_OK on success.
+ */
+SAIL_HIDDEN sail_status_t read_frame_passes(const struct hidden_state *state_of_mind, struct sail_image *image);
+
+/*
+ * Crops the read frame to the rectangle from crop_read_options. Does nothing if crop_read_options is NULL.
+ *
+ * Returns SAIL_OK on success.
+ */
+SAIL_HIDDEN sail_status_t crop_frame(const struct hidden_state *state_of_mind, struct sail_image **image);
+
+/* Discards the state of the row streaming started by sail_start_reading_rows(). */
+SAIL_HIDDEN void reset_rows_reading(struct hidden_state *state_of_mind);
+
 SAIL_HIDDEN sail_status_t stop_writing(void *state, size_t *written);
 
 SAIL_HIDDEN sail_status_t allowed_write_output_pixel_format(const struct sail_write_features *write_features,
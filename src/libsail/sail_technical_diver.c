@@ -46,6 +46,13 @@ sail_status_t sail_start_reading_io_with_options(struct sail_io *io,
     return SAIL_OK;
 }
 
+sail_status_t sail_reset_reading(void *state, struct sail_io *io) {
+
+    SAIL_TRY(reset_reading_io(state, io, false));
+
+    return SAIL_OK;
+}
+
 sail_status_t sail_start_writing_io(struct sail_io *io, const struct sail_codec_info *codec_info, void **state) {
 
     SAIL_TRY(sail_start_writing_io_with_options(io, codec_info, NULL, state));
@@ -88,6 +88,27 @@ SAIL_EXPORT sail_status_t sail_start_reading_io_with_options(struct sail_io *io,
                                                             const struct sail_codec_info *codec_info,
                                                             const struct sail_read_options *read_options, void **state);
 
+/*
+ * Resets the reading state started by one of the sail_start_reading_*() functions to read a new image
+ * from the specified I/O stream with the same codec and read options. The codec keeps its decoder allocated,
+ * so reading a series of small images of the same format this way is faster than starting a new state
+ * for every image. The previous I/O stream is destroyed if it was created by SAIL. The new I/O stream
+ * is not destroyed by SAIL.
+ *
+ * Typical usage: sail_start_reading_io()  ->
+ *                sail_read_next_frame()   ->
+ *                sail_reset_reading()     ->
+ *                sail_read_next_frame()   ->
+ *                sail_stop_reading()      ->
+ *                sail_destroy_io().
+ *
+ * Returns SAIL_ERROR_NOT_IMPLEMENTED if the codec cannot reset its state. The state is left untouched
+ * in this case. On other errors, the state MUST be only stopped with sail_stop_reading().
+ *
+ * Returns SAIL_OK on success.
+ */
+SAIL_EXPORT sail_status_t sail_reset_reading(void *state, struct sail_io *io);
+
 /*
  * Starts writing into the specified I/O stream.
  *
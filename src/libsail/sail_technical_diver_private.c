@@ -45,6 +45,25 @@ static sail_status_t check_io_arguments(struct sail_io *io,
     return SAIL_OK;
 }
 
+static sail_status_t check_reset_arguments(void *state, struct sail_io *io) {
+
+    SAIL_CHECK_STATE_PTR(state);
+    SAIL_CHECK_IO(io);
+
+    const struct hidden_state *state_of_mind = (const struct hidden_state *)state;
+
+    SAIL_CHECK_STATE_PTR(state_of_mind->state);
+    SAIL_CHECK_CODEC_PTR(state_of_mind->codec);
+
+    /* Write states have write options. */
+    if (state_of_mind->write_options != NULL) {
+        SAIL_LOG_ERROR("Only reading states could be reset");
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_INVALID_ARGUMENT);
+    }
+
+    return SAIL_OK;
+}
+
 static void print_unsupported_read_output_pixel_format(enum SailPixelFormat output_pixel_format) {
 
     const char *output_pixel_format_str = NULL;
@@ -54,15 +73,25 @@ static void print_unsupported_read_output_pixel_format(enum SailPixelFormat outp
                     output_pixel_format_str);
 }
 
+static bool codec_outputs_pixel_format(const struct sail_read_features *read_features,
+                                      enum SailPixelFormat pixel_format) {
+
+    for (unsigned i = 0; i < read_features->output_pixel_formats_length; i++) {
+        if (read_features->output_pixel_formats[i] == pixel_format) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 static sail_status_t allowed_read_output_pixel_format(const struct sail_read_features *read_features,
                                                       enum SailPixelFormat pixel_format) {
 
     SAIL_CHECK_READ_FEATURES_PTR(read_features);
 
-    for (unsigned i = 0; i < read_features->output_pixel_formats_length; i++) {
-        if (read_features->output_pixel_formats[i] == pixel_format) {
-            return SAIL_OK;
-        }
+    if (codec_outputs_pixel_format(read_features, pixel_format)) {
+        return SAIL_OK;
     }
 
     print_unsupported_read_output_pixel_format(pixel_format);
@@ -99,8 +128,45 @@ sail_status_t start_reading_io_with_options(struct sail_io *io, bool own_io,
     /*
      * When read options is not NULL, we need to check if we can actually output the requested pixel format.
      * When read options is NULL, we use the default output pixel format which is always acceptable.
+     *
+     * If the codec cannot output the requested pixel format, but can output BPP32-RGBA, frames are read
+     * as BPP32-RGBA and converted with sail_convert_image().
+     *
+     * If the codec cannot crop, frames are read as a whole and cropped with sail_crop_image().
      */
+    struct sail_read_options read_options_converted;
+    enum SailPixelFormat convert_pixel_format = SAIL_PIXEL_FORMAT_UNKNOWN;
+    const struct sail_read_options *crop_read_options = NULL;
+
     if (read_options != NULL) {
+        const bool convert = codec_info->read_features != NULL &&
+                                !codec_outputs_pixel_format(codec_info->read_features, read_options->output_pixel_format) &&
+                                codec_outputs_pixel_format(codec_info->read_features, SAIL_PIXEL_FORMAT_BPP32_RGBA) &&
+                                sail_can_convert(SAIL_PIXEL_FORMAT_BPP32_RGBA, read_options->output_pixel_format);
+        const bool crop = codec_info->read_features != NULL &&
+                            !(codec_info->read_features->features & SAIL_CODEC_FEATURE_CROP) &&
+                            (read_options->crop_x != 0 || read_options->crop_y != 0 ||
+                                read_options->crop_width != 0 || read_options->crop_height != 0);
+
+        if (convert || crop) {
+            read_options_converted = *read_options;
+
+            if (convert) {
+                convert_pixel_format = read_options->output_pixel_format;
+                read_options_converted.output_pixel_format = SAIL_PIXEL_FORMAT_BPP32_RGBA;
+            }
+
+            if (crop) {
+                crop_read_options = read_options;
+                read_options_converted.crop_x      = 0;
+                read_options_converted.crop_y      = 0;
+                read_options_converted.crop_width  = 0;
+                read_options_converted.crop_height = 0;
+            }
+
+            read_options = &read_options_converted;
+        }
+
         SAIL_TRY_OR_CLEANUP(allowed_read_output_pixel_format(codec_info->read_features, read_options->output_pixel_format),
                             /* cleanup */ if (own_io) sail_destroy_io(io));
     }
@@ -114,8 +180,18 @@ sail_status_t start_reading_io_with_options(struct sail_io *io, bool own_io,
     state_of_mind->own_io        = own_io;
     state_of_mind->write_options = NULL;
     state_of_mind->state         = NULL;
-    state_of_mind->codec_info   = codec_info;
-    state_of_mind->codec        = NULL;
+    state_of_mind->rows_image    = NULL;
+    state_of_mind->next_row      = 0;
+    state_of_mind->codec_info    = codec_info;
+    state_of_mind->codec         = NULL;
+
+    state_of_mind->convert_pixel_format = convert_pixel_format;
+    state_of_mind->crop_read_options    = NULL;
+
+    if (crop_read_options != NULL) {
+        SAIL_TRY_OR_CLEANUP(sail_copy_read_options(crop_read_options, &state_of_mind->crop_read_options),
+                            /* cleanup */ destroy_hidden_state(state_of_mind));
+    }
 
     SAIL_TRY_OR_CLEANUP(load_codec_by_codec_info(state_of_mind->codec_info, &state_of_mind->codec),
                         /* cleanup */ destroy_hidden_state(state_of_mind));
@@ -142,6 +218,37 @@ sail_status_t start_reading_io_with_options(struct sail_io *io, bool own_io,
     return SAIL_OK;
 }
 
+sail_status_t reset_reading_io(void *state, struct sail_io *io, bool own_io) {
+
+    SAIL_TRY_OR_CLEANUP(check_reset_arguments(state, io),
+                        /* cleanup */ if (own_io) sail_destroy_io(io));
+
+    struct hidden_state *state_of_mind = (struct hidden_state *)state;
+
+    if (state_of_mind->codec->v4->read_reset == NULL) {
+        if (own_io) {
+            sail_destroy_io(io);
+        }
+
+        SAIL_LOG_DEBUG("Codec '%s' cannot reset its reading state", state_of_mind->codec_info->name);
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_NOT_IMPLEMENTED);
+    }
+
+    reset_rows_reading(state_of_mind);
+
+    /* Switch to the new I/O stream before resetting, so sail_stop_reading() finishes it on error. */
+    if (state_of_mind->own_io) {
+        sail_destroy_io(state_of_mind->io);
+    }
+
+    state_of_mind->io     = io;
+    state_of_mind->own_io = own_io;
+
+    SAIL_TRY(state_of_mind->codec->v4->read_reset(state_of_mind->state, state_of_mind->io));
+
+    return SAIL_OK;
+}
+
 sail_status_t start_writing_io_with_options(struct sail_io *io, bool own_io,
                                            const struct sail_codec_info *codec_info,
                                            const struct sail_write_options *write_options, void **state) {
@@ -169,9 +276,14 @@ sail_status_t start_writing_io_with_options(struct sail_io *io, bool own_io,
     state_of_mind->own_io        = own_io;
     state_of_mind->write_options = NULL;
     state_of_mind->state         = NULL;
+    state_of_mind->rows_image    = NULL;
+    state_of_mind->next_row      = 0;
     state_of_mind->codec_info    = codec_info;
     state_of_mind->codec         = NULL;
 
+    state_of_mind->convert_pixel_format = SAIL_PIXEL_FORMAT_UNKNOWN;
+    state_of_mind->crop_read_options    = NULL;
+
     SAIL_TRY_OR_CLEANUP(load_codec_by_codec_info(state_of_mind->codec_info, &state_of_mind->codec),
                         /* cleanup */ destroy_hidden_state(state_of_mind));
 
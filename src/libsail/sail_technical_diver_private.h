@@ -45,6 +45,12 @@ SAIL_HIDDEN sail_status_t start_reading_io_with_options(struct sail_io *io, bool
                                                        const struct sail_codec_info *codec_info,
                                                        const struct sail_read_options *read_options, void **state);
 
+/*
+ * Resets the reading state to read a new image from the specified I/O stream. Takes the ownership
+ * of the I/O stream if own_io is true, even on error.
+ */
+SAIL_HIDDEN sail_status_t reset_reading_io(void *state, struct sail_io *io, bool own_io);
+
 SAIL_HIDDEN sail_status_t start_writing_io_with_options(struct sail_io *io, bool own_io,
                                                        const struct sail_codec_info *codec_info,
                                                        const struct sail_write_options *write_options, void **state);
@@ -35,10 +35,38 @@
 
 #include "helpers.h"
 #include "io.h"
+#include "quantize.h"
+
+/* Upper limit of encoding threads. */
+#define GIF_MAX_THREADS 64
 
 static const int InterlacedOffset[] = { 0, 4, 2, 1 };
 static const int InterlacedJumps[]  = { 8, 8, 4, 2 };
 
+/*
+ * Frame to encode. Frames are quantized and compressed apart from the output stream,
+ * so they can be encoded in parallel and written in order.
+ */
+struct gif_frame {
+    /* Pixels of the frame rectangle. Transparent pixels are zeroed. */
+    uint32_t *pixels;
+    unsigned left;
+    unsigned top;
+    unsigned width;
+    unsigned height;
+    bool dispose_background;
+    int delay;
+    struct sail_meta_data_node *meta_data_node;
+    enum SailDithering dithering;
+    bool interlaced;
+
+    /* Encoded image descriptor, local color map, and image data. */
+    struct gif_private_palette *palette;
+    GifPixelType *indexes;
+    int transparency_index;
+    struct gif_memory_buffer buffer;
+};
+
 /*
  * Codec-specific state.
  */
@@ -67,6 +95,34 @@ struct gif_state {
     unsigned prev_height;
     unsigned char **first_frame;
     unsigned char background[4]; /* RGBA */
+
+    /* Current color map expanded into output pixels. */
+    uint32_t lut[256];
+    gif_private_expand_row_t expand_row;
+
+    /*
+     * Writing. Frames are written one frame behind, when the next frame is known. Its transparent pixels
+     * define the disposal method of the written frame. Frames are normalized into RGBA with transparent
+     * pixels zeroed. The canvas holds the pixels of the written frames as a viewer displays them,
+     * before quantization.
+     */
+    struct sail_io *io;
+    bool header_written;
+    unsigned screen_width;
+    unsigned screen_height;
+    uint32_t *canvas;
+    uint32_t *pending_frame;
+    uint32_t *next_frame;
+    bool has_pending_frame;
+    int pending_delay;
+    struct sail_meta_data_node *pending_meta_data_node;
+
+    /* Ring of frames to encode. */
+    struct gif_frame *frames;
+    unsigned frames_count;
+    unsigned long frames_prepared;
+    /* Encoding threads. NULL when encoding in the calling thread only. */
+    struct sail_thread_pool *pool;
 };
 
 static sail_status_t alloc_gif_state(struct gif_state **gif_state) {
@@ -100,16 +156,52 @@ static sail_status_t alloc_gif_state(struct gif_state **gif_state) {
     (*gif_state)->prev_width         = 0;
     (*gif_state)->prev_height        = 0;
     (*gif_state)->first_frame        = NULL;
+    (*gif_state)->expand_row         = gif_private_select_expand_row();
+
+    (*gif_state)->io                     = NULL;
+    (*gif_state)->header_written         = false;
+    (*gif_state)->screen_width           = 0;
+    (*gif_state)->screen_height          = 0;
+    (*gif_state)->canvas                 = NULL;
+    (*gif_state)->pending_frame          = NULL;
+    (*gif_state)->next_frame             = NULL;
+    (*gif_state)->has_pending_frame      = false;
+    (*gif_state)->pending_delay          = 0;
+    (*gif_state)->pending_meta_data_node = NULL;
+    (*gif_state)->frames                 = NULL;
+    (*gif_state)->frames_count           = 0;
+    (*gif_state)->frames_prepared        = 0;
+    (*gif_state)->pool                   = NULL;
 
     return SAIL_OK;
 }
 
+static void destroy_frame(struct gif_frame *frame) {
+
+    sail_free(frame->pixels);
+    sail_destroy_meta_data_node_chain(frame->meta_data_node);
+    sail_free(frame->palette);
+    sail_free(frame->indexes);
+    sail_free(frame->buffer.data);
+}
+
 static void destroy_gif_state(struct gif_state *gif_state) {
 
     if (gif_state == NULL) {
         return;
     }
 
+    /* Stop the threads before destroying the frames they encode. */
+    sail_destroy_thread_pool(gif_state->pool);
+
+    if (gif_state->frames != NULL) {
+        for (unsigned i = 0; i < gif_state->frames_count; i++) {
+            destroy_frame(&gif_state->frames[i]);
+        }
+
+        sail_free(gif_state->frames);
+    }
+
     sail_destroy_read_options(gif_state->read_options);
     sail_destroy_write_options(gif_state->write_options);
 
@@ -123,6 +215,11 @@ static void destroy_gif_state(struct gif_state *gif_state) {
         sail_free(gif_state->first_frame);
     }
 
+    sail_free(gif_state->canvas);
+    sail_free(gif_state->pending_frame);
+    sail_free(gif_state->next_frame);
+    sail_destroy_meta_data_node_chain(gif_state->pending_meta_data_node);
+
     sail_free(gif_state);
 }
 
@@ -338,6 +435,12 @@ SAIL_EXPORT sail_status_t sail_codec_read_seek_next_frame_v4_gif(void *state, st
                 SAIL_LOG_AND_RETURN(SAIL_ERROR_MISSING_PALETTE);
             }
 
+            SAIL_TRY_OR_CLEANUP(gif_private_build_lut(gif_state->map,
+                                                      gif_state->transparency_index,
+                                                      gif_state->read_options->output_pixel_format,
+                                                      gif_state->lut),
+                                /* cleanup */ sail_destroy_image(*image));
+
             if (gif_state->gif->Image.Interlace) {
                 (*image)->source_image->properties |= SAIL_IMAGE_PROPERTY_INTERLACED;
                 (*image)->interlaced_passes = 4;
@@ -391,32 +494,29 @@ SAIL_EXPORT sail_status_t sail_codec_read_frame_v4_gif(void *state, struct sail_
 
     struct gif_state *gif_state = (struct gif_state *)state;
 
-    /* Apply disposal method on the previous frame. */
-    if (gif_state->current_image > 0 && gif_state->current_pass == 0) {
-       for (unsigned cc = gif_state->prev_row; cc < gif_state->prev_row+gif_state->prev_height; cc++) {
-            unsigned char *scan = (unsigned char *)image->pixels + image->width*4*cc;
-
-            if (gif_state->prev_disposal == DISPOSE_BACKGROUND) {
-                /*
-                 * Spec:
-                 *     2 - Restore to background color. The area used by the
-                 *         graphic must be restored to the background color.
-                 *
-                 * The meaning of the background color is not quite clear here. My idea was that
-                 * it's the color specified by the background color index in the global color map.
-                 * However, other decoders like XnView treat "background" as a transparent color here.
-                 * Let's do the same.
-                 */
-                memset(gif_state->first_frame[cc] + gif_state->prev_column*4, 0, gif_state->prev_width*4); /* 4 = RGBA */
-            }
-
-            memcpy(scan, gif_state->first_frame[cc], image->width * 4);
+    /*
+     * Apply disposal method on the previous frame. Only its rectangle is touched,
+     * the whole canvas is copied into the output below.
+     */
+    if (gif_state->current_image > 0 && gif_state->current_pass == 0 && gif_state->prev_disposal == DISPOSE_BACKGROUND) {
+        for (unsigned cc = gif_state->prev_row; cc < gif_state->prev_row+gif_state->prev_height; cc++) {
+            /*
+             * Spec:
+             *     2 - Restore to background color. The area used by the
+             *         graphic must be restored to the background color.
+             *
+             * The meaning of the background color is not quite clear here. My idea was that
+             * it's the color specified by the background color index in the global color map.
+             * However, other decoders like XnView treat "background" as a transparent color here.
+             * Let's do the same.
+             */
+            memset(gif_state->first_frame[cc] + gif_state->prev_column*4, 0, gif_state->prev_width*4); /* 4 = RGBA */
         }
     }
 
     /* Read lines. */
     for (unsigned cc = 0; cc < image->height; cc++) {
-        unsigned char *scan = (unsigned char *)image->pixels + image->width*4*cc;
+        unsigned char *scan = (unsigned char *)image->pixels + image->bytes_per_line*cc;
 
         if (cc < gif_state->row || cc >= gif_state->row + gif_state->height) {
             if (gif_state->current_pass == 0) {
@@ -449,31 +549,26 @@ SAIL_EXPORT sail_status_t sail_codec_read_frame_v4_gif(void *state, struct sail_
                 SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
             }
 
-            memcpy(scan, gif_state->first_frame[cc], image->width * 4);
+            const size_t frame_offset = (size_t)gif_state->column * 4;
+            const size_t frame_length = (size_t)gif_state->width * 4;
 
-            for (unsigned i = 0; i < gif_state->width; i++) {
-                if (gif_state->buf[i] == gif_state->transparency_index) {
-                    continue;
-                }
-
-                unsigned char *pixel = scan + (gif_state->column + i)*4;
+            /* Canvas to the left and to the right of the frame. */
+            memcpy(scan, gif_state->first_frame[cc], frame_offset);
+            memcpy(scan + frame_offset + frame_length,
+                    gif_state->first_frame[cc] + frame_offset + frame_length,
+                    (size_t)image->width * 4 - frame_offset - frame_length);
 
-                if (gif_state->read_options->output_pixel_format == SAIL_PIXEL_FORMAT_BPP32_RGBA) {
-                    pixel[0] = gif_state->map->Colors[gif_state->buf[i]].Red;
-                    pixel[1] = gif_state->map->Colors[gif_state->buf[i]].Green;
-                    pixel[2] = gif_state->map->Colors[gif_state->buf[i]].Blue;
-                } else if (gif_state->read_options->output_pixel_format == SAIL_PIXEL_FORMAT_BPP32_BGRA) {
-                    pixel[0] = gif_state->map->Colors[gif_state->buf[i]].Blue;
-                    pixel[1] = gif_state->map->Colors[gif_state->buf[i]].Green;
-                    pixel[2] = gif_state->map->Colors[gif_state->buf[i]].Red;
-                }
+            /* Transparent pixels show the canvas, opaque pixels overwrite it completely. */
+            if (gif_state->transparency_index >= 0) {
+                memcpy(scan + frame_offset, gif_state->first_frame[cc] + frame_offset, frame_length);
+            }
 
-                pixel[3] = 255;
-            } // for
+            gif_state->expand_row(scan + frame_offset, gif_state->buf, gif_state->width, gif_state->lut, gif_state->transparency_index);
         }
 
+        /* Rows outside of the frame rectangle are never changed, so only the rectangle is saved. */
         if (gif_state->current_pass == image->interlaced_passes-1) {
-            memcpy(gif_state->first_frame[cc], scan, image->width * 4);
+            memcpy(gif_state->first_frame[cc] + gif_state->column * 4, scan + gif_state->column * 4, gif_state->width * 4);
         }
     }
 
@@ -503,13 +598,438 @@ SAIL_EXPORT sail_status_t sail_codec_read_finish_v4_gif(void **state, struct sai
  * Encoding functions.
  */
 
+/* Converts the image into RGBA with transparent pixels zeroed. */
+static sail_status_t normalize_frame(const struct sail_image *image, uint32_t *frame) {
+
+    unsigned r, g, b, a;
+    unsigned bytes_per_pixel;
+
+    switch (image->pixel_format) {
+        case SAIL_PIXEL_FORMAT_BPP24_RGB:  { r = 0; g = 1; b = 2; a = 3; bytes_per_pixel = 3; break; }
+        case SAIL_PIXEL_FORMAT_BPP24_BGR:  { r = 2; g = 1; b = 0; a = 3; bytes_per_pixel = 3; break; }
+        case SAIL_PIXEL_FORMAT_BPP32_RGBA: { r = 0; g = 1; b = 2; a = 3; bytes_per_pixel = 4; break; }
+        case SAIL_PIXEL_FORMAT_BPP32_BGRA: { r = 2; g = 1; b = 0; a = 3; bytes_per_pixel = 4; break; }
+
+        default: {
+            SAIL_LOG_AND_RETURN(SAIL_ERROR_UNSUPPORTED_PIXEL_FORMAT);
+        }
+    }
+
+    for (unsigned row = 0; row < image->height; row++) {
+        const unsigned char *scan = (const unsigned char *)image->pixels + (size_t)row * image->bytes_per_line;
+        unsigned char *dst = (unsigned char *)(frame + (size_t)row * image->width);
+
+        for (unsigned column = 0; column < image->width; column++, scan += bytes_per_pixel, dst += 4) {
+            /* GIF has 1-bit transparency. */
+            if (bytes_per_pixel == 4 && scan[a] < 128) {
+                memset(dst, 0, 4);
+            } else {
+                dst[0] = scan[r];
+                dst[1] = scan[g];
+                dst[2] = scan[b];
+                dst[3] = 255;
+            }
+        }
+    }
+
+    return SAIL_OK;
+}
+
+/* Extends the rectangle [left, right) x [top, bottom) with the specified point. */
+static void extend_rect(unsigned x, unsigned y, unsigned *left, unsigned *top, unsigned *right, unsigned *bottom) {
+
+    if (x < *left) {
+        *left = x;
+    }
+    if (x + 1 > *right) {
+        *right = x + 1;
+    }
+    if (y < *top) {
+        *top = y;
+    }
+    if (y + 1 > *bottom) {
+        *bottom = y + 1;
+    }
+}
+
+static sail_status_t write_header(struct gif_state *gif_state, bool animated) {
+
+    EGifSetGifVersion(gif_state->gif, true);
+
+    if (EGifPutScreenDesc(gif_state->gif, gif_state->screen_width, gif_state->screen_height, 8, 0, NULL) == GIF_ERROR) {
+        SAIL_LOG_ERROR("GIF: %s", GifErrorString(gif_state->gif->Error));
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
+    }
+
+    /* Loop animations infinitely. */
+    if (animated) {
+        static const GifByteType netscape[]  = "NETSCAPE2.0";
+        static const GifByteType loop_count[] = { 1, 0, 0 };
+
+        if (EGifPutExtensionLeader(gif_state->gif, APPLICATION_EXT_FUNC_CODE) == GIF_ERROR ||
+                EGifPutExtensionBlock(gif_state->gif, 11, netscape) == GIF_ERROR ||
+                EGifPutExtensionBlock(gif_state->gif, sizeof(loop_count), loop_count) == GIF_ERROR ||
+                EGifPutExtensionTrailer(gif_state->gif) == GIF_ERROR) {
+            SAIL_LOG_ERROR("GIF: %s", GifErrorString(gif_state->gif->Error));
+            SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
+        }
+    }
+
+    gif_state->header_written = true;
+
+    return SAIL_OK;
+}
+
+static sail_status_t write_comments(struct gif_state *gif_state, const struct sail_meta_data_node *meta_data_node) {
+
+    for (; meta_data_node != NULL; meta_data_node = meta_data_node->next) {
+        if (meta_data_node->key != SAIL_META_DATA_COMMENT || meta_data_node->value_type != SAIL_META_DATA_TYPE_STRING) {
+            continue;
+        }
+
+        if (EGifPutComment(gif_state->gif, meta_data_node->value_string) == GIF_ERROR) {
+            SAIL_LOG_ERROR("GIF: %s", GifErrorString(gif_state->gif->Error));
+            SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
+        }
+    }
+
+    return SAIL_OK;
+}
+
+/*
+ * Prepares the pending frame for encoding. Only the rectangle of pixels differing from the canvas is encoded,
+ * and the pixels equal to the canvas are transparent. When the next frame makes opaque pixels transparent,
+ * the rectangle also covers them, and the frame is disposed to the background.
+ */
+static void prepare_frame(struct gif_state *gif_state, const uint32_t *next_frame, struct gif_frame *gif_frame) {
+
+    const unsigned width  = gif_state->screen_width;
+    const unsigned height = gif_state->screen_height;
+    const uint32_t *frame = gif_state->pending_frame;
+    uint32_t *canvas      = gif_state->canvas;
+
+    unsigned left = width, top = height, right = 0, bottom = 0;
+    bool dispose_background = false;
+
+    if (gif_state->frames_prepared == 0) {
+        left = top = 0;
+        right = width;
+        bottom = height;
+    } else {
+        for (unsigned row = 0; row < height; row++) {
+            const uint32_t *frame_row  = frame  + (size_t)row * width;
+            const uint32_t *canvas_row = canvas + (size_t)row * width;
+
+            if (memcmp(frame_row, canvas_row, (size_t)width * 4) == 0) {
+                continue;
+            }
+
+            for (unsigned column = 0; column < width; column++) {
+                if (frame_row[column] != canvas_row[column]) {
+                    extend_rect(column, row, &left, &top, &right, &bottom);
+                }
+            }
+        }
+    }
+
+    if (next_frame != NULL) {
+        for (unsigned row = 0; row < height; row++) {
+            const uint32_t *frame_row = frame      + (size_t)row * width;
+            const uint32_t *next_row  = next_frame + (size_t)row * width;
+
+            for (unsigned column = 0; column < width; column++) {
+                if (next_row[column] == 0 && frame_row[column] != 0) {
+                    extend_rect(column, row, &left, &top, &right, &bottom);
+                    dispose_background = true;
+                }
+            }
+        }
+    }
+
+    /* The frame is equal to the canvas. GIF frames cannot be empty. */
+    if (right == 0) {
+        left = top = 0;
+        right = bottom = 1;
+    }
+
+    gif_frame->left               = left;
+    gif_frame->top                = top;
+    gif_frame->width              = right - left;
+    gif_frame->height             = bottom - top;
+    gif_frame->dispose_background = dispose_background;
+    gif_frame->delay              = gif_state->pending_delay;
+    gif_frame->dithering          = gif_state->write_options->dithering;
+    gif_frame->interlaced         = gif_state->write_options->io_options & SAIL_IO_OPTION_INTERLACED;
+    gif_frame->buffer.size        = 0;
+
+    sail_destroy_meta_data_node_chain(gif_frame->meta_data_node);
+    gif_frame->meta_data_node         = gif_state->pending_meta_data_node;
+    gif_state->pending_meta_data_node = NULL;
+
+    /* Pixels equal to the canvas are transparent. */
+    for (unsigned row = top; row < bottom; row++) {
+        const uint32_t *frame_row  = frame  + (size_t)row * width + left;
+        uint32_t *canvas_row       = canvas + (size_t)row * width + left;
+        uint32_t *pixels_row       = gif_frame->pixels + (size_t)(row - top) * gif_frame->width;
+
+        for (unsigned column = 0; column < gif_frame->width; column++) {
+            pixels_row[column] = (frame_row[column] == canvas_row[column]) ? 0 : frame_row[column];
+        }
+
+        /* Update the canvas as a viewer does. */
+        if (dispose_background) {
+            memset(canvas_row, 0, (size_t)gif_frame->width * 4);
+        } else {
+            memcpy(canvas_row, frame_row, (size_t)gif_frame->width * 4);
+        }
+    }
+
+    gif_state->frames_prepared++;
+    gif_state->has_pending_frame = false;
+}
+
+/* Quantizes and compresses the frame. Runs in encoding threads. */
+static sail_status_t encode_frame(void *job) {
+
+    struct gif_frame *frame = job;
+    const size_t pixels_count = (size_t)frame->width * frame->height;
+
+    bool has_transparency = false;
+
+    for (size_t i = 0; i < pixels_count; i++) {
+        if (frame->pixels[i] == 0) {
+            has_transparency = true;
+            break;
+        }
+    }
+
+    /* Reserve the last color for transparency. */
+    SAIL_TRY(gif_private_build_palette(frame->pixels, frame->width, frame->height,
+                                       has_transparency ? 255 : 256, frame->palette));
+
+    frame->transparency_index = has_transparency ? (int)frame->palette->colors_count : NO_TRANSPARENT_COLOR;
+
+    SAIL_TRY(gif_private_map_pixels(frame->pixels, frame->width, frame->height,
+                                    frame->palette, frame->dithering,
+                                    frame->transparency_index, frame->indexes));
+
+    /* Color maps must have a power of two number of colors. */
+    const int colors_count = (int)frame->palette->colors_count + (has_transparency ? 1 : 0);
+    ColorMapObject *map = GifMakeMapObject(1 << GifBitSize(colors_count), frame->palette->colors);
+
+    if (map == NULL) {
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_MEMORY_ALLOCATION);
+    }
+
+    /* Compress into memory. The writer emits nothing until the image descriptor. */
+    int error_code;
+    GifFileType *gif = EGifOpen(&frame->buffer, my_memory_write_proc, &error_code);
+
+    if (gif == NULL) {
+        SAIL_LOG_ERROR("GIF: Failed to initialize. GIFLIB error code: %d", error_code);
+        GifFreeMapObject(map);
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
+    }
+
+    sail_status_t status = SAIL_OK;
+
+    if (EGifPutImageDesc(gif, frame->left, frame->top, frame->width, frame->height, frame->interlaced, map) == GIF_ERROR) {
+        SAIL_LOG_ERROR("GIF: %s", GifErrorString(gif->Error));
+        status = SAIL_ERROR_UNDERLYING_CODEC;
+    }
+
+    GifFreeMapObject(map);
+
+    /* Write rows. Interlaced rows are written pass by pass. */
+    for (int pass = 0; status == SAIL_OK && pass < (frame->interlaced ? 4 : 1); pass++) {
+        const unsigned first_row = frame->interlaced ? (unsigned)InterlacedOffset[pass] : 0;
+        const unsigned row_step  = frame->interlaced ? (unsigned)InterlacedJumps[pass]  : 1;
+
+        for (unsigned row = first_row; row < frame->height; row += row_step) {
+            if (EGifPutLine(gif, frame->indexes + (size_t)row * frame->width, frame->width) == GIF_ERROR) {
+                SAIL_LOG_ERROR("GIF: %s", GifErrorString(gif->Error));
+                status = SAIL_ERROR_UNDERLYING_CODEC;
+                break;
+            }
+        }
+    }
+
+    /* Drop the trailer written on close. */
+    const size_t size = frame->buffer.size;
+    EGifCloseFile(gif, /* ErrorCode */ NULL);
+    frame->buffer.size = size;
+
+    SAIL_TRY(status);
+
+    return SAIL_OK;
+}
+
+/* Writes the encoded frame into the output stream. */
+static sail_status_t emit_frame(struct gif_state *gif_state, const struct gif_frame *frame) {
+
+    /* Comments. */
+    if (gif_state->write_options->io_options & SAIL_IO_OPTION_META_DATA) {
+        SAIL_TRY(write_comments(gif_state, frame->meta_data_node));
+    }
+
+    /* Graphics control block. Delay is in 1/100 of seconds. */
+    GraphicsControlBlock gcb;
+    gcb.DisposalMode     = frame->dispose_background ? DISPOSE_BACKGROUND : DISPOSE_DO_NOT;
+    gcb.UserInputFlag    = false;
+    gcb.DelayTime        = (frame->delay > 0) ? (frame->delay + 5) / 10 : 0;
+    gcb.TransparentColor = frame->transparency_index;
+
+    GifByteType extension[4];
+    const size_t extension_length = EGifGCBToExtension(&gcb, extension);
+
+    if (EGifPutExtension(gif_state->gif, GRAPHICS_EXT_FUNC_CODE, (int)extension_length, extension) == GIF_ERROR) {
+        SAIL_LOG_ERROR("GIF: %s", GifErrorString(gif_state->gif->Error));
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
+    }
+
+    SAIL_TRY(gif_state->io->strict_write(gif_state->io->stream, frame->buffer.data, frame->buffer.size));
+
+    return SAIL_OK;
+}
+
+/* Takes back encoded frames in order and writes them. Waits for the frames if wait is true. */
+static sail_status_t emit_encoded_frames(struct gif_state *gif_state, bool wait) {
+
+    for (;;) {
+        void *job;
+        SAIL_TRY(sail_thread_pool_take(gif_state->pool, wait, &job));
+
+        if (job == NULL) {
+            break;
+        }
+
+        SAIL_TRY(emit_frame(gif_state, job));
+    }
+
+    return SAIL_OK;
+}
+
+static sail_status_t alloc_frame_buffers(struct gif_state *gif_state, struct gif_frame *frame) {
+
+    const size_t pixels_count = (size_t)gif_state->screen_width * gif_state->screen_height;
+    void *ptr;
+
+    SAIL_TRY(sail_malloc(pixels_count * sizeof(uint32_t), &ptr));
+    frame->pixels = ptr;
+
+    SAIL_TRY(sail_malloc(pixels_count * sizeof(GifPixelType), &ptr));
+    frame->indexes = ptr;
+
+    SAIL_TRY(sail_malloc(sizeof(struct gif_private_palette), &ptr));
+    frame->palette = ptr;
+
+    return SAIL_OK;
+}
+
+/* Encodes and writes the pending frame, possibly later in encoding threads. */
+static sail_status_t write_pending_frame(struct gif_state *gif_state, const uint32_t *next_frame) {
+
+    if (!gif_state->header_written) {
+        SAIL_TRY(write_header(gif_state, /* animated */ next_frame != NULL));
+    }
+
+    /* Make room in the ring. */
+    if (gif_state->pool != NULL && sail_thread_pool_queued(gif_state->pool) == gif_state->frames_count) {
+        void *job;
+        SAIL_TRY(sail_thread_pool_take(gif_state->pool, /* wait */ true, &job));
+        SAIL_TRY(emit_frame(gif_state, job));
+    }
+
+    struct gif_frame *frame = &gif_state->frames[gif_state->frames_prepared % gif_state->frames_count];
+
+    if (frame->pixels == NULL) {
+        SAIL_TRY(alloc_frame_buffers(gif_state, frame));
+    }
+
+    prepare_frame(gif_state, next_frame, frame);
+
+    if (gif_state->pool != NULL) {
+        SAIL_TRY(sail_thread_pool_submit(gif_state->pool, encode_frame, frame));
+        SAIL_TRY(emit_encoded_frames(gif_state, /* wait */ false));
+    } else {
+        SAIL_TRY(encode_frame(frame));
+        SAIL_TRY(emit_frame(gif_state, frame));
+    }
+
+    return SAIL_OK;
+}
+
+static sail_status_t alloc_write_buffers(struct gif_state *gif_state, unsigned width, unsigned height) {
+
+    const size_t pixels_count = (size_t)width * height;
+
+    gif_state->screen_width  = width;
+    gif_state->screen_height = height;
+
+    void *ptr;
+
+    SAIL_TRY(sail_calloc(pixels_count, sizeof(uint32_t), &ptr));
+    gif_state->canvas = ptr;
+
+    SAIL_TRY(sail_malloc(pixels_count * sizeof(uint32_t), &ptr));
+    gif_state->pending_frame = ptr;
+
+    SAIL_TRY(sail_malloc(pixels_count * sizeof(uint32_t), &ptr));
+    gif_state->next_frame = ptr;
+
+    return SAIL_OK;
+}
+
 SAIL_EXPORT sail_status_t sail_codec_write_init_v4_gif(struct sail_io *io, const struct sail_write_options *write_options, void **state) {
 
     SAIL_CHECK_STATE_PTR(state);
+    *state = NULL;
+
     SAIL_CHECK_IO(io);
     SAIL_CHECK_WRITE_OPTIONS_PTR(write_options);
 
-    SAIL_LOG_AND_RETURN(SAIL_ERROR_NOT_IMPLEMENTED);
+    /* Allocate a new state. */
+    struct gif_state *gif_state;
+    SAIL_TRY(alloc_gif_state(&gif_state));
+    *state = gif_state;
+
+    gif_state->io = io;
+
+    /* Deep copy write options. */
+    SAIL_TRY(sail_copy_write_options(write_options, &gif_state->write_options));
+
+    /* Sanity check. */
+    if (gif_state->write_options->compression != SAIL_COMPRESSION_LZW) {
+        SAIL_LOG_ERROR("GIF: Only LZW compression is allowed for writing");
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_UNSUPPORTED_COMPRESSION);
+    }
+
+    /*
+     * Frames are encoded in threads and written in order. The ring holds frames
+     * being encoded by all threads and as many frames waiting for them.
+     */
+    const unsigned threads = (gif_state->write_options->threads < GIF_MAX_THREADS) ? gif_state->write_options->threads : GIF_MAX_THREADS;
+
+    gif_state->frames_count = (threads > 1) ? threads * 2 : 1;
+
+    void *ptr;
+    SAIL_TRY(sail_calloc(gif_state->frames_count, sizeof(struct gif_frame), &ptr));
+    gif_state->frames = ptr;
+
+    if (threads > 1) {
+        SAIL_TRY(sail_alloc_thread_pool(threads, &gif_state->pool));
+    }
+
+    /* Initialize GIF. */
+    int error_code;
+    gif_state->gif = EGifOpen(io, my_write_proc, &error_code);
+
+    if (gif_state->gif == NULL) {
+        SAIL_LOG_ERROR("GIF: Failed to initialize. GIFLIB error code: %d", error_code);
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
+    }
+
+    return SAIL_OK;
 }
 
 SAIL_EXPORT sail_status_t sail_codec_write_seek_next_frame_v4_gif(void *state, struct sail_io *io, const struct sail_image *image) {
@@ -518,7 +1038,31 @@ SAIL_EXPORT sail_status_t sail_codec_write_seek_next_frame_v4_gif(void *state, s
     SAIL_CHECK_IO(io);
     SAIL_CHECK_IMAGE(image);
 
-    SAIL_LOG_AND_RETURN(SAIL_ERROR_NOT_IMPLEMENTED);
+    struct gif_state *gif_state = (struct gif_state *)state;
+
+    if (gif_state->canvas == NULL) {
+        if (image->width > 0xFFFF || image->height > 0xFFFF) {
+            SAIL_LOG_ERROR("GIF: Image dimensions %ux%u are too large", image->width, image->height);
+            SAIL_LOG_AND_RETURN(SAIL_ERROR_INCORRECT_IMAGE_DIMENSIONS);
+        }
+
+        SAIL_TRY(alloc_write_buffers(gif_state, image->width, image->height));
+    } else if (image->width != gif_state->screen_width || image->height != gif_state->screen_height) {
+        SAIL_LOG_ERROR("GIF: All frames must have the same dimensions %ux%u", gif_state->screen_width, gif_state->screen_height);
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_INCORRECT_IMAGE_DIMENSIONS);
+    }
+
+    gif_state->current_pass = -1;
+
+    if (gif_state->current_image < 0) {
+        const char *pixel_format_str = NULL;
+        SAIL_TRY_OR_SUPPRESS(sail_pixel_format_to_string(image->pixel_format, &pixel_format_str));
+        SAIL_LOG_DEBUG("GIF: Input pixel format is %s", pixel_format_str);
+    }
+
+    gif_state->current_image++;
+
+    return SAIL_OK;
 }
 
 SAIL_EXPORT sail_status_t sail_codec_write_seek_next_pass_v4_gif(void *state, struct sail_io *io, const struct sail_image *image) {
@@ -527,7 +1071,11 @@ SAIL_EXPORT sail_status_t sail_codec_write_seek_next_pass_v4_gif(void *state, st
     SAIL_CHECK_IO(io);
     SAIL_CHECK_IMAGE(image);
 
-    SAIL_LOG_AND_RETURN(SAIL_ERROR_NOT_IMPLEMENTED);
+    struct gif_state *gif_state = (struct gif_state *)state;
+
+    gif_state->current_pass++;
+
+    return SAIL_OK;
 }
 
 SAIL_EXPORT sail_status_t sail_codec_write_frame_v4_gif(void *state, struct sail_io *io, const struct sail_image *image) {
@@ -536,7 +1084,31 @@ SAIL_EXPORT sail_status_t sail_codec_write_frame_v4_gif(void *state, struct sail
     SAIL_CHECK_IO(io);
     SAIL_CHECK_IMAGE(image);
 
-    SAIL_LOG_AND_RETURN(SAIL_ERROR_NOT_IMPLEMENTED);
+    struct gif_state *gif_state = (struct gif_state *)state;
+
+    /* Interlaced frames are written in all passes at once. */
+    if (gif_state->current_pass > 0) {
+        return SAIL_OK;
+    }
+
+    SAIL_TRY(normalize_frame(image, gif_state->next_frame));
+
+    if (gif_state->has_pending_frame) {
+        SAIL_TRY(write_pending_frame(gif_state, gif_state->next_frame));
+    }
+
+    uint32_t *swap = gif_state->pending_frame;
+    gif_state->pending_frame = gif_state->next_frame;
+    gif_state->next_frame    = swap;
+
+    gif_state->has_pending_frame = true;
+    gif_state->pending_delay     = image->delay;
+
+    if (gif_state->write_options->io_options & SAIL_IO_OPTION_META_DATA && image->meta_data_node != NULL) {
+        SAIL_TRY(sail_copy_meta_data_node_chain(image->meta_data_node, &gif_state->pending_meta_data_node));
+    }
+
+    return SAIL_OK;
 }
 
 SAIL_EXPORT sail_status_t sail_codec_write_finish_v4_gif(void **state, struct sail_io *io) {
@@ -544,5 +1116,34 @@ SAIL_EXPORT sail_status_t sail_codec_write_finish_v4_gif(void **state, struct sa
     SAIL_CHECK_STATE_PTR(state);
     SAIL_CHECK_IO(io);
 
-    SAIL_LOG_AND_RETURN(SAIL_ERROR_NOT_IMPLEMENTED);
+    struct gif_state *gif_state = (struct gif_state *)(*state);
+
+    /* Subsequent calls to finish() will expectedly fail in the above line. */
+    *state = NULL;
+
+    if (gif_state->has_pending_frame && gif_state->gif != NULL) {
+        SAIL_TRY_OR_CLEANUP(write_pending_frame(gif_state, /* next frame */ NULL),
+                            /* cleanup */ EGifCloseFile(gif_state->gif, /* ErrorCode */ NULL),
+                                          destroy_gif_state(gif_state));
+    }
+
+    if (gif_state->pool != NULL && gif_state->gif != NULL) {
+        SAIL_TRY_OR_CLEANUP(emit_encoded_frames(gif_state, /* wait */ true),
+                            /* cleanup */ EGifCloseFile(gif_state->gif, /* ErrorCode */ NULL),
+                                          destroy_gif_state(gif_state));
+    }
+
+    if (gif_state->gif != NULL) {
+        int error_code;
+
+        if (EGifCloseFile(gif_state->gif, &error_code) == GIF_ERROR) {
+            SAIL_LOG_ERROR("GIF: Failed to finish writing. GIFLIB error code: %d", error_code);
+            destroy_gif_state(gif_state);
+            SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
+        }
+    }
+
+    destroy_gif_state(gif_state);
+
+    return SAIL_OK;
 }
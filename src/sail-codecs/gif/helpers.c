@@ -23,12 +23,71 @@
     SOFTWARE.
 */
 
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
 #include <gif_lib.h>
 
 #include "sail-common.h"
 
 #include "helpers.h"
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #include <immintrin.h>
+    #define GIF_EXPAND_AVX2
+#endif
+
+/*
+ * Private functions.
+ */
+
+static void expand_row_scalar(unsigned char *dst, const GifPixelType *src, unsigned width, const uint32_t *lut, int transparency_index) {
+
+    if (transparency_index < 0) {
+        for (unsigned i = 0; i < width; i++) {
+            memcpy(dst + i * 4, &lut[src[i]], 4);
+        }
+    } else {
+        for (unsigned i = 0; i < width; i++) {
+            if (src[i] != transparency_index) {
+                memcpy(dst + i * 4, &lut[src[i]], 4);
+            }
+        }
+    }
+}
+
+#ifdef GIF_EXPAND_AVX2
+/* Gathers 8 pixels per iteration and keeps the canvas under transparent pixels with a blend. */
+__attribute__((target("avx2")))
+static void expand_row_avx2(unsigned char *dst, const GifPixelType *src, unsigned width, const uint32_t *lut, int transparency_index) {
+
+    const __m256i transparent = _mm256_set1_epi32(transparency_index);
+
+    unsigned i = 0;
+
+    for (; i + 8 <= width; i += 8) {
+        const __m256i indexes = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(src + i)));
+        const __m256i colors  = _mm256_i32gather_epi32((const int *)lut, indexes, 4);
+
+        if (transparency_index < 0) {
+            _mm256_storeu_si256((__m256i *)(dst + i * 4), colors);
+        } else {
+            const __m256i keep   = _mm256_cmpeq_epi32(indexes, transparent);
+            const __m256i canvas = _mm256_loadu_si256((const __m256i *)(dst + i * 4));
+
+            _mm256_storeu_si256((__m256i *)(dst + i * 4), _mm256_blendv_epi8(colors, canvas, keep));
+        }
+    }
+
+    expand_row_scalar(dst + i * 4, src + i, width - i, lut, transparency_index);
+}
+#endif
+
+/*
+ * Public functions.
+ */
+
 sail_status_t gif_private_supported_read_output_pixel_format(enum SailPixelFormat pixel_format) {
 
     switch (pixel_format) {
@@ -65,11 +124,13 @@ sail_status_t gif_private_fetch_comment(const GifByteType *extension, struct sai
                         /* cleanup */ sail_destroy_meta_data_node(meta_data_node));
 
     /* Save it as a last meta data node in the image. */
-    while (*image_meta_data_node != NULL) {
-        *image_meta_data_node = (*image_meta_data_node)->next;
+    struct sail_meta_data_node **last_meta_data_node = image_meta_data_node;
+
+    while (*last_meta_data_node != NULL) {
+        last_meta_data_node = &(*last_meta_data_node)->next;
     }
 
-    *image_meta_data_node = meta_data_node;
+    *last_meta_data_node = meta_data_node;
 
     return SAIL_OK;
 }
@@ -91,11 +152,53 @@ sail_status_t gif_private_fetch_application(const GifByteType *extension, struct
                         /* cleanup */ sail_destroy_meta_data_node(meta_data_node));
 
     /* Save it as a last meta data node in the image. */
-    while (*image_meta_data_node != NULL) {
-        *image_meta_data_node = (*image_meta_data_node)->next;
+    struct sail_meta_data_node **last_meta_data_node = image_meta_data_node;
+
+    while (*last_meta_data_node != NULL) {
+        last_meta_data_node = &(*last_meta_data_node)->next;
     }
 
-    *image_meta_data_node = meta_data_node;
+    *last_meta_data_node = meta_data_node;
+
+    return SAIL_OK;
+}
+
+sail_status_t gif_private_build_lut(const ColorMapObject *map, int transparency_index, enum SailPixelFormat pixel_format, uint32_t lut[256]) {
+
+    SAIL_CHECK_PTR(map);
+    SAIL_CHECK_PTR(lut);
+
+    const bool bgr = pixel_format == SAIL_PIXEL_FORMAT_BPP32_BGRA;
+
+    for (unsigned i = 0; i < 256; i++) {
+        unsigned char pixel[4] = { 0, 0, 0, 255 };
+
+        /* Indexes out of the color map range decode as opaque black. */
+        if ((int)i < map->ColorCount) {
+            pixel[bgr ? 2 : 0] = map->Colors[i].Red;
+            pixel[1]           = map->Colors[i].Green;
+            pixel[bgr ? 0 : 2] = map->Colors[i].Blue;
+        }
+
+        if ((int)i == transparency_index) {
+            pixel[3] = 0;
+        }
+
+        memcpy(&lut[i], pixel, 4);
+    }
 
     return SAIL_OK;
 }
+
+gif_private_expand_row_t gif_private_select_expand_row(void) {
+
+#ifdef GIF_EXPAND_AVX2
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2")) {
+        return expand_row_avx2;
+    }
+#endif
+
+    return expand_row_scalar;
+}
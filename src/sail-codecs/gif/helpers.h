@@ -26,6 +26,8 @@
 #ifndef SAIL_GIF_HELPERS_H
 #define SAIL_GIF_HELPERS_H
 
+#include <stdint.h>
+
 #include <gif_lib.h>
 
 #include "common.h"
@@ -34,10 +36,20 @@
 
 struct sail_meta_data_node;
 
+/*
+ * Expands a row of color indexes into 32-bit pixels with a lookup table built by gif_private_build_lut().
+ * Pixels matching the transparency index (if >= 0) are left intact.
+ */
+typedef void (*gif_private_expand_row_t)(unsigned char *dst, const GifPixelType *src, unsigned width, const uint32_t *lut, int transparency_index);
+
 SAIL_HIDDEN sail_status_t gif_private_supported_read_output_pixel_format(enum SailPixelFormat pixel_format);
 
 SAIL_HIDDEN sail_status_t gif_private_fetch_comment(const GifByteType *extension, struct sail_meta_data_node **image_meta_data_node);
 
 SAIL_HIDDEN sail_status_t gif_private_fetch_application(const GifByteType *extension, struct sail_meta_data_node **image_meta_data_node);
 
+SAIL_HIDDEN sail_status_t gif_private_build_lut(const ColorMapObject *map, int transparency_index, enum SailPixelFormat pixel_format, uint32_t lut[256]);
+
+SAIL_HIDDEN gif_private_expand_row_t gif_private_select_expand_row(void);
+
 #endif
@@ -23,6 +23,8 @@
     SOFTWARE.
 */
 
+#include <string.h>
+
 #include "sail-common.h"
 
 #include "io.h"
@@ -42,7 +44,7 @@ int my_read_proc(GifFileType *gif, GifByteType *buffer, int buffer_size) {
     return (int)nbytes;
 }
 
-int my_write_proc(GifFileType *gif, GifByteType *buffer, int buffer_size) {
+int my_write_proc(GifFileType *gif, const GifByteType *buffer, int buffer_size) {
 
     struct sail_io *io = (struct sail_io *)gif->UserData;
     size_t nbytes;
@@ -56,3 +58,30 @@ int my_write_proc(GifFileType *gif, GifByteType *buffer, int buffer_size) {
 
     return (int)nbytes;
 }
+
+int my_memory_write_proc(GifFileType *gif, const GifByteType *buffer, int buffer_size) {
+
+    struct gif_memory_buffer *memory_buffer = (struct gif_memory_buffer *)gif->UserData;
+
+    if (memory_buffer->size + buffer_size > memory_buffer->capacity) {
+        size_t capacity = (memory_buffer->capacity > 0) ? memory_buffer->capacity * 2 : 16384;
+
+        while (memory_buffer->size + buffer_size > capacity) {
+            capacity *= 2;
+        }
+
+        void *ptr = memory_buffer->data;
+
+        if (sail_realloc(capacity, &ptr) != SAIL_OK) {
+            return 0;
+        }
+
+        memory_buffer->data     = ptr;
+        memory_buffer->capacity = capacity;
+    }
+
+    memcpy(memory_buffer->data + memory_buffer->size, buffer, buffer_size);
+    memory_buffer->size += buffer_size;
+
+    return buffer_size;
+}
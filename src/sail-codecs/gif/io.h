@@ -26,12 +26,24 @@
 #ifndef SAIL_GIF_IO_H
 #define SAIL_GIF_IO_H
 
+#include <stddef.h>
+
 #include <gif_lib.h>
 
 #include "export.h"
 
+/* Growing memory buffer to compress frames into. */
+struct gif_memory_buffer {
+    unsigned char *data;
+    size_t size;
+    size_t capacity;
+};
+
 SAIL_HIDDEN int my_read_proc(GifFileType *gif, GifByteType *buffer, int buffer_size);
 
-SAIL_HIDDEN int my_write_proc(GifFileType *gif, GifByteType *buffer, int buffer_size);
+SAIL_HIDDEN int my_write_proc(GifFileType *gif, const GifByteType *buffer, int buffer_size);
+
+/* Appends to struct gif_memory_buffer passed as user data. */
+SAIL_HIDDEN int my_memory_write_proc(GifFileType *gif, const GifByteType *buffer, int buffer_size);
 
 #endif
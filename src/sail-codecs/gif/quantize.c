@@ -0,0 +1,638 @@
+/*  This file is part of SAIL (https://github.com/smoked-herring/sail)
+
+    Copyright (c) 2020 Dmitry Baryshev
+
+    The MIT License
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <gif_lib.h>
+
+#include "sail-common.h"
+
+#include "quantize.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #include <immintrin.h>
+    #define GIF_DITHER_AVX2
+#endif
+
+/* Maximum number of pixels sampled to build a color histogram. */
+#define MAX_HISTOGRAM_SAMPLES (1 << 20)
+
+/* Number of k-means iterations refining the median cut colors. */
+#define KMEANS_ITERATIONS 2
+
+/* Number of 15-bit RGB colors. */
+#define COLOR_KEYS 32768
+
+static const int BAYER[4][4] = {
+    {  0,  8,  2, 10 },
+    { 12,  4, 14,  6 },
+    {  3, 11,  1,  9 },
+    { 15,  7, 13,  5 },
+};
+
+/* Ordered dithering offset of a Bayer matrix value. Spans about a half of the distance between colors of a 256-color palette. */
+#define ORDERED_OFFSET(value) (((value) - 8) * 3)
+
+/* Computes 15-bit RGB colors of a row with ordered dithering applied. */
+typedef void (*dither_keys_t)(const uint32_t *pixels, unsigned y, unsigned width, uint16_t *keys);
+
+struct histogram_entry {
+    unsigned char rgb[3];
+    uint32_t count;
+};
+
+struct box {
+    unsigned begin;
+    unsigned end;
+    unsigned channel;
+    uint64_t score;
+};
+
+/*
+ * Private functions.
+ */
+
+static inline unsigned color_key(unsigned r, unsigned g, unsigned b) {
+
+    return ((r >> 3) << 10) | ((g >> 3) << 5) | (b >> 3);
+}
+
+static inline unsigned clamp_channel(int value) {
+
+    return value < 0 ? 0 : (value > 255 ? 255 : (unsigned)value);
+}
+
+static inline unsigned hash_color(uint32_t color) {
+
+    return (unsigned)((color * 2654435761u) >> (32 - GIF_EXACT_HASH_BITS));
+}
+
+/* Collects the distinct colors into the palette. Returns false if there are more than max_colors of them. */
+static bool collect_exact_colors(const uint32_t *pixels, size_t pixels_count, unsigned max_colors, struct gif_private_palette *palette) {
+
+    memset(palette->exact_keys, 0, sizeof(palette->exact_keys));
+    palette->colors_count = 0;
+
+    uint32_t last_pixel = 0;
+
+    for (size_t i = 0; i < pixels_count; i++) {
+        const uint32_t pixel = pixels[i];
+
+        if (pixel == 0 || pixel == last_pixel) {
+            continue;
+        }
+
+        last_pixel = pixel;
+
+        unsigned slot = hash_color(pixel);
+
+        while (palette->exact_keys[slot] != 0 && palette->exact_keys[slot] != pixel) {
+            slot = (slot + 1) & (GIF_EXACT_HASH_SIZE - 1);
+        }
+
+        if (palette->exact_keys[slot] == pixel) {
+            continue;
+        }
+
+        if (palette->colors_count == max_colors) {
+            return false;
+        }
+
+        const unsigned char *rgba = (const unsigned char *)&pixels[i];
+
+        palette->exact_keys[slot]    = pixel;
+        palette->exact_indexes[slot] = (int16_t)palette->colors_count;
+
+        palette->colors[palette->colors_count].Red   = rgba[0];
+        palette->colors[palette->colors_count].Green = rgba[1];
+        palette->colors[palette->colors_count].Blue  = rgba[2];
+        palette->colors_count++;
+    }
+
+    return true;
+}
+
+static inline int exact_index(const struct gif_private_palette *palette, uint32_t pixel) {
+
+    unsigned slot = hash_color(pixel);
+
+    while (palette->exact_keys[slot] != pixel) {
+        slot = (slot + 1) & (GIF_EXACT_HASH_SIZE - 1);
+    }
+
+    return palette->exact_indexes[slot];
+}
+
+/* Builds a histogram of 15-bit colors of the sampled opaque pixels. Entries hold the average colors. */
+static sail_status_t build_histogram(const uint32_t *pixels, size_t pixels_count,
+                                     struct histogram_entry **entries, unsigned *entries_count) {
+
+    /* Number of pixels and sums of their R, G, and B values. */
+    void *ptr;
+    SAIL_TRY(sail_calloc(COLOR_KEYS, sizeof(uint64_t) * 4, &ptr));
+    uint64_t (*bins)[4] = ptr;
+
+    size_t step = pixels_count / MAX_HISTOGRAM_SAMPLES + 1;
+    unsigned bins_count = 0;
+
+    while (true) {
+        for (size_t i = 0; i < pixels_count; i += step) {
+            if (pixels[i] == 0) {
+                continue;
+            }
+
+            const unsigned char *rgba = (const unsigned char *)&pixels[i];
+            uint64_t *bin = bins[color_key(rgba[0], rgba[1], rgba[2])];
+
+            if (bin[0] == 0) {
+                bins_count++;
+            }
+
+            bin[0]++;
+            bin[1] += rgba[0];
+            bin[2] += rgba[1];
+            bin[3] += rgba[2];
+        }
+
+        /* Sampling missed all the opaque pixels. */
+        if (bins_count > 0 || step == 1) {
+            break;
+        }
+
+        step = 1;
+    }
+
+    SAIL_TRY_OR_CLEANUP(sail_malloc((bins_count > 0 ? bins_count : 1) * sizeof(struct histogram_entry), &ptr),
+                        /* cleanup */ sail_free(bins));
+    *entries = ptr;
+    *entries_count = 0;
+
+    for (unsigned key = 0; key < COLOR_KEYS; key++) {
+        const uint64_t count = bins[key][0];
+
+        if (count == 0) {
+            continue;
+        }
+
+        struct histogram_entry *entry = &(*entries)[(*entries_count)++];
+
+        entry->rgb[0] = (unsigned char)((bins[key][1] + count / 2) / count);
+        entry->rgb[1] = (unsigned char)((bins[key][2] + count / 2) / count);
+        entry->rgb[2] = (unsigned char)((bins[key][3] + count / 2) / count);
+        entry->count  = count > UINT32_MAX ? UINT32_MAX : (uint32_t)count;
+    }
+
+    sail_free(bins);
+
+    return SAIL_OK;
+}
+
+static int compare_red(const void *a, const void *b) {
+
+    return ((const struct histogram_entry *)a)->rgb[0] - ((const struct histogram_entry *)b)->rgb[0];
+}
+
+static int compare_green(const void *a, const void *b) {
+
+    return ((const struct histogram_entry *)a)->rgb[1] - ((const struct histogram_entry *)b)->rgb[1];
+}
+
+static int compare_blue(const void *a, const void *b) {
+
+    return ((const struct histogram_entry *)a)->rgb[2] - ((const struct histogram_entry *)b)->rgb[2];
+}
+
+/* Finds the widest channel of the box. Boxes with wide ranges and many pixels are split first. */
+static void measure_box(const struct histogram_entry *entries, struct box *box) {
+
+    unsigned char min[3] = { 255, 255, 255 };
+    unsigned char max[3] = { 0, 0, 0 };
+    uint64_t count = 0;
+
+    for (unsigned i = box->begin; i < box->end; i++) {
+        for (unsigned channel = 0; channel < 3; channel++) {
+            if (entries[i].rgb[channel] < min[channel]) {
+                min[channel] = entries[i].rgb[channel];
+            }
+            if (entries[i].rgb[channel] > max[channel]) {
+                max[channel] = entries[i].rgb[channel];
+            }
+        }
+
+        count += entries[i].count;
+    }
+
+    unsigned range = 0;
+    box->channel = 0;
+
+    for (unsigned channel = 0; channel < 3; channel++) {
+        if ((unsigned)(max[channel] - min[channel]) > range) {
+            range = max[channel] - min[channel];
+            box->channel = channel;
+        }
+    }
+
+    box->score = (box->end - box->begin > 1) ? (uint64_t)range * count : 0;
+}
+
+/* Splits the histogram into boxes by the median cut. */
+static unsigned median_cut(struct histogram_entry *entries, unsigned entries_count, unsigned max_colors, struct box *boxes) {
+
+    static int (* const compare[3])(const void *, const void *) = { compare_red, compare_green, compare_blue };
+
+    boxes[0].begin = 0;
+    boxes[0].end   = entries_count;
+    measure_box(entries, &boxes[0]);
+
+    unsigned boxes_count = 1;
+
+    while (boxes_count < max_colors) {
+        unsigned split = 0;
+
+        for (unsigned i = 1; i < boxes_count; i++) {
+            if (boxes[i].score > boxes[split].score) {
+                split = i;
+            }
+        }
+
+        if (boxes[split].score == 0) {
+            break;
+        }
+
+        struct box *box = &boxes[split];
+        qsort(entries + box->begin, box->end - box->begin, sizeof(struct histogram_entry), compare[box->channel]);
+
+        uint64_t total = 0;
+        for (unsigned i = box->begin; i < box->end; i++) {
+            total += entries[i].count;
+        }
+
+        /* Split at the weighted median, leaving at least one entry in both boxes. */
+        unsigned median = box->begin + 1;
+        uint64_t accumulated = entries[box->begin].count;
+
+        while (median < box->end - 1 && accumulated * 2 < total) {
+            accumulated += entries[median++].count;
+        }
+
+        boxes[boxes_count].begin = median;
+        boxes[boxes_count].end   = box->end;
+        box->end = median;
+
+        measure_box(entries, box);
+        measure_box(entries, &boxes[boxes_count]);
+
+        boxes_count++;
+    }
+
+    return boxes_count;
+}
+
+static unsigned nearest_color(const GifColorType *colors, unsigned colors_count, int r, int g, int b) {
+
+    unsigned best = 0;
+    int best_distance = 0x7FFFFFFF;
+
+    for (unsigned i = 0; i < colors_count; i++) {
+        const int dr = r - colors[i].Red;
+        const int dg = g - colors[i].Green;
+        const int db = b - colors[i].Blue;
+        const int distance = dr * dr + dg * dg + db * db;
+
+        if (distance < best_distance) {
+            best_distance = distance;
+            best = i;
+        }
+    }
+
+    return best;
+}
+
+/* Moves the colors to the centroids of the histogram entries nearest to them. */
+static void refine_colors(const struct histogram_entry *entries, unsigned entries_count, GifColorType *colors, unsigned colors_count) {
+
+    uint64_t sums[256][4];
+
+    for (unsigned iteration = 0; iteration < KMEANS_ITERATIONS; iteration++) {
+        memset(sums, 0, sizeof(sums));
+
+        for (unsigned i = 0; i < entries_count; i++) {
+            const struct histogram_entry *entry = &entries[i];
+            const unsigned nearest = nearest_color(colors, colors_count, entry->rgb[0], entry->rgb[1], entry->rgb[2]);
+
+            sums[nearest][0] += entry->count;
+            sums[nearest][1] += (uint64_t)entry->rgb[0] * entry->count;
+            sums[nearest][2] += (uint64_t)entry->rgb[1] * entry->count;
+            sums[nearest][3] += (uint64_t)entry->rgb[2] * entry->count;
+        }
+
+        for (unsigned i = 0; i < colors_count; i++) {
+            const uint64_t count = sums[i][0];
+
+            if (count == 0) {
+                continue;
+            }
+
+            colors[i].Red   = (GifByteType)((sums[i][1] + count / 2) / count);
+            colors[i].Green = (GifByteType)((sums[i][2] + count / 2) / count);
+            colors[i].Blue  = (GifByteType)((sums[i][3] + count / 2) / count);
+        }
+    }
+}
+
+static inline unsigned nearest_index(struct gif_private_palette *palette, unsigned key) {
+
+    if (palette->nearest[key] < 0) {
+        palette->nearest[key] = (int16_t)nearest_color(palette->colors,
+                                                        palette->colors_count,
+                                                        (int)((key >> 10) << 3) | 4,
+                                                        (int)(((key >> 5) & 31) << 3) | 4,
+                                                        (int)((key & 31) << 3) | 4);
+    }
+
+    return (unsigned)palette->nearest[key];
+}
+
+static void dither_keys_scalar(const uint32_t *pixels, unsigned y, unsigned width, uint16_t *keys) {
+
+    const int *bayer = BAYER[y & 3];
+
+    for (unsigned x = 0; x < width; x++) {
+        const unsigned char *rgba = (const unsigned char *)&pixels[x];
+        const int offset = ORDERED_OFFSET(bayer[x & 3]);
+
+        keys[x] = (uint16_t)color_key(clamp_channel(rgba[0] + offset),
+                                      clamp_channel(rgba[1] + offset),
+                                      clamp_channel(rgba[2] + offset));
+    }
+}
+
+#ifdef GIF_DITHER_AVX2
+/* Dithers 8 pixels per iteration with saturating adds and subtracts of the Bayer offsets. */
+__attribute__((target("avx2")))
+static void dither_keys_avx2(const uint32_t *pixels, unsigned y, unsigned width, uint16_t *keys) {
+
+    const int *bayer = BAYER[y & 3];
+
+    unsigned char add[32];
+    unsigned char sub[32];
+
+    for (unsigned i = 0; i < 8; i++) {
+        const int offset = ORDERED_OFFSET(bayer[i & 3]);
+
+        for (unsigned channel = 0; channel < 4; channel++) {
+            add[i * 4 + channel] = (channel < 3 && offset > 0) ? (unsigned char)offset : 0;
+            sub[i * 4 + channel] = (channel < 3 && offset < 0) ? (unsigned char)-offset : 0;
+        }
+    }
+
+    const __m256i offset_add = _mm256_loadu_si256((const __m256i *)add);
+    const __m256i offset_sub = _mm256_loadu_si256((const __m256i *)sub);
+    const __m256i mask       = _mm256_set1_epi32(0xF8);
+
+    unsigned x = 0;
+
+    for (; x + 8 <= width; x += 8) {
+        __m256i pixel = _mm256_loadu_si256((const __m256i *)(pixels + x));
+        pixel = _mm256_subs_epu8(_mm256_adds_epu8(pixel, offset_add), offset_sub);
+
+        const __m256i r = _mm256_and_si256(pixel, mask);
+        const __m256i g = _mm256_and_si256(_mm256_srli_epi32(pixel, 8), mask);
+        const __m256i b = _mm256_and_si256(_mm256_srli_epi32(pixel, 16), mask);
+
+        /* RRRRRGGGGGBBBBB */
+        const __m256i key = _mm256_or_si256(_mm256_or_si256(_mm256_slli_epi32(r, 7), _mm256_slli_epi32(g, 2)), _mm256_srli_epi32(b, 3));
+
+        /* Pack 32-bit keys of both lanes into the low 128 bits. */
+        const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(key, key), 0x08);
+        _mm_storeu_si128((__m128i *)(keys + x), _mm256_castsi256_si128(packed));
+    }
+
+    /* x is a multiple of 4, so the tail starts at the same Bayer column. */
+    dither_keys_scalar(pixels + x, y, width - x, keys + x);
+}
+#endif
+
+static dither_keys_t select_dither_keys(void) {
+
+#ifdef GIF_DITHER_AVX2
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2")) {
+        return dither_keys_avx2;
+    }
+#endif
+
+    return dither_keys_scalar;
+}
+
+static sail_status_t map_ordered(const uint32_t *pixels, unsigned width, unsigned height,
+                                 struct gif_private_palette *palette, int transparency_index, GifPixelType *indexes) {
+
+    void *ptr;
+    SAIL_TRY(sail_malloc((size_t)width * sizeof(uint16_t), &ptr));
+    uint16_t *keys = ptr;
+
+    const dither_keys_t dither_keys = select_dither_keys();
+
+    for (unsigned y = 0; y < height; y++) {
+        const uint32_t *row = pixels + (size_t)y * width;
+        GifPixelType *row_indexes = indexes + (size_t)y * width;
+
+        dither_keys(row, y, width, keys);
+
+        for (unsigned x = 0; x < width; x++) {
+            row_indexes[x] = (GifPixelType)(row[x] == 0 ? (unsigned)transparency_index : nearest_index(palette, keys[x]));
+        }
+    }
+
+    sail_free(keys);
+
+    return SAIL_OK;
+}
+
+static sail_status_t map_floyd_steinberg(const uint32_t *pixels, unsigned width, unsigned height,
+                                         struct gif_private_palette *palette, int transparency_index, GifPixelType *indexes) {
+
+    /* Errors of the current and the next rows multiplied by 16, with a guard column on both sides. */
+    const size_t errors_row_length = ((size_t)width + 2) * 3;
+
+    void *ptr;
+    SAIL_TRY(sail_calloc(errors_row_length * 2, sizeof(int), &ptr));
+    int *errors = ptr;
+
+    int *current = errors;
+    int *next    = errors + errors_row_length;
+
+    for (unsigned y = 0; y < height; y++) {
+        const uint32_t *row = pixels + (size_t)y * width;
+        GifPixelType *row_indexes = indexes + (size_t)y * width;
+
+        memset(next, 0, errors_row_length * sizeof(int));
+
+        for (unsigned x = 0; x < width; x++) {
+            if (row[x] == 0) {
+                row_indexes[x] = (GifPixelType)transparency_index;
+                continue;
+            }
+
+            const unsigned char *rgba = (const unsigned char *)&row[x];
+            int color[3];
+
+            for (unsigned channel = 0; channel < 3; channel++) {
+                color[channel] = (int)clamp_channel(rgba[channel] + current[(x + 1) * 3 + channel] / 16);
+            }
+
+            const unsigned index = nearest_index(palette, color_key((unsigned)color[0], (unsigned)color[1], (unsigned)color[2]));
+            const GifColorType *chosen = &palette->colors[index];
+            const int error[3] = { color[0] - chosen->Red, color[1] - chosen->Green, color[2] - chosen->Blue };
+
+            row_indexes[x] = (GifPixelType)index;
+
+            for (unsigned channel = 0; channel < 3; channel++) {
+                current[(x + 2) * 3 + channel] += error[channel] * 7;
+                next[x * 3 + channel]          += error[channel] * 3;
+                next[(x + 1) * 3 + channel]    += error[channel] * 5;
+                next[(x + 2) * 3 + channel]    += error[channel];
+            }
+        }
+
+        int *swap = current;
+        current = next;
+        next = swap;
+    }
+
+    sail_free(errors);
+
+    return SAIL_OK;
+}
+
+/*
+ * Public functions.
+ */
+
+sail_status_t gif_private_build_palette(const uint32_t *pixels, unsigned width, unsigned height, unsigned max_colors,
+                                        struct gif_private_palette *palette) {
+
+    SAIL_CHECK_PTR(pixels);
+    SAIL_CHECK_PTR(palette);
+
+    const size_t pixels_count = (size_t)width * height;
+
+    if (max_colors > 256) {
+        max_colors = 256;
+    }
+
+    memset(palette->colors, 0, sizeof(palette->colors));
+    memset(palette->nearest, 0xFF, sizeof(palette->nearest));
+
+    palette->exact = collect_exact_colors(pixels, pixels_count, max_colors, palette);
+
+    if (palette->exact) {
+        return SAIL_OK;
+    }
+
+    memset(palette->colors, 0, sizeof(palette->colors));
+
+    struct histogram_entry *entries;
+    unsigned entries_count;
+    SAIL_TRY(build_histogram(pixels, pixels_count, &entries, &entries_count));
+
+    struct box boxes[256];
+    const unsigned boxes_count = median_cut(entries, entries_count, max_colors, boxes);
+
+    for (unsigned i = 0; i < boxes_count; i++) {
+        uint64_t sums[4] = { 0, 0, 0, 0 };
+
+        for (unsigned j = boxes[i].begin; j < boxes[i].end; j++) {
+            sums[0] += entries[j].count;
+            sums[1] += (uint64_t)entries[j].rgb[0] * entries[j].count;
+            sums[2] += (uint64_t)entries[j].rgb[1] * entries[j].count;
+            sums[3] += (uint64_t)entries[j].rgb[2] * entries[j].count;
+        }
+
+        palette->colors[i].Red   = (GifByteType)((sums[1] + sums[0] / 2) / sums[0]);
+        palette->colors[i].Green = (GifByteType)((sums[2] + sums[0] / 2) / sums[0]);
+        palette->colors[i].Blue  = (GifByteType)((sums[3] + sums[0] / 2) / sums[0]);
+    }
+
+    palette->colors_count = boxes_count;
+
+    /* Median cut boxes are a good start, not the best colors. */
+    if (entries_count > boxes_count) {
+        refine_colors(entries, entries_count, palette->colors, palette->colors_count);
+    }
+
+    sail_free(entries);
+
+    return SAIL_OK;
+}
+
+sail_status_t gif_private_map_pixels(const uint32_t *pixels, unsigned width, unsigned height,
+                                     struct gif_private_palette *palette, enum SailDithering dithering,
+                                     int transparency_index, GifPixelType *indexes) {
+
+    SAIL_CHECK_PTR(pixels);
+    SAIL_CHECK_PTR(palette);
+    SAIL_CHECK_PTR(indexes);
+
+    const size_t pixels_count = (size_t)width * height;
+
+    if (palette->exact) {
+        for (size_t i = 0; i < pixels_count; i++) {
+            indexes[i] = (GifPixelType)(pixels[i] == 0 ? transparency_index : exact_index(palette, pixels[i]));
+        }
+
+        return SAIL_OK;
+    }
+
+    switch (dithering) {
+        case SAIL_DITHERING_ORDERED: {
+            SAIL_TRY(map_ordered(pixels, width, height, palette, transparency_index, indexes));
+            break;
+        }
+
+        case SAIL_DITHERING_FLOYD_STEINBERG: {
+            SAIL_TRY(map_floyd_steinberg(pixels, width, height, palette, transparency_index, indexes));
+            break;
+        }
+
+        default: {
+            for (size_t i = 0; i < pixels_count; i++) {
+                const unsigned char *rgba = (const unsigned char *)&pixels[i];
+
+                indexes[i] = (GifPixelType)(pixels[i] == 0
+                                            ? (unsigned)transparency_index
+                                            : nearest_index(palette, color_key(rgba[0], rgba[1], rgba[2])));
+            }
+            break;
+        }
+    }
+
+    return SAIL_OK;
+}
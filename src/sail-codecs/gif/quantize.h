@@ -0,0 +1,81 @@
+/*  This file is part of SAIL (https://github.com/smoked-herring/sail)
+
+    Copyright (c) 2020 Dmitry Baryshev
+
+    The MIT License
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#ifndef SAIL_GIF_QUANTIZE_H
+#define SAIL_GIF_QUANTIZE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <gif_lib.h>
+
+#include "common.h"
+#include "error.h"
+#include "export.h"
+
+/*
+ * Pixels passed to the functions below are 32-bit RGBA in memory order. Transparent pixels
+ * are all zeroes, other pixels are opaque.
+ */
+
+/* Number of entries in the exact colors hash table. */
+#define GIF_EXACT_HASH_BITS 9
+#define GIF_EXACT_HASH_SIZE (1 << GIF_EXACT_HASH_BITS)
+
+/* Palette of a frame. */
+struct gif_private_palette {
+    GifColorType colors[256];
+    unsigned colors_count;
+
+    /* The frame has no more colors than the palette, and its pixels are mapped exactly. */
+    bool exact;
+    uint32_t exact_keys[GIF_EXACT_HASH_SIZE];
+    int16_t exact_indexes[GIF_EXACT_HASH_SIZE];
+
+    /* Nearest palette color of every 15-bit RGB color. -1 means not found yet. */
+    int16_t nearest[32768];
+};
+
+/*
+ * Builds a palette of up to max_colors colors for the opaque pixels. Uses the colors as is
+ * when there are not more of them. Otherwise, splits a sampled 15-bit color histogram with the median cut,
+ * and refines the colors with k-means.
+ *
+ * Returns SAIL_OK on success.
+ */
+SAIL_HIDDEN sail_status_t gif_private_build_palette(const uint32_t *pixels, unsigned width, unsigned height, unsigned max_colors,
+                                                    struct gif_private_palette *palette);
+
+/*
+ * Maps the pixels to palette indexes with the specified dithering. Transparent pixels are mapped
+ * to the transparency index.
+ *
+ * Returns SAIL_OK on success.
+ */
+SAIL_HIDDEN sail_status_t gif_private_map_pixels(const uint32_t *pixels, unsigned width, unsigned height,
+                                                 struct gif_private_palette *palette, enum SailDithering dithering,
+                                                 int transparency_index, GifPixelType *indexes);
+
+#endif
@@ -117,67 +117,6 @@ sail_status_t jpeg_private_auto_output_color_space(enum SailPixelFormat input_pi
     }
 }
 
-static void get_cmyk(unsigned char **pixels, unsigned char *C, unsigned char *M, unsigned char *Y, unsigned char *K) {
-
-    *C = (unsigned char)(*(*pixels)++ / 100.0);
-    *M = (unsigned char)(*(*pixels)++ / 100.0);
-    *Y = (unsigned char)(*(*pixels)++ / 100.0);
-    *K = (unsigned char)(*(*pixels)++ / 100.0);
-}
-
-sail_status_t jpeg_private_convert_cmyk(unsigned char *pixels_source, unsigned char *pixels_target, unsigned width, enum SailPixelFormat target_pixel_format) {
-    unsigned char C, M, Y, K;
-
-    switch (target_pixel_format) {
-        case SAIL_PIXEL_FORMAT_BPP32_RGBA: {
-            for (unsigned i = 0; i < width; i++) {
-                get_cmyk(&pixels_source, &C, &M, &Y, &K);
-
-                *pixels_target++ = 255 * (1-C) * (1-K);
-                *pixels_target++ = 255 * (1-M) * (1-K);
-                *pixels_target++ = 255 * (1-Y) * (1-K);
-                *pixels_target++ = 255;
-            }
-            return SAIL_OK;
-        }
-        case SAIL_PIXEL_FORMAT_BPP32_BGRA: {
-            for (unsigned i = 0; i < width; i++) {
-                get_cmyk(&pixels_source, &C, &M, &Y, &K);
-
-                *pixels_target++ = 255 * (1-Y) * (1-K);
-                *pixels_target++ = 255 * (1-M) * (1-K);
-                *pixels_target++ = 255 * (1-C) * (1-K);
-                *pixels_target++ = 255;
-            }
-            return SAIL_OK;
-        }
-        case SAIL_PIXEL_FORMAT_BPP24_RGB: {
-            for (unsigned i = 0; i < width; i++) {
-                get_cmyk(&pixels_source, &C, &M, &Y, &K);
-
-                *pixels_target++ = 255 * (1-C) * (1-K);
-                *pixels_target++ = 255 * (1-M) * (1-K);
-                *pixels_target++ = 255 * (1-Y) * (1-K);
-            }
-            return SAIL_OK;
-        }
-        case SAIL_PIXEL_FORMAT_BPP24_BGR: {
-            for (unsigned i = 0; i < width; i++) {
-                get_cmyk(&pixels_source, &C, &M, &Y, &K);
-
-                *pixels_target++ = 255 * (1-Y) * (1-K);
-                *pixels_target++ = 255 * (1-M) * (1-K);
-                *pixels_target++ = 255 * (1-C) * (1-K);
-            }
-            return SAIL_OK;
-        }
-
-        default: {
-            SAIL_LOG_AND_RETURN(SAIL_ERROR_UNSUPPORTED_PIXEL_FORMAT);
-        }
-    }
-}
-
 sail_status_t jpeg_private_fetch_meta_data(struct jpeg_decompress_struct *decompress_context, struct sail_meta_data_node **last_meta_data_node) {
 
     SAIL_CHECK_META_DATA_NODE_PTR(last_meta_data_node);
@@ -275,6 +214,30 @@ sail_status_t jpeg_private_fetch_resolution(struct jpeg_decompress_struct *decom
     return SAIL_OK;
 }
 
+void jpeg_private_setup_scaling(struct jpeg_decompress_struct *decompress_context, unsigned target_width, unsigned target_height) {
+
+    if (target_width == 0 && target_height == 0) {
+        return;
+    }
+
+    /*
+     * Find the smallest DCT scale that still covers the target size. 1/2, 1/4 and 1/8 are supported by all
+     * libjpeg flavors. They skip most of the IDCT work. Output dimensions are rounded up like libjpeg does.
+     */
+    for (unsigned scale_denom = 8; scale_denom > 1; scale_denom /= 2) {
+        const unsigned scaled_width  = (decompress_context->image_width  + scale_denom - 1) / scale_denom;
+        const unsigned scaled_height = (decompress_context->image_height + scale_denom - 1) / scale_denom;
+
+        if (scaled_width >= target_width && scaled_height >= target_height) {
+            SAIL_LOG_DEBUG("JPEG: Decoding at 1/%u scale", scale_denom);
+
+            decompress_context->scale_num   = 1;
+            decompress_context->scale_denom = scale_denom;
+            return;
+        }
+    }
+}
+
 sail_status_t jpeg_private_write_resolution(struct jpeg_compress_struct *compress_context, const struct sail_resolution *resolution) {
 
     /* Not an error. */
@@ -33,7 +33,12 @@
  * Most of this file was copied from libjpeg-turbo 2.0.4 and adapted to SAIL.
  */
 
-#define OUTPUT_BUF_SIZE  4096   /* choose an efficiently fwrite'able size */
+/* Configured with the SAIL_JPEG_IO_BUFFER_SIZE CMake option. */
+#ifndef SAIL_JPEG_IO_BUFFER_SIZE
+    #define SAIL_JPEG_IO_BUFFER_SIZE 65536
+#endif
+
+#define OUTPUT_BUF_SIZE SAIL_JPEG_IO_BUFFER_SIZE
 
 /*
  * Initialize destination --- called by jpeg_start_compress
@@ -23,13 +23,20 @@
     SOFTWARE.
 */
 
+#include <string.h>
+
 #include <jerror.h>
 
 #include "sail-common.h"
 
 #include "io_src.h"
 
-#define INPUT_BUF_SIZE  4096    /* choose an efficiently fread'able size */
+/* Configured with the SAIL_JPEG_IO_BUFFER_SIZE CMake option. */
+#ifndef SAIL_JPEG_IO_BUFFER_SIZE
+    #define SAIL_JPEG_IO_BUFFER_SIZE 65536
+#endif
+
+#define INPUT_BUF_SIZE SAIL_JPEG_IO_BUFFER_SIZE
 
 /*
  * Most of this file was copied from libjpeg-turbo 2.0.4 and adapted to SAIL.
@@ -107,6 +114,23 @@ static boolean fill_input_buffer(j_decompress_ptr cinfo)
     return TRUE;
 }
 
+/*
+ * Fill the input buffer for memory-based I/O objects. The whole buffer was
+ * handed to libjpeg already, so reaching this point means the data is truncated.
+ * Insert a fake EOI marker like fill_input_buffer() does.
+ */
+static boolean fill_mem_input_buffer(j_decompress_ptr cinfo)
+{
+    static const JOCTET eoi_buffer[2] = { (JOCTET)0xFF, (JOCTET)JPEG_EOI };
+
+    WARNMS(cinfo, JWRN_JPEG_EOF);
+
+    cinfo->src->next_input_byte = eoi_buffer;
+    cinfo->src->bytes_in_buffer = 2;
+
+    return TRUE;
+}
+
 /*
  * Skip data --- used to skip over a potentially large amount of
  * uninteresting data (such as an APPn marker).
@@ -162,6 +186,15 @@ static void term_source(j_decompress_ptr cinfo)
     (void)cinfo;
 }
 
+/*
+ * Initialize source for incremental decoding --- nothing to do,
+ * the data is appended as it arrives.
+ */
+static void init_source_noop(j_decompress_ptr cinfo)
+{
+    (void)cinfo;
+}
+
 /*
  * Prepare for input from a SAIL I/O stream.
  * The caller must have already opened the stream, and is responsible
@@ -204,4 +237,219 @@ void jpeg_private_sail_io_src(j_decompress_ptr cinfo, struct sail_io *io) {
     src->io                    = io;
     src->pub.bytes_in_buffer   = 0;    /* forces fill_input_buffer on first read */
     src->pub.next_input_byte   = NULL; /* until buffer loaded */
+
+    /*
+     * Memory and memory-mapped I/O objects expose their whole buffer. Let libjpeg
+     * consume it in place starting from the current position, jpeg_mem_src() style.
+     */
+    const void *buffer;
+    size_t buffer_length;
+    size_t offset;
+
+    if (io->buffer != NULL &&
+            io->buffer(io->stream, &buffer, &buffer_length) == SAIL_OK &&
+            io->tell(io->stream, &offset) == SAIL_OK &&
+            offset < buffer_length) {
+        src->pub.fill_input_buffer = fill_mem_input_buffer;
+        src->pub.bytes_in_buffer   = buffer_length - offset;
+        src->pub.next_input_byte   = (const JOCTET *)buffer + offset;
+    }
+}
+
+/*
+ * Incremental decoding.
+ */
+
+/*
+ * Returns TRUE if no scans after the current one change the decoded rows, i.e. the current scan
+ * finishes all the coefficients of all the components.
+ */
+static boolean last_scan(j_decompress_ptr cinfo)
+{
+    /*
+     * coef_bits holds the successive approximation bit of the latest started scan of every coefficient.
+     * 0 means the coefficient is refined to full precision by the current or an earlier scan.
+     */
+    if (cinfo->progressive_mode) {
+        if (cinfo->coef_bits == NULL) {
+            return FALSE;
+        }
+
+        for (int ci = 0; ci < cinfo->num_components; ci++) {
+            for (int k = 0; k < DCTSIZE2; k++) {
+                if (cinfo->coef_bits[ci][k] != 0) {
+                    return FALSE;
+                }
+            }
+        }
+
+        return TRUE;
+    }
+
+    /* Sequential images are complete in one scan unless they have a scan per component. */
+    return cinfo->comps_in_scan == cinfo->num_components;
+}
+
+/*
+ * Fill the input buffer for incremental decoding. Suspend until more data arrives,
+ * or insert a fake EOI marker when no more data will arrive.
+ */
+static boolean fill_feed_input_buffer(j_decompress_ptr cinfo)
+{
+    static const JOCTET eoi_buffer[2] = { (JOCTET)0xFF, (JOCTET)JPEG_EOI };
+
+    struct sail_jpeg_feed_source_mgr *src = (struct sail_jpeg_feed_source_mgr *)cinfo->src;
+
+    if (!src->end_of_data) {
+        return FALSE;
+    }
+
+    WARNMS(cinfo, JWRN_JPEG_EOF);
+
+    /*
+     * The iMCU rows before the current one are fully decoded. The current one, if any,
+     * is decoded from the fake EOI marker. Fancy upsampling of vertically subsampled components
+     * blends every row group with the next one, so the last row group of the decoded rows
+     * also depends on the missing data. Nothing is final if later scans are missing.
+     */
+    if (!src->fake_eoi) {
+        src->fake_eoi     = TRUE;
+        src->decoded_rows = 0;
+
+        if (last_scan(cinfo)) {
+            src->decoded_rows = cinfo->input_iMCU_row * cinfo->max_v_samp_factor *
+#if JPEG_LIB_VERSION >= 70
+                                    cinfo->min_DCT_v_scaled_size;
+#else
+                                    cinfo->min_DCT_scaled_size;
+#endif
+        }
+
+        if (cinfo->do_fancy_upsampling && cinfo->max_v_samp_factor > 1) {
+            const JDIMENSION context_rows = (JDIMENSION)cinfo->max_v_samp_factor;
+
+            src->decoded_rows = src->decoded_rows > context_rows ? src->decoded_rows - context_rows : 0;
+        }
+    }
+
+    src->pub.next_input_byte = eoi_buffer;
+    src->pub.bytes_in_buffer = 2;
+
+    return TRUE;
+}
+
+/*
+ * Skip data. Bytes that have not arrived yet are skipped when they arrive.
+ */
+static void skip_feed_input_data(j_decompress_ptr cinfo, long num_bytes)
+{
+    struct sail_jpeg_feed_source_mgr *src = (struct sail_jpeg_feed_source_mgr *)cinfo->src;
+
+    if (num_bytes <= 0) {
+        return;
+    }
+
+    if ((size_t)num_bytes > src->pub.bytes_in_buffer) {
+        src->bytes_to_skip += (size_t)num_bytes - src->pub.bytes_in_buffer;
+        src->pub.next_input_byte += src->pub.bytes_in_buffer;
+        src->pub.bytes_in_buffer = 0;
+    } else {
+        src->pub.next_input_byte += (size_t)num_bytes;
+        src->pub.bytes_in_buffer -= (size_t)num_bytes;
+    }
+}
+
+void jpeg_private_feed_src(j_decompress_ptr cinfo) {
+
+    cinfo->src = (struct jpeg_source_mgr *)(*cinfo->mem->alloc_small)((j_common_ptr)cinfo,
+                                                                        JPOOL_PERMANENT,
+                                                                        sizeof(struct sail_jpeg_feed_source_mgr));
+
+    struct sail_jpeg_feed_source_mgr *src = (struct sail_jpeg_feed_source_mgr *)cinfo->src;
+
+    src->pub.init_source       = init_source_noop;
+    src->pub.fill_input_buffer = fill_feed_input_buffer;
+    src->pub.skip_input_data   = skip_feed_input_data;
+    src->pub.resync_to_restart = jpeg_resync_to_restart; /* use default method */
+    src->pub.term_source       = term_source;
+    src->pub.bytes_in_buffer   = 0;
+    src->pub.next_input_byte   = NULL;
+    src->buffer                = NULL;
+    src->buffer_capacity       = 0;
+    src->bytes_to_skip         = 0;
+    src->end_of_data           = FALSE;
+    src->fake_eoi              = FALSE;
+    src->decoded_rows          = 0;
+}
+
+sail_status_t jpeg_private_feed_src_append(j_decompress_ptr cinfo, const void *buffer, size_t buffer_length) {
+
+    struct sail_jpeg_feed_source_mgr *src = (struct sail_jpeg_feed_source_mgr *)cinfo->src;
+
+    if (buffer == NULL) {
+        src->end_of_data = TRUE;
+        return SAIL_OK;
+    }
+
+    const size_t skip = src->bytes_to_skip < buffer_length ? src->bytes_to_skip : buffer_length;
+    src->bytes_to_skip -= skip;
+    buffer = (const JOCTET *)buffer + skip;
+    buffer_length -= skip;
+
+    /* Keep the unread data. libjpeg rescans it after a suspension. */
+    const size_t unread = src->pub.bytes_in_buffer;
+
+    if (unread + buffer_length > src->buffer_capacity) {
+        const size_t offset = (unread > 0) ? (size_t)(src->pub.next_input_byte - src->buffer) : 0;
+        size_t buffer_capacity = src->buffer_capacity > 0 ? src->buffer_capacity : 4096;
+
+        while (buffer_capacity < unread + buffer_length) {
+            buffer_capacity *= 2;
+        }
+
+        void *ptr = src->buffer;
+        SAIL_TRY(sail_realloc(buffer_capacity, &ptr));
+
+        src->buffer          = ptr;
+        src->buffer_capacity = buffer_capacity;
+        src->pub.next_input_byte = src->buffer + offset;
+    }
+
+    if (unread > 0) {
+        memmove(src->buffer, src->pub.next_input_byte, unread);
+    }
+
+    memcpy(src->buffer + unread, buffer, buffer_length);
+
+    src->pub.next_input_byte = src->buffer;
+    src->pub.bytes_in_buffer = unread + buffer_length;
+
+    return SAIL_OK;
+}
+
+unsigned jpeg_private_feed_src_decoded_rows(const struct jpeg_decompress_struct *cinfo) {
+
+    const struct sail_jpeg_feed_source_mgr *src = (const struct sail_jpeg_feed_source_mgr *)cinfo->src;
+
+    if (!src->fake_eoi || src->decoded_rows > cinfo->output_height) {
+        return cinfo->output_height;
+    }
+
+    return src->decoded_rows;
+}
+
+void jpeg_private_feed_src_free(j_decompress_ptr cinfo) {
+
+    struct sail_jpeg_feed_source_mgr *src = (struct sail_jpeg_feed_source_mgr *)cinfo->src;
+
+    if (src == NULL) {
+        return;
+    }
+
+    sail_free(src->buffer);
+
+    src->buffer              = NULL;
+    src->buffer_capacity     = 0;
+    src->pub.next_input_byte = NULL;
+    src->pub.bytes_in_buffer = 0;
 }
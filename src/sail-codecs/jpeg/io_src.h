@@ -30,6 +30,7 @@
 
 #include <jpeglib.h>
 
+#include "error.h"
 #include "export.h"
 
 struct sail_io;
@@ -45,6 +46,35 @@ struct sail_jpeg_source_mgr {
     boolean start_of_file;        /* have we gotten any data yet? */
 };
 
+/*
+ * Data source object for incremental decoding. Data is appended as it arrives. libjpeg suspends
+ * when it runs out of data.
+ */
+struct sail_jpeg_feed_source_mgr {
+    struct jpeg_source_mgr pub;   /* public fields */
+
+    JOCTET *buffer;               /* start of buffer */
+    size_t buffer_capacity;       /* allocated size of buffer */
+    size_t bytes_to_skip;         /* bytes to skip that have not arrived yet */
+    boolean end_of_data;          /* no more data will arrive */
+    boolean fake_eoi;             /* a fake EOI marker was inserted after the truncated data */
+    JDIMENSION decoded_rows;      /* output rows decoded before the fake EOI marker */
+};
+
 SAIL_HIDDEN void jpeg_private_sail_io_src(j_decompress_ptr cinfo, struct sail_io *io);
 
+SAIL_HIDDEN void jpeg_private_feed_src(j_decompress_ptr cinfo);
+
+/* Appends the data to the unread data. A NULL buffer means the end of the data. */
+SAIL_HIDDEN sail_status_t jpeg_private_feed_src_append(j_decompress_ptr cinfo, const void *buffer, size_t buffer_length);
+
+/*
+ * Returns the number of output rows decoded from the received data. When the data is truncated,
+ * these are the rows decoded before the fake EOI marker. Otherwise, the whole output height.
+ */
+SAIL_HIDDEN unsigned jpeg_private_feed_src_decoded_rows(const struct jpeg_decompress_struct *cinfo);
+
+/* Frees the data buffer. Must be called before the decompress context is destroyed. */
+SAIL_HIDDEN void jpeg_private_feed_src_free(j_decompress_ptr cinfo);
+
 #endif
@@ -45,6 +45,21 @@ static const double COMPRESSION_MIN     = 0;
 static const double COMPRESSION_MAX     = 100;
 static const double COMPRESSION_DEFAULT = 15;
 
+/*
+ * Number of scan lines passed to libjpeg per call. libjpeg processes up to an iMCU row (8 or 16 lines
+ * for common sampling factors) per call, and buffers scan lines internally when it gets less than that.
+ */
+#define BATCH_ROWS 16
+
+/* Stages of incremental decoding. */
+enum feed_stage {
+    FEED_STAGE_HEADER,
+    FEED_STAGE_START,
+    FEED_STAGE_SCAN_LINES,
+    FEED_STAGE_BUFFERED,
+    FEED_STAGE_DONE,
+};
+
 /*
  * Codec-specific state.
  */
@@ -60,9 +75,35 @@ struct jpeg_state {
     bool frame_written;
     bool started_compress;
 
-    /* Extra scan line used as a buffer when reading CMYK/YCCK images. */
-    bool extra_scan_line_needed_for_cmyk;
-    void *extra_scan_line;
+    /*
+     * CMYK/YCCK images are decoded as CMYK and converted to RGB. The buffer holds a batch of scan lines
+     * when the output pixels are smaller than CMYK pixels and cannot be converted in place, or when decoded
+     * scan lines are wider than the cropped image.
+     */
+    bool convert_from_cmyk;
+    void *scan_lines;
+
+    /*
+     * Region of interest. libjpeg crops scan lines at iMCU boundaries, so decoded scan lines
+     * start crop_skip pixels to the left of the region.
+     */
+    bool crop;
+    unsigned crop_x;
+    unsigned crop_y;
+    unsigned crop_width;
+    unsigned crop_height;
+    unsigned crop_skip;
+
+    /*
+     * Incremental decoding. Progressive images are decoded in the buffered-image mode, and every
+     * completed scan is output to the image. Only the output of the final scan holds final pixels.
+     */
+    enum feed_stage feed_stage;
+    struct sail_image *feed_image;
+    unsigned feed_valid_rows;
+    bool feed_output_active;
+    bool feed_final_output;
+    int feed_completed_scan;
 };
 
 static sail_status_t alloc_jpeg_state(struct jpeg_state **jpeg_state) {
@@ -79,8 +120,20 @@ static sail_status_t alloc_jpeg_state(struct jpeg_state **jpeg_state) {
     (*jpeg_state)->frame_read                      = false;
     (*jpeg_state)->frame_written                   = false;
     (*jpeg_state)->started_compress                = false;
-    (*jpeg_state)->extra_scan_line_needed_for_cmyk = false;
-    (*jpeg_state)->extra_scan_line                 = NULL;
+    (*jpeg_state)->convert_from_cmyk               = false;
+    (*jpeg_state)->scan_lines                      = NULL;
+    (*jpeg_state)->crop                            = false;
+    (*jpeg_state)->crop_x                          = 0;
+    (*jpeg_state)->crop_y                          = 0;
+    (*jpeg_state)->crop_width                      = 0;
+    (*jpeg_state)->crop_height                     = 0;
+    (*jpeg_state)->crop_skip                       = 0;
+    (*jpeg_state)->feed_stage                      = FEED_STAGE_HEADER;
+    (*jpeg_state)->feed_image                      = NULL;
+    (*jpeg_state)->feed_valid_rows                 = 0;
+    (*jpeg_state)->feed_output_active              = false;
+    (*jpeg_state)->feed_final_output               = false;
+    (*jpeg_state)->feed_completed_scan             = 0;
 
     return SAIL_OK;
 }
@@ -97,28 +150,15 @@ static void destroy_jpeg_state(struct jpeg_state *jpeg_state) {
     sail_destroy_read_options(jpeg_state->read_options);
     sail_destroy_write_options(jpeg_state->write_options);
 
-    sail_free(jpeg_state->extra_scan_line);
+    sail_free(jpeg_state->scan_lines);
+
+    sail_destroy_image(jpeg_state->feed_image);
 
     sail_free(jpeg_state);
 }
 
-/*
- * Decoding functions.
- */
-
-SAIL_EXPORT sail_status_t sail_codec_read_init_v4_jpeg(struct sail_io *io, const struct sail_read_options *read_options, void **state) {
-
-    SAIL_CHECK_STATE_PTR(state);
-    *state = NULL;
-
-    SAIL_CHECK_IO(io);
-    SAIL_CHECK_READ_OPTIONS_PTR(read_options);
-
-    /* Allocate a new state. */
-    struct jpeg_state *jpeg_state;
-    SAIL_TRY(alloc_jpeg_state(&jpeg_state));
-
-    *state = jpeg_state;
+/* Creates a decompress context. */
+static sail_status_t init_decompress(struct jpeg_state *jpeg_state, const struct sail_read_options *read_options) {
 
     /* Deep copy read options. */
     SAIL_TRY(sail_copy_read_options(read_options, &jpeg_state->read_options));
@@ -140,7 +180,6 @@ SAIL_EXPORT sail_status_t sail_codec_read_init_v4_jpeg(struct sail_io *io, const
 
     /* JPEG setup. */
     jpeg_create_decompress(jpeg_state->decompress_context);
-    jpeg_private_sail_io_src(jpeg_state->decompress_context, io);
 
     if (jpeg_state->read_options->io_options & SAIL_IO_OPTION_META_DATA) {
         jpeg_save_markers(jpeg_state->decompress_context, JPEG_COM, 0xffff);
@@ -149,7 +188,11 @@ SAIL_EXPORT sail_status_t sail_codec_read_init_v4_jpeg(struct sail_io *io, const
         jpeg_save_markers(jpeg_state->decompress_context, JPEG_APP0 + 2, 0xFFFF);
     }
 
-    jpeg_read_header(jpeg_state->decompress_context, true);
+    return SAIL_OK;
+}
+
+/* Sets up the output parameters of the decompression with the read header. */
+static sail_status_t setup_output(struct jpeg_state *jpeg_state) {
 
     /* Handle the requested color space. */
     if (jpeg_state->read_options->output_pixel_format == SAIL_PIXEL_FORMAT_SOURCE) {
@@ -163,7 +206,7 @@ SAIL_EXPORT sail_status_t sail_codec_read_init_v4_jpeg(struct sail_io *io, const
 
         if (jpeg_state->decompress_context->jpeg_color_space == JCS_YCCK || jpeg_state->decompress_context->jpeg_color_space == JCS_CMYK) {
             SAIL_LOG_DEBUG("JPEG: Requesting to convert to CMYK and only then to RGB/RGBA");
-            jpeg_state->extra_scan_line_needed_for_cmyk = true;
+            jpeg_state->convert_from_cmyk = true;
             jpeg_state->decompress_context->out_color_space = JCS_CMYK;
         } else {
             jpeg_state->decompress_context->out_color_space = requested_color_space;
@@ -173,25 +216,37 @@ SAIL_EXPORT sail_status_t sail_codec_read_init_v4_jpeg(struct sail_io *io, const
     /* We don't want colormapped output. */
     jpeg_state->decompress_context->quantize_colors = false;
 
-    /* Launch decompression! */
-    jpeg_start_decompress(jpeg_state->decompress_context);
+    /* Decode a downscaled image if requested. */
+    jpeg_private_setup_scaling(jpeg_state->decompress_context,
+                                jpeg_state->read_options->target_width,
+                                jpeg_state->read_options->target_height);
 
     return SAIL_OK;
 }
 
-SAIL_EXPORT sail_status_t sail_codec_read_seek_next_frame_v4_jpeg(void *state, struct sail_io *io, struct sail_image **image) {
+/*
+ * Reads the JPEG header from the specified I/O stream with a created decompress context. The context
+ * could be used to read another image before, so the source manager and its buffer are reused.
+ */
+static sail_status_t read_header(struct jpeg_state *jpeg_state, struct sail_io *io) {
 
-    SAIL_CHECK_STATE_PTR(state);
-    SAIL_CHECK_IO(io);
-    SAIL_CHECK_IMAGE_PTR(image);
+    if (setjmp(jpeg_state->error_context.setjmp_buffer) != 0) {
+        jpeg_state->libjpeg_error = true;
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
+    }
 
-    struct jpeg_state *jpeg_state = (struct jpeg_state *)state;
+    jpeg_private_sail_io_src(jpeg_state->decompress_context, io);
 
-    if (jpeg_state->frame_read) {
-        SAIL_LOG_AND_RETURN(SAIL_ERROR_NO_MORE_FRAMES);
-    }
+    jpeg_read_header(jpeg_state->decompress_context, true);
+
+    SAIL_TRY(setup_output(jpeg_state));
+
+    return SAIL_OK;
+}
+
+/* Allocates a new image and fills its properties. Output dimensions must be already calculated. */
+static sail_status_t fetch_image(struct jpeg_state *jpeg_state, struct sail_image **image) {
 
-    jpeg_state->frame_read = true;
     SAIL_TRY(sail_alloc_image(image));
 
     SAIL_TRY_OR_CLEANUP(sail_alloc_source_image(&(*image)->source_image),
@@ -204,17 +259,21 @@ SAIL_EXPORT sail_status_t sail_codec_read_seek_next_frame_v4_jpeg(void *state, s
     }
 
     /* Image properties. */
+    const unsigned width  = jpeg_state->crop ? jpeg_state->crop_width  : jpeg_state->decompress_context->output_width;
+    const unsigned height = jpeg_state->crop ? jpeg_state->crop_height : jpeg_state->decompress_context->output_height;
+
     unsigned bytes_per_line;
     if (jpeg_state->read_options->output_pixel_format == SAIL_PIXEL_FORMAT_SOURCE) {
-        bytes_per_line = jpeg_state->decompress_context->output_width * jpeg_state->decompress_context->output_components;
+        bytes_per_line = width * jpeg_state->decompress_context->output_components;
     } else {
-        SAIL_TRY(sail_bytes_per_line(jpeg_state->decompress_context->output_width,
-                                        jpeg_state->read_options->output_pixel_format,
-                                        &bytes_per_line));
+        SAIL_TRY_OR_CLEANUP(sail_bytes_per_line(width,
+                                                jpeg_state->read_options->output_pixel_format,
+                                                &bytes_per_line),
+                            /* cleanup */ sail_destroy_image(*image));
     }
 
-    (*image)->width                      = jpeg_state->decompress_context->output_width;
-    (*image)->height                     = jpeg_state->decompress_context->output_height;
+    (*image)->width                      = width;
+    (*image)->height                     = height;
     (*image)->bytes_per_line             = bytes_per_line;
     (*image)->source_image->pixel_format = jpeg_private_color_space_to_pixel_format(jpeg_state->decompress_context->jpeg_color_space);
 
@@ -224,16 +283,6 @@ SAIL_EXPORT sail_status_t sail_codec_read_seek_next_frame_v4_jpeg(void *state, s
         (*image)->pixel_format           = jpeg_state->read_options->output_pixel_format;
     }
 
-    /* Extra scan line used as a buffer when reading CMYK/YCCK images. */
-    if (jpeg_state->extra_scan_line_needed_for_cmyk) {
-        unsigned src_bytes_per_line;
-        SAIL_TRY(sail_bytes_per_line((*image)->width,
-                                        (*image)->source_image->pixel_format,
-                                        &src_bytes_per_line));
-
-        SAIL_TRY(sail_malloc(src_bytes_per_line, &jpeg_state->extra_scan_line));
-    }
-
     /* Read meta data. */
     if (jpeg_state->read_options->io_options & SAIL_IO_OPTION_META_DATA) {
         SAIL_TRY_OR_CLEANUP(jpeg_private_fetch_meta_data(jpeg_state->decompress_context, &(*image)->meta_data_node),
@@ -247,7 +296,7 @@ SAIL_EXPORT sail_status_t sail_codec_read_seek_next_frame_v4_jpeg(void *state, s
     /* Fetch ICC profile. */
 #ifdef HAVE_JPEG_ICCP
     if (jpeg_state->read_options->io_options & SAIL_IO_OPTION_ICCP) {
-        if (jpeg_state->extra_scan_line_needed_for_cmyk) {
+        if (jpeg_state->convert_from_cmyk) {
             SAIL_LOG_DEBUG("JPEG: Skipping the ICC profile (if any) as we convert from CMYK");
         } else {
             SAIL_TRY_OR_CLEANUP(jpeg_private_fetch_iccp(jpeg_state->decompress_context, &(*image)->iccp),
@@ -265,6 +314,250 @@ SAIL_EXPORT sail_status_t sail_codec_read_seek_next_frame_v4_jpeg(void *state, s
     return SAIL_OK;
 }
 
+/*
+ * Decodes scan lines in batches. Converts CMYK/YCCK scan lines to the output pixel format, and crops
+ * scan lines wider than the image. Must be called with the libjpeg error handler set.
+ */
+static sail_status_t read_scan_lines(struct jpeg_state *jpeg_state, const struct sail_image *image, unsigned row_count, void *rows) {
+
+    struct jpeg_decompress_struct *decompress_context = jpeg_state->decompress_context;
+    const size_t scan_line_size = (size_t)decompress_context->output_width * decompress_context->output_components;
+    const size_t crop_skip_size = (size_t)jpeg_state->crop_skip * decompress_context->output_components;
+
+    /* Adobe applications write inverted CMYK. */
+    const bool inverted = decompress_context->saw_Adobe_marker;
+
+    for (unsigned row = 0; row < row_count;) {
+        const unsigned batch_rows = row_count - row < BATCH_ROWS ? row_count - row : BATCH_ROWS;
+        JSAMPROW samprows[BATCH_ROWS];
+
+        for (unsigned i = 0; i < batch_rows; i++) {
+            if (jpeg_state->scan_lines == NULL) {
+                samprows[i] = (JSAMPROW)((unsigned char *)rows + (size_t)(row + i) * image->bytes_per_line);
+            } else {
+                samprows[i] = (JSAMPROW)((unsigned char *)jpeg_state->scan_lines + (size_t)i * scan_line_size);
+            }
+        }
+
+        /* libjpeg returns at most an iMCU row of scan lines per call. */
+        unsigned read_rows = 0;
+
+        while (read_rows < batch_rows) {
+            const JDIMENSION lines = jpeg_read_scanlines(decompress_context, samprows + read_rows, batch_rows - read_rows);
+
+            if (lines == 0) {
+                SAIL_LOG_ERROR("JPEG: Failed to read scan lines");
+                SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
+            }
+
+            read_rows += lines;
+        }
+
+        if (jpeg_state->convert_from_cmyk) {
+            for (unsigned i = 0; i < batch_rows; i++) {
+                SAIL_TRY(sail_convert_cmyk_row(samprows[i] + crop_skip_size,
+                                               inverted,
+                                               image->width,
+                                               image->pixel_format,
+                                               (unsigned char *)rows + (size_t)(row + i) * image->bytes_per_line));
+            }
+        } else if (jpeg_state->scan_lines != NULL) {
+            for (unsigned i = 0; i < batch_rows; i++) {
+                memcpy((unsigned char *)rows + (size_t)(row + i) * image->bytes_per_line,
+                        samprows[i] + crop_skip_size,
+                        (size_t)image->width * decompress_context->output_components);
+            }
+        }
+
+        row += batch_rows;
+    }
+
+    return SAIL_OK;
+}
+
+/*
+ * Clips the requested region of interest to the output dimensions. Output dimensions must be already calculated.
+ * Rows and columns are actually skipped by start_crop() when the decompression starts.
+ */
+static sail_status_t init_crop(struct jpeg_state *jpeg_state) {
+
+#ifdef HAVE_JPEG_CROP
+    SAIL_TRY(sail_read_options_crop_rectangle(jpeg_state->read_options,
+                                                jpeg_state->decompress_context->output_width,
+                                                jpeg_state->decompress_context->output_height,
+                                                &jpeg_state->crop_x,
+                                                &jpeg_state->crop_y,
+                                                &jpeg_state->crop_width,
+                                                &jpeg_state->crop_height));
+
+    jpeg_state->crop = jpeg_state->crop_width != jpeg_state->decompress_context->output_width ||
+                        jpeg_state->crop_height != jpeg_state->decompress_context->output_height;
+#else
+    (void)jpeg_state;
+#endif
+
+    return SAIL_OK;
+}
+
+#ifdef HAVE_JPEG_CROP
+/* Skips the columns and rows outside of the region of interest. Must be called with the libjpeg error handler set. */
+static void start_crop(struct jpeg_state *jpeg_state) {
+
+    if (!jpeg_state->crop) {
+        return;
+    }
+
+    /*
+     * libjpeg extends the range to iMCU boundaries. Fancy upsampling replicates chroma samples
+     * at the edges of the range, so also decode a neighbor chroma sample on both sides to get
+     * the same pixels as the full decode.
+     */
+    struct jpeg_decompress_struct *decompress_context = jpeg_state->decompress_context;
+    const JDIMENSION margin = (JDIMENSION)decompress_context->max_h_samp_factor;
+    const JDIMENSION crop_end = jpeg_state->crop_x + jpeg_state->crop_width;
+
+    JDIMENSION xoffset = (jpeg_state->crop_x > margin) ? jpeg_state->crop_x - margin : 0;
+    JDIMENSION width   = ((decompress_context->output_width - crop_end > margin) ? crop_end + margin : decompress_context->output_width) - xoffset;
+
+    if (width != decompress_context->output_width) {
+        jpeg_crop_scanline(decompress_context, &xoffset, &width);
+    }
+
+    jpeg_state->crop_skip = jpeg_state->crop_x - xoffset;
+
+    SAIL_LOG_DEBUG("JPEG: Cropping to %u,%u %ux%u, decoding %u columns from %u",
+                    jpeg_state->crop_x, jpeg_state->crop_y, jpeg_state->crop_width, jpeg_state->crop_height, width, xoffset);
+
+    if (jpeg_state->crop_y > 0) {
+        jpeg_skip_scanlines(decompress_context, jpeg_state->crop_y);
+    }
+}
+#endif
+
+/* Starts decompressing the image with the read header. */
+static sail_status_t start_decompress(struct jpeg_state *jpeg_state) {
+
+    if (setjmp(jpeg_state->error_context.setjmp_buffer) != 0) {
+        jpeg_state->libjpeg_error = true;
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
+    }
+
+    /* Launch decompression! */
+    jpeg_start_decompress(jpeg_state->decompress_context);
+
+    SAIL_TRY(init_crop(jpeg_state));
+
+#ifdef HAVE_JPEG_CROP
+    start_crop(jpeg_state);
+#endif
+
+    return SAIL_OK;
+}
+
+/*
+ * Decoding functions.
+ */
+
+SAIL_EXPORT sail_status_t sail_codec_read_init_v4_jpeg(struct sail_io *io, const struct sail_read_options *read_options, void **state) {
+
+    SAIL_CHECK_STATE_PTR(state);
+    *state = NULL;
+
+    SAIL_CHECK_IO(io);
+    SAIL_CHECK_READ_OPTIONS_PTR(read_options);
+
+    /* Allocate a new state. */
+    struct jpeg_state *jpeg_state;
+    SAIL_TRY(alloc_jpeg_state(&jpeg_state));
+
+    *state = jpeg_state;
+
+    SAIL_TRY(init_decompress(jpeg_state, read_options));
+    SAIL_TRY(read_header(jpeg_state, io));
+    SAIL_TRY(start_decompress(jpeg_state));
+
+    return SAIL_OK;
+}
+
+SAIL_EXPORT sail_status_t sail_codec_read_reset_v4_jpeg(void *state, struct sail_io *io) {
+
+    SAIL_CHECK_STATE_PTR(state);
+    SAIL_CHECK_IO(io);
+
+    struct jpeg_state *jpeg_state = (struct jpeg_state *)state;
+
+    if (jpeg_state->decompress_context == NULL) {
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
+    }
+
+    if (setjmp(jpeg_state->error_context.setjmp_buffer) != 0) {
+        jpeg_state->libjpeg_error = true;
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
+    }
+
+    /*
+     * Return the decompress context to the initial state. The permanent pool with the source manager
+     * and the saved markers setup survives, only the per-image memory is released.
+     */
+    jpeg_abort_decompress(jpeg_state->decompress_context);
+
+    sail_free(jpeg_state->scan_lines);
+
+    jpeg_state->libjpeg_error     = false;
+    jpeg_state->frame_read        = false;
+    jpeg_state->convert_from_cmyk = false;
+    jpeg_state->scan_lines        = NULL;
+    jpeg_state->crop              = false;
+    jpeg_state->crop_x            = 0;
+    jpeg_state->crop_y            = 0;
+    jpeg_state->crop_width        = 0;
+    jpeg_state->crop_height       = 0;
+    jpeg_state->crop_skip         = 0;
+
+    SAIL_TRY(read_header(jpeg_state, io));
+    SAIL_TRY(start_decompress(jpeg_state));
+
+    return SAIL_OK;
+}
+
+SAIL_EXPORT sail_status_t sail_codec_read_seek_next_frame_v4_jpeg(void *state, struct sail_io *io, struct sail_image **image) {
+
+    SAIL_CHECK_STATE_PTR(state);
+    SAIL_CHECK_IO(io);
+    SAIL_CHECK_IMAGE_PTR(image);
+
+    struct jpeg_state *jpeg_state = (struct jpeg_state *)state;
+
+    if (jpeg_state->frame_read) {
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_NO_MORE_FRAMES);
+    }
+
+    jpeg_state->frame_read = true;
+    SAIL_TRY(fetch_image(jpeg_state, image));
+
+    /*
+     * 32-bit output pixels are converted from CMYK in place. Smaller ones need a separate buffer.
+     * Scan lines wider than the cropped image also need it.
+     */
+    bool scan_lines = jpeg_state->decompress_context->output_width != (*image)->width;
+
+    if (jpeg_state->convert_from_cmyk) {
+        unsigned bits_per_pixel;
+        SAIL_TRY_OR_CLEANUP(sail_bits_per_pixel((*image)->pixel_format, &bits_per_pixel),
+                            /* cleanup */ sail_destroy_image(*image));
+
+        scan_lines = scan_lines || bits_per_pixel != 32;
+    }
+
+    if (scan_lines) {
+        SAIL_TRY_OR_CLEANUP(sail_malloc((size_t)BATCH_ROWS * jpeg_state->decompress_context->output_width * jpeg_state->decompress_context->output_components,
+                                        &jpeg_state->scan_lines),
+                            /* cleanup */ sail_destroy_image(*image));
+    }
+
+    return SAIL_OK;
+}
+
 SAIL_EXPORT sail_status_t sail_codec_read_seek_next_pass_v4_jpeg(void *state, struct sail_io *io, const struct sail_image *image) {
 
     SAIL_CHECK_STATE_PTR(state);
@@ -274,11 +567,15 @@ SAIL_EXPORT sail_status_t sail_codec_read_seek_next_pass_v4_jpeg(void *state, st
     return SAIL_OK;
 }
 
-SAIL_EXPORT sail_status_t sail_codec_read_frame_v4_jpeg(void *state, struct sail_io *io, struct sail_image *image) {
+SAIL_EXPORT sail_status_t sail_codec_read_rows_v4_jpeg(void *state, struct sail_io *io, const struct sail_image *image,
+                                                        unsigned first_row, unsigned row_count, void *rows) {
+
+    (void)first_row;
 
     SAIL_CHECK_STATE_PTR(state);
     SAIL_CHECK_IO(io);
     SAIL_CHECK_IMAGE(image);
+    SAIL_CHECK_BUFFER_PTR(rows);
 
     struct jpeg_state *jpeg_state = (struct jpeg_state *)state;
 
@@ -291,27 +588,345 @@ SAIL_EXPORT sail_status_t sail_codec_read_frame_v4_jpeg(void *state, struct sail
         SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
     }
 
-    for (unsigned row = 0; row < image->height; row++) {
-        unsigned char *scanline = (unsigned char *)image->pixels + row * image->bytes_per_line;
+    SAIL_TRY(read_scan_lines(jpeg_state, image, row_count, rows));
+
+    return SAIL_OK;
+}
+
+SAIL_EXPORT sail_status_t sail_codec_read_frame_v4_jpeg(void *state, struct sail_io *io, struct sail_image *image) {
+
+    SAIL_CHECK_IMAGE(image);
+
+    SAIL_TRY(sail_codec_read_rows_v4_jpeg(state, io, image, /* first row */ 0, image->height, image->pixels));
+
+    return SAIL_OK;
+}
+
+SAIL_EXPORT sail_status_t sail_codec_read_finish_v4_jpeg(void **state, struct sail_io *io) {
+
+    SAIL_CHECK_STATE_PTR(state);
+    SAIL_CHECK_IO(io);
+
+    struct jpeg_state *jpeg_state = (struct jpeg_state *)(*state);
+
+    /* Subsequent calls to finish() will expectedly fail in the above line. */
+    *state = NULL;
+
+    if (setjmp(jpeg_state->error_context.setjmp_buffer) != 0) {
+        destroy_jpeg_state(jpeg_state);
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
+    }
+
+    if (jpeg_state->decompress_context != NULL) {
+        jpeg_abort_decompress(jpeg_state->decompress_context);
+        jpeg_destroy_decompress(jpeg_state->decompress_context);
+    }
+
+    destroy_jpeg_state(jpeg_state);
+
+    return SAIL_OK;
+}
+
+SAIL_EXPORT sail_status_t sail_codec_probe_v4_jpeg(struct sail_io *io, const struct sail_read_options *read_options, struct sail_image **image) {
+
+    SAIL_CHECK_IO(io);
+    SAIL_CHECK_READ_OPTIONS_PTR(read_options);
+    SAIL_CHECK_IMAGE_PTR(image);
+
+    /* Allocate a new state. */
+    struct jpeg_state *jpeg_state;
+    SAIL_TRY(alloc_jpeg_state(&jpeg_state));
+
+    void *state = jpeg_state;
+
+    SAIL_TRY_OR_CLEANUP(init_decompress(jpeg_state, read_options),
+                        /* cleanup */ sail_codec_read_finish_v4_jpeg(&state, io));
+    SAIL_TRY_OR_CLEANUP(read_header(jpeg_state, io),
+                        /* cleanup */ sail_codec_read_finish_v4_jpeg(&state, io));
+
+    if (setjmp(jpeg_state->error_context.setjmp_buffer) != 0) {
+        jpeg_state->libjpeg_error = true;
+        sail_codec_read_finish_v4_jpeg(&state, io);
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
+    }
+
+    /* Don't start decompression. It allocates the whole decompressor. */
+    jpeg_calc_output_dimensions(jpeg_state->decompress_context);
+
+    SAIL_TRY_OR_CLEANUP(init_crop(jpeg_state),
+                        /* cleanup */ sail_codec_read_finish_v4_jpeg(&state, io));
+
+    SAIL_TRY_OR_CLEANUP(fetch_image(jpeg_state, image),
+                        /* cleanup */ sail_codec_read_finish_v4_jpeg(&state, io));
+
+    SAIL_TRY_OR_CLEANUP(sail_codec_read_finish_v4_jpeg(&state, io),
+                        /* cleanup */ sail_destroy_image(*image));
+
+    return SAIL_OK;
+}
+
+/*
+ * Incremental decoding functions.
+ */
+
+/* Allocates the image to decode into. Decompression must be already started. */
+static sail_status_t init_feed_image(struct jpeg_state *jpeg_state) {
+
+    struct sail_image *image;
+    SAIL_TRY(fetch_image(jpeg_state, &image));
+
+    const size_t pixels_size = (size_t)image->height * image->bytes_per_line;
+
+    SAIL_TRY_OR_CLEANUP(sail_malloc_pixels(pixels_size, &image->pixels),
+                        /* cleanup */ sail_destroy_image(image));
+
+    /* Rows not received yet are black. */
+    memset(image->pixels, 0, pixels_size);
+
+    jpeg_state->feed_image = image;
+
+    /* CMYK scan lines are converted from a separate buffer. */
+    if (jpeg_state->convert_from_cmyk) {
+        SAIL_TRY(sail_malloc((size_t)jpeg_state->decompress_context->output_width * jpeg_state->decompress_context->output_components,
+                                &jpeg_state->scan_lines));
+    }
+
+    return SAIL_OK;
+}
+
+/*
+ * Returns the number of output rows holding final pixels. The rows output after a truncated
+ * input were decoded from the fake EOI marker, so they don't count.
+ */
+static unsigned feed_valid_rows(const struct jpeg_decompress_struct *decompress_context) {
+
+    const unsigned decoded_rows = jpeg_private_feed_src_decoded_rows(decompress_context);
+
+    return decompress_context->output_scanline < decoded_rows ? decompress_context->output_scanline : decoded_rows;
+}
+
+/*
+ * Reads the scan lines of the current output pass until libjpeg runs out of data. Must be called
+ * with the libjpeg error handler set.
+ */
+static sail_status_t feed_read_scan_lines(struct jpeg_state *jpeg_state) {
+
+    struct jpeg_decompress_struct *decompress_context = jpeg_state->decompress_context;
+    struct sail_image *image = jpeg_state->feed_image;
+
+    while (decompress_context->output_scanline < decompress_context->output_height) {
+        unsigned char *dst = (unsigned char *)image->pixels + (size_t)decompress_context->output_scanline * image->bytes_per_line;
+        JSAMPROW samprow = (jpeg_state->scan_lines == NULL) ? (JSAMPROW)dst : (JSAMPROW)jpeg_state->scan_lines;
+
+        /* Suspended. */
+        if (jpeg_read_scanlines(decompress_context, &samprow, 1) == 0) {
+            break;
+        }
+
+        if (jpeg_state->convert_from_cmyk) {
+            SAIL_TRY(sail_convert_cmyk_row(jpeg_state->scan_lines,
+                                           decompress_context->saw_Adobe_marker,
+                                           image->width,
+                                           image->pixel_format,
+                                           dst));
+        }
+    }
+
+    return SAIL_OK;
+}
+
+/*
+ * Decodes a progressive image in the buffered-image mode. Outputs the most recent completed scan
+ * to the image, and the final scan when all the data is received. Must be called with the libjpeg
+ * error handler set.
+ */
+static sail_status_t feed_buffered(struct jpeg_state *jpeg_state) {
+
+    struct jpeg_decompress_struct *decompress_context = jpeg_state->decompress_context;
+
+    for (;;) {
+        if (jpeg_state->feed_output_active) {
+            SAIL_TRY(feed_read_scan_lines(jpeg_state));
+
+            if (jpeg_state->feed_final_output) {
+                jpeg_state->feed_valid_rows = feed_valid_rows(decompress_context);
+            }
+
+            if (decompress_context->output_scanline < decompress_context->output_height) {
+                return SAIL_OK;
+            }
+
+            if (!jpeg_finish_output(decompress_context)) {
+                return SAIL_OK;
+            }
+
+            jpeg_state->feed_output_active = false;
+
+            if (jpeg_state->feed_final_output) {
+                jpeg_state->feed_stage = FEED_STAGE_DONE;
+                return SAIL_OK;
+            }
+        }
+
+        /* Absorb the received data. */
+        int status;
+
+        do {
+            status = jpeg_consume_input(decompress_context);
 
-        /* Convert the CMYK image to BPP32-RGBA/BPP32-BGRA/etc. */
-        if (jpeg_state->extra_scan_line_needed_for_cmyk) {
-            JSAMPROW samprow = (JSAMPROW)jpeg_state->extra_scan_line;
-            (void)jpeg_read_scanlines(jpeg_state->decompress_context, &samprow, 1);
-            SAIL_TRY(jpeg_private_convert_cmyk(jpeg_state->extra_scan_line, scanline, image->width, image->pixel_format));
+            if (status == JPEG_SCAN_COMPLETED) {
+                jpeg_state->feed_completed_scan = decompress_context->input_scan_number;
+            }
+        } while (status != JPEG_SUSPENDED && status != JPEG_REACHED_EOI);
+
+        int scan_number;
+
+        if (jpeg_input_complete(decompress_context)) {
+            jpeg_state->feed_final_output = true;
+            scan_number = decompress_context->input_scan_number;
+        } else if (jpeg_state->feed_completed_scan > decompress_context->output_scan_number) {
+            scan_number = jpeg_state->feed_completed_scan;
         } else {
-            JSAMPROW samprow = (JSAMPROW)scanline;
-            (void)jpeg_read_scanlines(jpeg_state->decompress_context, &samprow, 1);
+            return SAIL_OK;
+        }
+
+        /* Never suspends without color quantization. */
+        (void)jpeg_start_output(decompress_context, scan_number);
+        jpeg_state->feed_output_active = true;
+    }
+}
+
+/* Reads the header and starts decompression when enough data is received. */
+static sail_status_t feed_start_decompress(struct jpeg_state *jpeg_state) {
+
+    struct jpeg_decompress_struct *decompress_context = jpeg_state->decompress_context;
+
+    if (setjmp(jpeg_state->error_context.setjmp_buffer) != 0) {
+        jpeg_state->libjpeg_error = true;
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
+    }
+
+    if (jpeg_state->feed_stage == FEED_STAGE_HEADER) {
+        if (jpeg_read_header(decompress_context, true) == JPEG_SUSPENDED) {
+            return SAIL_OK;
+        }
+
+        SAIL_TRY(setup_output(jpeg_state));
+
+        /* Don't wait for all the scans of progressive images. */
+        decompress_context->buffered_image = jpeg_has_multiple_scans(decompress_context);
+
+        jpeg_state->feed_stage = FEED_STAGE_START;
+    }
+
+    if (jpeg_state->feed_stage == FEED_STAGE_START) {
+        if (!jpeg_start_decompress(decompress_context)) {
+            return SAIL_OK;
+        }
+
+        jpeg_state->feed_stage = decompress_context->buffered_image ? FEED_STAGE_BUFFERED : FEED_STAGE_SCAN_LINES;
+    }
+
+    return SAIL_OK;
+}
+
+/* Decodes the scan lines of the received data into the image. */
+static sail_status_t feed_read(struct jpeg_state *jpeg_state) {
+
+    struct jpeg_decompress_struct *decompress_context = jpeg_state->decompress_context;
+
+    if (setjmp(jpeg_state->error_context.setjmp_buffer) != 0) {
+        jpeg_state->libjpeg_error = true;
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
+    }
+
+    if (jpeg_state->feed_stage == FEED_STAGE_SCAN_LINES) {
+        SAIL_TRY(feed_read_scan_lines(jpeg_state));
+
+        jpeg_state->feed_valid_rows = feed_valid_rows(decompress_context);
+
+        if (decompress_context->output_scanline == decompress_context->output_height) {
+            jpeg_state->feed_stage = FEED_STAGE_DONE;
         }
+    } else if (jpeg_state->feed_stage == FEED_STAGE_BUFFERED) {
+        SAIL_TRY(feed_buffered(jpeg_state));
     }
 
     return SAIL_OK;
 }
 
-SAIL_EXPORT sail_status_t sail_codec_read_finish_v4_jpeg(void **state, struct sail_io *io) {
+/* Advances decoding with the received data. */
+static sail_status_t feed_decode(struct jpeg_state *jpeg_state) {
+
+    SAIL_TRY(feed_start_decompress(jpeg_state));
+
+    /* Waiting for more data. */
+    if (jpeg_state->feed_stage == FEED_STAGE_HEADER || jpeg_state->feed_stage == FEED_STAGE_START) {
+        return SAIL_OK;
+    }
+
+    if (jpeg_state->feed_image == NULL) {
+        SAIL_TRY(init_feed_image(jpeg_state));
+    }
+
+    SAIL_TRY(feed_read(jpeg_state));
+
+    return SAIL_OK;
+}
+
+SAIL_EXPORT sail_status_t sail_codec_feed_init_v4_jpeg(const struct sail_read_options *read_options, void **state) {
+
+    SAIL_CHECK_STATE_PTR(state);
+    *state = NULL;
+
+    SAIL_CHECK_READ_OPTIONS_PTR(read_options);
+
+    /* Allocate a new state. */
+    struct jpeg_state *jpeg_state;
+    SAIL_TRY(alloc_jpeg_state(&jpeg_state));
+
+    *state = jpeg_state;
+
+    SAIL_TRY(init_decompress(jpeg_state, read_options));
+
+    if (setjmp(jpeg_state->error_context.setjmp_buffer) != 0) {
+        jpeg_state->libjpeg_error = true;
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
+    }
+
+    jpeg_private_feed_src(jpeg_state->decompress_context);
+
+    return SAIL_OK;
+}
+
+SAIL_EXPORT sail_status_t sail_codec_feed_v4_jpeg(void *state, const void *buffer, size_t buffer_length,
+                                                   const struct sail_image **image, unsigned *valid_rows) {
+
+    SAIL_CHECK_STATE_PTR(state);
+    SAIL_CHECK_IMAGE_PTR(image);
+    SAIL_CHECK_RESULT_PTR(valid_rows);
+
+    struct jpeg_state *jpeg_state = (struct jpeg_state *)state;
+
+    if (jpeg_state->libjpeg_error) {
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
+    }
+
+    /* Ignore the data after the image. */
+    if (jpeg_state->feed_stage != FEED_STAGE_DONE) {
+        SAIL_TRY(jpeg_private_feed_src_append(jpeg_state->decompress_context, buffer, buffer_length));
+        SAIL_TRY(feed_decode(jpeg_state));
+    }
+
+    *image      = jpeg_state->feed_image;
+    *valid_rows = jpeg_state->feed_valid_rows;
+
+    return SAIL_OK;
+}
+
+SAIL_EXPORT sail_status_t sail_codec_feed_finish_v4_jpeg(void **state) {
 
     SAIL_CHECK_STATE_PTR(state);
-    SAIL_CHECK_IO(io);
 
     struct jpeg_state *jpeg_state = (struct jpeg_state *)(*state);
 
@@ -324,6 +939,7 @@ SAIL_EXPORT sail_status_t sail_codec_read_finish_v4_jpeg(void **state, struct sa
     }
 
     if (jpeg_state->decompress_context != NULL) {
+        jpeg_private_feed_src_free(jpeg_state->decompress_context);
         jpeg_abort_decompress(jpeg_state->decompress_context);
         jpeg_destroy_decompress(jpeg_state->decompress_context);
     }
@@ -491,9 +1107,22 @@ SAIL_EXPORT sail_status_t sail_codec_write_frame_v4_jpeg(void *state, struct sai
         SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
     }
 
-    for (unsigned row = 0; row < image->height; row++) {
-        JSAMPROW samprow = (JSAMPROW)((const unsigned char *)image->pixels + row * image->bytes_per_line);
-        jpeg_write_scanlines(jpeg_state->compress_context, &samprow, 1);
+    for (unsigned row = 0; row < image->height;) {
+        const unsigned batch_rows = image->height - row < BATCH_ROWS ? image->height - row : BATCH_ROWS;
+        JSAMPROW samprows[BATCH_ROWS];
+
+        for (unsigned i = 0; i < batch_rows; i++) {
+            samprows[i] = (JSAMPROW)((const unsigned char *)image->pixels + (size_t)(row + i) * image->bytes_per_line);
+        }
+
+        const JDIMENSION lines = jpeg_write_scanlines(jpeg_state->compress_context, samprows, batch_rows);
+
+        if (lines == 0) {
+            SAIL_LOG_ERROR("JPEG: Failed to write scan lines");
+            SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
+        }
+
+        row += lines;
     }
 
     return SAIL_OK;
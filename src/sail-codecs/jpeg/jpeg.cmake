@@ -41,6 +41,11 @@ macro(sail_codec_post_add)
         target_compile_definitions(${TARGET} PRIVATE HAVE_JPEG_ICCP)
     endif()
 
+    # Size of the buffers between libjpeg and SAIL I/O streams
+    #
+    set(SAIL_JPEG_IO_BUFFER_SIZE 65536 CACHE STRING "Size of the JPEG codec I/O buffers in bytes.")
+    target_compile_definitions(${TARGET} PRIVATE SAIL_JPEG_IO_BUFFER_SIZE=${SAIL_JPEG_IO_BUFFER_SIZE})
+
     # Check for libjpeg-turbo
     #
     cmake_push_check_state(RESET)
@@ -64,4 +69,30 @@ macro(sail_codec_post_add)
     if (HAVE_JPEG_JCS_EXT)
         target_compile_definitions(${TARGET} PRIVATE HAVE_JPEG_JCS_EXT)
     endif()
+
+    # Check for partial decoding functions that were added in libjpeg-turbo-1.5.0
+    #
+    cmake_push_check_state(RESET)
+        set(CMAKE_REQUIRED_INCLUDES ${sail_jpeg_include_dirs})
+        set(CMAKE_REQUIRED_LIBRARIES ${sail_jpeg_libs})
+
+        check_c_source_compiles(
+            "
+            #include <stdio.h>
+            #include <jpeglib.h>
+
+            int main(int argc, char *argv[]) {
+                jpeg_crop_scanline(NULL, NULL, NULL);
+                jpeg_skip_scanlines(NULL, 0);
+                return 0;
+            }
+        "
+        HAVE_JPEG_CROP
+        )
+    cmake_pop_check_state()
+
+    if (HAVE_JPEG_CROP)
+        set(CODEC_INFO_FEATURE_CROP ";CROP")
+        target_compile_definitions(${TARGET} PRIVATE HAVE_JPEG_CROP)
+    endif()
 endmacro()
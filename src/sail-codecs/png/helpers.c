@@ -30,6 +30,11 @@
 
 #include "sail-common.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define BLEND_OVER_SSE2
+#endif
+
 #include "helpers.h"
 
 void png_private_my_error_fn(png_structp png_ptr, png_const_charp text) {
@@ -400,7 +405,221 @@ sail_status_t png_private_fetch_palette(png_structp png_ptr, png_infop info_ptr,
     return SAIL_OK;
 }
 
-#ifdef PNG_APNG_SUPPORTED
+/* Rounded division by 255 and 65535, exact for products of two channel values. */
+static inline unsigned div255(unsigned x) {
+
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+static inline uint32_t div65535(uint32_t x) {
+
+    x += 32768;
+    return (x + (x >> 16)) >> 16;
+}
+
+/*
+ * Straight alpha "over" of a single pixel. The destination color is weighted by its alpha
+ * attenuated by the source coverage, so fully transparent destination pixels don't leak
+ * their color into the result.
+ */
+static inline void blend_over_pixel8(uint8_t *dst, const uint8_t *src, unsigned alpha_index) {
+
+    const unsigned src_a = src[alpha_index];
+
+    if (src_a == 255) {
+        memcpy(dst, src, 4);
+        return;
+    } else if (src_a == 0) {
+        return;
+    }
+
+    /* Weights are kept scaled by 255 to not lose precision on semi-transparent destinations. */
+    const unsigned src_weight = src_a * 255;
+    const unsigned dst_weight = dst[alpha_index] * (255 - src_a);
+    const unsigned weight     = src_weight + dst_weight;
+
+    for (unsigned i = 0; i < 4; i++) {
+        dst[i] = (uint8_t)((src[i] * src_weight + dst[i] * dst_weight + weight / 2) / weight);
+    }
+
+    dst[alpha_index] = (uint8_t)div255(weight);
+}
+
+/* 16-bit samples are stored in the host byte order. */
+static inline uint32_t load16(const uint8_t *p) {
+
+    uint16_t v;
+    memcpy(&v, p, sizeof(v));
+
+    return v;
+}
+
+static inline void store16(uint8_t *p, uint32_t v) {
+
+    const uint16_t v16 = (uint16_t)v;
+    memcpy(p, &v16, sizeof(v16));
+}
+
+static inline void blend_over_pixel16(uint8_t *dst, const uint8_t *src, unsigned alpha_index) {
+
+    const uint32_t src_a = load16(src + alpha_index * 2);
+
+    if (src_a == 65535) {
+        memcpy(dst, src, 8);
+        return;
+    } else if (src_a == 0) {
+        return;
+    }
+
+    const uint32_t src_weight = src_a * 65535;
+    const uint32_t dst_weight = load16(dst + alpha_index * 2) * (65535 - src_a);
+    const uint64_t weight     = (uint64_t)src_weight + dst_weight;
+
+    for (unsigned i = 0; i < 4; i++) {
+        const uint64_t sum = (uint64_t)load16(src + i * 2) * src_weight + (uint64_t)load16(dst + i * 2) * dst_weight;
+        store16(dst + i * 2, (uint32_t)((sum + weight / 2) / weight));
+    }
+
+    store16(dst + alpha_index * 2, (uint32_t)((weight + 32767) / 65535));
+}
+
+#ifdef BLEND_OVER_SSE2
+/*
+ * Blends 4 RGBA8 pixels per iteration. Blocks that are fully opaque or fully transparent
+ * in the source are copied or skipped, blocks over an opaque destination are blended
+ * with the div-255 approximation in 16-bit lanes. Mixed blocks fall back to the scalar path.
+ */
+static unsigned blend_over8_sse2(uint8_t *dst, const uint8_t *src, unsigned width, unsigned alpha_index) {
+
+    const __m128i alpha_mask = _mm_set1_epi32((int)(0xFFu << (alpha_index * 8)));
+    const __m128i zero       = _mm_setzero_si128();
+    const __m128i c255       = _mm_set1_epi16(255);
+    const __m128i c128       = _mm_set1_epi16(128);
+
+    unsigned x = 0;
+
+    for (; x + 4 <= width; x += 4, src += 16, dst += 16) {
+        const __m128i s   = _mm_loadu_si128((const __m128i *)src);
+        const __m128i s_a = _mm_and_si128(s, alpha_mask);
+
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(s_a, alpha_mask)) == 0xFFFF) {
+            _mm_storeu_si128((__m128i *)dst, s);
+            continue;
+        }
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(s_a, zero)) == 0xFFFF) {
+            continue;
+        }
+
+        const __m128i d = _mm_loadu_si128((const __m128i *)dst);
+
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(d, alpha_mask), alpha_mask)) != 0xFFFF) {
+            for (unsigned i = 0; i < 4; i++) {
+                blend_over_pixel8(dst + i * 4, src + i * 4, alpha_index);
+            }
+            continue;
+        }
+
+        /* Broadcast the source alpha into all the channels of its pixel. */
+        __m128i a = alpha_index == 0 ? s_a : _mm_srli_epi32(s_a, 24);
+        a = _mm_or_si128(a, _mm_slli_epi32(a, 8));
+        a = _mm_or_si128(a, _mm_slli_epi32(a, 16));
+
+        const __m128i a_lo = _mm_unpacklo_epi8(a, zero);
+        const __m128i a_hi = _mm_unpackhi_epi8(a, zero);
+
+        /* src * a + dst * (255 - a) <= 255 * 255 fits into 16 bits. */
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), a_lo),
+                                   _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), _mm_sub_epi16(c255, a_lo)));
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), a_hi),
+                                   _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), _mm_sub_epi16(c255, a_hi)));
+
+        lo = _mm_add_epi16(lo, c128);
+        hi = _mm_add_epi16(hi, c128);
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+
+        /* Blending over an opaque destination gives an opaque result. */
+        _mm_storeu_si128((__m128i *)dst, _mm_or_si128(_mm_packus_epi16(lo, hi), alpha_mask));
+    }
+
+    return x;
+}
+
+/* Rounded division by 65535 of 32-bit lanes narrowed back into 16-bit lanes. */
+static inline __m128i div65535_pack_sse2(__m128i lo, __m128i hi) {
+
+    const __m128i c32768 = _mm_set1_epi32(32768);
+
+    lo = _mm_add_epi32(lo, c32768);
+    hi = _mm_add_epi32(hi, c32768);
+    lo = _mm_srli_epi32(_mm_add_epi32(lo, _mm_srli_epi32(lo, 16)), 16);
+    hi = _mm_srli_epi32(_mm_add_epi32(hi, _mm_srli_epi32(hi, 16)), 16);
+
+    /* Sign-extend so the signed pack keeps the unsigned 16-bit values intact. */
+    lo = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);
+    hi = _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16);
+
+    return _mm_packs_epi32(lo, hi);
+}
+
+/* Same as blend_over8_sse2() for 2 RGBA16 pixels per iteration. */
+static unsigned blend_over16_sse2(uint8_t *dst, const uint8_t *src, unsigned width, unsigned alpha_index) {
+
+    const __m128i alpha_mask = alpha_index == 0 ? _mm_set_epi16(0, 0, 0, -1, 0, 0, 0, -1) : _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+    const __m128i ones       = _mm_set1_epi32(-1);
+    const __m128i zero       = _mm_setzero_si128();
+
+    unsigned x = 0;
+
+    for (; x + 2 <= width; x += 2, src += 16, dst += 16) {
+        const __m128i s = _mm_loadu_si128((const __m128i *)src);
+
+        /* Broadcast the source alpha into all the channels of its pixel. */
+        __m128i a = alpha_index == 0
+            ? _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, _MM_SHUFFLE(0, 0, 0, 0)), _MM_SHUFFLE(0, 0, 0, 0))
+            : _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(a, ones)) == 0xFFFF) {
+            _mm_storeu_si128((__m128i *)dst, s);
+            continue;
+        }
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(a, zero)) == 0xFFFF) {
+            continue;
+        }
+
+        const __m128i d = _mm_loadu_si128((const __m128i *)dst);
+
+        const __m128i d_a = alpha_index == 0
+            ? _mm_shufflehi_epi16(_mm_shufflelo_epi16(d, _MM_SHUFFLE(0, 0, 0, 0)), _MM_SHUFFLE(0, 0, 0, 0))
+            : _mm_shufflehi_epi16(_mm_shufflelo_epi16(d, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(d_a, ones)) != 0xFFFF) {
+            blend_over_pixel16(dst,     src,     alpha_index);
+            blend_over_pixel16(dst + 8, src + 8, alpha_index);
+            continue;
+        }
+
+        const __m128i inv_a = _mm_xor_si128(a, ones);
+
+        /* Full 32-bit products out of the low and high 16-bit halves. */
+        const __m128i s_lo = _mm_mullo_epi16(s, a);
+        const __m128i s_hi = _mm_mulhi_epu16(s, a);
+        const __m128i d_lo = _mm_mullo_epi16(d, inv_a);
+        const __m128i d_hi = _mm_mulhi_epu16(d, inv_a);
+
+        /* src * a + dst * (65535 - a) <= 65535 * 65535 fits into 32 bits. */
+        const __m128i sum_lo = _mm_add_epi32(_mm_unpacklo_epi16(s_lo, s_hi), _mm_unpacklo_epi16(d_lo, d_hi));
+        const __m128i sum_hi = _mm_add_epi32(_mm_unpackhi_epi16(s_lo, s_hi), _mm_unpackhi_epi16(d_lo, d_hi));
+
+        /* Blending over an opaque destination gives an opaque result. */
+        _mm_storeu_si128((__m128i *)dst, _mm_or_si128(div65535_pack_sse2(sum_lo, sum_hi), alpha_mask));
+    }
+
+    return x;
+}
+#endif
+
 sail_status_t png_private_blend_source(void *dst_raw, unsigned dst_offset, const void *src_raw, unsigned src_length, unsigned bytes_per_pixel) {
 
     SAIL_CHECK_PTR(dst_raw);
@@ -413,44 +632,65 @@ sail_status_t png_private_blend_source(void *dst_raw, unsigned dst_offset, const
     return SAIL_OK;
 }
 
-sail_status_t png_private_blend_over(void *dst_raw, unsigned dst_offset, const void *src_raw, unsigned width, unsigned bytes_per_pixel) {
+sail_status_t png_private_blend_over(void *dst_raw, unsigned dst_offset, const void *src_raw, unsigned width, enum SailPixelFormat pixel_format) {
 
     SAIL_CHECK_PTR(src_raw);
     SAIL_CHECK_PTR(dst_raw);
 
-    if (bytes_per_pixel == 4) {
-        const uint8_t *src = src_raw;
-        uint8_t *dst = (uint8_t *)dst_raw + dst_offset * bytes_per_pixel;
+    unsigned bytes_per_channel;
+    unsigned alpha_index;
 
-        while (width--) {
-            const double src_a = *(src+3) / 255.0;
-            const double dst_a = *(dst+3) / 255.0;
+    switch (pixel_format) {
+        case SAIL_PIXEL_FORMAT_BPP32_RGBA:
+        case SAIL_PIXEL_FORMAT_BPP32_BGRA: bytes_per_channel = 1; alpha_index = 3; break;
+        case SAIL_PIXEL_FORMAT_BPP32_ARGB:
+        case SAIL_PIXEL_FORMAT_BPP32_ABGR: bytes_per_channel = 1; alpha_index = 0; break;
+        case SAIL_PIXEL_FORMAT_BPP64_RGBA:
+        case SAIL_PIXEL_FORMAT_BPP64_BGRA: bytes_per_channel = 2; alpha_index = 3; break;
+        case SAIL_PIXEL_FORMAT_BPP64_ARGB:
+        case SAIL_PIXEL_FORMAT_BPP64_ABGR: bytes_per_channel = 2; alpha_index = 0; break;
+
+        case SAIL_PIXEL_FORMAT_BPP8_GRAYSCALE_ALPHA:
+        case SAIL_PIXEL_FORMAT_BPP16_GRAYSCALE_ALPHA: {
+            const char *pixel_format_str = NULL;
+            SAIL_TRY_OR_SUPPRESS(sail_pixel_format_to_string(pixel_format, &pixel_format_str));
+            SAIL_LOG_ERROR("PNG: Blending %s frames is not supported", pixel_format_str);
+            SAIL_LOG_AND_RETURN(SAIL_ERROR_UNSUPPORTED_PIXEL_FORMAT);
+        }
+
+        default: {
+            /* Without alpha every source pixel is opaque, so blending is just copying. */
+            unsigned bits_per_pixel;
+            SAIL_TRY(sail_bits_per_pixel(pixel_format, &bits_per_pixel));
 
-            *dst = (uint8_t)(src_a * (*src) + (1-src_a) * dst_a * (*dst)); src++; dst++;
-            *dst = (uint8_t)(src_a * (*src) + (1-src_a) * dst_a * (*dst)); src++; dst++;
-            *dst = (uint8_t)(src_a * (*src) + (1-src_a) * dst_a * (*dst)); src++; dst++;
-            *dst = (uint8_t)((src_a + (1-src_a) * dst_a) * 255);           src++; dst++;
+            return png_private_blend_source(dst_raw, dst_offset, src_raw, width, bits_per_pixel / 8);
         }
-    } else if (bytes_per_pixel == 8) {
-        const uint16_t *src = src_raw;
-        uint16_t *dst = (uint16_t *)((uint8_t *)dst_raw + dst_offset * bytes_per_pixel);
+    }
 
-        while (width--) {
-            const double src_a = *(src+3) / 65535.0;
-            const double dst_a = *(dst+3) / 65535.0;
+    const uint8_t *src = src_raw;
+    uint8_t *dst = (uint8_t *)dst_raw + dst_offset * 4 * bytes_per_channel;
+    unsigned x = 0;
 
-            *dst = (uint16_t)(src_a * (*src) + (1-src_a) * dst_a * (*dst)); src++; dst++;
-            *dst = (uint16_t)(src_a * (*src) + (1-src_a) * dst_a * (*dst)); src++; dst++;
-            *dst = (uint16_t)(src_a * (*src) + (1-src_a) * dst_a * (*dst)); src++; dst++;
-            *dst = (uint16_t)((src_a + (1-src_a) * dst_a) * 65535);         src++; dst++;
+    if (bytes_per_channel == 1) {
+#ifdef BLEND_OVER_SSE2
+        x = blend_over8_sse2(dst, src, width, alpha_index);
+#endif
+        for (; x < width; x++) {
+            blend_over_pixel8(dst + x * 4, src + x * 4, alpha_index);
         }
     } else {
-        SAIL_LOG_AND_RETURN(SAIL_ERROR_UNSUPPORTED_BIT_DEPTH);
+#ifdef BLEND_OVER_SSE2
+        x = blend_over16_sse2(dst, src, width, alpha_index);
+#endif
+        for (; x < width; x++) {
+            blend_over_pixel16(dst + x * 8, src + x * 8, alpha_index);
+        }
     }
 
     return SAIL_OK;
 }
 
+#ifdef PNG_APNG_SUPPORTED
 sail_status_t png_private_skip_hidden_frame(unsigned bytes_per_line, unsigned height, png_structp png_ptr, png_infop info_ptr, void **row) {
 
     SAIL_CHECK_PTR(png_ptr);
@@ -470,6 +710,7 @@ sail_status_t png_private_skip_hidden_frame(unsigned bytes_per_line, unsigned he
 
     return SAIL_OK;
 }
+#endif
 
 sail_status_t png_private_alloc_rows(png_bytep **A, unsigned row_length, unsigned height) {
 
@@ -505,7 +746,25 @@ void png_private_destroy_rows(png_bytep **A, unsigned height) {
     sail_free(*A);
     *A = NULL;
 }
-#endif
+
+void png_private_crop_row(const unsigned char *scanline, unsigned scanline_length, unsigned first_bit, unsigned char *target, unsigned target_length) {
+
+    const unsigned char *source = scanline + first_bit / 8;
+    const unsigned shift = first_bit % 8;
+
+    if (shift == 0) {
+        memcpy(target, source, target_length);
+        return;
+    }
+
+    /* Packed pixels don't start on a byte boundary. */
+    const unsigned source_length = scanline_length - first_bit / 8;
+
+    for (unsigned i = 0; i < target_length; i++) {
+        const unsigned char next = (i + 1 < source_length) ? source[i + 1] : 0;
+        target[i] = (unsigned char)((source[i] << shift) | (next >> (8 - shift)));
+    }
+}
 
 sail_status_t png_private_fetch_resolution(png_structp png_ptr, png_infop info_ptr, struct sail_resolution **resolution) {
 
@@ -561,3 +820,34 @@ sail_status_t png_private_write_resolution(png_structp png_ptr, png_infop info_p
 
     return SAIL_OK;
 }
+
+int png_private_filter_to_png_filters(enum SailFilter filter) {
+
+    switch (filter) {
+        case SAIL_FILTER_NONE:     return PNG_FILTER_NONE;
+        case SAIL_FILTER_SUB:      return PNG_FILTER_SUB;
+        case SAIL_FILTER_UP:       return PNG_FILTER_UP;
+        case SAIL_FILTER_AVERAGE:  return PNG_FILTER_AVG;
+        case SAIL_FILTER_PAETH:    return PNG_FILTER_PAETH;
+
+        default: {
+            return PNG_ALL_FILTERS;
+        }
+    }
+}
+
+bool png_private_host_is_little_endian(void) {
+
+    const uint16_t value = 1;
+    uint8_t first_byte;
+    memcpy(&first_byte, &value, 1);
+
+    return first_byte == 1;
+}
+
+void png_private_set_host_byte_order(png_structp png_ptr, int bit_depth) {
+
+    if (bit_depth == 16 && png_private_host_is_little_endian()) {
+        png_set_swap(png_ptr);
+    }
+}
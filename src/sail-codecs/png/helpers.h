@@ -60,20 +60,29 @@ SAIL_HIDDEN sail_status_t png_private_fetch_iccp(png_structp png_ptr, png_infop
 
 SAIL_HIDDEN sail_status_t png_private_fetch_palette(png_structp png_ptr, png_infop info_ptr, struct sail_palette **palette);
 
-#ifdef PNG_APNG_SUPPORTED
 SAIL_HIDDEN sail_status_t png_private_blend_source(void *dst_raw, unsigned dst_offset, const void *src_raw, unsigned src_length, unsigned bytes_per_pixel);
 
-SAIL_HIDDEN sail_status_t png_private_blend_over(void *dst_raw, unsigned dst_offset, const void *src_raw, unsigned width, unsigned bytes_per_pixel);
+SAIL_HIDDEN sail_status_t png_private_blend_over(void *dst_raw, unsigned dst_offset, const void *src_raw, unsigned width, enum SailPixelFormat pixel_format);
 
+#ifdef PNG_APNG_SUPPORTED
 SAIL_HIDDEN sail_status_t png_private_skip_hidden_frame(unsigned bytes_per_line, unsigned height, png_structp png_ptr, png_infop info_ptr, void **row);
+#endif
 
 SAIL_HIDDEN sail_status_t png_private_alloc_rows(png_bytep **A, unsigned row_length, unsigned height);
 
 SAIL_HIDDEN void png_private_destroy_rows(png_bytep **A, unsigned height);
-#endif
+
+SAIL_HIDDEN void png_private_crop_row(const unsigned char *scanline, unsigned scanline_length, unsigned first_bit, unsigned char *target, unsigned target_length);
 
 SAIL_HIDDEN sail_status_t png_private_fetch_resolution(png_structp png_ptr, png_infop info_ptr, struct sail_resolution **resolution);
 
 SAIL_HIDDEN sail_status_t png_private_write_resolution(png_structp png_ptr, png_infop info_ptr, const struct sail_resolution *resolution);
 
+SAIL_HIDDEN int png_private_filter_to_png_filters(enum SailFilter filter);
+
+SAIL_HIDDEN bool png_private_host_is_little_endian(void);
+
+/* SAIL keeps 16-bit samples in the host byte order. PNG stores them big-endian. */
+SAIL_HIDDEN void png_private_set_host_byte_order(png_structp png_ptr, int bit_depth);
+
 #endif
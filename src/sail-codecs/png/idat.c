@@ -0,0 +1,747 @@
+/*  This file is part of SAIL (https://github.com/smoked-herring/sail)
+
+    Copyright (c) 2020 Dmitry Baryshev
+
+    The MIT License
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <png.h>
+#include <zlib.h>
+
+#include "sail-common.h"
+
+#include "helpers.h"
+#include "idat.h"
+
+/* Uncompressed size of a segment. Every segment but the last one fills the dictionary of the next one. */
+#define PNG_SEGMENT_SIZE (128 * 1024)
+
+/* Upper limit of encoding threads. */
+#define PNG_MAX_THREADS 64
+
+/* Deflate window size. */
+#define PNG_WINDOW_SIZE 32768
+
+/* Adam7 passes. */
+static const unsigned ADAM7_X_START[] = { 0, 4, 0, 2, 0, 1, 0 };
+static const unsigned ADAM7_X_STEP[]  = { 8, 8, 4, 4, 2, 2, 1 };
+static const unsigned ADAM7_Y_START[] = { 0, 0, 4, 0, 2, 0, 1 };
+static const unsigned ADAM7_Y_STEP[]  = { 8, 8, 8, 4, 4, 2, 2 };
+
+/* Reduced image of an interlaced pass or the whole image. */
+struct png_pass {
+    unsigned x_start;
+    unsigned x_step;
+    unsigned y_start;
+    unsigned y_step;
+    unsigned width;
+    unsigned height;
+    size_t row_length;
+    /* Index of the first row in the sequence of rows of all passes. */
+    unsigned first_row;
+};
+
+struct png_segment {
+    z_stream stream;
+    bool stream_initialized;
+
+    /* Filtered rows prefixed with filter types. */
+    unsigned char *filtered;
+    size_t filtered_size;
+    uLong adler;
+
+    unsigned char *compressed;
+    size_t compressed_size;
+    size_t compressed_capacity;
+
+    /* Previous and current rows extracted from the image, and a trial row of the adaptive filter. */
+    unsigned char *scanlines;
+};
+
+struct png_idat_encoder {
+    /* Threads filtering and deflating segments along with the calling thread. */
+    struct sail_thread_pool *pool;
+
+    int compression_level;
+    int strategy;
+    enum SailFilter filter;
+
+    unsigned bits_per_pixel;
+    /* Distance to the corresponding byte of the previous pixel. */
+    unsigned filter_distance;
+    size_t row_length;
+
+    /* One pass for non-interlaced images. Empty passes are skipped. */
+    struct png_pass passes[7];
+    unsigned passes_count;
+
+    /* Rows of all passes are split into segments of at least PNG_SEGMENT_SIZE bytes. */
+    unsigned *segment_first_rows;
+    unsigned segments_count;
+
+    /* Sample order and byte order expected by PNG when they differ from the image. */
+    bool reorder;
+    bool swap_bytes;
+    unsigned channels;
+    unsigned sample_size;
+    unsigned char order[4];
+
+    /* Segments processed in a batch. */
+    struct png_segment *segments;
+    unsigned batch_size;
+
+    /* Current batch. */
+    const struct sail_image *image;
+    unsigned first_segment;
+
+    /* Tail of the last segment in the previous batch. */
+    unsigned char dictionary[PNG_WINDOW_SIZE];
+    uLong adler;
+
+    /* All passes are written at once. */
+    bool written;
+};
+
+/*
+ * Private functions.
+ */
+
+static void sample_order(enum SailPixelFormat pixel_format, struct png_idat_encoder *encoder) {
+
+    static const unsigned char RGB[]  = { 0, 1, 2, 3 };
+    static const unsigned char BGR[]  = { 2, 1, 0, 3 };
+    static const unsigned char ARGB[] = { 1, 2, 3, 0 };
+    static const unsigned char ABGR[] = { 3, 2, 1, 0 };
+
+    const unsigned char *order;
+
+    switch (pixel_format) {
+        case SAIL_PIXEL_FORMAT_BPP24_BGR:             order = BGR;  encoder->channels = 3; encoder->sample_size = 1; break;
+        case SAIL_PIXEL_FORMAT_BPP48_BGR:             order = BGR;  encoder->channels = 3; encoder->sample_size = 2; break;
+        case SAIL_PIXEL_FORMAT_BPP32_BGRA:            order = BGR;  encoder->channels = 4; encoder->sample_size = 1; break;
+        case SAIL_PIXEL_FORMAT_BPP64_BGRA:            order = BGR;  encoder->channels = 4; encoder->sample_size = 2; break;
+        case SAIL_PIXEL_FORMAT_BPP32_ARGB:            order = ARGB; encoder->channels = 4; encoder->sample_size = 1; break;
+        case SAIL_PIXEL_FORMAT_BPP64_ARGB:            order = ARGB; encoder->channels = 4; encoder->sample_size = 2; break;
+        case SAIL_PIXEL_FORMAT_BPP32_ABGR:            order = ABGR; encoder->channels = 4; encoder->sample_size = 1; break;
+        case SAIL_PIXEL_FORMAT_BPP64_ABGR:            order = ABGR; encoder->channels = 4; encoder->sample_size = 2; break;
+
+        /* Only the byte order differs. */
+        case SAIL_PIXEL_FORMAT_BPP16_GRAYSCALE:       order = RGB;  encoder->channels = 1; encoder->sample_size = 2; break;
+        case SAIL_PIXEL_FORMAT_BPP32_GRAYSCALE_ALPHA: order = RGB;  encoder->channels = 2; encoder->sample_size = 2; break;
+        case SAIL_PIXEL_FORMAT_BPP48_RGB:             order = RGB;  encoder->channels = 3; encoder->sample_size = 2; break;
+        case SAIL_PIXEL_FORMAT_BPP64_RGBA:            order = RGB;  encoder->channels = 4; encoder->sample_size = 2; break;
+
+        default: {
+            encoder->reorder    = false;
+            encoder->swap_bytes = false;
+            return;
+        }
+    }
+
+    /* Same as png_set_swap(). 16-bit samples are big-endian in PNG. */
+    encoder->swap_bytes = encoder->sample_size == 2 && png_private_host_is_little_endian();
+    encoder->reorder    = order != RGB || encoder->swap_bytes;
+    memcpy(encoder->order, order, sizeof(encoder->order));
+}
+
+/* Same as png_set_bgr(), png_set_swap_alpha(), and png_set_swap(). */
+static void reorder_row(const struct png_idat_encoder *encoder, const unsigned char *row, size_t length, unsigned char *target) {
+
+    const size_t pixel_size = encoder->channels * encoder->sample_size;
+
+    for (size_t pixel = 0; pixel < length; pixel += pixel_size) {
+        for (unsigned channel = 0; channel < encoder->channels; channel++) {
+            const unsigned char *sample = row + pixel + encoder->order[channel] * encoder->sample_size;
+            unsigned char *target_sample = target + pixel + channel * encoder->sample_size;
+
+            if (encoder->swap_bytes) {
+                target_sample[0] = sample[1];
+                target_sample[1] = sample[0];
+            } else {
+                memcpy(target_sample, sample, encoder->sample_size);
+            }
+        }
+    }
+}
+
+static unsigned char paeth_predictor(unsigned char a, unsigned char b, unsigned char c) {
+
+    const int p  = a + b - c;
+    const int pa = abs(p - a);
+    const int pb = abs(p - b);
+    const int pc = abs(p - c);
+
+    if (pa <= pb && pa <= pc) {
+        return a;
+    } else if (pb <= pc) {
+        return b;
+    } else {
+        return c;
+    }
+}
+
+/* Filters the row into the target prefixed with the filter type. The previous row is NULL for the first row. */
+static void filter_row(int filter_type, const unsigned char *row, const unsigned char *prev, size_t length, unsigned distance, unsigned char *target) {
+
+    *target++ = (unsigned char)filter_type;
+
+    switch (filter_type) {
+        case PNG_FILTER_VALUE_SUB: {
+            for (size_t i = 0; i < length; i++) {
+                target[i] = (unsigned char)(row[i] - (i >= distance ? row[i - distance] : 0));
+            }
+            break;
+        }
+        case PNG_FILTER_VALUE_UP: {
+            for (size_t i = 0; i < length; i++) {
+                target[i] = (unsigned char)(row[i] - (prev != NULL ? prev[i] : 0));
+            }
+            break;
+        }
+        case PNG_FILTER_VALUE_AVG: {
+            for (size_t i = 0; i < length; i++) {
+                const unsigned a = (i >= distance) ? row[i - distance] : 0;
+                const unsigned b = (prev != NULL) ? prev[i] : 0;
+
+                target[i] = (unsigned char)(row[i] - ((a + b) >> 1));
+            }
+            break;
+        }
+        case PNG_FILTER_VALUE_PAETH: {
+            for (size_t i = 0; i < length; i++) {
+                const unsigned char a = (i >= distance) ? row[i - distance] : 0;
+                const unsigned char b = (prev != NULL) ? prev[i] : 0;
+                const unsigned char c = (prev != NULL && i >= distance) ? prev[i - distance] : 0;
+
+                target[i] = (unsigned char)(row[i] - paeth_predictor(a, b, c));
+            }
+            break;
+        }
+        default: {
+            memcpy(target, row, length);
+            break;
+        }
+    }
+}
+
+/*
+ * Sum of absolute values of the filtered bytes as signed numbers. The same heuristic as in libpng.
+ * Stops early when the sum reaches the limit.
+ */
+static size_t filter_cost(const unsigned char *filtered, size_t length, size_t limit) {
+
+    size_t cost = 0;
+
+    for (size_t i = 1; i <= length && cost < limit; i++) {
+        cost += (filtered[i] < 128) ? filtered[i] : 256 - filtered[i];
+    }
+
+    return cost;
+}
+
+static void filter_row_adaptive(const unsigned char *row, const unsigned char *prev, size_t length, unsigned distance,
+                                unsigned char *target, unsigned char *trial) {
+
+    filter_row(PNG_FILTER_VALUE_NONE, row, prev, length, distance, target);
+    size_t best_cost = filter_cost(target, length, SIZE_MAX);
+
+    for (int filter_type = PNG_FILTER_VALUE_SUB; filter_type <= PNG_FILTER_VALUE_PAETH; filter_type++) {
+        filter_row(filter_type, row, prev, length, distance, trial);
+        const size_t cost = filter_cost(trial, length, best_cost);
+
+        if (cost < best_cost) {
+            best_cost = cost;
+            memcpy(target, trial, length + 1);
+        }
+    }
+}
+
+static int filter_type(enum SailFilter filter) {
+
+    switch (filter) {
+        case SAIL_FILTER_SUB:     return PNG_FILTER_VALUE_SUB;
+        case SAIL_FILTER_UP:      return PNG_FILTER_VALUE_UP;
+        case SAIL_FILTER_AVERAGE: return PNG_FILTER_VALUE_AVG;
+        case SAIL_FILTER_PAETH:   return PNG_FILTER_VALUE_PAETH;
+
+        default: {
+            return PNG_FILTER_VALUE_NONE;
+        }
+    }
+}
+
+/* Extracts pixels of the pass from the image row. */
+static void extract_row(const struct png_idat_encoder *encoder, const struct png_pass *pass, const unsigned char *row, unsigned char *target) {
+
+    if (encoder->bits_per_pixel >= 8) {
+        const unsigned bytes_per_pixel = encoder->bits_per_pixel / 8;
+
+        for (unsigned x = 0; x < pass->width; x++) {
+            memcpy(target + (size_t)x * bytes_per_pixel, row + (size_t)(pass->x_start + x * pass->x_step) * bytes_per_pixel, bytes_per_pixel);
+        }
+    } else {
+        const unsigned bits = encoder->bits_per_pixel;
+        const unsigned mask = (1U << bits) - 1;
+
+        memset(target, 0, pass->row_length);
+
+        for (unsigned x = 0; x < pass->width; x++) {
+            const size_t source_bit = (size_t)(pass->x_start + x * pass->x_step) * bits;
+            const size_t target_bit = (size_t)x * bits;
+            const unsigned value = (row[source_bit / 8] >> (8 - bits - source_bit % 8)) & mask;
+
+            target[target_bit / 8] |= (unsigned char)(value << (8 - bits - target_bit % 8));
+        }
+    }
+}
+
+/*
+ * Returns the pass row in the PNG sample order. Uses the scan line when the image row doesn't fit as is.
+ * The temporary buffer holds extracted pixels before reordering.
+ */
+static const unsigned char *pass_row(const struct png_idat_encoder *encoder, const struct png_pass *pass, unsigned row,
+                                     unsigned char *scanline, unsigned char *temp) {
+
+    const unsigned char *image_row = (const unsigned char *)encoder->image->pixels
+                                        + (size_t)(pass->y_start + row * pass->y_step) * encoder->image->bytes_per_line;
+
+    if (pass->x_step > 1) {
+        unsigned char *target = encoder->reorder ? temp : scanline;
+        extract_row(encoder, pass, image_row, target);
+        image_row = target;
+    }
+
+    if (encoder->reorder) {
+        reorder_row(encoder, image_row, pass->row_length, scanline);
+        image_row = scanline;
+    }
+
+    return image_row;
+}
+
+static const struct png_pass *find_pass(const struct png_idat_encoder *encoder, unsigned row) {
+
+    unsigned i = encoder->passes_count - 1;
+
+    while (encoder->passes[i].first_row > row) {
+        i--;
+    }
+
+    return &encoder->passes[i];
+}
+
+static sail_status_t filter_segment_job(void *context, unsigned job, unsigned worker) {
+
+    (void)worker;
+
+    const struct png_idat_encoder *encoder = context;
+    struct png_segment *segment = &encoder->segments[job];
+
+    const unsigned global_segment = encoder->first_segment + job;
+    const unsigned first_row = encoder->segment_first_rows[global_segment];
+    const unsigned last_row  = encoder->segment_first_rows[global_segment + 1];
+
+    /* Previous and current rows alternate between the two scan lines. */
+    unsigned char *scanlines[2] = { segment->scanlines, segment->scanlines + encoder->row_length };
+    unsigned char *trial = segment->scanlines + encoder->row_length * 2;
+    unsigned current_scanline = 0;
+
+    const struct png_pass *pass = find_pass(encoder, first_row);
+    const unsigned char *prev = NULL;
+
+    if (first_row > pass->first_row) {
+        prev = pass_row(encoder, pass, first_row - pass->first_row - 1, scanlines[current_scanline], trial);
+        current_scanline ^= 1;
+    }
+
+    unsigned char *target = segment->filtered;
+
+    for (unsigned row = first_row; row < last_row; row++) {
+        if (row >= pass->first_row + pass->height) {
+            pass++;
+            prev = NULL;
+        }
+
+        const unsigned char *current = pass_row(encoder, pass, row - pass->first_row, scanlines[current_scanline], trial);
+        current_scanline ^= 1;
+
+        if (encoder->filter == SAIL_FILTER_ADAPTIVE) {
+            filter_row_adaptive(current, prev, pass->row_length, encoder->filter_distance, target, trial);
+        } else {
+            filter_row(filter_type(encoder->filter), current, prev, pass->row_length, encoder->filter_distance, target);
+        }
+
+        target += pass->row_length + 1;
+        prev = current;
+    }
+
+    segment->filtered_size = (size_t)(target - segment->filtered);
+    segment->adler = adler32(adler32(0L, Z_NULL, 0), segment->filtered, (uInt)segment->filtered_size);
+
+    return SAIL_OK;
+}
+
+static sail_status_t reserve_compressed(struct png_segment *segment, size_t capacity) {
+
+    if (segment->compressed_capacity >= capacity) {
+        return SAIL_OK;
+    }
+
+    void *ptr = segment->compressed;
+    SAIL_TRY(sail_realloc(capacity, &ptr));
+    segment->compressed          = ptr;
+    segment->compressed_capacity = capacity;
+
+    return SAIL_OK;
+}
+
+/* Writes the zlib stream header. */
+static void write_zlib_header(int compression_level, unsigned char *target) {
+
+    /* Deflate with a 32 KiB window. */
+    const unsigned cmf = 0x78;
+    const unsigned level = (compression_level < 2) ? 0 : (compression_level < 6) ? 1 : (compression_level == 6) ? 2 : 3;
+    unsigned flg = level << 6;
+    flg += 31 - ((cmf << 8) + flg) % 31;
+
+    target[0] = (unsigned char)cmf;
+    target[1] = (unsigned char)flg;
+}
+
+static sail_status_t deflate_segment_job(void *context, unsigned job, unsigned worker) {
+
+    (void)worker;
+
+    const struct png_idat_encoder *encoder = context;
+    struct png_segment *segment = &encoder->segments[job];
+    z_stream *stream = &segment->stream;
+
+    const unsigned global_segment = encoder->first_segment + job;
+    const bool last = global_segment == encoder->segments_count - 1;
+    const size_t header_size = (global_segment == 0) ? 2 : 0;
+
+    if (deflateReset(stream) != Z_OK) {
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
+    }
+
+    /* Back-references may cross the segment boundary. */
+    if (global_segment > 0) {
+        const unsigned char *dictionary = (job > 0)
+            ? encoder->segments[job - 1].filtered + encoder->segments[job - 1].filtered_size - PNG_WINDOW_SIZE
+            : encoder->dictionary;
+
+        if (deflateSetDictionary(stream, dictionary, PNG_WINDOW_SIZE) != Z_OK) {
+            SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
+        }
+    }
+
+    /* Extra room for the sync flush marker and the checksum. */
+    SAIL_TRY(reserve_compressed(segment, header_size + deflateBound(stream, (uLong)segment->filtered_size) + 16));
+
+    if (header_size > 0) {
+        write_zlib_header(encoder->compression_level, segment->compressed);
+    }
+
+    const int flush = last ? Z_FINISH : Z_SYNC_FLUSH;
+
+    stream->next_in   = segment->filtered;
+    stream->avail_in  = (uInt)segment->filtered_size;
+    stream->next_out  = segment->compressed + header_size;
+    stream->avail_out = (uInt)(segment->compressed_capacity - header_size);
+
+    for (;;) {
+        if (stream->avail_out == 0) {
+            const size_t offset = (size_t)(stream->next_out - segment->compressed);
+
+            SAIL_TRY(reserve_compressed(segment, segment->compressed_capacity * 2));
+
+            stream->next_out  = segment->compressed + offset;
+            stream->avail_out = (uInt)(segment->compressed_capacity - offset);
+        }
+
+        const int ret = deflate(stream, flush);
+
+        if (ret == Z_STREAM_ERROR) {
+            SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
+        }
+
+        if (last ? ret == Z_STREAM_END : stream->avail_out != 0) {
+            break;
+        }
+    }
+
+    segment->compressed_size = (size_t)(stream->next_out - segment->compressed);
+
+    return SAIL_OK;
+}
+
+static void init_passes(struct png_idat_encoder *encoder, unsigned width, unsigned height, bool interlaced) {
+
+    encoder->passes_count = 0;
+    unsigned first_row = 0;
+
+    for (unsigned i = 0; i < (interlaced ? 7U : 1U); i++) {
+        struct png_pass *pass = &encoder->passes[encoder->passes_count];
+
+        pass->x_start = interlaced ? ADAM7_X_START[i] : 0;
+        pass->x_step  = interlaced ? ADAM7_X_STEP[i]  : 1;
+        pass->y_start = interlaced ? ADAM7_Y_START[i] : 0;
+        pass->y_step  = interlaced ? ADAM7_Y_STEP[i]  : 1;
+
+        if (width <= pass->x_start || height <= pass->y_start) {
+            continue;
+        }
+
+        pass->width      = (width  - pass->x_start + pass->x_step - 1) / pass->x_step;
+        pass->height     = (height - pass->y_start + pass->y_step - 1) / pass->y_step;
+        pass->row_length = ((size_t)pass->width * encoder->bits_per_pixel + 7) / 8;
+        pass->first_row  = first_row;
+
+        first_row += pass->height;
+        encoder->passes_count++;
+    }
+}
+
+/* Splits rows of all passes into segments. Returns the largest segment size. */
+static sail_status_t init_segments(struct png_idat_encoder *encoder, size_t *max_segment_size) {
+
+    const struct png_pass *last_pass = &encoder->passes[encoder->passes_count - 1];
+    const unsigned rows_count = last_pass->first_row + last_pass->height;
+
+    /* Every segment has at least one row. */
+    void *ptr;
+    SAIL_TRY(sail_malloc(sizeof(unsigned) * ((size_t)rows_count + 1), &ptr));
+    encoder->segment_first_rows = ptr;
+
+    encoder->segments_count = 0;
+    *max_segment_size = 0;
+    size_t segment_size = 0;
+
+    for (unsigned p = 0; p < encoder->passes_count; p++) {
+        const struct png_pass *pass = &encoder->passes[p];
+
+        for (unsigned row = pass->first_row; row < pass->first_row + pass->height; row++) {
+            if (segment_size == 0) {
+                encoder->segment_first_rows[encoder->segments_count++] = row;
+            }
+
+            segment_size += pass->row_length + 1;
+
+            if (segment_size >= PNG_SEGMENT_SIZE) {
+                *max_segment_size = (segment_size > *max_segment_size) ? segment_size : *max_segment_size;
+                segment_size = 0;
+            }
+        }
+    }
+
+    *max_segment_size = (segment_size > *max_segment_size) ? segment_size : *max_segment_size;
+    encoder->segment_first_rows[encoder->segments_count] = rows_count;
+
+    return SAIL_OK;
+}
+
+/*
+ * Public functions.
+ */
+
+sail_status_t png_private_alloc_idat_encoder(unsigned threads, int compression_level, enum SailFilter filter,
+                                             enum SailPixelFormat pixel_format, unsigned width, unsigned height, bool interlaced,
+                                             struct png_idat_encoder **encoder) {
+
+    SAIL_CHECK_PTR(encoder);
+
+    unsigned bits_per_pixel;
+    SAIL_TRY(sail_bits_per_pixel(pixel_format, &bits_per_pixel));
+    unsigned row_length;
+    SAIL_TRY(sail_bytes_per_line(width, pixel_format, &row_length));
+
+    void *ptr;
+    SAIL_TRY(sail_malloc(sizeof(struct png_idat_encoder), &ptr));
+    struct png_idat_encoder *result = ptr;
+
+    result->pool               = NULL;
+    result->compression_level  = compression_level;
+    result->bits_per_pixel     = bits_per_pixel;
+    result->filter_distance    = (bits_per_pixel < 8) ? 1 : bits_per_pixel / 8;
+    result->row_length         = row_length;
+    result->segment_first_rows = NULL;
+    result->segments           = NULL;
+    result->batch_size         = 0;
+    result->image              = NULL;
+    result->first_segment      = 0;
+    result->adler              = 0;
+    result->written            = false;
+
+    const bool indexed = pixel_format == SAIL_PIXEL_FORMAT_BPP1_INDEXED ||
+                            pixel_format == SAIL_PIXEL_FORMAT_BPP2_INDEXED ||
+                            pixel_format == SAIL_PIXEL_FORMAT_BPP4_INDEXED ||
+                            pixel_format == SAIL_PIXEL_FORMAT_BPP8_INDEXED;
+
+    if (filter == SAIL_FILTER_DEFAULT) {
+        result->filter = (indexed || bits_per_pixel < 8) ? SAIL_FILTER_NONE : SAIL_FILTER_ADAPTIVE;
+    } else {
+        result->filter = filter;
+    }
+
+    /* Same as libpng. */
+    result->strategy = (result->filter == SAIL_FILTER_NONE) ? Z_DEFAULT_STRATEGY : Z_FILTERED;
+
+    sample_order(pixel_format, result);
+
+    init_passes(result, width, height, interlaced);
+
+    size_t segment_size;
+    SAIL_TRY_OR_CLEANUP(init_segments(result, &segment_size),
+                        /* cleanup */ png_private_destroy_idat_encoder(result));
+
+    if (threads > PNG_MAX_THREADS) {
+        threads = PNG_MAX_THREADS;
+    } else if (threads == 0) {
+        threads = 1;
+    }
+
+    SAIL_TRY_OR_CLEANUP(sail_alloc_thread_pool(threads - 1, &result->pool),
+                        /* cleanup */ png_private_destroy_idat_encoder(result));
+
+    /* Segments filtered and deflated at once. */
+    const unsigned batch_size = (threads * 2 < result->segments_count) ? threads * 2 : result->segments_count;
+
+    SAIL_TRY_OR_CLEANUP(sail_calloc(batch_size, sizeof(struct png_segment), &ptr),
+                        /* cleanup */ png_private_destroy_idat_encoder(result));
+    result->segments   = ptr;
+    result->batch_size = batch_size;
+
+    for (unsigned i = 0; i < batch_size; i++) {
+        struct png_segment *segment = &result->segments[i];
+
+        SAIL_TRY_OR_CLEANUP(sail_malloc(segment_size, &ptr),
+                            /* cleanup */ png_private_destroy_idat_encoder(result));
+        segment->filtered = ptr;
+
+        SAIL_TRY_OR_CLEANUP(sail_malloc((size_t)row_length * 3 + 1, &ptr),
+                            /* cleanup */ png_private_destroy_idat_encoder(result));
+        segment->scanlines = ptr;
+
+        /* Raw deflate, the zlib header and checksum are written separately. */
+        if (deflateInit2(&segment->stream, compression_level, Z_DEFLATED, -15, 8, result->strategy) != Z_OK) {
+            png_private_destroy_idat_encoder(result);
+            SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
+        }
+
+        segment->stream_initialized = true;
+    }
+
+    *encoder = result;
+
+    return SAIL_OK;
+}
+
+void png_private_destroy_idat_encoder(struct png_idat_encoder *encoder) {
+
+    if (encoder == NULL) {
+        return;
+    }
+
+    if (encoder->segments != NULL) {
+        for (unsigned i = 0; i < encoder->batch_size; i++) {
+            struct png_segment *segment = &encoder->segments[i];
+
+            if (segment->stream_initialized) {
+                deflateEnd(&segment->stream);
+            }
+
+            sail_free(segment->filtered);
+            sail_free(segment->compressed);
+            sail_free(segment->scanlines);
+        }
+
+        sail_free(encoder->segments);
+    }
+
+    sail_destroy_thread_pool(encoder->pool);
+
+    sail_free(encoder->segment_first_rows);
+    sail_free(encoder);
+}
+
+sail_status_t png_private_write_idat(struct png_idat_encoder *encoder, png_structp png_ptr, const struct sail_image *image) {
+
+    SAIL_CHECK_PTR(encoder);
+    SAIL_CHECK_PTR(png_ptr);
+    SAIL_CHECK_IMAGE(image);
+
+    if (encoder->written) {
+        return SAIL_OK;
+    }
+
+    encoder->image   = image;
+    encoder->written = true;
+
+    for (unsigned first_segment = 0; first_segment < encoder->segments_count; first_segment += encoder->batch_size) {
+        const unsigned count = (encoder->segments_count - first_segment < encoder->batch_size)
+                                ? encoder->segments_count - first_segment
+                                : encoder->batch_size;
+
+        encoder->first_segment = first_segment;
+
+        SAIL_TRY(sail_thread_pool_run(encoder->pool, count, filter_segment_job, encoder));
+        SAIL_TRY(sail_thread_pool_run(encoder->pool, count, deflate_segment_job, encoder));
+
+        for (unsigned i = 0; i < count; i++) {
+            struct png_segment *segment = &encoder->segments[i];
+
+            encoder->adler = (first_segment + i == 0)
+                                ? segment->adler
+                                : adler32_combine(encoder->adler, segment->adler, (z_off_t)segment->filtered_size);
+
+            /* Append the big-endian checksum of all filtered rows to the last segment. */
+            if (first_segment + i == encoder->segments_count - 1) {
+                SAIL_TRY(reserve_compressed(segment, segment->compressed_size + 4));
+
+                unsigned char *target = segment->compressed + segment->compressed_size;
+
+                target[0] = (unsigned char)(encoder->adler >> 24);
+                target[1] = (unsigned char)(encoder->adler >> 16);
+                target[2] = (unsigned char)(encoder->adler >> 8);
+                target[3] = (unsigned char)(encoder->adler);
+
+                segment->compressed_size += 4;
+            }
+
+            png_write_chunk(png_ptr, (png_const_bytep)"IDAT", segment->compressed, segment->compressed_size);
+        }
+
+        /* The next batch starts with a dictionary from this one. */
+        const struct png_segment *last = &encoder->segments[count - 1];
+
+        if (first_segment + count < encoder->segments_count) {
+            memcpy(encoder->dictionary, last->filtered + last->filtered_size - PNG_WINDOW_SIZE, PNG_WINDOW_SIZE);
+        }
+    }
+
+    return SAIL_OK;
+}
@@ -0,0 +1,63 @@
+/*  This file is part of SAIL (https://github.com/smoked-herring/sail)
+
+    Copyright (c) 2020 Dmitry Baryshev
+
+    The MIT License
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#ifndef SAIL_PNG_IDAT_H
+#define SAIL_PNG_IDAT_H
+
+#include <stdbool.h>
+
+#include <png.h>
+
+#include "common.h"
+#include "error.h"
+#include "export.h"
+
+struct sail_image;
+
+/*
+ * Parallel IDAT encoder. Rows are split into segments that are filtered and deflated concurrently.
+ * Every segment is primed with the last 32 KiB of the previous one and ends on a byte boundary
+ * with a sync flush, so the concatenated segments form a single valid zlib stream.
+ */
+struct png_idat_encoder;
+
+/*
+ * Allocates an encoder for images of the specified pixel format. Interlaced images are written as Adam7 passes.
+ * SAIL_FILTER_DEFAULT selects the libpng default: no filtering for indexed images and images below 8 bits
+ * per pixel, adaptive filtering otherwise.
+ */
+SAIL_HIDDEN sail_status_t png_private_alloc_idat_encoder(unsigned threads, int compression_level, enum SailFilter filter,
+                                                         enum SailPixelFormat pixel_format, unsigned width, unsigned height, bool interlaced,
+                                                         struct png_idat_encoder **encoder);
+
+SAIL_HIDDEN void png_private_destroy_idat_encoder(struct png_idat_encoder *encoder);
+
+/*
+ * Filters and compresses the image pixels and writes them as IDAT chunks. Interlaced passes are written at once,
+ * subsequent calls do nothing.
+ */
+SAIL_HIDDEN sail_status_t png_private_write_idat(struct png_idat_encoder *encoder, png_structp png_ptr, const struct sail_image *image);
+
+#endif
@@ -35,6 +35,7 @@
 #include "sail-common.h"
 
 #include "helpers.h"
+#include "idat.h"
 #include "io.h"
 
 /*
@@ -64,6 +65,29 @@ struct png_state {
     int frames;
     int current_frame;
 
+    /* Region of interest. */
+    bool crop;
+    unsigned crop_x;
+    unsigned crop_y;
+    unsigned crop_width;
+    unsigned crop_height;
+    unsigned bits_per_pixel;
+    /* The next row of the full image to read in the current pass. */
+    unsigned next_row;
+    unsigned pass;
+    /* Full-width scan line to read the rows into before cropping. */
+    void *crop_scanline;
+    /* Full-width rows of the region kept between interlaced passes. */
+    png_bytep *crop_rows;
+
+    /* Incremental decoding. The image being decoded and the number of rows with final pixels. */
+    struct sail_image *feed_image;
+    unsigned feed_valid_rows;
+    bool feed_finished;
+
+    /* Parallel encoding. NULL when encoding with libpng in the calling thread. */
+    struct png_idat_encoder *idat_encoder;
+
     /* APNG-specific. */
 #ifdef PNG_APNG_SUPPORTED
     bool is_apng;
@@ -107,6 +131,23 @@ static sail_status_t alloc_png_state(struct png_state **png_state) {
     (*png_state)->frames         = 0;
     (*png_state)->current_frame  = 0;
 
+    (*png_state)->crop           = false;
+    (*png_state)->crop_x         = 0;
+    (*png_state)->crop_y         = 0;
+    (*png_state)->crop_width     = 0;
+    (*png_state)->crop_height    = 0;
+    (*png_state)->bits_per_pixel = 0;
+    (*png_state)->next_row       = 0;
+    (*png_state)->pass           = 0;
+    (*png_state)->crop_scanline  = NULL;
+    (*png_state)->crop_rows      = NULL;
+
+    (*png_state)->feed_image      = NULL;
+    (*png_state)->feed_valid_rows = 0;
+    (*png_state)->feed_finished   = false;
+
+    (*png_state)->idat_encoder    = NULL;
+
     /* APNG-specific. */
 #ifdef PNG_APNG_SUPPORTED
     (*png_state)->is_apng               = false;
@@ -139,6 +180,11 @@ static void destroy_png_state(struct png_state *png_state) {
     sail_destroy_read_options(png_state->read_options);
     sail_destroy_write_options(png_state->write_options);
 
+    sail_free(png_state->crop_scanline);
+    png_private_destroy_rows(&png_state->crop_rows, png_state->crop_height);
+
+    png_private_destroy_idat_encoder(png_state->idat_encoder);
+
 #ifdef PNG_APNG_SUPPORTED
     sail_free(png_state->temp_scanline);
     sail_free(png_state->scanline_for_skipping);
@@ -150,34 +196,16 @@ static void destroy_png_state(struct png_state *png_state) {
 
     sail_destroy_image(png_state->first_image);
     sail_destroy_iccp(png_state->iccp);
+    sail_destroy_image(png_state->feed_image);
 
     sail_free(png_state);
 }
 
-/*
- * Decoding functions.
- */
-
-SAIL_EXPORT sail_status_t sail_codec_read_init_v4_png(struct sail_io *io, const struct sail_read_options *read_options, void **state) {
-
-    SAIL_CHECK_STATE_PTR(state);
-    *state = NULL;
+/* Deep copies the read options and creates the PNG read structures. */
+static sail_status_t init_png(struct png_state *png_state, const struct sail_read_options *read_options) {
 
-    SAIL_CHECK_IO(io);
-    SAIL_CHECK_READ_OPTIONS_PTR(read_options);
-
-    SAIL_TRY(png_private_supported_read_output_pixel_format(read_options->output_pixel_format));
-
-    /* Allocate a new state. */
-    struct png_state *png_state;
-    SAIL_TRY(alloc_png_state(&png_state));
-
-    *state = png_state;
-
-    /* Deep copy read options. */
     SAIL_TRY(sail_copy_read_options(read_options, &png_state->read_options));
 
-    /* Initialize PNG. */
     if ((png_state->png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, png_private_my_error_fn, png_private_my_warning_fn)) == NULL) {
         png_state->libpng_error = true;
         SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
@@ -188,14 +216,14 @@ SAIL_EXPORT sail_status_t sail_codec_read_init_v4_png(struct sail_io *io, const
         SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
     }
 
-    /* Error handling setup. */
-    if (setjmp(png_jmpbuf(png_state->png_ptr))) {
-        png_state->libpng_error = true;
-        SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
-    }
+    return SAIL_OK;
+}
 
-    png_set_read_fn(png_state->png_ptr, io, png_private_my_read_fn);
-    png_read_info(png_state->png_ptr, png_state->info_ptr);
+/*
+ * Reads the image properties from the read PNG header and sets up the PNG transformations
+ * to output the requested pixel format.
+ */
+static sail_status_t init_image(struct png_state *png_state) {
 
     SAIL_TRY(sail_alloc_image(&png_state->first_image));
     SAIL_TRY(sail_alloc_source_image(&png_state->first_image->source_image));
@@ -227,6 +255,8 @@ SAIL_EXPORT sail_status_t sail_codec_read_init_v4_png(struct sail_io *io, const
         if (png_state->color_type == PNG_COLOR_TYPE_PALETTE) {
             SAIL_TRY(png_private_fetch_palette(png_state->png_ptr, png_state->info_ptr, &png_state->first_image->palette));
         }
+
+        png_private_set_host_byte_order(png_state->png_ptr, png_state->bit_depth);
     } else {
         if (png_state->bit_depth == 16) {
             png_set_strip_16(png_state->png_ptr);
@@ -290,10 +320,27 @@ SAIL_EXPORT sail_status_t sail_codec_read_init_v4_png(struct sail_io *io, const
     /* Apply requested transformations. */
     png_read_update_info(png_state->png_ptr, png_state->info_ptr);
 
+    SAIL_TRY(sail_bits_per_pixel(png_state->first_image->pixel_format, &png_state->bits_per_pixel));
+
+    /* Region of interest. Rows are still decoded in full, but only the requested part is kept. */
+    SAIL_TRY(sail_read_options_crop_rectangle(png_state->read_options,
+                                              png_state->first_image->width, png_state->first_image->height,
+                                              &png_state->crop_x, &png_state->crop_y,
+                                              &png_state->crop_width, &png_state->crop_height));
+
+    png_state->crop = png_state->crop_width != png_state->first_image->width ||
+                        png_state->crop_height != png_state->first_image->height;
+
+    if (png_state->crop) {
+        SAIL_TRY(sail_malloc(png_state->first_image->bytes_per_line, &png_state->crop_scanline));
+
+        if (png_state->first_image->interlaced_passes > 1) {
+            SAIL_TRY(png_private_alloc_rows(&png_state->crop_rows, png_state->first_image->bytes_per_line, png_state->crop_height));
+        }
+    }
+
 #ifdef PNG_APNG_SUPPORTED
-    unsigned bits_per_pixel;
-    SAIL_TRY(sail_bits_per_pixel(png_state->first_image->pixel_format, &bits_per_pixel));
-    png_state->bytes_per_pixel = bits_per_pixel / 8;
+    png_state->bytes_per_pixel = png_state->bits_per_pixel / 8;
 
     png_state->is_apng = png_get_valid(png_state->png_ptr, png_state->info_ptr, PNG_INFO_acTL) != 0;
     png_state->frames = png_state->is_apng ? png_get_num_frames(png_state->png_ptr, png_state->info_ptr) : 1;
@@ -340,6 +387,42 @@ SAIL_EXPORT sail_status_t sail_codec_read_init_v4_png(struct sail_io *io, const
     return SAIL_OK;
 }
 
+/*
+ * Decoding functions.
+ */
+
+SAIL_EXPORT sail_status_t sail_codec_read_init_v4_png(struct sail_io *io, const struct sail_read_options *read_options, void **state) {
+
+    SAIL_CHECK_STATE_PTR(state);
+    *state = NULL;
+
+    SAIL_CHECK_IO(io);
+    SAIL_CHECK_READ_OPTIONS_PTR(read_options);
+
+    SAIL_TRY(png_private_supported_read_output_pixel_format(read_options->output_pixel_format));
+
+    /* Allocate a new state. */
+    struct png_state *png_state;
+    SAIL_TRY(alloc_png_state(&png_state));
+
+    *state = png_state;
+
+    SAIL_TRY(init_png(png_state, read_options));
+
+    /* Error handling setup. */
+    if (setjmp(png_jmpbuf(png_state->png_ptr))) {
+        png_state->libpng_error = true;
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
+    }
+
+    png_set_read_fn(png_state->png_ptr, io, png_private_my_read_fn);
+    png_read_info(png_state->png_ptr, png_state->info_ptr);
+
+    SAIL_TRY(init_image(png_state));
+
+    return SAIL_OK;
+}
+
 SAIL_EXPORT sail_status_t sail_codec_read_seek_next_frame_v4_png(void *state, struct sail_io *io, struct sail_image **image) {
 
     SAIL_CHECK_STATE_PTR(state);
@@ -364,6 +447,16 @@ SAIL_EXPORT sail_status_t sail_codec_read_seek_next_frame_v4_png(void *state, st
 
     SAIL_TRY(sail_copy_image(png_state->first_image, image));
 
+    if (png_state->crop) {
+        (*image)->width  = png_state->crop_width;
+        (*image)->height = png_state->crop_height;
+        SAIL_TRY_OR_CLEANUP(sail_bytes_per_line((*image)->width, (*image)->pixel_format, &(*image)->bytes_per_line),
+                            /* cleanup */ sail_destroy_image(*image));
+    }
+
+    png_state->next_row = 0;
+    png_state->pass     = 0;
+
     /* Only the first frame can have ICCP (if any). */
     if (png_state->current_frame == 0) {
         if (png_state->iccp != NULL) {
@@ -408,16 +501,16 @@ SAIL_EXPORT sail_status_t sail_codec_read_seek_next_frame_v4_png(void *state, st
                                         &png_state->next_frame_delay_num, &png_state->next_frame_delay_den,
                                         &png_state->next_frame_dispose_op, &png_state->next_frame_blend_op);
             } else {
-                png_state->next_frame_width      = (*image)->width;
-                png_state->next_frame_height     = (*image)->height;
+                png_state->next_frame_width      = png_state->first_image->width;
+                png_state->next_frame_height     = png_state->first_image->height;
                 png_state->next_frame_x_offset   = 0;
                 png_state->next_frame_y_offset   = 0;
                 png_state->next_frame_dispose_op = PNG_DISPOSE_OP_BACKGROUND;
                 png_state->next_frame_blend_op   = PNG_BLEND_OP_SOURCE;
             }
 
-            if (png_state->next_frame_width + png_state->next_frame_x_offset > (*image)->width ||
-                    png_state->next_frame_height + png_state->next_frame_y_offset > (*image)->height) {
+            if (png_state->next_frame_width + png_state->next_frame_x_offset > png_state->first_image->width ||
+                    png_state->next_frame_height + png_state->next_frame_y_offset > png_state->first_image->height) {
                 SAIL_LOG_AND_RETURN(SAIL_ERROR_INCORRECT_IMAGE_DIMENSIONS);
             }
 
@@ -447,14 +540,145 @@ SAIL_EXPORT sail_status_t sail_codec_read_seek_next_pass_v4_png(void *state, str
         SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
     }
 
+    png_state->pass++;
+    png_state->next_row = 0;
+
     return SAIL_OK;
 }
 
-SAIL_EXPORT sail_status_t sail_codec_read_frame_v4_png(void *state, struct sail_io *io, struct sail_image *image) {
+#ifdef PNG_APNG_SUPPORTED
+/* Composes the specified canvas row of the current APNG frame into the scan line. */
+static sail_status_t read_apng_row(struct png_state *png_state, unsigned row, unsigned char *scanline) {
+
+    const unsigned bytes_per_pixel = png_state->bytes_per_pixel;
+    const size_t canvas_length = (size_t)png_state->first_image->width * bytes_per_pixel;
+    const size_t frame_offset  = (size_t)png_state->next_frame_x_offset * bytes_per_pixel;
+    const size_t frame_length  = (size_t)png_state->next_frame_width * bytes_per_pixel;
+    const bool blend_source = png_state->current_frame == 1 || png_state->next_frame_blend_op == PNG_BLEND_OP_SOURCE;
+
+    /* Rows outside of the frame region are the previous canvas as is. */
+    if (row < png_state->next_frame_y_offset || row >= png_state->next_frame_y_offset + png_state->next_frame_height) {
+        memcpy(scanline, png_state->prev[row], canvas_length);
+        return SAIL_OK;
+    }
+
+    /* Only the parts of the canvas to the left and to the right of the frame are untouched. */
+    memcpy(scanline, png_state->prev[row], frame_offset);
+    memcpy(scanline + frame_offset + frame_length,
+            png_state->prev[row] + frame_offset + frame_length,
+            canvas_length - frame_offset - frame_length);
+
+    if (blend_source) {
+        /* Copy all pixel values including alpha right into the frame region. */
+        png_read_row(png_state->png_ptr, scanline + frame_offset, NULL);
+    } else { /* PNG_BLEND_OP_OVER */
+        memcpy(scanline + frame_offset, png_state->prev[row] + frame_offset, frame_length);
+        png_read_row(png_state->png_ptr, (png_bytep)png_state->temp_scanline, NULL);
+
+        SAIL_TRY(png_private_blend_over(scanline,
+                            png_state->next_frame_x_offset,
+                            png_state->temp_scanline,
+                            png_state->next_frame_width,
+                            png_state->first_image->pixel_format));
+    }
+
+    if (png_state->next_frame_dispose_op == PNG_DISPOSE_OP_BACKGROUND) {
+        memset(png_state->prev[row] + frame_offset, 0, frame_length);
+    } else if (png_state->next_frame_dispose_op == PNG_DISPOSE_OP_NONE) {
+        memcpy(png_state->prev[row] + frame_offset, scanline + frame_offset, frame_length);
+    } else { /* PNG_DISPOSE_OP_PREVIOUS */
+    }
+
+    return SAIL_OK;
+}
+#endif
+
+/* Reads the specified row of the full image into the scan line. */
+static sail_status_t read_row(struct png_state *png_state, unsigned row, unsigned char *scanline) {
+
+#ifdef PNG_APNG_SUPPORTED
+    if (png_state->is_apng) {
+        SAIL_TRY(read_apng_row(png_state, row, scanline));
+        return SAIL_OK;
+    }
+#endif
+
+    (void)row;
+    png_read_row(png_state->png_ptr, scanline, NULL);
+
+    return SAIL_OK;
+}
+
+/* Reads the full rows into a scratch scan line and keeps only the region of interest. */
+static sail_status_t read_cropped_rows(struct png_state *png_state, const struct sail_image *image,
+                                        unsigned first_row, unsigned row_count, void *rows) {
+
+    const unsigned scanline_length = png_state->first_image->bytes_per_line;
+    const unsigned first_bit = png_state->crop_x * png_state->bits_per_pixel;
+    const unsigned crop_end = png_state->crop_y + png_state->crop_height;
+
+#ifdef PNG_APNG_SUPPORTED
+    /* The rest of an APNG frame still updates the canvas for the next frames. */
+    const bool read_to_end = png_state->is_apng;
+#else
+    const bool read_to_end = false;
+#endif
+
+    /* Interlaced images are read pass by pass, every pass covers all the rows. */
+    if (image->interlaced_passes > 1) {
+        const bool last_pass = png_state->pass == (unsigned)image->interlaced_passes;
+        const unsigned row_end = (last_pass && !read_to_end) ? crop_end : png_state->first_image->height;
+
+        for (unsigned row = 0; row < row_end; row++) {
+            if (row < png_state->crop_y || row >= crop_end) {
+                SAIL_TRY(read_row(png_state, row, png_state->crop_scanline));
+                continue;
+            }
+
+            /* Later passes fill in the pixels of the earlier ones, so the full rows are kept. */
+            unsigned char *scanline = png_state->crop_rows[row - png_state->crop_y];
+            SAIL_TRY(read_row(png_state, row, scanline));
+
+            png_private_crop_row(scanline, scanline_length, first_bit,
+                                    (unsigned char *)rows + (size_t)(row - png_state->crop_y) * image->bytes_per_line,
+                                    image->bytes_per_line);
+        }
+
+        return SAIL_OK;
+    }
+
+    /* Skip the rows above the region. */
+    const unsigned first_source_row = png_state->crop_y + first_row;
+
+    for (; png_state->next_row < first_source_row; png_state->next_row++) {
+        SAIL_TRY(read_row(png_state, png_state->next_row, png_state->crop_scanline));
+    }
+
+    for (unsigned row = 0; row < row_count; row++, png_state->next_row++) {
+        SAIL_TRY(read_row(png_state, png_state->next_row, png_state->crop_scanline));
+
+        png_private_crop_row(png_state->crop_scanline, scanline_length, first_bit,
+                                (unsigned char *)rows + (size_t)row * image->bytes_per_line,
+                                image->bytes_per_line);
+    }
+
+    /* Stop after the last needed row. */
+    if (read_to_end && first_row + row_count == image->height) {
+        for (; png_state->next_row < png_state->first_image->height; png_state->next_row++) {
+            SAIL_TRY(read_row(png_state, png_state->next_row, png_state->crop_scanline));
+        }
+    }
+
+    return SAIL_OK;
+}
+
+SAIL_EXPORT sail_status_t sail_codec_read_rows_v4_png(void *state, struct sail_io *io, const struct sail_image *image,
+                                                       unsigned first_row, unsigned row_count, void *rows) {
 
     SAIL_CHECK_STATE_PTR(state);
     SAIL_CHECK_IO(io);
     SAIL_CHECK_IMAGE(image);
+    SAIL_CHECK_BUFFER_PTR(rows);
 
     struct png_state *png_state = (struct png_state *)state;
 
@@ -467,54 +691,35 @@ SAIL_EXPORT sail_status_t sail_codec_read_frame_v4_png(void *state, struct sail_
         SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
     }
 
+    if (png_state->crop) {
+        SAIL_TRY(read_cropped_rows(png_state, image, first_row, row_count, rows));
+        return SAIL_OK;
+    }
+
 #ifdef PNG_APNG_SUPPORTED
     if (png_state->is_apng) {
-        for (unsigned row = 0; row < image->height; row++) {
-            unsigned char *scanline = (unsigned char *)image->pixels + row * image->bytes_per_line;
-
-            memcpy(scanline, png_state->prev[row], png_state->first_image->width * png_state->bytes_per_pixel);
-
-            if (row >= png_state->next_frame_y_offset && row < png_state->next_frame_y_offset + png_state->next_frame_height) {
-                png_read_row(png_state->png_ptr, (png_bytep)png_state->temp_scanline, NULL);
-
-                /* Copy all pixel values including alpha. */
-                if (png_state->current_frame == 1 || png_state->next_frame_blend_op == PNG_BLEND_OP_SOURCE) {
-                    SAIL_TRY(png_private_blend_source(scanline,
-                                            png_state->next_frame_x_offset,
-                                            png_state->temp_scanline,
-                                            png_state->next_frame_width,
-                                            png_state->bytes_per_pixel));
-                } else { /* PNG_BLEND_OP_OVER */
-                    SAIL_TRY(png_private_blend_over(scanline,
-                                        png_state->next_frame_x_offset,
-                                        png_state->temp_scanline,
-                                        png_state->next_frame_width,
-                                        png_state->bytes_per_pixel));
-                }
-
-                if (png_state->next_frame_dispose_op == PNG_DISPOSE_OP_BACKGROUND) {
-                    memset(png_state->prev[row] + png_state->next_frame_x_offset * png_state->bytes_per_pixel,
-                            0,
-                            png_state->next_frame_width * png_state->bytes_per_pixel);
-                } else if (png_state->next_frame_dispose_op == PNG_DISPOSE_OP_NONE) {
-                    memcpy(png_state->prev[row] + png_state->next_frame_x_offset * png_state->bytes_per_pixel,
-                            scanline,
-                            png_state->next_frame_width * png_state->bytes_per_pixel);
-                } else { /* PNG_DISPOSE_OP_PREVIOUS */
-                }
-            }
+        for (unsigned row = first_row; row < first_row + row_count; row++) {
+            SAIL_TRY(read_apng_row(png_state, row, (unsigned char *)rows + (size_t)(row - first_row) * image->bytes_per_line));
         }
-    } else {
-        for (unsigned row = 0; row < image->height; row++) {
-            png_read_row(png_state->png_ptr, (unsigned char *)image->pixels + row * image->bytes_per_line, NULL);
-        }
-    }
-#else
-    for (unsigned row = 0; row < image->height; row++) {
-        png_read_row(png_state->png_ptr, (unsigned char *)image->pixels + row * image->bytes_per_line, NULL);
+
+        return SAIL_OK;
     }
 #endif
 
+    for (unsigned row = 0; row < row_count; row++) {
+        png_read_row(png_state->png_ptr, (unsigned char *)rows + (size_t)row * image->bytes_per_line, NULL);
+    }
+
+    return SAIL_OK;
+}
+
+SAIL_EXPORT sail_status_t sail_codec_read_frame_v4_png(void *state, struct sail_io *io, struct sail_image *image) {
+
+    SAIL_CHECK_IMAGE(image);
+
+    /* Interlaced images are read pass by pass, every pass covers all the rows. */
+    SAIL_TRY(sail_codec_read_rows_v4_png(state, io, image, /* first row */ 0, image->height, image->pixels));
+
     return SAIL_OK;
 }
 
@@ -544,6 +749,155 @@ SAIL_EXPORT sail_status_t sail_codec_read_finish_v4_png(void **state, struct sai
     return SAIL_OK;
 }
 
+/*
+ * Incremental decoding functions.
+ */
+
+/* Allocates the image to decode the rows into. Interlaced rows are combined from zeroed pixels. */
+static sail_status_t init_feed_image(struct png_state *png_state) {
+
+    SAIL_TRY(init_image(png_state));
+
+    SAIL_TRY(sail_copy_image(png_state->first_image, &png_state->feed_image));
+
+    if (png_state->iccp != NULL) {
+        SAIL_TRY(sail_copy_iccp(png_state->iccp, &png_state->feed_image->iccp));
+    }
+
+    const size_t pixels_size = (size_t)png_state->feed_image->height * png_state->feed_image->bytes_per_line;
+
+    SAIL_TRY(sail_malloc_pixels(pixels_size, &png_state->feed_image->pixels));
+
+    memset(png_state->feed_image->pixels, 0, pixels_size);
+
+    return SAIL_OK;
+}
+
+static void feed_info_callback(png_structp png_ptr, png_infop info_ptr) {
+
+    (void)info_ptr;
+
+    struct png_state *png_state = png_get_progressive_ptr(png_ptr);
+
+    if (init_feed_image(png_state) != SAIL_OK) {
+        png_error(png_ptr, "Failed to initialize the image");
+    }
+}
+
+static void feed_row_callback(png_structp png_ptr, png_bytep new_row, png_uint_32 row_num, int pass) {
+
+    struct png_state *png_state = png_get_progressive_ptr(png_ptr);
+    struct sail_image *image = png_state->feed_image;
+
+    /* The row has no pixels in this pass. */
+    if (new_row == NULL) {
+        return;
+    }
+
+    png_progressive_combine_row(png_ptr, (png_bytep)image->pixels + (size_t)row_num * image->bytes_per_line, new_row);
+
+    /*
+     * Rows of the last pass are final as well as all the rows above them. The last pass of interlaced images
+     * has only odd rows, so its last row also finishes the last even row.
+     */
+    if (image->interlaced_passes == 1) {
+        png_state->feed_valid_rows = row_num + 1;
+    } else if (pass == image->interlaced_passes - 1) {
+        png_state->feed_valid_rows = (row_num + 2 >= image->height) ? image->height : row_num + 1;
+    }
+}
+
+static void feed_end_callback(png_structp png_ptr, png_infop info_ptr) {
+
+    (void)info_ptr;
+
+    struct png_state *png_state = png_get_progressive_ptr(png_ptr);
+
+    png_state->feed_valid_rows = png_state->feed_image->height;
+    png_state->feed_finished   = true;
+}
+
+SAIL_EXPORT sail_status_t sail_codec_feed_init_v4_png(const struct sail_read_options *read_options, void **state) {
+
+    SAIL_CHECK_STATE_PTR(state);
+    *state = NULL;
+
+    SAIL_CHECK_READ_OPTIONS_PTR(read_options);
+
+    SAIL_TRY(png_private_supported_read_output_pixel_format(read_options->output_pixel_format));
+
+    /* Allocate a new state. */
+    struct png_state *png_state;
+    SAIL_TRY(alloc_png_state(&png_state));
+
+    *state = png_state;
+
+    SAIL_TRY(init_png(png_state, read_options));
+
+    /* Error handling setup. */
+    if (setjmp(png_jmpbuf(png_state->png_ptr))) {
+        png_state->libpng_error = true;
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
+    }
+
+    png_set_progressive_read_fn(png_state->png_ptr, png_state, feed_info_callback, feed_row_callback, feed_end_callback);
+
+    return SAIL_OK;
+}
+
+SAIL_EXPORT sail_status_t sail_codec_feed_v4_png(void *state, const void *buffer, size_t buffer_length,
+                                                  const struct sail_image **image, unsigned *valid_rows) {
+
+    SAIL_CHECK_STATE_PTR(state);
+    SAIL_CHECK_IMAGE_PTR(image);
+    SAIL_CHECK_RESULT_PTR(valid_rows);
+
+    struct png_state *png_state = (struct png_state *)state;
+
+    if (png_state->libpng_error) {
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
+    }
+
+    /*
+     * The first frame is complete when all its rows are decoded. Don't feed the rest of the data
+     * like APNG frames to libpng.
+     */
+    const bool complete = png_state->feed_finished ||
+                            (png_state->feed_image != NULL && png_state->feed_valid_rows == png_state->feed_image->height);
+
+    if (buffer != NULL && buffer_length > 0 && !complete) {
+        if (setjmp(png_jmpbuf(png_state->png_ptr))) {
+            png_state->libpng_error = true;
+            SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
+        }
+
+        png_process_data(png_state->png_ptr, png_state->info_ptr, (png_bytep)buffer, buffer_length);
+    }
+
+    *image      = png_state->feed_image;
+    *valid_rows = png_state->feed_valid_rows;
+
+    return SAIL_OK;
+}
+
+SAIL_EXPORT sail_status_t sail_codec_feed_finish_v4_png(void **state) {
+
+    SAIL_CHECK_STATE_PTR(state);
+
+    struct png_state *png_state = (struct png_state *)(*state);
+
+    /* Subsequent calls to finish() will expectedly fail in the above line. */
+    *state = NULL;
+
+    if (png_state->png_ptr != NULL) {
+        png_destroy_read_struct(&png_state->png_ptr, &png_state->info_ptr, NULL);
+    }
+
+    destroy_png_state(png_state);
+
+    return SAIL_OK;
+}
+
 /*
  * Encoding functions.
  */
@@ -674,8 +1028,14 @@ SAIL_EXPORT sail_status_t sail_codec_write_seek_next_frame_v4_png(void *state, s
 
     png_set_compression_level(png_state->png_ptr, (int)compression);
 
+    if (png_state->write_options->filter != SAIL_FILTER_DEFAULT) {
+        png_set_filter(png_state->png_ptr, PNG_FILTER_TYPE_BASE, png_private_filter_to_png_filters(png_state->write_options->filter));
+    }
+
     png_write_info(png_state->png_ptr, png_state->info_ptr);
 
+    png_private_set_host_byte_order(png_state->png_ptr, bit_depth);
+
     if (image->pixel_format == SAIL_PIXEL_FORMAT_BPP24_BGR      ||
             image->pixel_format == SAIL_PIXEL_FORMAT_BPP48_BGR  ||
             image->pixel_format == SAIL_PIXEL_FORMAT_BPP32_BGRA ||
@@ -696,6 +1056,19 @@ SAIL_EXPORT sail_status_t sail_codec_write_seek_next_frame_v4_png(void *state, s
         png_set_interlace_handling(png_state->png_ptr);
     }
 
+    if (png_state->write_options->threads > 1) {
+        SAIL_TRY(png_private_alloc_idat_encoder(png_state->write_options->threads,
+                                                (int)compression,
+                                                png_state->write_options->filter,
+                                                image->pixel_format,
+                                                image->width,
+                                                image->height,
+                                                png_state->write_options->io_options & SAIL_IO_OPTION_INTERLACED,
+                                                &png_state->idat_encoder));
+
+        SAIL_LOG_DEBUG("PNG: Encoding with %u threads", png_state->write_options->threads);
+    }
+
     const char *pixel_format_str;
     SAIL_TRY_OR_SUPPRESS(sail_pixel_format_to_string(image->pixel_format, &pixel_format_str));
     SAIL_LOG_DEBUG("PNG: Input pixel format is %s", pixel_format_str);
@@ -732,8 +1105,12 @@ SAIL_EXPORT sail_status_t sail_codec_write_frame_v4_png(void *state, struct sail
         SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
     }
 
-    for (unsigned row = 0; row < image->height; row++) {
-        png_write_row(png_state->png_ptr, (const unsigned char *)image->pixels + row * image->bytes_per_line);
+    if (png_state->idat_encoder != NULL) {
+        SAIL_TRY(png_private_write_idat(png_state->idat_encoder, png_state->png_ptr, image));
+    } else {
+        for (unsigned row = 0; row < image->height; row++) {
+            png_write_row(png_state->png_ptr, (const unsigned char *)image->pixels + row * image->bytes_per_line);
+        }
     }
 
     return SAIL_OK;
@@ -758,7 +1135,13 @@ SAIL_EXPORT sail_status_t sail_codec_write_finish_v4_png(void **state, struct sa
     }
 
     if (png_state->png_ptr != NULL && !png_state->libpng_error) {
-        png_write_end(png_state->png_ptr, png_state->info_ptr);
+        if (png_state->idat_encoder != NULL) {
+            /* libpng hasn't seen the IDAT chunks written in parallel. */
+            png_write_chunk(png_state->png_ptr, (png_const_bytep)"IEND", NULL, 0);
+            png_private_my_flush_fn(png_state->png_ptr);
+        } else {
+            png_write_end(png_state->png_ptr, png_state->info_ptr);
+        }
     }
 
     if (png_state->png_ptr != NULL) {
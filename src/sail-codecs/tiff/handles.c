@@ -0,0 +1,336 @@
+/*  This file is part of SAIL (https://github.com/smoked-herring/sail)
+
+    Copyright (c) 2020 Dmitry Baryshev
+
+    The MIT License
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "sail-common.h"
+
+#ifdef SAIL_WIN32
+    #include <windows.h>
+#else
+    #include <pthread.h>
+#endif
+
+#include "handles.h"
+#include "io.h"
+
+#ifdef SAIL_WIN32
+typedef SRWLOCK tiff_lock_t;
+#else
+typedef pthread_mutex_t tiff_lock_t;
+#endif
+
+struct tiff_handle {
+    struct tiff_handles *handles;
+    TIFF *tiff;
+    /* Position in the shared I/O object. */
+    toff_t position;
+    unsigned char *tile;
+};
+
+struct tiff_handles {
+    struct sail_io *io;
+
+    /* Whole memory buffer of the I/O object if it's available. */
+    const unsigned char *buffer;
+    size_t buffer_length;
+
+    tiff_lock_t io_lock;
+
+    struct tiff_handle *handles;
+    unsigned count;
+};
+
+/*
+ * Private functions.
+ */
+
+static void init_lock(tiff_lock_t *lock) {
+
+#ifdef SAIL_WIN32
+    InitializeSRWLock(lock);
+#else
+    pthread_mutex_init(lock, NULL);
+#endif
+}
+
+static void destroy_lock(tiff_lock_t *lock) {
+
+#ifdef SAIL_WIN32
+    (void)lock;
+#else
+    pthread_mutex_destroy(lock);
+#endif
+}
+
+static void lock(tiff_lock_t *lock) {
+
+#ifdef SAIL_WIN32
+    AcquireSRWLockExclusive(lock);
+#else
+    pthread_mutex_lock(lock);
+#endif
+}
+
+static void unlock(tiff_lock_t *lock) {
+
+#ifdef SAIL_WIN32
+    ReleaseSRWLockExclusive(lock);
+#else
+    pthread_mutex_unlock(lock);
+#endif
+}
+
+static tmsize_t handle_read_proc(thandle_t client_data, void *buffer, tmsize_t buffer_size) {
+
+    struct tiff_handle *handle = (struct tiff_handle *)client_data;
+    struct tiff_handles *handles = handle->handles;
+    size_t nbytes;
+
+    if (handles->buffer != NULL) {
+        if (handle->position >= handles->buffer_length) {
+            return 0;
+        }
+
+        nbytes = handles->buffer_length - (size_t)handle->position;
+        nbytes = ((size_t)buffer_size < nbytes) ? (size_t)buffer_size : nbytes;
+
+        memcpy(buffer, handles->buffer + handle->position, nbytes);
+    } else {
+        struct sail_io *io = handles->io;
+
+        lock(&handles->io_lock);
+
+        sail_status_t err = io->seek(io->stream, (long)handle->position, SEEK_SET);
+
+        if (err == SAIL_OK) {
+            err = io->tolerant_read(io->stream, buffer, buffer_size, &nbytes);
+        }
+
+        unlock(&handles->io_lock);
+
+        if (err != SAIL_OK) {
+            TIFFError(NULL, "Failed to read from the I/O stream: %d", err);
+            return (tmsize_t)-1;
+        }
+    }
+
+    handle->position += nbytes;
+
+    return (tmsize_t)nbytes;
+}
+
+static tmsize_t handle_write_proc(thandle_t client_data, void *buffer, tmsize_t buffer_size) {
+
+    (void)client_data;
+    (void)buffer;
+    (void)buffer_size;
+
+    return (tmsize_t)-1;
+}
+
+static toff_t handle_seek_proc(thandle_t client_data, toff_t offset, int whence) {
+
+    struct tiff_handle *handle = (struct tiff_handle *)client_data;
+    struct tiff_handles *handles = handle->handles;
+
+    switch (whence) {
+        case SEEK_SET: {
+            handle->position = offset;
+            break;
+        }
+        case SEEK_CUR: {
+            handle->position += offset;
+            break;
+        }
+        case SEEK_END: {
+            size_t size;
+
+            if (handles->buffer != NULL) {
+                size = handles->buffer_length;
+            } else {
+                struct sail_io *io = handles->io;
+
+                lock(&handles->io_lock);
+
+                sail_status_t err = io->seek(io->stream, 0, SEEK_END);
+
+                if (err == SAIL_OK) {
+                    err = io->tell(io->stream, &size);
+                }
+
+                unlock(&handles->io_lock);
+
+                if (err != SAIL_OK) {
+                    TIFFError(NULL, "Failed to seek the I/O stream: %d", err);
+                    return (toff_t)-1;
+                }
+            }
+
+            handle->position = size + offset;
+            break;
+        }
+        default: {
+            return (toff_t)-1;
+        }
+    }
+
+    return handle->position;
+}
+
+/*
+ * Public functions.
+ */
+
+sail_status_t tiff_private_alloc_handles(struct sail_io *io, unsigned workers, struct tiff_handles **handles) {
+
+    SAIL_CHECK_IO(io);
+    SAIL_CHECK_PTR(handles);
+
+    if (workers == 0) {
+        SAIL_LOG_ERROR("TIFF: Number of workers must be positive");
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_INVALID_ARGUMENT);
+    }
+
+    void *ptr;
+    SAIL_TRY(sail_malloc(sizeof(struct tiff_handles), &ptr));
+    struct tiff_handles *result = ptr;
+
+    SAIL_TRY_OR_CLEANUP(sail_malloc(sizeof(struct tiff_handle) * workers, &ptr),
+                        /* cleanup */ sail_free(result));
+    result->handles = ptr;
+
+    const void *buffer;
+    size_t buffer_length;
+
+    if (io->buffer != NULL && io->buffer(io->stream, &buffer, &buffer_length) == SAIL_OK) {
+        result->buffer        = buffer;
+        result->buffer_length = buffer_length;
+    } else {
+        result->buffer        = NULL;
+        result->buffer_length = 0;
+    }
+
+    result->io    = io;
+    result->count = workers;
+
+    init_lock(&result->io_lock);
+
+    for (unsigned i = 0; i < workers; i++) {
+        result->handles[i].handles  = result;
+        result->handles[i].tiff     = NULL;
+        result->handles[i].position = 0;
+        result->handles[i].tile     = NULL;
+    }
+
+    *handles = result;
+
+    return SAIL_OK;
+}
+
+void tiff_private_destroy_handles(struct tiff_handles *handles) {
+
+    if (handles == NULL) {
+        return;
+    }
+
+    for (unsigned i = 0; i < handles->count; i++) {
+        if (handles->handles[i].tiff != NULL) {
+            TIFFCleanup(handles->handles[i].tiff);
+        }
+
+        sail_free(handles->handles[i].tile);
+    }
+
+    destroy_lock(&handles->io_lock);
+
+    sail_free(handles->handles);
+    sail_free(handles);
+}
+
+sail_status_t tiff_private_handles_set_directory(struct tiff_handles *handles, uint16_t directory, tmsize_t tile_size) {
+
+    SAIL_CHECK_PTR(handles);
+
+    for (unsigned i = 0; i < handles->count; i++) {
+        struct tiff_handle *handle = &handles->handles[i];
+
+        if (handle->tiff == NULL) {
+            handle->tiff = TIFFClientOpen("tiff-sail-codec",
+                                          "rhm",
+                                          handle,
+                                          handle_read_proc,
+                                          handle_write_proc,
+                                          handle_seek_proc,
+                                          tiff_private_my_dummy_close_proc,
+                                          tiff_private_my_dummy_size_proc,
+                                          /* map */ NULL,
+                                          /* unmap */ NULL);
+
+            if (handle->tiff == NULL) {
+                SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
+            }
+        }
+
+        if (!TIFFSetDirectory(handle->tiff, directory)) {
+            SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
+        }
+    }
+
+    SAIL_TRY(tiff_private_handles_set_tile_size(handles, tile_size));
+
+    return SAIL_OK;
+}
+
+sail_status_t tiff_private_handles_set_tile_size(struct tiff_handles *handles, tmsize_t tile_size) {
+
+    SAIL_CHECK_PTR(handles);
+
+    for (unsigned i = 0; i < handles->count; i++) {
+        struct tiff_handle *handle = &handles->handles[i];
+
+        sail_free(handle->tile);
+        handle->tile = NULL;
+
+        void *ptr;
+        SAIL_TRY(sail_malloc((size_t)tile_size, &ptr));
+        handle->tile = ptr;
+    }
+
+    return SAIL_OK;
+}
+
+TIFF *tiff_private_handle(const struct tiff_handles *handles, unsigned worker) {
+
+    return handles->handles[worker].tiff;
+}
+
+unsigned char *tiff_private_handle_tile(const struct tiff_handles *handles, unsigned worker) {
+
+    return handles->handles[worker].tile;
+}
@@ -0,0 +1,64 @@
+/*  This file is part of SAIL (https://github.com/smoked-herring/sail)
+
+    Copyright (c) 2020 Dmitry Baryshev
+
+    The MIT License
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#ifndef SAIL_TIFF_HANDLES_H
+#define SAIL_TIFF_HANDLES_H
+
+#include <stdint.h>
+
+#include <tiffio.h>
+
+#include "common.h"
+#include "error.h"
+#include "export.h"
+
+struct sail_io;
+
+/*
+ * Private TIFF handles and tile buffers of the threads decoding or encoding strips and tiles. Every worker
+ * of the thread pool gets a separate TIFF handle opened over the shared I/O object, so workers decode
+ * strips and tiles concurrently. Reads from memory buffers are lock-free, other I/O objects are accessed
+ * under a lock. Encoding uses the tile buffers only.
+ */
+struct tiff_handles;
+
+/* Allocates handles for the specified number of workers. TIFF handles are opened later. */
+SAIL_HIDDEN sail_status_t tiff_private_alloc_handles(struct sail_io *io, unsigned workers, struct tiff_handles **handles);
+
+SAIL_HIDDEN void tiff_private_destroy_handles(struct tiff_handles *handles);
+
+/* Switches all TIFF handles to the specified directory and reallocates the tile buffers. */
+SAIL_HIDDEN sail_status_t tiff_private_handles_set_directory(struct tiff_handles *handles, uint16_t directory, tmsize_t tile_size);
+
+/* Reallocates the tile buffers without opening TIFF handles. */
+SAIL_HIDDEN sail_status_t tiff_private_handles_set_tile_size(struct tiff_handles *handles, tmsize_t tile_size);
+
+/* Returns the TIFF handle of the worker. See sail_thread_pool_job_t. */
+SAIL_HIDDEN TIFF *tiff_private_handle(const struct tiff_handles *handles, unsigned worker);
+
+/* Returns the tile buffer of the worker. It has the size passed to tiff_private_handles_set_tile_size(). */
+SAIL_HIDDEN unsigned char *tiff_private_handle_tile(const struct tiff_handles *handles, unsigned worker);
+
+#endif
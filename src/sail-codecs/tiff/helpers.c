@@ -277,6 +277,54 @@ sail_status_t tiff_private_sail_compression_to_compression(enum SailCompression
     }
 }
 
+bool tiff_private_predictor_supported(int compression) {
+
+    switch (compression) {
+#ifdef HAVE_TIFF_WRITE_ADOBE_DEFLATE
+        case COMPRESSION_ADOBE_DEFLATE:
+#endif
+#ifdef HAVE_TIFF_WRITE_DEFLATE
+        case COMPRESSION_DEFLATE:
+#endif
+#ifdef HAVE_TIFF_WRITE_LZMA
+        case COMPRESSION_LZMA:
+#endif
+#ifdef HAVE_TIFF_WRITE_LZW
+        case COMPRESSION_LZW:
+#endif
+#ifdef HAVE_TIFF_WRITE_ZSTD
+        case COMPRESSION_ZSTD:
+#endif
+        {
+            return true;
+        }
+
+        default: {
+            return false;
+        }
+    }
+}
+
+bool tiff_private_compression_is_independent(int compression) {
+
+    if (tiff_private_predictor_supported(compression)) {
+        return true;
+    }
+
+    switch (compression) {
+#ifdef HAVE_TIFF_WRITE_PACKBITS
+        case COMPRESSION_PACKBITS:
+#endif
+        case COMPRESSION_NONE: {
+            return true;
+        }
+
+        default: {
+            return false;
+        }
+    }
+}
+
 enum SailPixelFormat tiff_private_bpp_to_pixel_format(int bpp) {
 
     switch (bpp) {
@@ -420,6 +468,31 @@ sail_status_t tiff_private_supported_write_output_pixel_format(enum SailPixelFor
     }
 }
 
+sail_status_t tiff_private_write_layout(enum SailPixelFormat pixel_format, struct tiff_native_layout *layout) {
+
+    SAIL_CHECK_PTR(layout);
+
+    switch (pixel_format) {
+        case SAIL_PIXEL_FORMAT_BPP8_GRAYSCALE:        layout->photometric = PHOTOMETRIC_MINISBLACK; layout->bits_per_sample = 8;  layout->samples_per_pixel = 1; break;
+        case SAIL_PIXEL_FORMAT_BPP16_GRAYSCALE:       layout->photometric = PHOTOMETRIC_MINISBLACK; layout->bits_per_sample = 16; layout->samples_per_pixel = 1; break;
+        case SAIL_PIXEL_FORMAT_BPP16_GRAYSCALE_ALPHA: layout->photometric = PHOTOMETRIC_MINISBLACK; layout->bits_per_sample = 8;  layout->samples_per_pixel = 2; break;
+        case SAIL_PIXEL_FORMAT_BPP32_GRAYSCALE_ALPHA: layout->photometric = PHOTOMETRIC_MINISBLACK; layout->bits_per_sample = 16; layout->samples_per_pixel = 2; break;
+        case SAIL_PIXEL_FORMAT_BPP24_RGB:             layout->photometric = PHOTOMETRIC_RGB;        layout->bits_per_sample = 8;  layout->samples_per_pixel = 3; break;
+        case SAIL_PIXEL_FORMAT_BPP48_RGB:             layout->photometric = PHOTOMETRIC_RGB;        layout->bits_per_sample = 16; layout->samples_per_pixel = 3; break;
+        case SAIL_PIXEL_FORMAT_BPP32_RGBA:            layout->photometric = PHOTOMETRIC_RGB;        layout->bits_per_sample = 8;  layout->samples_per_pixel = 4; break;
+        case SAIL_PIXEL_FORMAT_BPP64_RGBA:            layout->photometric = PHOTOMETRIC_RGB;        layout->bits_per_sample = 16; layout->samples_per_pixel = 4; break;
+
+        default: {
+            SAIL_LOG_AND_RETURN(SAIL_ERROR_UNSUPPORTED_PIXEL_FORMAT);
+        }
+    }
+
+    layout->alpha        = layout->samples_per_pixel == 2 || layout->samples_per_pixel == 4;
+    layout->pixel_format = pixel_format;
+
+    return SAIL_OK;
+}
+
 sail_status_t tiff_private_fetch_resolution(TIFF *tiff, struct sail_resolution **resolution) {
 
     SAIL_CHECK_RESOLUTION_PTR(resolution);
@@ -485,3 +558,260 @@ sail_status_t tiff_private_write_resolution(TIFF *tiff, const struct sail_resolu
 
     return SAIL_OK;
 }
+
+bool tiff_private_fetch_native_layout(TIFF *tiff, struct tiff_native_layout *layout) {
+
+    uint16_t planar_config;
+    uint16_t sample_format;
+    uint16_t orientation;
+    uint16_t extra_samples_count;
+    uint16_t *extra_samples;
+    int compression = COMPRESSION_NONE;
+
+    TIFFGetFieldDefaulted(tiff, TIFFTAG_PLANARCONFIG,    &planar_config);
+    TIFFGetFieldDefaulted(tiff, TIFFTAG_SAMPLEFORMAT,    &sample_format);
+    TIFFGetFieldDefaulted(tiff, TIFFTAG_ORIENTATION,     &orientation);
+    TIFFGetFieldDefaulted(tiff, TIFFTAG_EXTRASAMPLES,    &extra_samples_count, &extra_samples);
+    TIFFGetFieldDefaulted(tiff, TIFFTAG_BITSPERSAMPLE,   &layout->bits_per_sample);
+    TIFFGetFieldDefaulted(tiff, TIFFTAG_SAMPLESPERPIXEL, &layout->samples_per_pixel);
+    TIFFGetField(tiff, TIFFTAG_COMPRESSION, &compression);
+
+    if (!TIFFGetField(tiff, TIFFTAG_PHOTOMETRIC, &layout->photometric)) {
+        return false;
+    }
+
+    if (planar_config != PLANARCONFIG_CONTIG || sample_format != SAMPLEFORMAT_UINT ||
+            orientation != ORIENTATION_TOPLEFT || compression == COMPRESSION_OJPEG) {
+        return false;
+    }
+
+    unsigned color_samples;
+
+    switch (layout->photometric) {
+        case PHOTOMETRIC_MINISWHITE:
+        case PHOTOMETRIC_MINISBLACK:
+        case PHOTOMETRIC_PALETTE: color_samples = 1; break;
+        case PHOTOMETRIC_RGB:     color_samples = 3; break;
+
+        default: {
+            return false;
+        }
+    }
+
+    /* Only straight alpha is supported. libtiff premultiplies the rest in TIFFRGBAImageGet(). */
+    if (layout->samples_per_pixel == color_samples) {
+        layout->alpha = false;
+    } else if (layout->samples_per_pixel == color_samples + 1 && layout->photometric != PHOTOMETRIC_PALETTE &&
+                extra_samples_count == 1 && extra_samples[0] == EXTRASAMPLE_UNASSALPHA) {
+        layout->alpha = true;
+    } else {
+        return false;
+    }
+
+    const unsigned bps = layout->bits_per_sample;
+
+    switch (layout->photometric) {
+        case PHOTOMETRIC_MINISWHITE:
+        case PHOTOMETRIC_MINISBLACK: {
+            if (layout->alpha) {
+                layout->pixel_format = (bps == 8) ? SAIL_PIXEL_FORMAT_BPP16_GRAYSCALE_ALPHA
+                                        : (bps == 16) ? SAIL_PIXEL_FORMAT_BPP32_GRAYSCALE_ALPHA
+                                        : SAIL_PIXEL_FORMAT_UNKNOWN;
+            } else {
+                layout->pixel_format = (bps == 1) ? SAIL_PIXEL_FORMAT_BPP1_GRAYSCALE
+                                        : (bps == 2) ? SAIL_PIXEL_FORMAT_BPP2_GRAYSCALE
+                                        : (bps == 4) ? SAIL_PIXEL_FORMAT_BPP4_GRAYSCALE
+                                        : (bps == 8) ? SAIL_PIXEL_FORMAT_BPP8_GRAYSCALE
+                                        : (bps == 16) ? SAIL_PIXEL_FORMAT_BPP16_GRAYSCALE
+                                        : SAIL_PIXEL_FORMAT_UNKNOWN;
+            }
+            break;
+        }
+        case PHOTOMETRIC_PALETTE: {
+            layout->pixel_format = (bps == 1) ? SAIL_PIXEL_FORMAT_BPP1_INDEXED
+                                    : (bps == 2) ? SAIL_PIXEL_FORMAT_BPP2_INDEXED
+                                    : (bps == 4) ? SAIL_PIXEL_FORMAT_BPP4_INDEXED
+                                    : (bps == 8) ? SAIL_PIXEL_FORMAT_BPP8_INDEXED
+                                    : SAIL_PIXEL_FORMAT_UNKNOWN;
+            break;
+        }
+        default: { /* PHOTOMETRIC_RGB */
+            if (layout->alpha) {
+                layout->pixel_format = (bps == 8) ? SAIL_PIXEL_FORMAT_BPP32_RGBA
+                                        : (bps == 16) ? SAIL_PIXEL_FORMAT_BPP64_RGBA
+                                        : SAIL_PIXEL_FORMAT_UNKNOWN;
+            } else {
+                layout->pixel_format = (bps == 8) ? SAIL_PIXEL_FORMAT_BPP24_RGB
+                                        : (bps == 16) ? SAIL_PIXEL_FORMAT_BPP48_RGB
+                                        : SAIL_PIXEL_FORMAT_UNKNOWN;
+            }
+            break;
+        }
+    }
+
+    return layout->pixel_format != SAIL_PIXEL_FORMAT_UNKNOWN;
+}
+
+sail_status_t tiff_private_fetch_palette(TIFF *tiff, unsigned bits_per_sample, struct sail_palette **palette) {
+
+    SAIL_CHECK_PALETTE_PTR(palette);
+
+    uint16_t *red;
+    uint16_t *green;
+    uint16_t *blue;
+
+    if (!TIFFGetField(tiff, TIFFTAG_COLORMAP, &red, &green, &blue)) {
+        SAIL_LOG_ERROR("TIFF: The indexed image has no palette");
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_MISSING_PALETTE);
+    }
+
+    const unsigned color_count = 1U << bits_per_sample;
+
+    /* Some old writers store 8-bit values in the 16-bit color map. libtiff detects them the same way. */
+    unsigned shift = 0;
+
+    for (unsigned i = 0; i < color_count; i++) {
+        if (red[i] >= 256 || green[i] >= 256 || blue[i] >= 256) {
+            shift = 8;
+            break;
+        }
+    }
+
+    SAIL_TRY(sail_alloc_palette(palette));
+
+    (*palette)->pixel_format = SAIL_PIXEL_FORMAT_BPP24_RGB;
+    (*palette)->color_count = color_count;
+
+    SAIL_TRY_OR_CLEANUP(sail_malloc(color_count * 3, &(*palette)->data),
+                        /* cleanup */ sail_destroy_palette(*palette));
+
+    unsigned char *palette_ptr = (*palette)->data;
+
+    for (unsigned i = 0; i < color_count; i++) {
+        *palette_ptr++ = (unsigned char)(red[i]   >> shift);
+        *palette_ptr++ = (unsigned char)(green[i] >> shift);
+        *palette_ptr++ = (unsigned char)(blue[i]  >> shift);
+    }
+
+    return SAIL_OK;
+}
+
+void tiff_private_build_lut(const struct tiff_native_layout *layout, const struct sail_palette *palette, bool bgr, uint32_t lut[256]) {
+
+    const unsigned count = 1U << (layout->bits_per_sample < 8 ? layout->bits_per_sample : 8);
+    const unsigned max = count - 1;
+
+    for (unsigned i = 0; i < 256; i++) {
+        unsigned char pixel[4] = { 0, 0, 0, 255 };
+
+        if (i < count) {
+            if (layout->photometric == PHOTOMETRIC_PALETTE) {
+                const unsigned char *color = (const unsigned char *)palette->data + i * 3;
+
+                pixel[bgr ? 2 : 0] = color[0];
+                pixel[1]           = color[1];
+                pixel[bgr ? 0 : 2] = color[2];
+            } else {
+                const unsigned value = (i * 255 + max / 2) / max;
+                const unsigned char gray = (unsigned char)(layout->photometric == PHOTOMETRIC_MINISWHITE ? 255 - value : value);
+
+                pixel[0] = pixel[1] = pixel[2] = gray;
+            }
+        }
+
+        memcpy(&lut[i], pixel, 4);
+    }
+}
+
+void tiff_private_copy_row(const struct tiff_native_layout *layout, const void *src, size_t length, void *dst) {
+
+    if (src != dst) {
+        memcpy(dst, src, length);
+    }
+
+    /* Min-is-white is not a SAIL pixel format, so invert the gray samples. */
+    if (layout->photometric == PHOTOMETRIC_MINISWHITE) {
+        unsigned char *bytes = dst;
+
+        for (size_t i = 0; i < length; i++) {
+            bytes[i] = (unsigned char)~bytes[i];
+        }
+
+        /* Restore the interleaved alpha samples. */
+        if (layout->alpha) {
+            const unsigned bytes_per_sample = layout->bits_per_sample / 8;
+
+            for (size_t i = bytes_per_sample; i < length; i += 2 * bytes_per_sample) {
+                for (unsigned k = 0; k < bytes_per_sample; k++) {
+                    bytes[i + k] = (unsigned char)~bytes[i + k];
+                }
+            }
+        }
+    }
+}
+
+void tiff_private_convert_row(const struct tiff_native_layout *layout, const void *src, unsigned width, const uint32_t *lut, bool bgr, unsigned char *dst) {
+
+    const unsigned bps = layout->bits_per_sample;
+    const unsigned spp = layout->samples_per_pixel;
+
+    /* Gray and indexed pixels up to 8 bits go through the lookup table. */
+    if (spp == 1 && bps <= 8) {
+        const unsigned char *bytes = src;
+
+        if (bps == 8) {
+            for (unsigned i = 0; i < width; i++) {
+                memcpy(dst + i * 4, &lut[bytes[i]], 4);
+            }
+        } else {
+            const unsigned per_byte = 8 / bps;
+            const unsigned mask = (1U << bps) - 1;
+
+            for (unsigned i = 0; i < width; i++) {
+                const unsigned shift = 8 - bps * (i % per_byte + 1);
+                memcpy(dst + i * 4, &lut[(bytes[i / per_byte] >> shift) & mask], 4);
+            }
+        }
+
+        return;
+    }
+
+    const unsigned r = bgr ? 2 : 0;
+    const unsigned b = bgr ? 0 : 2;
+    const bool gray = layout->photometric != PHOTOMETRIC_RGB;
+    const bool invert = layout->photometric == PHOTOMETRIC_MINISWHITE;
+
+    if (bps == 8) {
+        const unsigned char *s = src;
+
+        if (!gray && spp == 3) {
+            for (unsigned i = 0; i < width; i++, s += 3, dst += 4) {
+                dst[r] = s[0]; dst[1] = s[1]; dst[b] = s[2]; dst[3] = 255;
+            }
+        } else if (!gray) {
+            for (unsigned i = 0; i < width; i++, s += 4, dst += 4) {
+                dst[r] = s[0]; dst[1] = s[1]; dst[b] = s[2]; dst[3] = s[3];
+            }
+        } else {
+            for (unsigned i = 0; i < width; i++, s += 2, dst += 4) {
+                const unsigned char value = invert ? (unsigned char)~s[0] : s[0];
+                dst[0] = dst[1] = dst[2] = value; dst[3] = s[1];
+            }
+        }
+    } else { /* 16 bits per sample in the host byte order */
+        const uint16_t *s = src;
+
+        for (unsigned i = 0; i < width; i++, s += spp, dst += 4) {
+            if (gray) {
+                const unsigned char value = (unsigned char)((invert ? (uint16_t)~s[0] : s[0]) >> 8);
+                dst[0] = dst[1] = dst[2] = value;
+                dst[3] = layout->alpha ? (unsigned char)(s[1] >> 8) : 255;
+            } else {
+                dst[r] = (unsigned char)(s[0] >> 8);
+                dst[1] = (unsigned char)(s[1] >> 8);
+                dst[b] = (unsigned char)(s[2] >> 8);
+                dst[3] = layout->alpha ? (unsigned char)(s[3] >> 8) : 255;
+            }
+        }
+    }
+}
@@ -27,6 +27,9 @@
 #define SAIL_TIFF_HELPERS_H
 
 #include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 
 #include <tiffio.h>
@@ -36,8 +39,19 @@
 #include "export.h"
 
 struct sail_meta_data_node;
+struct sail_palette;
 struct sail_resolution;
 
+/* Directory layout that can be decoded with TIFFReadEncodedStrip() or TIFFReadEncodedTile(). */
+struct tiff_native_layout {
+    uint16_t photometric;
+    uint16_t bits_per_sample;
+    uint16_t samples_per_pixel;
+    bool alpha;
+    /* Pixel format of the decoded samples. */
+    enum SailPixelFormat pixel_format;
+};
+
 SAIL_HIDDEN void tiff_private_my_error_fn(const char *module, const char *format, va_list ap);
 
 SAIL_HIDDEN void tiff_private_my_warning_fn(const char *module, const char *format, va_list ap);
@@ -48,6 +62,15 @@ SAIL_HIDDEN enum SailCompression tiff_private_compression_to_sail_compression(in
 
 SAIL_HIDDEN sail_status_t tiff_private_sail_compression_to_compression(enum SailCompression compression, int *tiff_compression);
 
+/* Returns true if the horizontal predictor can be used with the compression. */
+SAIL_HIDDEN bool tiff_private_predictor_supported(int compression);
+
+/*
+ * Returns true if the compression keeps no state between strips and tiles, so they can be compressed
+ * in separate TIFF handles and written with TIFFWriteRawStrip() or TIFFWriteRawTile().
+ */
+SAIL_HIDDEN bool tiff_private_compression_is_independent(int compression);
+
 SAIL_HIDDEN enum SailPixelFormat tiff_private_bpp_to_pixel_format(int bpp);
 
 SAIL_HIDDEN void tiff_private_zero_tiff_image(TIFFRGBAImage *img);
@@ -60,8 +83,28 @@ SAIL_HIDDEN sail_status_t tiff_private_write_meta_data(TIFF *tiff, const struct
 
 SAIL_HIDDEN sail_status_t tiff_private_supported_write_output_pixel_format(enum SailPixelFormat pixel_format);
 
+/* Fills the layout to write images of the specified pixel format as is. */
+SAIL_HIDDEN sail_status_t tiff_private_write_layout(enum SailPixelFormat pixel_format, struct tiff_native_layout *layout);
+
 SAIL_HIDDEN sail_status_t tiff_private_fetch_resolution(TIFF *tiff, struct sail_resolution **resolution);
 
 SAIL_HIDDEN sail_status_t tiff_private_write_resolution(TIFF *tiff, const struct sail_resolution *resolution);
 
+/*
+ * Fills the layout of the current directory. Returns false if the directory needs the generic
+ * TIFFRGBAImage path: planar, non-integer, rotated, associated alpha, CMYK, YCbCr etc.
+ */
+SAIL_HIDDEN bool tiff_private_fetch_native_layout(TIFF *tiff, struct tiff_native_layout *layout);
+
+SAIL_HIDDEN sail_status_t tiff_private_fetch_palette(TIFF *tiff, unsigned bits_per_sample, struct sail_palette **palette);
+
+/* Builds a table of RGBA or BGRA pixels for gray and indexed layouts up to 8 bits per sample. */
+SAIL_HIDDEN void tiff_private_build_lut(const struct tiff_native_layout *layout, const struct sail_palette *palette, bool bgr, uint32_t lut[256]);
+
+/* Copies a decoded row as is except min-is-white samples which are inverted. */
+SAIL_HIDDEN void tiff_private_copy_row(const struct tiff_native_layout *layout, const void *src, size_t length, void *dst);
+
+/* Converts a decoded row into RGBA or BGRA. */
+SAIL_HIDDEN void tiff_private_convert_row(const struct tiff_native_layout *layout, const void *src, unsigned width, const uint32_t *lut, bool bgr, unsigned char *dst);
+
 #endif
@@ -23,6 +23,9 @@
     SOFTWARE.
 */
 
+#include <stdio.h> /* SEEK_SET */
+#include <string.h>
+
 #include "sail-common.h"
 
 #include "io.h"
@@ -92,3 +95,82 @@ toff_t tiff_private_my_dummy_size_proc(thandle_t client_data) {
 
     return (toff_t)-1;
 }
+
+tmsize_t tiff_private_memory_read_proc(thandle_t client_data, void *buffer, tmsize_t buffer_size) {
+
+    struct tiff_memory_file *file = (struct tiff_memory_file *)client_data;
+
+    if (file->position >= file->size) {
+        return 0;
+    }
+
+    size_t nbytes = file->size - file->position;
+    nbytes = ((size_t)buffer_size < nbytes) ? (size_t)buffer_size : nbytes;
+
+    memcpy(buffer, file->data + file->position, nbytes);
+    file->position += nbytes;
+
+    return (tmsize_t)nbytes;
+}
+
+tmsize_t tiff_private_memory_write_proc(thandle_t client_data, void *buffer, tmsize_t buffer_size) {
+
+    struct tiff_memory_file *file = (struct tiff_memory_file *)client_data;
+    const size_t end = file->position + (size_t)buffer_size;
+
+    if (end > file->capacity) {
+        size_t capacity = (file->capacity > 0) ? file->capacity * 2 : 65536;
+
+        while (end > capacity) {
+            capacity *= 2;
+        }
+
+        void *ptr = file->data;
+
+        if (sail_realloc(capacity, &ptr) != SAIL_OK) {
+            TIFFError(NULL, "Failed to grow the memory buffer to %lu bytes", (unsigned long)capacity);
+            return (tmsize_t)-1;
+        }
+
+        file->data     = ptr;
+        file->capacity = capacity;
+    }
+
+    /* Fill the gap after seeking past the end. */
+    if (file->position > file->size) {
+        memset(file->data + file->size, 0, file->position - file->size);
+    }
+
+    memcpy(file->data + file->position, buffer, (size_t)buffer_size);
+    file->position = end;
+
+    if (end > file->size) {
+        file->size = end;
+    }
+
+    return buffer_size;
+}
+
+toff_t tiff_private_memory_seek_proc(thandle_t client_data, toff_t offset, int whence) {
+
+    struct tiff_memory_file *file = (struct tiff_memory_file *)client_data;
+
+    switch (whence) {
+        case SEEK_SET: file->position = (size_t)offset;               break;
+        case SEEK_CUR: file->position += (size_t)offset;              break;
+        case SEEK_END: file->position = file->size + (size_t)offset;  break;
+
+        default: {
+            return (toff_t)-1;
+        }
+    }
+
+    return (toff_t)file->position;
+}
+
+toff_t tiff_private_memory_size_proc(thandle_t client_data) {
+
+    const struct tiff_memory_file *file = (const struct tiff_memory_file *)client_data;
+
+    return (toff_t)file->size;
+}
@@ -26,10 +26,20 @@
 #ifndef SAIL_TIFF_IO_H
 #define SAIL_TIFF_IO_H
 
+#include <stddef.h>
+
 #include <tiffio.h>
 
 #include "export.h"
 
+/* Growing memory buffer used as a file to compress strips and tiles apart from the output stream. */
+struct tiff_memory_file {
+    unsigned char *data;
+    size_t size;
+    size_t capacity;
+    size_t position;
+};
+
 SAIL_HIDDEN tmsize_t tiff_private_my_read_proc(thandle_t client_data, void *buffer, tmsize_t buffer_size);
 
 SAIL_HIDDEN tmsize_t tiff_private_my_write_proc(thandle_t client_data, void *buffer, tmsize_t buffer_size);
@@ -40,4 +50,13 @@ SAIL_HIDDEN int tiff_private_my_dummy_close_proc(thandle_t client_data);
 
 SAIL_HIDDEN toff_t tiff_private_my_dummy_size_proc(thandle_t client_data);
 
+/* Procedures over struct tiff_memory_file. */
+SAIL_HIDDEN tmsize_t tiff_private_memory_read_proc(thandle_t client_data, void *buffer, tmsize_t buffer_size);
+
+SAIL_HIDDEN tmsize_t tiff_private_memory_write_proc(thandle_t client_data, void *buffer, tmsize_t buffer_size);
+
+SAIL_HIDDEN toff_t tiff_private_memory_seek_proc(thandle_t client_data, toff_t offset, int whence);
+
+SAIL_HIDDEN toff_t tiff_private_memory_size_proc(thandle_t client_data);
+
 #endif
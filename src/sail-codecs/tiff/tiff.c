@@ -27,14 +27,19 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <tiffio.h>
 
 #include "sail-common.h"
 
+#include "handles.h"
 #include "helpers.h"
 #include "io.h"
 
+/* Upper limit of decoding and encoding threads. */
+#define TIFF_MAX_THREADS 64
+
 /*
  * Codec-specific state.
  */
@@ -46,7 +51,54 @@ struct tiff_state {
     struct sail_write_options *write_options;
     int write_compression;
     TIFFRGBAImage image;
-    int line;
+
+    /* Region of interest. */
+    bool crop;
+    uint32_t crop_x;
+    uint32_t crop_y;
+
+    /* Native strip and tile decoding. */
+    bool native;
+    struct tiff_native_layout layout;
+    bool tiled;
+    uint32_t tile_width;
+    uint32_t tiles_across;
+    /* Tile columns intersecting the region of interest, the last one is exclusive. */
+    uint32_t first_tile;
+    uint32_t last_tile;
+    /* Rows per strip or tile length. */
+    uint32_t block_height;
+    /* Decoded strip or band of tiles and the first row in it. */
+    unsigned char *block;
+    uint32_t block_first_row;
+    tmsize_t tile_size;
+    tmsize_t tile_row_size;
+    tmsize_t row_size;
+    /* Row assembled from tiles. */
+    unsigned char *scanline;
+    /* Row of packed pixels shifted to the region of interest. */
+    unsigned char *crop_scanline;
+    uint32_t lut[256];
+
+    /*
+     * Threads decoding or encoding strips and tiles along with the calling thread, and their handles.
+     * They are kept between frames. Parallel is true when the current frame uses them.
+     */
+    struct sail_thread_pool *pool;
+    struct tiff_handles *handles;
+    bool parallel;
+
+    /*
+     * Strip and tile encoding. Strips or tiles are copied from the image into the block,
+     * padded with zeroes. With threads, batches of them are compressed in separate TIFF handles
+     * and written as raw data.
+     */
+    uint16_t predictor;
+    uint32_t block_width;
+    uint32_t blocks_count;
+    size_t bytes_per_pixel;
+    struct tiff_memory_file *encoded;
+    unsigned encoded_count;
 };
 
 static sail_status_t alloc_tiff_state(struct tiff_state **tiff_state) {
@@ -65,7 +117,32 @@ static sail_status_t alloc_tiff_state(struct tiff_state **tiff_state) {
     (*tiff_state)->read_options      = NULL;
     (*tiff_state)->write_options     = NULL;
     (*tiff_state)->write_compression = COMPRESSION_NONE;
-    (*tiff_state)->line              = 0;
+    (*tiff_state)->crop              = false;
+    (*tiff_state)->crop_x            = 0;
+    (*tiff_state)->crop_y            = 0;
+    (*tiff_state)->native            = false;
+    (*tiff_state)->tiled             = false;
+    (*tiff_state)->tile_width        = 0;
+    (*tiff_state)->tiles_across      = 0;
+    (*tiff_state)->first_tile        = 0;
+    (*tiff_state)->last_tile         = 0;
+    (*tiff_state)->block_height      = 0;
+    (*tiff_state)->block             = NULL;
+    (*tiff_state)->block_first_row   = UINT32_MAX;
+    (*tiff_state)->tile_size         = 0;
+    (*tiff_state)->tile_row_size     = 0;
+    (*tiff_state)->row_size          = 0;
+    (*tiff_state)->scanline          = NULL;
+    (*tiff_state)->crop_scanline     = NULL;
+    (*tiff_state)->pool              = NULL;
+    (*tiff_state)->handles           = NULL;
+    (*tiff_state)->parallel          = false;
+    (*tiff_state)->predictor         = PREDICTOR_NONE;
+    (*tiff_state)->block_width       = 0;
+    (*tiff_state)->blocks_count      = 0;
+    (*tiff_state)->bytes_per_pixel   = 0;
+    (*tiff_state)->encoded           = NULL;
+    (*tiff_state)->encoded_count     = 0;
 
     tiff_private_zero_tiff_image(&(*tiff_state)->image);
 
@@ -83,31 +160,47 @@ static void destroy_tiff_state(struct tiff_state *tiff_state) {
 
     TIFFRGBAImageEnd(&tiff_state->image);
 
+    sail_free(tiff_state->block);
+    sail_free(tiff_state->scanline);
+    sail_free(tiff_state->crop_scanline);
+
+    sail_destroy_thread_pool(tiff_state->pool);
+    tiff_private_destroy_handles(tiff_state->handles);
+
+    if (tiff_state->encoded != NULL) {
+        for (unsigned i = 0; i < tiff_state->encoded_count; i++) {
+            sail_free(tiff_state->encoded[i].data);
+        }
+
+        sail_free(tiff_state->encoded);
+    }
+
     sail_free(tiff_state);
 }
 
-/*
- * Decoding functions.
- */
-
-SAIL_EXPORT sail_status_t sail_codec_read_init_v4_tiff(struct sail_io *io, const struct sail_read_options *read_options, void **state) {
+/* Starts the threads and allocates their handles unless they're already allocated. The calling thread is the first worker. */
+static sail_status_t alloc_workers(struct tiff_state *tiff_state, struct sail_io *io, unsigned threads) {
 
-    SAIL_CHECK_STATE_PTR(state);
-    *state = NULL;
+    if (threads > TIFF_MAX_THREADS) {
+        threads = TIFF_MAX_THREADS;
+    }
 
-    SAIL_CHECK_IO(io);
-    SAIL_CHECK_READ_OPTIONS_PTR(read_options);
+    if (tiff_state->handles == NULL) {
+        SAIL_TRY(tiff_private_alloc_handles(io, threads, &tiff_state->handles));
+    }
 
-    TIFFSetWarningHandler(tiff_private_my_warning_fn);
-    TIFFSetErrorHandler(tiff_private_my_error_fn);
+    if (tiff_state->pool == NULL) {
+        SAIL_TRY(sail_alloc_thread_pool(threads - 1, &tiff_state->pool));
+    }
 
-    SAIL_TRY(tiff_private_supported_read_output_pixel_format(read_options->output_pixel_format));
+    return SAIL_OK;
+}
 
-    /* Allocate a new state. */
-    struct tiff_state *tiff_state;
-    SAIL_TRY(alloc_tiff_state(&tiff_state));
+/* Opens the TIFF file for reading. */
+static sail_status_t init_read(struct tiff_state *tiff_state, struct sail_io *io, const struct sail_read_options *read_options) {
 
-    *state = tiff_state;
+    TIFFSetWarningHandler(tiff_private_my_warning_fn);
+    TIFFSetErrorHandler(tiff_private_my_error_fn);
 
     /* Deep copy read options. */
     SAIL_TRY(sail_copy_read_options(read_options, &tiff_state->read_options));
@@ -137,38 +230,13 @@ SAIL_EXPORT sail_status_t sail_codec_read_init_v4_tiff(struct sail_io *io, const
     return SAIL_OK;
 }
 
-SAIL_EXPORT sail_status_t sail_codec_read_seek_next_frame_v4_tiff(void *state, struct sail_io *io, struct sail_image **image) {
-
-    SAIL_CHECK_STATE_PTR(state);
-    SAIL_CHECK_IO(io);
-    SAIL_CHECK_IMAGE_PTR(image);
-
-    struct tiff_state *tiff_state = (struct tiff_state *)state;
-
-    if (tiff_state->libtiff_error) {
-        SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
-    }
+/* Allocates a new image and fills its properties from the current directory. */
+static sail_status_t fetch_image(struct tiff_state *tiff_state, struct sail_image **image) {
 
     SAIL_TRY(sail_alloc_image(image));
     SAIL_TRY_OR_CLEANUP(sail_alloc_source_image(&(*image)->source_image),
                         /* cleanup */ sail_destroy_image(*image));
 
-    /* Start reading the next directory. */
-    if (!TIFFSetDirectory(tiff_state->tiff, tiff_state->current_frame++)) {
-        sail_destroy_image(*image);
-        SAIL_LOG_AND_RETURN(SAIL_ERROR_NO_MORE_FRAMES);
-    }
-
-    /* Start reading the next image. */
-    char emsg[1024];
-    if (!TIFFRGBAImageBegin(&tiff_state->image, tiff_state->tiff, /* stop */ 1, emsg)) {
-        SAIL_LOG_ERROR("TIFF: %s", emsg);
-        sail_destroy_image(*image);
-        SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
-    }
-
-    tiff_state->image.req_orientation = ORIENTATION_TOPLEFT;
-
     /* Fill the image properties. */
     if (!TIFFGetField(tiff_state->tiff, TIFFTAG_IMAGEWIDTH,  &(*image)->width) || !TIFFGetField(tiff_state->tiff, TIFFTAG_IMAGELENGTH, &(*image)->height)) {
         SAIL_LOG_ERROR("Failed to get the image dimensions");
@@ -194,6 +262,8 @@ SAIL_EXPORT sail_status_t sail_codec_read_seek_next_frame_v4_tiff(void *state, s
     SAIL_TRY_OR_CLEANUP(tiff_private_fetch_resolution(tiff_state->tiff, &(*image)->resolution),
                             /* cleanup */ sail_destroy_image(*image));
 
+    tiff_state->native = tiff_private_fetch_native_layout(tiff_state->tiff, &tiff_state->layout);
+
     switch (tiff_state->read_options->output_pixel_format) {
         case SAIL_PIXEL_FORMAT_BPP32_RGBA:
         case SAIL_PIXEL_FORMAT_BPP32_BGRA: {
@@ -201,7 +271,17 @@ SAIL_EXPORT sail_status_t sail_codec_read_seek_next_frame_v4_tiff(void *state, s
             break;
         }
         case SAIL_PIXEL_FORMAT_SOURCE: {
-            (*image)->pixel_format = SAIL_PIXEL_FORMAT_BPP32_RGBA;
+            /* Layouts unknown to the native path are decoded by libtiff into RGBA. */
+            if (tiff_state->native) {
+                (*image)->pixel_format = tiff_state->layout.pixel_format;
+
+                if (tiff_state->layout.photometric == PHOTOMETRIC_PALETTE) {
+                    SAIL_TRY_OR_CLEANUP(tiff_private_fetch_palette(tiff_state->tiff, tiff_state->layout.bits_per_sample, &(*image)->palette),
+                                        /* cleanup */ sail_destroy_image(*image));
+                }
+            } else {
+                (*image)->pixel_format = SAIL_PIXEL_FORMAT_BPP32_RGBA;
+            }
             break;
         }
         default: {
@@ -209,6 +289,18 @@ SAIL_EXPORT sail_status_t sail_codec_read_seek_next_frame_v4_tiff(void *state, s
         }
     }
 
+    /* Region of interest. Only the intersecting strips or tiles are decoded. */
+    unsigned crop_width;
+    unsigned crop_height;
+    SAIL_TRY_OR_CLEANUP(sail_read_options_crop_rectangle(tiff_state->read_options, (*image)->width, (*image)->height,
+                                                         &tiff_state->crop_x, &tiff_state->crop_y, &crop_width, &crop_height),
+                        /* cleanup */ sail_destroy_image(*image));
+
+    tiff_state->crop = crop_width != (*image)->width || crop_height != (*image)->height;
+
+    (*image)->width  = crop_width;
+    (*image)->height = crop_height;
+
     SAIL_TRY_OR_CLEANUP(sail_bytes_per_line((*image)->width, (*image)->pixel_format, &(*image)->bytes_per_line),
                         /* cleanup */ sail_destroy_image(*image));
 
@@ -220,8 +312,13 @@ SAIL_EXPORT sail_status_t sail_codec_read_seek_next_frame_v4_tiff(void *state, s
         SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
     }
 
+    uint16_t bits_per_sample;
+    uint16_t samples_per_pixel;
+    TIFFGetFieldDefaulted(tiff_state->tiff, TIFFTAG_BITSPERSAMPLE,   &bits_per_sample);
+    TIFFGetFieldDefaulted(tiff_state->tiff, TIFFTAG_SAMPLESPERPIXEL, &samples_per_pixel);
+
     (*image)->source_image->compression = tiff_private_compression_to_sail_compression(compression);
-    (*image)->source_image->pixel_format = tiff_private_bpp_to_pixel_format(tiff_state->image.bitspersample * tiff_state->image.samplesperpixel);
+    (*image)->source_image->pixel_format = tiff_private_bpp_to_pixel_format(bits_per_sample * samples_per_pixel);
 
     const char *pixel_format_str = NULL;
     SAIL_TRY_OR_SUPPRESS(sail_pixel_format_to_string((*image)->source_image->pixel_format, &pixel_format_str));
@@ -232,6 +329,362 @@ SAIL_EXPORT sail_status_t sail_codec_read_seek_next_frame_v4_tiff(void *state, s
     return SAIL_OK;
 }
 
+/* Allocates the strip or tile buffers and the lookup table for the current directory. */
+static sail_status_t init_native_read(struct tiff_state *tiff_state, struct sail_io *io, const struct sail_image *image) {
+
+    TIFF *tiff = tiff_state->tiff;
+
+    sail_free(tiff_state->block);
+    sail_free(tiff_state->scanline);
+    sail_free(tiff_state->crop_scanline);
+    tiff_state->block           = NULL;
+    tiff_state->scanline        = NULL;
+    tiff_state->crop_scanline   = NULL;
+    tiff_state->block_first_row = UINT32_MAX;
+
+    uint32_t width;
+    TIFFGetField(tiff, TIFFTAG_IMAGEWIDTH, &width);
+
+    tiff_state->tiled    = TIFFIsTiled(tiff) != 0;
+    tiff_state->row_size = TIFFScanlineSize(tiff);
+
+    size_t block_size;
+
+    if (tiff_state->tiled) {
+        uint32_t tile_length;
+
+        if (!TIFFGetField(tiff, TIFFTAG_TILEWIDTH, &tiff_state->tile_width) || !TIFFGetField(tiff, TIFFTAG_TILELENGTH, &tile_length) ||
+                tiff_state->tile_width == 0 || tile_length == 0) {
+            SAIL_LOG_ERROR("TIFF: Failed to get the tile dimensions");
+            SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
+        }
+
+        tiff_state->tiles_across  = (width + tiff_state->tile_width - 1) / tiff_state->tile_width;
+        tiff_state->first_tile    = tiff_state->crop_x / tiff_state->tile_width;
+        tiff_state->last_tile     = (tiff_state->crop_x + image->width + tiff_state->tile_width - 1) / tiff_state->tile_width;
+        tiff_state->block_height  = tile_length;
+        tiff_state->tile_size     = TIFFTileSize(tiff);
+        tiff_state->tile_row_size = TIFFTileRowSize(tiff);
+        block_size = (size_t)tiff_state->tiles_across * (size_t)tiff_state->tile_size;
+
+        void *ptr;
+        SAIL_TRY(sail_malloc((size_t)tiff_state->tiles_across * (size_t)tiff_state->tile_row_size, &ptr));
+        tiff_state->scanline = ptr;
+    } else {
+        uint32_t rows_per_strip;
+        TIFFGetFieldDefaulted(tiff, TIFFTAG_ROWSPERSTRIP, &rows_per_strip);
+
+        uint32_t height;
+        TIFFGetField(tiff, TIFFTAG_IMAGELENGTH, &height);
+
+        tiff_state->block_height = (rows_per_strip == 0 || rows_per_strip > height) ? height : rows_per_strip;
+        block_size = (size_t)TIFFStripSize(tiff);
+    }
+
+    if (tiff_state->row_size <= 0 || block_size == 0) {
+        SAIL_LOG_ERROR("TIFF: Failed to compute the strip or tile size");
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
+    }
+
+    void *ptr;
+    SAIL_TRY(sail_malloc(block_size, &ptr));
+    tiff_state->block = ptr;
+
+    /* Packed pixels of the region may start in the middle of a byte. */
+    if ((tiff_state->crop_x * tiff_state->layout.bits_per_sample * tiff_state->layout.samples_per_pixel) % 8 != 0) {
+        SAIL_TRY(sail_malloc((size_t)tiff_state->row_size, &ptr));
+        tiff_state->crop_scanline = ptr;
+    }
+
+    if (tiff_state->read_options->output_pixel_format != SAIL_PIXEL_FORMAT_SOURCE &&
+            tiff_state->layout.samples_per_pixel == 1 && tiff_state->layout.bits_per_sample <= 8) {
+        struct sail_palette *palette = NULL;
+
+        if (tiff_state->layout.photometric == PHOTOMETRIC_PALETTE) {
+            SAIL_TRY(tiff_private_fetch_palette(tiff, tiff_state->layout.bits_per_sample, &palette));
+        }
+
+        tiff_private_build_lut(&tiff_state->layout,
+                                palette,
+                                tiff_state->read_options->output_pixel_format == SAIL_PIXEL_FORMAT_BPP32_BGRA,
+                                tiff_state->lut);
+
+        sail_destroy_palette(palette);
+    }
+
+    /* Tiles are compressed independently, so decode them in parallel when requested. */
+    tiff_state->parallel = tiff_state->tiled && tiff_state->read_options->threads > 1;
+
+    if (tiff_state->parallel) {
+        SAIL_TRY(alloc_workers(tiff_state, io, tiff_state->read_options->threads));
+        SAIL_TRY(tiff_private_handles_set_directory(tiff_state->handles, tiff_state->current_frame - 1, tiff_state->tile_size));
+    }
+
+    return SAIL_OK;
+}
+
+/* Decodes a tile of the band at block_first_row into the block. */
+static sail_status_t load_native_tile_job(void *context, unsigned job, unsigned worker) {
+
+    const struct tiff_state *tiff_state = context;
+    TIFF *tiff = tiff_private_handle(tiff_state->handles, worker);
+
+    if (TIFFReadEncodedTile(tiff,
+                            TIFFComputeTile(tiff, (tiff_state->first_tile + job) * tiff_state->tile_width, tiff_state->block_first_row, 0, 0),
+                            tiff_state->block + (size_t)(tiff_state->first_tile + job) * (size_t)tiff_state->tile_size,
+                            tiff_state->tile_size) < 0) {
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
+    }
+
+    return SAIL_OK;
+}
+
+/* Decodes the strip or the band of tiles containing the row. */
+static sail_status_t load_native_block(struct tiff_state *tiff_state, uint32_t row) {
+
+    TIFF *tiff = tiff_state->tiff;
+    const uint32_t first_row = row - row % tiff_state->block_height;
+
+    /* Invalidate the buffer until it's fully decoded. */
+    tiff_state->block_first_row = UINT32_MAX;
+
+    if (tiff_state->parallel) {
+        /* Jobs read the band position from the state. */
+        tiff_state->block_first_row = first_row;
+
+        sail_status_t status = sail_thread_pool_run(tiff_state->pool,
+                                                    tiff_state->last_tile - tiff_state->first_tile,
+                                                    load_native_tile_job,
+                                                    tiff_state);
+
+        if (status != SAIL_OK) {
+            tiff_state->block_first_row = UINT32_MAX;
+            SAIL_LOG_AND_RETURN(status);
+        }
+    } else if (tiff_state->tiled) {
+        /* Only the tile columns intersecting the region of interest. */
+        const uint32_t last_x = tiff_state->last_tile * tiff_state->tile_width;
+        unsigned char *tile = tiff_state->block + (size_t)tiff_state->first_tile * (size_t)tiff_state->tile_size;
+
+        for (uint32_t x = tiff_state->first_tile * tiff_state->tile_width; x < last_x; x += tiff_state->tile_width, tile += tiff_state->tile_size) {
+            if (TIFFReadEncodedTile(tiff, TIFFComputeTile(tiff, x, first_row, 0, 0), tile, tiff_state->tile_size) < 0) {
+                SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
+            }
+        }
+    } else {
+        if (TIFFReadEncodedStrip(tiff, TIFFComputeStrip(tiff, first_row, 0), tiff_state->block, (tmsize_t)-1) < 0) {
+            SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
+        }
+    }
+
+    tiff_state->block_first_row = first_row;
+
+    return SAIL_OK;
+}
+
+/* Returns the decoded row. Tile rows are assembled into a single scan line. */
+static const unsigned char *native_row(struct tiff_state *tiff_state, uint32_t row) {
+
+    const size_t row_in_block = row - tiff_state->block_first_row;
+
+    if (!tiff_state->tiled) {
+        return tiff_state->block + row_in_block * (size_t)tiff_state->row_size;
+    }
+
+    const size_t tile_row_size = (size_t)tiff_state->tile_row_size;
+    const size_t tile_row_end  = tiff_state->last_tile * tile_row_size;
+    const size_t row_size      = ((size_t)tiff_state->row_size < tile_row_end) ? (size_t)tiff_state->row_size : tile_row_end;
+    const unsigned char *tile  = tiff_state->block + tiff_state->first_tile * (size_t)tiff_state->tile_size + row_in_block * tile_row_size;
+
+    /* Only the tiles intersecting the region of interest are decoded and assembled. */
+    for (size_t offset = tiff_state->first_tile * tile_row_size; offset < row_size; offset += tile_row_size, tile += tiff_state->tile_size) {
+        memcpy(tiff_state->scanline + offset, tile, (row_size - offset < tile_row_size) ? row_size - offset : tile_row_size);
+    }
+
+    return tiff_state->scanline;
+}
+
+/* Bands of tiles decoded by workers straight into the output rows. */
+struct tiff_bands_job {
+    const struct tiff_state *tiff_state;
+    const struct sail_image *image;
+    uint32_t first_band;
+    unsigned first_row;
+    unsigned char *rows;
+};
+
+static sail_status_t read_bands_job(void *context, unsigned job, unsigned worker) {
+
+    const struct tiff_bands_job *bands_job = context;
+    const struct tiff_state *tiff_state = bands_job->tiff_state;
+    const struct sail_image *image = bands_job->image;
+    TIFF *tiff = tiff_private_handle(tiff_state->handles, worker);
+    unsigned char *tile = tiff_private_handle_tile(tiff_state->handles, worker);
+
+    const uint32_t x = job % tiff_state->tiles_across * tiff_state->tile_width;
+    const uint32_t y = (bands_job->first_band + job / tiff_state->tiles_across) * tiff_state->block_height;
+
+    if (TIFFReadEncodedTile(tiff, TIFFComputeTile(tiff, x, y, 0, 0), tile, tiff_state->tile_size) < 0) {
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
+    }
+
+    const bool source = tiff_state->read_options->output_pixel_format == SAIL_PIXEL_FORMAT_SOURCE;
+    const bool bgr    = tiff_state->read_options->output_pixel_format == SAIL_PIXEL_FORMAT_BPP32_BGRA;
+
+    /* Tile widths are multiples of 16, so tiles always start on a byte boundary. */
+    const unsigned bits_per_pixel = tiff_state->layout.bits_per_sample * tiff_state->layout.samples_per_pixel;
+    const unsigned width          = (image->width - x < tiff_state->tile_width) ? image->width - x : tiff_state->tile_width;
+    const unsigned height         = (image->height - y < tiff_state->block_height) ? image->height - y : tiff_state->block_height;
+    const size_t dst_offset       = source ? (size_t)x * bits_per_pixel / 8 : (size_t)x * 4;
+    const size_t copy_length      = ((size_t)width * bits_per_pixel + 7) / 8;
+
+    for (unsigned row = 0; row < height; row++) {
+        const unsigned char *src = tile + (size_t)row * (size_t)tiff_state->tile_row_size;
+        unsigned char *dst = bands_job->rows + (size_t)(y + row - bands_job->first_row) * image->bytes_per_line + dst_offset;
+
+        if (source) {
+            tiff_private_copy_row(&tiff_state->layout, src, copy_length, dst);
+        } else {
+            tiff_private_convert_row(&tiff_state->layout, src, width, tiff_state->lut, bgr, dst);
+        }
+    }
+
+    return SAIL_OK;
+}
+
+static sail_status_t read_native_rows(struct tiff_state *tiff_state, const struct sail_image *image,
+                                        unsigned first_row, unsigned row_count, void *rows) {
+
+    const bool source = tiff_state->read_options->output_pixel_format == SAIL_PIXEL_FORMAT_SOURCE;
+    const bool bgr    = tiff_state->read_options->output_pixel_format == SAIL_PIXEL_FORMAT_BPP32_BGRA;
+    const unsigned first_bit = tiff_state->crop_x * tiff_state->layout.bits_per_sample * tiff_state->layout.samples_per_pixel;
+    const size_t region_size = (size_t)tiff_state->row_size - first_bit / 8;
+    const size_t copy_length = (region_size < image->bytes_per_line) ? region_size : image->bytes_per_line;
+    const unsigned last_row = first_row + row_count;
+
+    for (unsigned row = first_row; row < last_row;) {
+        /*
+         * Bands of tiles fully covered by the requested rows are decoded in parallel straight
+         * into the output. Partially covered bands go through the block.
+         */
+        if (tiff_state->parallel && !tiff_state->crop && row % tiff_state->block_height == 0) {
+            const unsigned bands_end = (last_row == image->height) ? last_row : last_row - last_row % tiff_state->block_height;
+
+            if (bands_end > row) {
+                const uint32_t bands = (bands_end - row + tiff_state->block_height - 1) / tiff_state->block_height;
+
+                struct tiff_bands_job bands_job = {
+                    .tiff_state = tiff_state,
+                    .image      = image,
+                    .first_band = row / tiff_state->block_height,
+                    .first_row  = first_row,
+                    .rows       = rows,
+                };
+
+                SAIL_TRY(sail_thread_pool_run(tiff_state->pool, bands * tiff_state->tiles_across, read_bands_job, &bands_job));
+
+                row = bands_end;
+                continue;
+            }
+        }
+
+        const uint32_t source_row = tiff_state->crop_y + row;
+
+        if (tiff_state->block_first_row == UINT32_MAX || source_row < tiff_state->block_first_row ||
+                source_row >= tiff_state->block_first_row + tiff_state->block_height) {
+            SAIL_TRY(load_native_block(tiff_state, source_row));
+        }
+
+        const unsigned char *src = native_row(tiff_state, source_row) + first_bit / 8;
+
+        if (tiff_state->crop_scanline != NULL) {
+            const unsigned shift = first_bit % 8;
+
+            for (size_t i = 0; i < region_size; i++) {
+                const unsigned char next = (i + 1 < region_size) ? src[i + 1] : 0;
+                tiff_state->crop_scanline[i] = (unsigned char)((src[i] << shift) | (next >> (8 - shift)));
+            }
+
+            src = tiff_state->crop_scanline;
+        }
+
+        unsigned char *dst = (unsigned char *)rows + (size_t)(row - first_row) * image->bytes_per_line;
+
+        if (source) {
+            tiff_private_copy_row(&tiff_state->layout, src, copy_length, dst);
+        } else {
+            tiff_private_convert_row(&tiff_state->layout, src, image->width, tiff_state->lut, bgr, dst);
+        }
+
+        row++;
+    }
+
+    return SAIL_OK;
+}
+
+/*
+ * Decoding functions.
+ */
+
+SAIL_EXPORT sail_status_t sail_codec_read_init_v4_tiff(struct sail_io *io, const struct sail_read_options *read_options, void **state) {
+
+    SAIL_CHECK_STATE_PTR(state);
+    *state = NULL;
+
+    SAIL_CHECK_IO(io);
+    SAIL_CHECK_READ_OPTIONS_PTR(read_options);
+
+    SAIL_TRY(tiff_private_supported_read_output_pixel_format(read_options->output_pixel_format));
+
+    /* Allocate a new state. */
+    struct tiff_state *tiff_state;
+    SAIL_TRY(alloc_tiff_state(&tiff_state));
+
+    *state = tiff_state;
+
+    SAIL_TRY(init_read(tiff_state, io, read_options));
+
+    return SAIL_OK;
+}
+
+SAIL_EXPORT sail_status_t sail_codec_read_seek_next_frame_v4_tiff(void *state, struct sail_io *io, struct sail_image **image) {
+
+    SAIL_CHECK_STATE_PTR(state);
+    SAIL_CHECK_IO(io);
+    SAIL_CHECK_IMAGE_PTR(image);
+
+    struct tiff_state *tiff_state = (struct tiff_state *)state;
+
+    if (tiff_state->libtiff_error) {
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
+    }
+
+    /* Start reading the next directory. */
+    if (!TIFFSetDirectory(tiff_state->tiff, tiff_state->current_frame++)) {
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_NO_MORE_FRAMES);
+    }
+
+    SAIL_TRY(fetch_image(tiff_state, image));
+
+    /* Start reading the next image. Strips and tiles are decoded natively when possible. */
+    if (tiff_state->native) {
+        SAIL_LOG_DEBUG("TIFF: Decoding %s natively", TIFFIsTiled(tiff_state->tiff) ? "tiles" : "strips");
+        SAIL_TRY_OR_CLEANUP(init_native_read(tiff_state, io, *image),
+                            /* cleanup */ sail_destroy_image(*image));
+    } else {
+        char emsg[1024];
+        if (!TIFFRGBAImageBegin(&tiff_state->image, tiff_state->tiff, /* stop */ 1, emsg)) {
+            SAIL_LOG_ERROR("TIFF: %s", emsg);
+            sail_destroy_image(*image);
+            SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
+        }
+
+        tiff_state->image.req_orientation = ORIENTATION_TOPLEFT;
+    }
+
+    return SAIL_OK;
+}
+
 SAIL_EXPORT sail_status_t sail_codec_read_seek_next_pass_v4_tiff(void *state, struct sail_io *io, const struct sail_image *image) {
 
     SAIL_CHECK_STATE_PTR(state);
@@ -241,11 +694,13 @@ SAIL_EXPORT sail_status_t sail_codec_read_seek_next_pass_v4_tiff(void *state, st
     return SAIL_OK;
 }
 
-SAIL_EXPORT sail_status_t sail_codec_read_frame_v4_tiff(void *state, struct sail_io *io, struct sail_image *image) {
+SAIL_EXPORT sail_status_t sail_codec_read_rows_v4_tiff(void *state, struct sail_io *io, const struct sail_image *image,
+                                                        unsigned first_row, unsigned row_count, void *rows) {
 
     SAIL_CHECK_STATE_PTR(state);
     SAIL_CHECK_IO(io);
     SAIL_CHECK_IMAGE(image);
+    SAIL_CHECK_BUFFER_PTR(rows);
 
     struct tiff_state *tiff_state = (struct tiff_state *)state;
 
@@ -253,28 +708,63 @@ SAIL_EXPORT sail_status_t sail_codec_read_frame_v4_tiff(void *state, struct sail
         SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
     }
 
-    if (!TIFFRGBAImageGet(&tiff_state->image, image->pixels, image->width, image->height)) {
+    if (tiff_state->native) {
+        SAIL_TRY(read_native_rows(tiff_state, image, first_row, row_count, rows));
+        return SAIL_OK;
+    }
+
+    /* TIFFRGBAImageGet() reads the band starting at row_offset and col_offset. */
+    tiff_state->image.row_offset = (int)(tiff_state->crop_y + first_row);
+    tiff_state->image.col_offset = (int)tiff_state->crop_x;
+
+    if (!TIFFRGBAImageGet(&tiff_state->image, rows, image->width, row_count)) {
         SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
     }
 
-    TIFFRGBAImageEnd(&tiff_state->image);
+    if (first_row + row_count == image->height) {
+        TIFFRGBAImageEnd(&tiff_state->image);
+    }
+
+    /*
+     * TIFFRGBAImageGet() outputs packed rows. Move them to their places from the last one
+     * when the caller has requested padded rows.
+     */
+    const unsigned packed_bytes_per_line = image->width * 4;
+
+    if (image->bytes_per_line > packed_bytes_per_line) {
+        for (unsigned row = row_count; row-- > 1;) {
+            memmove((unsigned char *)rows + (size_t)row * image->bytes_per_line,
+                    (unsigned char *)rows + (size_t)row * packed_bytes_per_line,
+                    packed_bytes_per_line);
+        }
+    }
 
     /* Swap colors. */
     if (tiff_state->read_options->output_pixel_format == SAIL_PIXEL_FORMAT_BPP32_BGRA) {
-        unsigned char *pixels = image->pixels;
-        const unsigned pixels_count = image->width * image->height;
-        unsigned char tmp;
-
-        for (unsigned i = 0; i < pixels_count; i++, pixels += 4) {
-            tmp = *pixels;
-            *pixels = *(pixels+2);
-            *(pixels+2) = tmp;
+        for (unsigned row = 0; row < row_count; row++) {
+            unsigned char *pixels = (unsigned char *)rows + (size_t)row * image->bytes_per_line;
+            unsigned char tmp;
+
+            for (unsigned i = 0; i < image->width; i++, pixels += 4) {
+                tmp = *pixels;
+                *pixels = *(pixels+2);
+                *(pixels+2) = tmp;
+            }
         }
     }
 
     return SAIL_OK;
 }
 
+SAIL_EXPORT sail_status_t sail_codec_read_frame_v4_tiff(void *state, struct sail_io *io, struct sail_image *image) {
+
+    SAIL_CHECK_IMAGE(image);
+
+    SAIL_TRY(sail_codec_read_rows_v4_tiff(state, io, image, /* first row */ 0, image->height, image->pixels));
+
+    return SAIL_OK;
+}
+
 SAIL_EXPORT sail_status_t sail_codec_read_finish_v4_tiff(void **state, struct sail_io *io) {
 
     SAIL_CHECK_STATE_PTR(state);
@@ -294,10 +784,284 @@ SAIL_EXPORT sail_status_t sail_codec_read_finish_v4_tiff(void **state, struct sa
     return SAIL_OK;
 }
 
+SAIL_EXPORT sail_status_t sail_codec_probe_v4_tiff(struct sail_io *io, const struct sail_read_options *read_options, struct sail_image **image) {
+
+    SAIL_CHECK_IO(io);
+    SAIL_CHECK_READ_OPTIONS_PTR(read_options);
+    SAIL_CHECK_IMAGE_PTR(image);
+
+    SAIL_TRY(tiff_private_supported_read_output_pixel_format(read_options->output_pixel_format));
+
+    /* Allocate a new state. */
+    struct tiff_state *tiff_state;
+    SAIL_TRY(alloc_tiff_state(&tiff_state));
+
+    void *state = tiff_state;
+
+    SAIL_TRY_OR_CLEANUP(init_read(tiff_state, io, read_options),
+                        /* cleanup */ sail_codec_read_finish_v4_tiff(&state, io));
+
+    /* TIFFClientOpen() has already read the first directory. Don't start RGBA decoding. */
+    SAIL_TRY_OR_CLEANUP(fetch_image(tiff_state, image),
+                        /* cleanup */ sail_codec_read_finish_v4_tiff(&state, io));
+
+    SAIL_TRY_OR_CLEANUP(sail_codec_read_finish_v4_tiff(&state, io),
+                        /* cleanup */ sail_destroy_image(*image));
+
+    return SAIL_OK;
+}
+
 /*
  * Encoding functions.
  */
 
+/* Sets the directory layout shared by the output and block TIFF handles. */
+static void set_write_layout(const struct tiff_state *tiff_state, TIFF *tiff, uint32_t width, uint32_t height) {
+
+    TIFFSetField(tiff, TIFFTAG_IMAGEWIDTH,      width);
+    TIFFSetField(tiff, TIFFTAG_IMAGELENGTH,     height);
+    TIFFSetField(tiff, TIFFTAG_ORIENTATION,     ORIENTATION_TOPLEFT);
+    TIFFSetField(tiff, TIFFTAG_SAMPLESPERPIXEL, tiff_state->layout.samples_per_pixel);
+    TIFFSetField(tiff, TIFFTAG_BITSPERSAMPLE,   tiff_state->layout.bits_per_sample);
+    TIFFSetField(tiff, TIFFTAG_PLANARCONFIG,    PLANARCONFIG_CONTIG);
+    TIFFSetField(tiff, TIFFTAG_PHOTOMETRIC,     tiff_state->layout.photometric);
+    TIFFSetField(tiff, TIFFTAG_COMPRESSION,     tiff_state->write_compression);
+
+    if (tiff_state->layout.alpha) {
+        const uint16_t extra_samples[] = { EXTRASAMPLE_UNASSALPHA };
+        TIFFSetField(tiff, TIFFTAG_EXTRASAMPLES, 1, extra_samples);
+    }
+
+    if (tiff_state->predictor != PREDICTOR_NONE) {
+        TIFFSetField(tiff, TIFFTAG_PREDICTOR, tiff_state->predictor);
+    }
+}
+
+/* Copies the strip or tile from the image. Returns the number of rows in the block. */
+static uint32_t copy_block(const struct tiff_state *tiff_state, const struct sail_image *image, uint32_t block, unsigned char *dst) {
+
+    const size_t block_row_size = tiff_state->block_width * tiff_state->bytes_per_pixel;
+    uint32_t x = 0;
+    uint32_t y;
+    uint32_t rows;
+
+    if (tiff_state->tiled) {
+        x = (block % tiff_state->tiles_across) * tiff_state->block_width;
+        y = (block / tiff_state->tiles_across) * tiff_state->block_height;
+    } else {
+        y = block * tiff_state->block_height;
+    }
+
+    const uint32_t columns = (image->width - x < tiff_state->block_width) ? image->width - x : tiff_state->block_width;
+    rows = (image->height - y < tiff_state->block_height) ? image->height - y : tiff_state->block_height;
+
+    /* Pad edge tiles. */
+    if (tiff_state->tiled && (columns < tiff_state->block_width || rows < tiff_state->block_height)) {
+        memset(dst, 0, (size_t)tiff_state->tile_size);
+    }
+
+    for (uint32_t row = 0; row < rows; row++) {
+        memcpy(dst + row * block_row_size,
+                (const unsigned char *)image->pixels + (size_t)(y + row) * image->bytes_per_line + x * tiff_state->bytes_per_pixel,
+                columns * tiff_state->bytes_per_pixel);
+    }
+
+    /* Tiles are always complete. */
+    return tiff_state->tiled ? tiff_state->block_height : rows;
+}
+
+/* Compresses the block into the memory file with a separate TIFF handle. Leaves only the compressed data in the file. */
+static sail_status_t compress_block(const struct tiff_state *tiff_state, unsigned char *block, uint32_t rows, struct tiff_memory_file *file) {
+
+    file->size     = 0;
+    file->position = 0;
+
+    TIFF *tiff = TIFFClientOpen("tiff-sail-codec",
+                                "wm",
+                                file,
+                                tiff_private_memory_read_proc,
+                                tiff_private_memory_write_proc,
+                                tiff_private_memory_seek_proc,
+                                tiff_private_my_dummy_close_proc,
+                                tiff_private_memory_size_proc,
+                                /* map */ NULL,
+                                /* unmap */ NULL);
+
+    if (tiff == NULL) {
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
+    }
+
+    /* The block is a single strip of the same width. */
+    set_write_layout(tiff_state, tiff, tiff_state->block_width, rows);
+    TIFFSetField(tiff, TIFFTAG_ROWSPERSTRIP, rows);
+
+    const tmsize_t block_size = (tmsize_t)(rows * tiff_state->block_width * tiff_state->bytes_per_pixel);
+
+    uint64_t *offsets;
+    uint64_t *byte_counts;
+
+    if (TIFFWriteEncodedStrip(tiff, 0, block, block_size) < 0 ||
+            !TIFFGetField(tiff, TIFFTAG_STRIPOFFSETS, &offsets) ||
+            !TIFFGetField(tiff, TIFFTAG_STRIPBYTECOUNTS, &byte_counts)) {
+        TIFFCleanup(tiff);
+        SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
+    }
+
+    const size_t offset = (size_t)offsets[0];
+    const size_t size   = (size_t)byte_counts[0];
+
+    /* Flushes the directory after the compressed data. */
+    TIFFCleanup(tiff);
+
+    memmove(file->data, file->data + offset, size);
+    file->size = size;
+
+    return SAIL_OK;
+}
+
+struct encode_blocks_job {
+    const struct tiff_state *tiff_state;
+    const struct sail_image *image;
+    uint32_t first_block;
+};
+
+static sail_status_t encode_block_job(void *context, unsigned job, unsigned worker) {
+
+    const struct encode_blocks_job *encode_job = context;
+    const struct tiff_state *tiff_state = encode_job->tiff_state;
+    unsigned char *tile = tiff_private_handle_tile(tiff_state->handles, worker);
+
+    const uint32_t rows = copy_block(tiff_state, encode_job->image, encode_job->first_block + job, tile);
+
+    SAIL_TRY(compress_block(tiff_state, tile, rows, &tiff_state->encoded[job]));
+
+    return SAIL_OK;
+}
+
+/* Compresses batches of strips or tiles in parallel and writes them in order. */
+static sail_status_t write_blocks_in_parallel(struct tiff_state *tiff_state, const struct sail_image *image) {
+
+    for (uint32_t first_block = 0; first_block < tiff_state->blocks_count; first_block += tiff_state->encoded_count) {
+        const unsigned count = (tiff_state->blocks_count - first_block < tiff_state->encoded_count)
+                                ? tiff_state->blocks_count - first_block
+                                : tiff_state->encoded_count;
+
+        struct encode_blocks_job encode_job = { tiff_state, image, first_block };
+        SAIL_TRY(sail_thread_pool_run(tiff_state->pool, count, encode_block_job, &encode_job));
+
+        for (unsigned i = 0; i < count; i++) {
+            const struct tiff_memory_file *file = &tiff_state->encoded[i];
+
+            const tmsize_t written = tiff_state->tiled
+                ? TIFFWriteRawTile(tiff_state->tiff, first_block + i, file->data, (tmsize_t)file->size)
+                : TIFFWriteRawStrip(tiff_state->tiff, first_block + i, file->data, (tmsize_t)file->size);
+
+            if (written < 0) {
+                SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
+            }
+        }
+    }
+
+    return SAIL_OK;
+}
+
+static sail_status_t write_blocks(struct tiff_state *tiff_state, const struct sail_image *image) {
+
+    for (uint32_t block = 0; block < tiff_state->blocks_count; block++) {
+        const uint32_t rows = copy_block(tiff_state, image, block, tiff_state->block);
+
+        const tmsize_t written = tiff_state->tiled
+            ? TIFFWriteEncodedTile(tiff_state->tiff, block, tiff_state->block, tiff_state->tile_size)
+            : TIFFWriteEncodedStrip(tiff_state->tiff, block, tiff_state->block,
+                                    (tmsize_t)(rows * tiff_state->block_width * tiff_state->bytes_per_pixel));
+
+        if (written < 0) {
+            SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
+        }
+    }
+
+    return SAIL_OK;
+}
+
+/* Allocates the block and encoding threads for the current frame. */
+static sail_status_t init_blocks(struct tiff_state *tiff_state, struct sail_io *io, const struct sail_image *image) {
+
+    TIFF *tiff = tiff_state->tiff;
+    const unsigned threads = tiff_state->write_options->threads;
+    const bool parallel = threads > 1 && tiff_private_compression_is_independent(tiff_state->write_compression);
+
+    tiff_state->bytes_per_pixel = (size_t)tiff_state->layout.samples_per_pixel * tiff_state->layout.bits_per_sample / 8;
+    tiff_state->row_size        = (tmsize_t)(image->width * tiff_state->bytes_per_pixel);
+    tiff_state->tiled           = tiff_state->write_options->tile_width > 0 && tiff_state->write_options->tile_height > 0;
+
+    if (tiff_state->tiled) {
+        /* Tile dimensions must be multiples of 16. */
+        const uint32_t tile_width  = (tiff_state->write_options->tile_width  + 15) / 16 * 16;
+        const uint32_t tile_length = (tiff_state->write_options->tile_height + 15) / 16 * 16;
+
+        TIFFSetField(tiff, TIFFTAG_TILEWIDTH,  tile_width);
+        TIFFSetField(tiff, TIFFTAG_TILELENGTH, tile_length);
+
+        tiff_state->block_width  = tile_width;
+        tiff_state->block_height = tile_length;
+        tiff_state->tiles_across = (image->width + tile_width - 1) / tile_width;
+        tiff_state->blocks_count = tiff_state->tiles_across * ((image->height + tile_length - 1) / tile_length);
+    } else {
+        uint32_t rows_per_strip = TIFFDefaultStripSize(tiff, (uint32_t)-1);
+
+        /* Larger strips amortize the cost of separate TIFF handles. */
+        if (parallel) {
+            const uint32_t min_rows = (uint32_t)(262144 / tiff_state->row_size);
+
+            if (rows_per_strip < min_rows) {
+                rows_per_strip = min_rows;
+            }
+        }
+
+        if (rows_per_strip == 0 || rows_per_strip > image->height) {
+            rows_per_strip = image->height;
+        }
+
+        TIFFSetField(tiff, TIFFTAG_ROWSPERSTRIP, rows_per_strip);
+
+        tiff_state->block_width  = image->width;
+        tiff_state->block_height = rows_per_strip;
+        tiff_state->blocks_count = (image->height + rows_per_strip - 1) / rows_per_strip;
+    }
+
+    tiff_state->tile_size = (tmsize_t)(tiff_state->block_width * tiff_state->block_height * tiff_state->bytes_per_pixel);
+
+    tiff_state->parallel = parallel;
+
+    if (parallel) {
+        SAIL_TRY(alloc_workers(tiff_state, io, threads));
+
+        if (tiff_state->encoded == NULL) {
+            const unsigned encoded_count = (sail_thread_pool_threads(tiff_state->pool) + 1) * 4;
+
+            /* Batches of blocks written after compressing them. */
+            void *ptr;
+            SAIL_TRY(sail_calloc(encoded_count, sizeof(struct tiff_memory_file), &ptr));
+            tiff_state->encoded       = ptr;
+            tiff_state->encoded_count = encoded_count;
+        }
+
+        SAIL_TRY(tiff_private_handles_set_tile_size(tiff_state->handles, tiff_state->tile_size));
+    } else {
+        sail_free(tiff_state->block);
+        tiff_state->block = NULL;
+
+        void *ptr;
+        SAIL_TRY(sail_malloc((size_t)tiff_state->tile_size, &ptr));
+        tiff_state->block = ptr;
+    }
+
+    SAIL_LOG_DEBUG("TIFF: Writing %u %s of %ux%u%s", tiff_state->blocks_count, tiff_state->tiled ? "tiles" : "strips",
+                    tiff_state->block_width, tiff_state->block_height, parallel ? " in parallel" : "");
+
+    return SAIL_OK;
+}
+
 SAIL_EXPORT sail_status_t sail_codec_write_init_v4_tiff(struct sail_io *io, const struct sail_write_options *write_options, void **state) {
 
     SAIL_CHECK_STATE_PTR(state);
@@ -318,6 +1082,14 @@ SAIL_EXPORT sail_status_t sail_codec_write_init_v4_tiff(struct sail_io *io, cons
     SAIL_TRY(tiff_private_supported_write_output_pixel_format(tiff_state->write_options->output_pixel_format));
     SAIL_TRY(tiff_private_sail_compression_to_compression(tiff_state->write_options->compression, &tiff_state->write_compression));
 
+    if (tiff_state->write_options->filter == SAIL_FILTER_SUB) {
+        if (tiff_private_predictor_supported(tiff_state->write_compression)) {
+            tiff_state->predictor = PREDICTOR_HORIZONTAL;
+        } else {
+            SAIL_LOG_WARNING("TIFF: Horizontal predictor is not supported with the selected compression, ignoring");
+        }
+    }
+
     TIFFSetWarningHandler(tiff_private_my_warning_fn);
     TIFFSetErrorHandler(tiff_private_my_error_fn);
 
@@ -357,17 +1129,10 @@ SAIL_EXPORT sail_status_t sail_codec_write_seek_next_frame_v4_tiff(void *state,
         SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
     }
 
-    tiff_state->line = 0;
+    SAIL_TRY(tiff_private_write_layout(image->pixel_format, &tiff_state->layout));
 
-    TIFFSetField(tiff_state->tiff, TIFFTAG_IMAGEWIDTH,  image->width);
-    TIFFSetField(tiff_state->tiff, TIFFTAG_IMAGELENGTH, image->height);
-    TIFFSetField(tiff_state->tiff, TIFFTAG_ORIENTATION, ORIENTATION_TOPLEFT);
-    TIFFSetField(tiff_state->tiff, TIFFTAG_SAMPLESPERPIXEL, 4);
-    TIFFSetField(tiff_state->tiff, TIFFTAG_BITSPERSAMPLE, 8);
-    TIFFSetField(tiff_state->tiff, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
-    TIFFSetField(tiff_state->tiff, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_RGB);
-    TIFFSetField(tiff_state->tiff, TIFFTAG_COMPRESSION, tiff_state->write_compression);
-    TIFFSetField(tiff_state->tiff, TIFFTAG_ROWSPERSTRIP, TIFFDefaultStripSize(tiff_state->tiff, (uint32)-1));
+    set_write_layout(tiff_state, tiff_state->tiff, image->width, image->height);
+    SAIL_TRY(init_blocks(tiff_state, io, image));
 
     /* Write ICC profile. */
     if (tiff_state->write_options->io_options & SAIL_IO_OPTION_ICCP && image->iccp != NULL) {
@@ -414,10 +1179,10 @@ SAIL_EXPORT sail_status_t sail_codec_write_frame_v4_tiff(void *state, struct sai
         SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
     }
 
-    for (unsigned row = 0; row < image->height; row++) {
-        if (TIFFWriteScanline(tiff_state->tiff, (unsigned char *)image->pixels + row * image->bytes_per_line, tiff_state->line++, 0) < 0) {
-            SAIL_LOG_AND_RETURN(SAIL_ERROR_UNDERLYING_CODEC);
-        }
+    if (tiff_state->parallel) {
+        SAIL_TRY(write_blocks_in_parallel(tiff_state, image));
+    } else {
+        SAIL_TRY(write_blocks(tiff_state, image));
     }
 
     if (!TIFFWriteDirectory(tiff_state->tiff)) {
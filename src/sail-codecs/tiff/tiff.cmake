@@ -8,6 +8,12 @@ macro(sail_find_dependencies)
     set(sail_tiff_include_dirs ${TIFF_INCLUDE_DIRS})
     set(sail_tiff_libs ${TIFF_LIBRARIES})
 
+    # Lock of the I/O object shared by tile decoding threads
+    #
+    if (UNIX)
+        list(APPEND sail_tiff_libs pthread)
+    endif()
+
     set(SAIL_CODECS_FIND_DEPENDENCIES ${SAIL_CODECS_FIND_DEPENDENCIES} "TIFF,TIFF::TIFF" PARENT_SCOPE)
 endmacro()
 
@@ -0,0 +1,300 @@
+/*  This file is part of SAIL (https://github.com/smoked-herring/sail)
+
+    Copyright (c) 2020 Dmitry Baryshev
+
+    The MIT License
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "sail-common.h"
+#include "sail.h"
+#include "sail-c++.h"
+
+#include "munit.h"
+
+// More items than threads, so workers steal items from each other
+//
+static const unsigned ITEMS_COUNT = 24;
+
+// Runs of items of the same codec. JPEG resets the reading state of the previous item
+//
+static const unsigned CODEC_RUN = 4;
+
+// The item which fails to read in the middle of a JPEG run
+//
+static const unsigned CORRUPT_ITEM = 5;
+
+/*
+ * Helpers.
+ */
+
+static const char* item_extension(unsigned index)
+{
+    return ((index / CODEC_RUN) % 2 == 0) ? "jpg" : "png";
+}
+
+// Encodes a gradient image of the specified size with the specified codec
+//
+static std::vector<uint8_t> encode_image(const char *extension, unsigned width, unsigned height)
+{
+    sail_image *image;
+    munit_assert(sail_alloc_image(&image) == SAIL_OK);
+
+    image->width          = width;
+    image->height         = height;
+    image->pixel_format   = SAIL_PIXEL_FORMAT_BPP24_RGB;
+    image->bytes_per_line = image->width * 3;
+
+    void *pixels;
+    munit_assert(sail_malloc_pixels(static_cast<size_t>(image->bytes_per_line) * image->height, &pixels) == SAIL_OK);
+    image->pixels = pixels;
+
+    for (unsigned y = 0; y < image->height; y++) {
+        uint8_t *pixel = static_cast<uint8_t *>(image->pixels) + static_cast<size_t>(y) * image->bytes_per_line;
+
+        for (unsigned x = 0; x < image->width; x++, pixel += 3) {
+            pixel[0] = static_cast<uint8_t>(x * 3);
+            pixel[1] = static_cast<uint8_t>(y * 5);
+            pixel[2] = static_cast<uint8_t>(x + y);
+        }
+    }
+
+    const sail_codec_info *codec_info;
+    munit_assert(sail_codec_info_from_extension(extension, &codec_info) == SAIL_OK);
+
+    void *data = nullptr;
+    size_t size;
+    munit_assert(sail_write_growable_mem(&data, &size, image, codec_info) == SAIL_OK);
+
+    std::vector<uint8_t> result(static_cast<uint8_t *>(data), static_cast<uint8_t *>(data) + size);
+
+    sail_free(data);
+    sail_destroy_image(image);
+
+    return result;
+}
+
+// Checks that the pixels match row by row. Padding is not compared
+//
+static void assert_same_pixels(const sail::image &image, const sail::image &reference)
+{
+    munit_assert(image.is_valid());
+    munit_assert(reference.is_valid());
+
+    munit_assert_uint(image.width(),       ==, reference.width());
+    munit_assert_uint(image.height(),      ==, reference.height());
+    munit_assert_int(image.pixel_format(), ==, reference.pixel_format());
+
+    unsigned bytes_per_line;
+    munit_assert(sail::image::bytes_per_line(image.width(), image.pixel_format(), &bytes_per_line) == SAIL_OK);
+
+    for (unsigned y = 0; y < image.height(); y++) {
+        munit_assert_memory_equal(bytes_per_line,
+                                  static_cast<const uint8_t *>(image.pixels()) + static_cast<size_t>(y) * image.bytes_per_line(),
+                                  static_cast<const uint8_t *>(reference.pixels()) + static_cast<size_t>(y) * reference.bytes_per_line());
+    }
+}
+
+// Encoded images with their references read in the calling thread
+//
+struct batch_fixture
+{
+    batch_fixture()
+    {
+        for (unsigned i = 0; i < ITEMS_COUNT; i++) {
+            // Different sizes make JPEG reset its state for a really different image
+            //
+            data.push_back(encode_image(item_extension(i), 17 + i * 5, 11 + i * 3));
+
+            if (i == CORRUPT_ITEM) {
+                // Keep the magic number, so the codec is detected, but break everything after it
+                //
+                for (size_t k = 4; k < data[i].size(); k++) {
+                    data[i][k] = static_cast<uint8_t>(k * 7);
+                }
+
+                references.emplace_back();
+            } else {
+                sail::image reference;
+                munit_assert(sail::image_reader().read(data[i].data(), data[i].size(), &reference) == SAIL_OK);
+                references.push_back(std::move(reference));
+            }
+
+            paths.push_back("batch_reader-" + std::to_string(i) + "." + item_extension(i));
+
+            FILE *file = std::fopen(paths[i].c_str(), "wb");
+            munit_assert_not_null(file);
+            munit_assert_size(std::fwrite(data[i].data(), 1, data[i].size(), file), ==, data[i].size());
+            munit_assert_int(std::fclose(file), ==, 0);
+
+            buffers.emplace_back(data[i].data(), data[i].size());
+        }
+    }
+
+    ~batch_fixture()
+    {
+        for (const std::string &path : paths) {
+            std::remove(path.c_str());
+        }
+    }
+
+    std::vector<std::vector<uint8_t>> data;
+    std::vector<sail::image> references;
+    std::vector<std::string> paths;
+    std::vector<std::pair<const void *, size_t>> buffers;
+};
+
+// Collects the results of a batch and checks them against the references
+//
+class batch_results
+{
+public:
+    explicit batch_results(const batch_fixture &fixture)
+        : m_fixture(fixture),
+          m_calls(ITEMS_COUNT, 0),
+          m_status(ITEMS_COUNT, SAIL_OK),
+          m_images(ITEMS_COUNT)
+    {
+    }
+
+    sail::batch_reader::callback_t callback()
+    {
+        return [this](unsigned index, sail_status_t status, sail::image &&image) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            m_calls[index]++;
+            m_status[index] = status;
+            m_images[index] = std::move(image);
+        };
+    }
+
+    // Compares the pixels with the references read with the default options, or checks the pixel format
+    //
+    void check(SailPixelFormat pixel_format = SAIL_PIXEL_FORMAT_UNKNOWN) const
+    {
+        for (unsigned i = 0; i < ITEMS_COUNT; i++) {
+            munit_assert_uint(m_calls[i], ==, 1);
+
+            if (i == CORRUPT_ITEM) {
+                munit_assert_int(m_status[i], !=, SAIL_OK);
+                munit_assert(!m_images[i].is_valid());
+            } else if (pixel_format == SAIL_PIXEL_FORMAT_UNKNOWN) {
+                munit_assert_int(m_status[i], ==, SAIL_OK);
+                assert_same_pixels(m_images[i], m_fixture.references[i]);
+            } else {
+                munit_assert_int(m_status[i], ==, SAIL_OK);
+                munit_assert_uint(m_images[i].width(),       ==, m_fixture.references[i].width());
+                munit_assert_uint(m_images[i].height(),      ==, m_fixture.references[i].height());
+                munit_assert_int(m_images[i].pixel_format(), ==, pixel_format);
+            }
+        }
+    }
+
+private:
+    const batch_fixture &m_fixture;
+    std::mutex m_mutex;
+    std::vector<unsigned> m_calls;
+    std::vector<sail_status_t> m_status;
+    std::vector<sail::image> m_images;
+};
+
+/*
+ * Batch reading.
+ */
+static MunitResult test_read(const MunitParameter params[], void *user_data)
+{
+    (void)params;
+    (void)user_data;
+
+    const batch_fixture fixture;
+
+    // A single worker reads all the items in order. 0 means the number of online processors
+    //
+    for (unsigned threads : { 1u, 3u, 8u, 0u }) {
+        sail::batch_reader reader(threads);
+        munit_assert(reader.is_valid());
+
+        // Workers and their codecs stay warm between batches
+        //
+        for (unsigned batch = 0; batch < 2; batch++) {
+            batch_results path_results(fixture);
+            munit_assert(reader.read(fixture.paths, path_results.callback()) == SAIL_OK);
+            path_results.check();
+
+            batch_results buffer_results(fixture);
+            munit_assert(reader.read(fixture.buffers, buffer_results.callback()) == SAIL_OK);
+            buffer_results.check();
+        }
+    }
+
+    return MUNIT_OK;
+}
+
+static MunitResult test_read_options(const MunitParameter params[], void *user_data)
+{
+    (void)params;
+    (void)user_data;
+
+    const batch_fixture fixture;
+
+    sail::read_options read_options;
+    read_options.with_output_pixel_format(SAIL_PIXEL_FORMAT_BPP24_RGB);
+
+    sail::batch_reader reader(3);
+    munit_assert(reader.is_valid());
+
+    batch_results path_results(fixture);
+    munit_assert(reader.read(fixture.paths, read_options, path_results.callback()) == SAIL_OK);
+    path_results.check(SAIL_PIXEL_FORMAT_BPP24_RGB);
+
+    batch_results buffer_results(fixture);
+    munit_assert(reader.read(fixture.buffers, read_options, buffer_results.callback()) == SAIL_OK);
+    buffer_results.check(SAIL_PIXEL_FORMAT_BPP24_RGB);
+
+    return MUNIT_OK;
+}
+
+static MunitTest test_suite_tests[] = {
+    { (char *)"/read",         test_read,         nullptr, nullptr, MUNIT_TEST_OPTION_NONE, nullptr },
+    { (char *)"/read-options", test_read_options, nullptr, nullptr, MUNIT_TEST_OPTION_NONE, nullptr },
+
+    { nullptr, nullptr, nullptr, nullptr, MUNIT_TEST_OPTION_NONE, nullptr }
+};
+
+static const MunitSuite test_suite = {
+    (char *)"/batch_reader",
+    test_suite_tests,
+    nullptr,
+    1,
+    MUNIT_SUITE_OPTION_NONE
+};
+
+int main(int argc, char *argv[MUNIT_ARRAY_PARAM(argc + 1)])
+{
+    return munit_suite_main(&test_suite, nullptr, argc, argv);
+}
@@ -0,0 +1,432 @@
+/*  This file is part of SAIL (https://github.com/smoked-herring/sail)
+
+    Copyright (c) 2020 Dmitry Baryshev
+
+    The MIT License
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sail-common.h"
+#include "sail.h"
+
+#include "munit.h"
+
+/* More items than threads, so workers steal items from each other. */
+#define ITEMS_COUNT 24
+
+/* Runs of items of the same codec. JPEG resets the reading state of the previous item. */
+#define CODEC_RUN 4
+
+/* The item which fails to read in the middle of a JPEG run. */
+#define CORRUPT_ITEM 5
+
+/*
+ * Helpers.
+ */
+
+/* Encodes a gradient image of the specified size with the specified codec. The data must be freed with sail_free(). */
+static void encode_image(const char *extension, unsigned width, unsigned height, void **data, size_t *size) {
+
+    struct sail_image *image;
+    munit_assert(sail_alloc_image(&image) == SAIL_OK);
+
+    image->width          = width;
+    image->height         = height;
+    image->pixel_format   = SAIL_PIXEL_FORMAT_BPP24_RGB;
+    image->bytes_per_line = image->width * 3;
+
+    munit_assert(sail_malloc_pixels((size_t)image->bytes_per_line * image->height, &image->pixels) == SAIL_OK);
+
+    for (unsigned y = 0; y < image->height; y++) {
+        uint8_t *pixel = (uint8_t *)image->pixels + (size_t)y * image->bytes_per_line;
+
+        for (unsigned x = 0; x < image->width; x++, pixel += 3) {
+            pixel[0] = (uint8_t)(x * 3);
+            pixel[1] = (uint8_t)(y * 5);
+            pixel[2] = (uint8_t)(x + y);
+        }
+    }
+
+    const struct sail_codec_info *codec_info;
+    munit_assert(sail_codec_info_from_extension(extension, &codec_info) == SAIL_OK);
+
+    *data = NULL;
+    munit_assert(sail_write_growable_mem(data, size, image, codec_info) == SAIL_OK);
+
+    sail_destroy_image(image);
+}
+
+/* Checks that the pixels match row by row. Padding is not compared. */
+static void assert_same_pixels(const struct sail_image *image, const struct sail_image *reference) {
+
+    munit_assert_uint(image->width,       ==, reference->width);
+    munit_assert_uint(image->height,      ==, reference->height);
+    munit_assert_int(image->pixel_format, ==, reference->pixel_format);
+
+    unsigned bytes_per_line;
+    munit_assert(sail_bytes_per_line(image->width, image->pixel_format, &bytes_per_line) == SAIL_OK);
+
+    for (unsigned y = 0; y < image->height; y++) {
+        munit_assert_memory_equal(bytes_per_line,
+                                  (const uint8_t *)image->pixels + (size_t)y * image->bytes_per_line,
+                                  (const uint8_t *)reference->pixels + (size_t)y * reference->bytes_per_line);
+    }
+}
+
+/*
+ * Custom I/O reading from memory. It provides no contiguous buffer, so codecs read it
+ * through the callbacks.
+ */
+static const uint64_t TEST_IO_ID = UINT64_C(0x62617463682d696f);
+
+struct test_stream {
+    const uint8_t *data;
+    size_t size;
+    size_t pos;
+};
+
+static sail_status_t test_tolerant_read(void *stream, void *buf, size_t size_to_read, size_t *read_size) {
+
+    struct test_stream *test_stream = stream;
+
+    *read_size = 0;
+
+    if (test_stream->pos >= test_stream->size) {
+        return SAIL_ERROR_EOF;
+    }
+
+    *read_size = (test_stream->size - test_stream->pos < size_to_read) ? test_stream->size - test_stream->pos : size_to_read;
+    memcpy(buf, test_stream->data + test_stream->pos, *read_size);
+    test_stream->pos += *read_size;
+
+    return SAIL_OK;
+}
+
+static sail_status_t test_strict_read(void *stream, void *buf, size_t size_to_read) {
+
+    size_t read_size;
+    SAIL_TRY(test_tolerant_read(stream, buf, size_to_read, &read_size));
+
+    return (read_size == size_to_read) ? SAIL_OK : SAIL_ERROR_READ_IO;
+}
+
+static sail_status_t test_seek(void *stream, long offset, int whence) {
+
+    struct test_stream *test_stream = stream;
+
+    long base;
+
+    switch (whence) {
+        case SEEK_SET: base = 0;                        break;
+        case SEEK_CUR: base = (long)test_stream->pos;   break;
+        case SEEK_END: base = (long)test_stream->size;  break;
+        default:       return SAIL_ERROR_UNSUPPORTED_SEEK_WHENCE;
+    }
+
+    if (base + offset < 0) {
+        return SAIL_ERROR_SEEK_IO;
+    }
+
+    test_stream->pos = (size_t)(base + offset);
+
+    return SAIL_OK;
+}
+
+static sail_status_t test_tell(void *stream, size_t *offset) {
+
+    *offset = ((struct test_stream *)stream)->pos;
+
+    return SAIL_OK;
+}
+
+static sail_status_t test_tolerant_write(void *stream, const void *buf, size_t size_to_write, size_t *written_size) {
+
+    (void)stream;
+    (void)buf;
+    (void)size_to_write;
+    (void)written_size;
+
+    return SAIL_ERROR_NOT_IMPLEMENTED;
+}
+
+static sail_status_t test_strict_write(void *stream, const void *buf, size_t size_to_write) {
+
+    (void)stream;
+    (void)buf;
+    (void)size_to_write;
+
+    return SAIL_ERROR_NOT_IMPLEMENTED;
+}
+
+static sail_status_t test_flush(void *stream) {
+
+    (void)stream;
+
+    return SAIL_OK;
+}
+
+static sail_status_t test_close(void *stream) {
+
+    (void)stream;
+
+    return SAIL_OK;
+}
+
+static sail_status_t test_eof(void *stream, bool *result) {
+
+    const struct test_stream *test_stream = stream;
+
+    *result = test_stream->pos >= test_stream->size;
+
+    return SAIL_OK;
+}
+
+static struct sail_io* alloc_test_io(struct test_stream *test_stream) {
+
+    struct sail_io *io;
+    munit_assert(sail_alloc_io(&io) == SAIL_OK);
+
+    io->id             = TEST_IO_ID;
+    io->stream         = test_stream;
+    io->tolerant_read  = test_tolerant_read;
+    io->strict_read    = test_strict_read;
+    io->seek           = test_seek;
+    io->tell           = test_tell;
+    io->tolerant_write = test_tolerant_write;
+    io->strict_write   = test_strict_write;
+    io->flush          = test_flush;
+    io->close          = test_close;
+    io->eof            = test_eof;
+
+    return io;
+}
+
+/* Encoded images with their references read in the calling thread. */
+struct batch_fixture {
+    void *data[ITEMS_COUNT];
+    size_t size[ITEMS_COUNT];
+    char path[ITEMS_COUNT][32];
+    struct sail_image *reference[ITEMS_COUNT];
+
+    struct test_stream stream[ITEMS_COUNT];
+    struct sail_io *io[ITEMS_COUNT];
+
+    struct sail_batch_item items[ITEMS_COUNT];
+};
+
+/* Items are paths, buffers, and I/O objects in turn. Codecs change every CODEC_RUN items. */
+static void init_fixture(struct batch_fixture *fixture) {
+
+    memset(fixture, 0, sizeof(*fixture));
+
+    for (unsigned i = 0; i < ITEMS_COUNT; i++) {
+        const char *extension = ((i / CODEC_RUN) % 2 == 0) ? "jpg" : "png";
+
+        /* Different sizes make JPEG reset its state for a really different image. */
+        encode_image(extension, 17 + i * 5, 11 + i * 3, &fixture->data[i], &fixture->size[i]);
+
+        if (i == CORRUPT_ITEM) {
+            /* Keep the magic number, so the codec is detected, but break everything after it. */
+            for (size_t k = 4; k < fixture->size[i]; k++) {
+                ((uint8_t *)fixture->data[i])[k] = (uint8_t)(k * 7);
+            }
+        } else {
+            munit_assert(sail_read_mem(fixture->data[i], fixture->size[i], &fixture->reference[i]) == SAIL_OK);
+        }
+
+        switch (i % 3) {
+            case 0: {
+                snprintf(fixture->path[i], sizeof(fixture->path[i]), "batch-%u.%s", i, extension);
+
+                FILE *file = fopen(fixture->path[i], "wb");
+                munit_assert_not_null(file);
+                munit_assert_size(fwrite(fixture->data[i], 1, fixture->size[i], file), ==, fixture->size[i]);
+                munit_assert_int(fclose(file), ==, 0);
+
+                fixture->items[i].path = fixture->path[i];
+                break;
+            }
+            case 1: {
+                fixture->items[i].buffer        = fixture->data[i];
+                fixture->items[i].buffer_length = fixture->size[i];
+                break;
+            }
+            default: {
+                fixture->stream[i].data = fixture->data[i];
+                fixture->stream[i].size = fixture->size[i];
+                fixture->io[i] = alloc_test_io(&fixture->stream[i]);
+
+                fixture->items[i].io = fixture->io[i];
+                break;
+            }
+        }
+    }
+}
+
+static void destroy_fixture(struct batch_fixture *fixture) {
+
+    for (unsigned i = 0; i < ITEMS_COUNT; i++) {
+        if (fixture->items[i].path != NULL) {
+            remove(fixture->path[i]);
+        }
+
+        sail_destroy_io(fixture->io[i]);
+        sail_destroy_image(fixture->reference[i]);
+        sail_free(fixture->data[i]);
+    }
+}
+
+/* Results collected by the callback. Every item has its own slot, so no locking is needed. */
+struct batch_results {
+    unsigned calls[ITEMS_COUNT];
+    sail_status_t status[ITEMS_COUNT];
+    struct sail_image *image[ITEMS_COUNT];
+};
+
+static void batch_callback(unsigned index, sail_status_t status, struct sail_image *image, void *user_data) {
+
+    struct batch_results *results = user_data;
+
+    results->calls[index]++;
+    results->status[index] = status;
+    results->image[index]  = image;
+}
+
+static void assert_results(const struct batch_fixture *fixture, struct batch_results *results) {
+
+    for (unsigned i = 0; i < ITEMS_COUNT; i++) {
+        munit_assert_uint(results->calls[i], ==, 1);
+
+        if (i == CORRUPT_ITEM) {
+            munit_assert_int(results->status[i], !=, SAIL_OK);
+            munit_assert_null(results->image[i]);
+        } else {
+            munit_assert_int(results->status[i], ==, SAIL_OK);
+            munit_assert_not_null(results->image[i]);
+
+            assert_same_pixels(results->image[i], fixture->reference[i]);
+        }
+
+        sail_destroy_image(results->image[i]);
+    }
+}
+
+/*
+ * Batch reading.
+ */
+static MunitResult test_read_batch(const MunitParameter params[], void *user_data) {
+    (void)params;
+    (void)user_data;
+
+    static struct batch_fixture fixture;
+    init_fixture(&fixture);
+
+    /* A single worker reads all the items in order. 0 means the number of online processors. */
+    static const unsigned threads[] = { 1, 3, 8, 0 };
+
+    for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); t++) {
+        struct sail_batch_reader *batch_reader;
+        munit_assert(sail_alloc_batch_reader(threads[t], &batch_reader) == SAIL_OK);
+
+        /* Workers and their codecs stay warm between batches. */
+        for (unsigned batch = 0; batch < 2; batch++) {
+            for (unsigned i = 0; i < ITEMS_COUNT; i++) {
+                fixture.stream[i].pos = 0;
+            }
+
+            static struct batch_results results;
+            memset(&results, 0, sizeof(results));
+
+            munit_assert(sail_read_batch(batch_reader, fixture.items, ITEMS_COUNT, NULL, batch_callback, &results) == SAIL_OK);
+
+            assert_results(&fixture, &results);
+        }
+
+        sail_destroy_batch_reader(batch_reader);
+    }
+
+    destroy_fixture(&fixture);
+
+    return MUNIT_OK;
+}
+
+static MunitResult test_read_files_batch(const MunitParameter params[], void *user_data) {
+    (void)params;
+    (void)user_data;
+
+    static struct batch_fixture fixture;
+    init_fixture(&fixture);
+
+    /* Every item as a file. */
+    const char *paths[ITEMS_COUNT];
+    char path[ITEMS_COUNT][32];
+
+    for (unsigned i = 0; i < ITEMS_COUNT; i++) {
+        snprintf(path[i], sizeof(path[i]), "batch-file-%u.%s", i, ((i / CODEC_RUN) % 2 == 0) ? "jpg" : "png");
+
+        FILE *file = fopen(path[i], "wb");
+        munit_assert_not_null(file);
+        munit_assert_size(fwrite(fixture.data[i], 1, fixture.size[i], file), ==, fixture.size[i]);
+        munit_assert_int(fclose(file), ==, 0);
+
+        paths[i] = path[i];
+    }
+
+    static struct batch_results results;
+    memset(&results, 0, sizeof(results));
+
+    munit_assert(sail_read_files_batch(paths, ITEMS_COUNT, 3, batch_callback, &results) == SAIL_OK);
+
+    assert_results(&fixture, &results);
+
+    for (unsigned i = 0; i < ITEMS_COUNT; i++) {
+        remove(path[i]);
+    }
+
+    destroy_fixture(&fixture);
+
+    return MUNIT_OK;
+}
+
+static MunitTest test_suite_tests[] = {
+    { (char *)"/read-batch",       test_read_batch,       NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+    { (char *)"/read-files-batch", test_read_files_batch, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+
+    { NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL }
+};
+
+static const MunitSuite test_suite = {
+    (char *)"/batch",
+    test_suite_tests,
+    NULL,
+    1,
+    MUNIT_SUITE_OPTION_NONE
+};
+
+int main(int argc, char *argv[MUNIT_ARRAY_PARAM(argc + 1)]) {
+    return munit_suite_main(&test_suite, NULL, argc, argv);
+}
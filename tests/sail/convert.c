@@ -0,0 +1,246 @@
+/*  This file is part of SAIL (https://github.com/smoked-herring/sail)
+
+    Copyright (c) 2020 Dmitry Baryshev
+
+    The MIT License
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "sail-common.h"
+
+#include "munit.h"
+
+/*
+ * CMYK.
+ */
+static uint8_t cmyk_reference(uint8_t color, uint8_t k, bool inverted) {
+
+    const double c_ink = inverted ? 1 - color / 255.0 : color / 255.0;
+    const double k_ink = inverted ? 1 - k / 255.0     : k / 255.0;
+
+    return (uint8_t)(255 * (1 - c_ink) * (1 - k_ink) + 0.5);
+}
+
+static void fill_cmyk(uint8_t *cmyk, unsigned width) {
+
+    /* Cover all the channel values in every position. */
+    for (unsigned i = 0; i < width * 4; i++) {
+        cmyk[i] = (uint8_t)(i * 37 + i / 251);
+    }
+}
+
+static MunitResult test_cmyk_row(const MunitParameter params[], void *user_data) {
+    (void)params;
+    (void)user_data;
+
+    static const unsigned widths[] = { 1, 7, 37, 256, 1000 };
+
+    static const struct {
+        enum SailPixelFormat pixel_format;
+        unsigned bpp;
+        int red, green, blue, alpha;
+    } outputs[] = {
+        { SAIL_PIXEL_FORMAT_BPP32_RGBA, 4, 0, 1, 2,  3 },
+        { SAIL_PIXEL_FORMAT_BPP32_BGRA, 4, 2, 1, 0,  3 },
+        { SAIL_PIXEL_FORMAT_BPP32_ARGB, 4, 1, 2, 3,  0 },
+        { SAIL_PIXEL_FORMAT_BPP24_RGB,  3, 0, 1, 2, -1 },
+        { SAIL_PIXEL_FORMAT_BPP24_BGR,  3, 2, 1, 0, -1 },
+    };
+
+    uint8_t cmyk[1000 * 4];
+    uint8_t output[1000 * 4];
+
+    for (size_t w = 0; w < sizeof(widths) / sizeof(widths[0]); w++) {
+        const unsigned width = widths[w];
+        fill_cmyk(cmyk, width);
+
+        for (size_t o = 0; o < sizeof(outputs) / sizeof(outputs[0]); o++) {
+            for (int inverted = 0; inverted <= 1; inverted++) {
+                munit_assert(sail_convert_cmyk_row(cmyk, inverted, width, outputs[o].pixel_format, output) == SAIL_OK);
+
+                for (unsigned x = 0; x < width; x++) {
+                    const uint8_t *c = cmyk + x * 4;
+                    const uint8_t *p = output + x * outputs[o].bpp;
+
+                    munit_assert_uint8(p[outputs[o].red],   ==, cmyk_reference(c[0], c[3], inverted));
+                    munit_assert_uint8(p[outputs[o].green], ==, cmyk_reference(c[1], c[3], inverted));
+                    munit_assert_uint8(p[outputs[o].blue],  ==, cmyk_reference(c[2], c[3], inverted));
+
+                    if (outputs[o].alpha >= 0) {
+                        munit_assert_uint8(p[outputs[o].alpha], ==, 255);
+                    }
+                }
+            }
+        }
+    }
+
+    return MUNIT_OK;
+}
+
+static MunitResult test_cmyk_row_in_place(const MunitParameter params[], void *user_data) {
+    (void)params;
+    (void)user_data;
+
+    const unsigned width = 1000;
+
+    uint8_t cmyk[1000 * 4];
+    uint8_t pixels[1000 * 4];
+
+    fill_cmyk(cmyk, width);
+
+    static const enum SailPixelFormat pixel_formats[] = { SAIL_PIXEL_FORMAT_BPP32_RGBA, SAIL_PIXEL_FORMAT_BPP24_BGR };
+
+    for (size_t f = 0; f < sizeof(pixel_formats) / sizeof(pixel_formats[0]); f++) {
+        uint8_t expected[1000 * 4];
+        munit_assert(sail_convert_cmyk_row(cmyk, true, width, pixel_formats[f], expected) == SAIL_OK);
+
+        memcpy(pixels, cmyk, sizeof(pixels));
+        munit_assert(sail_convert_cmyk_row(pixels, true, width, pixel_formats[f], pixels) == SAIL_OK);
+
+        const unsigned bpp = pixel_formats[f] == SAIL_PIXEL_FORMAT_BPP32_RGBA ? 4 : 3;
+        munit_assert_memory_equal(width * bpp, pixels, expected);
+    }
+
+    return MUNIT_OK;
+}
+
+/*
+ * Images.
+ */
+static MunitResult test_convert_image(const MunitParameter params[], void *user_data) {
+    (void)params;
+    (void)user_data;
+
+    struct sail_image *image;
+    munit_assert(sail_alloc_image(&image) == SAIL_OK);
+
+    /* Padded rows. */
+    image->width          = 45;
+    image->height         = 3;
+    image->pixel_format   = SAIL_PIXEL_FORMAT_BPP24_RGB;
+    image->bytes_per_line = image->width * 3 + 5;
+
+    munit_assert(sail_malloc_pixels((size_t)image->bytes_per_line * image->height, &image->pixels) == SAIL_OK);
+
+    for (unsigned i = 0; i < image->bytes_per_line * image->height; i++) {
+        ((uint8_t *)image->pixels)[i] = (uint8_t)(i * 7);
+    }
+
+    struct sail_image *image_output;
+    munit_assert(sail_convert_image(image, SAIL_PIXEL_FORMAT_BPP32_BGRA, &image_output) == SAIL_OK);
+
+    munit_assert(image_output->pixel_format == SAIL_PIXEL_FORMAT_BPP32_BGRA);
+    munit_assert_uint(image_output->bytes_per_line, ==, image->width * 4);
+
+    for (unsigned y = 0; y < image->height; y++) {
+        for (unsigned x = 0; x < image->width; x++) {
+            const uint8_t *rgb  = (const uint8_t *)image->pixels + y * image->bytes_per_line + x * 3;
+            const uint8_t *bgra = (const uint8_t *)image_output->pixels + y * image_output->bytes_per_line + x * 4;
+
+            munit_assert_uint8(bgra[0], ==, rgb[2]);
+            munit_assert_uint8(bgra[1], ==, rgb[1]);
+            munit_assert_uint8(bgra[2], ==, rgb[0]);
+            munit_assert_uint8(bgra[3], ==, 255);
+        }
+    }
+
+    sail_destroy_image(image_output);
+
+    munit_assert(sail_convert_image(image, SAIL_PIXEL_FORMAT_BPP32_YCCK, &image_output) == SAIL_ERROR_UNSUPPORTED_PIXEL_FORMAT);
+
+    sail_destroy_image(image);
+
+    return MUNIT_OK;
+}
+
+static MunitResult test_premultiply_alpha(const MunitParameter params[], void *user_data) {
+    (void)params;
+    (void)user_data;
+
+    struct sail_image *image;
+    munit_assert(sail_alloc_image(&image) == SAIL_OK);
+
+    image->width          = 256;
+    image->height         = 256;
+    image->pixel_format   = SAIL_PIXEL_FORMAT_BPP32_RGBA;
+    image->bytes_per_line = image->width * 4;
+
+    munit_assert(sail_malloc_pixels((size_t)image->bytes_per_line * image->height, &image->pixels) == SAIL_OK);
+
+    /* Every color value with every alpha value. */
+    for (unsigned y = 0; y < image->height; y++) {
+        for (unsigned x = 0; x < image->width; x++) {
+            uint8_t *pixel = (uint8_t *)image->pixels + y * image->bytes_per_line + x * 4;
+
+            pixel[0] = pixel[1] = pixel[2] = (uint8_t)x;
+            pixel[3] = (uint8_t)y;
+        }
+    }
+
+    munit_assert(sail_premultiply_alpha(image) == SAIL_OK);
+
+    for (unsigned y = 0; y < image->height; y++) {
+        for (unsigned x = 0; x < image->width; x++) {
+            const uint8_t *pixel = (const uint8_t *)image->pixels + y * image->bytes_per_line + x * 4;
+
+            munit_assert_uint8(pixel[0], ==, (uint8_t)(x * y / 255.0 + 0.5));
+            munit_assert_uint8(pixel[3], ==, y);
+        }
+    }
+
+    munit_assert(sail_unpremultiply_alpha(image) == SAIL_OK);
+
+    /* Opaque pixels survive the round trip. */
+    for (unsigned x = 0; x < image->width; x++) {
+        const uint8_t *pixel = (const uint8_t *)image->pixels + 255 * image->bytes_per_line + x * 4;
+
+        munit_assert_uint8(pixel[0], ==, x);
+    }
+
+    sail_destroy_image(image);
+
+    return MUNIT_OK;
+}
+
+static MunitTest test_suite_tests[] = {
+    { (char *)"/cmyk-row",          test_cmyk_row,          NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+    { (char *)"/cmyk-row-in-place", test_cmyk_row_in_place, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+
+    { (char *)"/convert-image",     test_convert_image,     NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+    { (char *)"/premultiply-alpha", test_premultiply_alpha, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+
+    { NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL }
+};
+
+static const MunitSuite test_suite = {
+    (char *)"/convert",
+    test_suite_tests,
+    NULL,
+    1,
+    MUNIT_SUITE_OPTION_NONE
+};
+
+int main(int argc, char *argv[MUNIT_ARRAY_PARAM(argc + 1)]) {
+    return munit_suite_main(&test_suite, NULL, argc, argv);
+}
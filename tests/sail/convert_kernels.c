@@ -0,0 +1,302 @@
+/*  This file is part of SAIL (https://github.com/smoked-herring/sail)
+
+    Copyright (c) 2020 Dmitry Baryshev
+
+    The MIT License
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "convert_private.h"
+
+#include "munit.h"
+
+/*
+ * Every SIMD kernel must produce exactly what the scalar kernel produces.
+ */
+struct kernel_set {
+
+    const char *name;
+    bool (*available)(void);
+    struct convert_kernels kernels;
+};
+
+#ifdef SAIL_HAVE_NEON_KERNELS
+static bool neon_available(void) {
+
+    return true;
+}
+#endif
+
+static const struct kernel_set KERNEL_SETS[] = {
+#ifdef SAIL_HAVE_X86_KERNELS
+    { "sse2", convert_cpu_has_sse2,
+        { convert_shuffle8_sse2, convert_narrow16_sse2, convert_premultiply_sse2, convert_cmyk_sse2 } },
+    { "avx2", convert_cpu_has_avx2,
+        { convert_shuffle8_avx2, convert_narrow16_avx2, convert_premultiply_avx2, convert_cmyk_avx2 } },
+#endif
+#ifdef SAIL_HAVE_NEON_KERNELS
+    { "neon", neon_available,
+        { convert_shuffle8_neon, convert_narrow16_neon, convert_premultiply_neon, convert_cmyk_neon } },
+#endif
+    { NULL, NULL, { NULL, NULL, NULL, NULL } }
+};
+
+/* Widths around the 4, 8, 16, and 32 pixel vector steps and one long row. */
+static const unsigned WIDTHS[] = { 0, 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 32, 33, 63, 64, 65, 1027 };
+
+#define MAX_WIDTH 1027
+
+/* Bytes after the row which must stay untouched. */
+#define GUARD 64
+
+/* The source and the output rows start at both aligned and unaligned addresses. */
+#define MAX_OFFSET 1
+
+static MunitResult test_shuffle8(const MunitParameter params[], void *user_data) {
+    (void)params;
+    (void)user_data;
+
+    static uint8_t src[MAX_OFFSET + MAX_WIDTH * 4];
+    static uint8_t expected[MAX_OFFSET + MAX_WIDTH * 4 + GUARD];
+    static uint8_t actual[MAX_OFFSET + MAX_WIDTH * 4 + GUARD];
+
+    munit_rand_memory(sizeof(src), src);
+
+    bool tested = false;
+
+    for (const struct kernel_set *set = KERNEL_SETS; set->name != NULL; set++) {
+        if (!set->available()) {
+            continue;
+        }
+
+        tested = true;
+
+        /*
+         * Every map of every source and output pixel size. This covers the maps of all the
+         * 8-bit pixel format pairs the conversion builds, including channel fills and grayscale expansion.
+         */
+        for (unsigned src_bpp = 1; src_bpp <= 4; src_bpp++) {
+            for (unsigned dst_bpp = 1; dst_bpp <= 4; dst_bpp++) {
+                unsigned maps = 1;
+
+                for (unsigned i = 0; i < dst_bpp; i++) {
+                    maps *= src_bpp + 1;
+                }
+
+                for (unsigned m = 0; m < maps; m++) {
+                    uint8_t map[4] = { 0, 0, 0, 0 };
+
+                    for (unsigned i = 0, digits = m; i < dst_bpp; i++, digits /= src_bpp + 1) {
+                        const unsigned index = digits % (src_bpp + 1);
+                        map[i] = index == src_bpp ? CONVERT_FILL : (uint8_t)index;
+                    }
+
+                    for (size_t w = 0; w < sizeof(WIDTHS) / sizeof(WIDTHS[0]); w++) {
+                        for (unsigned offset = 0; offset <= MAX_OFFSET; offset++) {
+                            const unsigned width = WIDTHS[w];
+                            const size_t size = (size_t)width * dst_bpp + GUARD;
+
+                            memset(expected, 0xA5, sizeof(expected));
+                            memset(actual,   0xA5, sizeof(actual));
+
+                            convert_shuffle8_scalar(src + offset, src_bpp, expected + offset, dst_bpp, map, width);
+                            set->kernels.shuffle8(src + offset, src_bpp, actual + offset, dst_bpp, map, width);
+
+                            if (memcmp(expected + offset, actual + offset, size) != 0) {
+                                munit_errorf("%s: %u to %u bytes with map %02X %02X %02X %02X, width %u, offset %u",
+                                             set->name, src_bpp, dst_bpp, map[0], map[1], map[2], map[3], width, offset);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    return tested ? MUNIT_OK : MUNIT_SKIP;
+}
+
+static MunitResult test_narrow16(const MunitParameter params[], void *user_data) {
+    (void)params;
+    (void)user_data;
+
+    /* Narrowing works on channels, so RGBA rows have 4 times more of them. */
+    static uint16_t src[MAX_OFFSET + MAX_WIDTH * 4];
+    static uint8_t expected[MAX_OFFSET + MAX_WIDTH * 4 + GUARD];
+    static uint8_t actual[MAX_OFFSET + MAX_WIDTH * 4 + GUARD];
+
+    munit_rand_memory(sizeof(src), (uint8_t *)src);
+
+    bool tested = false;
+
+    for (const struct kernel_set *set = KERNEL_SETS; set->name != NULL; set++) {
+        if (!set->available()) {
+            continue;
+        }
+
+        tested = true;
+
+        for (unsigned channels = 1; channels <= 4; channels++) {
+            for (size_t w = 0; w < sizeof(WIDTHS) / sizeof(WIDTHS[0]); w++) {
+                for (unsigned offset = 0; offset <= MAX_OFFSET; offset++) {
+                    const size_t count = (size_t)WIDTHS[w] * channels;
+
+                    memset(expected, 0xA5, sizeof(expected));
+                    memset(actual,   0xA5, sizeof(actual));
+
+                    convert_narrow16_scalar(src + offset, expected + offset, count);
+                    set->kernels.narrow16(src + offset, actual + offset, count);
+
+                    if (memcmp(expected + offset, actual + offset, count + GUARD) != 0) {
+                        munit_errorf("%s: %u channels, width %u, offset %u", set->name, channels, WIDTHS[w], offset);
+                    }
+                }
+            }
+        }
+    }
+
+    return tested ? MUNIT_OK : MUNIT_SKIP;
+}
+
+static MunitResult test_premultiply(const MunitParameter params[], void *user_data) {
+    (void)params;
+    (void)user_data;
+
+    static uint8_t src[MAX_OFFSET + MAX_WIDTH * 4 + GUARD];
+    static uint8_t expected[MAX_OFFSET + MAX_WIDTH * 4 + GUARD];
+    static uint8_t actual[MAX_OFFSET + MAX_WIDTH * 4 + GUARD];
+
+    munit_rand_memory(sizeof(src), src);
+
+    /* Cover the fully transparent and the fully opaque alpha too. */
+    for (unsigned i = 0; i < 64; i++) {
+        src[i] = i % 2 == 0 ? 0 : 255;
+    }
+
+    bool tested = false;
+
+    for (const struct kernel_set *set = KERNEL_SETS; set->name != NULL; set++) {
+        if (!set->available()) {
+            continue;
+        }
+
+        tested = true;
+
+        /* RGBA/BGRA and ARGB/ABGR. */
+        for (unsigned alpha_index = 0; alpha_index <= 3; alpha_index += 3) {
+            for (size_t w = 0; w < sizeof(WIDTHS) / sizeof(WIDTHS[0]); w++) {
+                for (unsigned offset = 0; offset <= MAX_OFFSET; offset++) {
+                    const unsigned width = WIDTHS[w];
+
+                    memcpy(expected, src, sizeof(src));
+                    memcpy(actual,   src, sizeof(src));
+
+                    convert_premultiply_scalar(expected + offset, alpha_index, width);
+                    set->kernels.premultiply(actual + offset, alpha_index, width);
+
+                    if (memcmp(expected, actual, sizeof(src)) != 0) {
+                        munit_errorf("%s: alpha index %u, width %u, offset %u", set->name, alpha_index, width, offset);
+                    }
+                }
+            }
+        }
+    }
+
+    return tested ? MUNIT_OK : MUNIT_SKIP;
+}
+
+static MunitResult test_cmyk(const MunitParameter params[], void *user_data) {
+    (void)params;
+    (void)user_data;
+
+    static uint8_t src[MAX_OFFSET + MAX_WIDTH * 4 + GUARD];
+    static uint8_t expected[MAX_OFFSET + MAX_WIDTH * 4 + GUARD];
+    static uint8_t actual[MAX_OFFSET + MAX_WIDTH * 4 + GUARD];
+
+    munit_rand_memory(sizeof(src), src);
+
+    bool tested = false;
+
+    for (const struct kernel_set *set = KERNEL_SETS; set->name != NULL; set++) {
+        if (!set->available()) {
+            continue;
+        }
+
+        tested = true;
+
+        for (int inverted = 0; inverted <= 1; inverted++) {
+            for (size_t w = 0; w < sizeof(WIDTHS) / sizeof(WIDTHS[0]); w++) {
+                for (unsigned offset = 0; offset <= MAX_OFFSET; offset++) {
+                    const unsigned width = WIDTHS[w];
+
+                    /* Into a separate row. */
+                    memset(expected, 0xA5, sizeof(expected));
+                    memset(actual,   0xA5, sizeof(actual));
+
+                    convert_cmyk_scalar(src + offset, expected + offset, inverted, width);
+                    set->kernels.cmyk(src + offset, actual + offset, inverted, width);
+
+                    if (memcmp(expected, actual, sizeof(expected)) != 0) {
+                        munit_errorf("%s: inverted %d, width %u, offset %u", set->name, inverted, width, offset);
+                    }
+
+                    /* In place. */
+                    memcpy(expected, src, sizeof(src));
+                    memcpy(actual,   src, sizeof(src));
+
+                    convert_cmyk_scalar(expected + offset, expected + offset, inverted, width);
+                    set->kernels.cmyk(actual + offset, actual + offset, inverted, width);
+
+                    if (memcmp(expected, actual, sizeof(expected)) != 0) {
+                        munit_errorf("%s: in place, inverted %d, width %u, offset %u", set->name, inverted, width, offset);
+                    }
+                }
+            }
+        }
+    }
+
+    return tested ? MUNIT_OK : MUNIT_SKIP;
+}
+
+static MunitTest test_suite_tests[] = {
+    { (char *)"/shuffle8",    test_shuffle8,    NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+    { (char *)"/narrow16",    test_narrow16,    NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+    { (char *)"/premultiply", test_premultiply, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+    { (char *)"/cmyk",        test_cmyk,        NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+
+    { NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL }
+};
+
+static const MunitSuite test_suite = {
+    (char *)"/convert-kernels",
+    test_suite_tests,
+    NULL,
+    1,
+    MUNIT_SUITE_OPTION_NONE
+};
+
+int main(int argc, char *argv[MUNIT_ARRAY_PARAM(argc + 1)]) {
+    return munit_suite_main(&test_suite, NULL, argc, argv);
+}
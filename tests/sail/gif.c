@@ -0,0 +1,785 @@
+/*  This file is part of SAIL (https://github.com/smoked-herring/sail)
+
+    Copyright (c) 2020 Dmitry Baryshev
+
+    The MIT License
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sail-common.h"
+#include "sail.h"
+
+#include "munit.h"
+
+#define WIDTH  128
+#define HEIGHT 128
+
+/* Blocks of pixels compared by their average colors when dithering. */
+#define BLOCK_SIZE 8
+
+/*
+ * Helpers.
+ */
+
+static bool has_alpha(enum SailPixelFormat pixel_format) {
+
+    return pixel_format == SAIL_PIXEL_FORMAT_BPP32_RGBA || pixel_format == SAIL_PIXEL_FORMAT_BPP32_BGRA;
+}
+
+static bool is_bgr(enum SailPixelFormat pixel_format) {
+
+    return pixel_format == SAIL_PIXEL_FORMAT_BPP24_BGR || pixel_format == SAIL_PIXEL_FORMAT_BPP32_BGRA;
+}
+
+/* Allocates an image with padded rows to check that the codec honors bytes_per_line. */
+static struct sail_image* alloc_image(enum SailPixelFormat pixel_format) {
+
+    struct sail_image *image;
+    munit_assert(sail_alloc_image(&image) == SAIL_OK);
+
+    image->width        = WIDTH;
+    image->height       = HEIGHT;
+    image->pixel_format = pixel_format;
+    image->delay        = 10;
+
+    munit_assert(sail_bytes_per_line(image->width, pixel_format, &image->bytes_per_line) == SAIL_OK);
+    image->bytes_per_line += 3;
+
+    munit_assert(sail_malloc_pixels((size_t)image->bytes_per_line * image->height, &image->pixels) == SAIL_OK);
+    memset(image->pixels, 0, (size_t)image->bytes_per_line * image->height);
+
+    return image;
+}
+
+/*
+ * Sets the pixel. Transparent pixels get random colors and alpha values below 128, opaque pixels get
+ * alpha values of 128 and above, as GIF has 1-bit transparency.
+ */
+static void set_pixel(struct sail_image *image, unsigned x, unsigned y, const uint8_t rgb[3], bool transparent) {
+
+    const unsigned bytes_per_pixel = has_alpha(image->pixel_format) ? 4 : 3;
+    const uint32_t hash = (x * 73856093U) ^ (y * 19349663U);
+
+    uint8_t *pixel = (uint8_t *)image->pixels + (size_t)y * image->bytes_per_line + (size_t)x * bytes_per_pixel;
+
+    if (transparent) {
+        pixel[0] = (uint8_t)(hash >> 8);
+        pixel[1] = (uint8_t)(hash >> 16);
+        pixel[2] = (uint8_t)(hash >> 24);
+        pixel[3] = (uint8_t)(hash % 128);
+    } else {
+        pixel[is_bgr(image->pixel_format) ? 2 : 0] = rgb[0];
+        pixel[1]                                   = rgb[1];
+        pixel[is_bgr(image->pixel_format) ? 0 : 2] = rgb[2];
+
+        if (bytes_per_pixel == 4) {
+            pixel[3] = (uint8_t)(128 + hash % 128);
+        }
+    }
+}
+
+/* Returns the pixel as decoded losslessly into RGBA. Transparent pixels are all zeroes. */
+static void expected_rgba(const struct sail_image *image, unsigned x, unsigned y, uint8_t rgba[4]) {
+
+    const unsigned bytes_per_pixel = has_alpha(image->pixel_format) ? 4 : 3;
+    const uint8_t *pixel = (const uint8_t *)image->pixels + (size_t)y * image->bytes_per_line + (size_t)x * bytes_per_pixel;
+
+    if (bytes_per_pixel == 4 && pixel[3] < 128) {
+        memset(rgba, 0, 4);
+    } else {
+        rgba[0] = pixel[is_bgr(image->pixel_format) ? 2 : 0];
+        rgba[1] = pixel[1];
+        rgba[2] = pixel[is_bgr(image->pixel_format) ? 0 : 2];
+        rgba[3] = 255;
+    }
+}
+
+/*
+ * Allocates an image of exactly the specified number of distinct colors, and transparent pixels
+ * if requested. Such images are written without quantization.
+ */
+static struct sail_image* palette_image(enum SailPixelFormat pixel_format, unsigned colors, bool transparency) {
+
+    struct sail_image *image = alloc_image(pixel_format);
+
+    for (unsigned y = 0; y < image->height; y++) {
+        for (unsigned x = 0; x < image->width; x++) {
+            /* Every color is used. */
+            const unsigned index = (y * image->width + x) % colors;
+            const uint8_t rgb[3] = { (uint8_t)index, (uint8_t)(index * 37), (uint8_t)(index * 101) };
+
+            set_pixel(image, x, y, rgb, transparency && (x + y) % 7 == 0);
+        }
+    }
+
+    return image;
+}
+
+/*
+ * Allocates a smooth gradient of about 16K colors. Frames move the blue channel and the transparent blocks,
+ * if transparency is requested.
+ */
+static struct sail_image* gradient_image(enum SailPixelFormat pixel_format, unsigned frame, bool transparency) {
+
+    struct sail_image *image = alloc_image(pixel_format);
+
+    for (unsigned y = 0; y < image->height; y++) {
+        for (unsigned x = 0; x < image->width; x++) {
+            const uint8_t rgb[3] = {
+                (uint8_t)(x * 255 / (WIDTH - 1)),
+                (uint8_t)(y * 255 / (HEIGHT - 1)),
+                (uint8_t)((x + y) * 255 / (WIDTH + HEIGHT - 2) + frame * 40),
+            };
+
+            set_pixel(image, x, y, rgb, transparency && (x / 16 + y / 16 + frame) % 5 == 0);
+        }
+    }
+
+    return image;
+}
+
+/* Writes the frames into memory. The data must be freed with sail_free(). */
+static void write_frames(struct sail_image **frames, unsigned frames_count, enum SailDithering dithering, unsigned threads,
+                            bool interlaced, void **data, size_t *size) {
+
+    const struct sail_codec_info *codec_info;
+    munit_assert(sail_codec_info_from_extension("gif", &codec_info) == SAIL_OK);
+
+    struct sail_write_options *write_options;
+    munit_assert(sail_alloc_write_options_from_features(codec_info->write_features, &write_options) == SAIL_OK);
+    write_options->dithering = dithering;
+    write_options->threads   = threads;
+
+    if (interlaced) {
+        write_options->io_options |= SAIL_IO_OPTION_INTERLACED;
+    }
+
+    void *state;
+    *data = NULL;
+    munit_assert(sail_start_writing_growable_mem_with_options(data, size, codec_info, write_options, &state) == SAIL_OK);
+
+    for (unsigned i = 0; i < frames_count; i++) {
+        munit_assert(sail_write_next_frame(state, frames[i]) == SAIL_OK);
+    }
+
+    munit_assert(sail_stop_writing(state) == SAIL_OK);
+
+    sail_destroy_write_options(write_options);
+}
+
+/* Reads exactly the specified number of RGBA frames. The frames must be destroyed. */
+static void read_frames(const void *data, size_t size, struct sail_image **frames, unsigned frames_count) {
+
+    const struct sail_codec_info *codec_info;
+    munit_assert(sail_codec_info_from_extension("gif", &codec_info) == SAIL_OK);
+
+    struct sail_read_options *read_options;
+    munit_assert(sail_alloc_read_options_from_features(codec_info->read_features, &read_options) == SAIL_OK);
+    read_options->output_pixel_format = SAIL_PIXEL_FORMAT_BPP32_RGBA;
+
+    void *state;
+    munit_assert(sail_start_reading_mem_with_options(data, size, codec_info, read_options, &state) == SAIL_OK);
+
+    for (unsigned i = 0; i < frames_count; i++) {
+        munit_assert(sail_read_next_frame(state, &frames[i]) == SAIL_OK);
+
+        munit_assert_uint(frames[i]->width,       ==, WIDTH);
+        munit_assert_uint(frames[i]->height,      ==, HEIGHT);
+        munit_assert_int(frames[i]->pixel_format, ==, SAIL_PIXEL_FORMAT_BPP32_RGBA);
+    }
+
+    struct sail_image *image;
+    munit_assert(sail_read_next_frame(state, &image) == SAIL_ERROR_NO_MORE_FRAMES);
+
+    munit_assert(sail_stop_reading(state) == SAIL_OK);
+
+    sail_destroy_read_options(read_options);
+}
+
+static const uint8_t* decoded_pixel(const struct sail_image *decoded, unsigned x, unsigned y) {
+
+    return (const uint8_t *)decoded->pixels + (size_t)y * decoded->bytes_per_line + (size_t)x * 4;
+}
+
+/*
+ * Checks that transparent pixels stay transparent, opaque pixels stay opaque, and their colors
+ * differ by not more than max_error in every channel.
+ */
+static void assert_decoded(const struct sail_image *decoded, const struct sail_image *image, unsigned max_error) {
+
+    for (unsigned y = 0; y < image->height; y++) {
+        for (unsigned x = 0; x < image->width; x++) {
+            uint8_t rgba[4];
+            expected_rgba(image, x, y, rgba);
+
+            const uint8_t *pixel = decoded_pixel(decoded, x, y);
+
+            munit_assert_uint8(pixel[3], ==, rgba[3]);
+
+            if (rgba[3] == 0) {
+                continue;
+            }
+
+            for (unsigned channel = 0; channel < 3; channel++) {
+                munit_assert_int(abs(pixel[channel] - rgba[channel]), <=, (int)max_error);
+            }
+        }
+    }
+}
+
+/* Returns the largest difference between the average channels of opaque blocks. Dithering preserves them. */
+static unsigned max_block_error(const struct sail_image *decoded, const struct sail_image *image) {
+
+    unsigned max_error = 0;
+
+    for (unsigned block_y = 0; block_y < image->height; block_y += BLOCK_SIZE) {
+        for (unsigned block_x = 0; block_x < image->width; block_x += BLOCK_SIZE) {
+            int sums[3] = { 0, 0, 0 };
+            bool opaque = true;
+
+            for (unsigned y = block_y; y < block_y + BLOCK_SIZE; y++) {
+                for (unsigned x = block_x; x < block_x + BLOCK_SIZE; x++) {
+                    uint8_t rgba[4];
+                    expected_rgba(image, x, y, rgba);
+
+                    const uint8_t *pixel = decoded_pixel(decoded, x, y);
+
+                    opaque = opaque && rgba[3] != 0;
+
+                    for (unsigned channel = 0; channel < 3; channel++) {
+                        sums[channel] += pixel[channel] - rgba[channel];
+                    }
+                }
+            }
+
+            for (unsigned channel = 0; opaque && channel < 3; channel++) {
+                const unsigned error = (unsigned)abs(sums[channel]) / (BLOCK_SIZE * BLOCK_SIZE);
+
+                if (error > max_error) {
+                    max_error = error;
+                }
+            }
+        }
+    }
+
+    return max_error;
+}
+
+static const enum SailDithering ditherings[] = {
+    SAIL_DITHERING_NONE,
+    SAIL_DITHERING_ORDERED,
+    SAIL_DITHERING_FLOYD_STEINBERG,
+};
+
+/*
+ * Exact colors.
+ */
+static MunitResult test_exact(const MunitParameter params[], void *user_data) {
+    (void)user_data;
+
+    enum SailPixelFormat pixel_format;
+    munit_assert(sail_pixel_format_from_string(munit_parameters_get(params, "pixel-format"), &pixel_format) == SAIL_OK);
+
+    /* The last color is reserved for transparency. */
+    for (unsigned transparency = 0; transparency < (has_alpha(pixel_format) ? 2U : 1U); transparency++) {
+        struct sail_image *image = palette_image(pixel_format, transparency ? 255 : 256, transparency);
+
+        /* Colors are mapped exactly regardless of dithering. */
+        for (size_t d = 0; d < sizeof(ditherings) / sizeof(ditherings[0]); d++) {
+            void *data;
+            size_t size;
+            write_frames(&image, 1, ditherings[d], 1, false, &data, &size);
+
+            struct sail_image *decoded;
+            read_frames(data, size, &decoded, 1);
+
+            assert_decoded(decoded, image, 0);
+
+            sail_destroy_image(decoded);
+            sail_free(data);
+        }
+
+        sail_destroy_image(image);
+    }
+
+    return MUNIT_OK;
+}
+
+/*
+ * Quantization.
+ */
+static MunitResult test_quantize(const MunitParameter params[], void *user_data) {
+    (void)user_data;
+
+    enum SailPixelFormat pixel_format;
+    munit_assert(sail_pixel_format_from_string(munit_parameters_get(params, "pixel-format"), &pixel_format) == SAIL_OK);
+
+    struct sail_image *image = gradient_image(pixel_format, 0, has_alpha(pixel_format));
+
+    struct sail_image *decoded[sizeof(ditherings) / sizeof(ditherings[0])];
+
+    for (size_t d = 0; d < sizeof(ditherings) / sizeof(ditherings[0]); d++) {
+        void *data;
+        size_t size;
+        write_frames(&image, 1, ditherings[d], 1, false, &data, &size);
+
+        read_frames(data, size, &decoded[d], 1);
+
+        /*
+         * The nearest palette colors are close to the gradient. Dithering adds noise to pixels,
+         * but keeps the average colors of blocks.
+         */
+        assert_decoded(decoded[d], image, ditherings[d] == SAIL_DITHERING_NONE ? 24 : 64);
+        munit_assert_uint(max_block_error(decoded[d], image), <=, 16);
+
+        /* Dithering changes the pixels. */
+        if (d > 0) {
+            munit_assert_memory_not_equal((size_t)decoded[d]->bytes_per_line * decoded[d]->height, decoded[d]->pixels, decoded[0]->pixels);
+        }
+
+        sail_free(data);
+    }
+
+    for (size_t d = 0; d < sizeof(ditherings) / sizeof(ditherings[0]); d++) {
+        sail_destroy_image(decoded[d]);
+    }
+
+    sail_destroy_image(image);
+
+    return MUNIT_OK;
+}
+
+/*
+ * Parallel encoding.
+ */
+static MunitResult test_threads(const MunitParameter params[], void *user_data) {
+    (void)user_data;
+
+    enum SailPixelFormat pixel_format;
+    munit_assert(sail_pixel_format_from_string(munit_parameters_get(params, "pixel-format"), &pixel_format) == SAIL_OK);
+
+    /* More threads than frames too. */
+    static const unsigned threads[] = { 2, 3, 4, 8 };
+    static const bool interlaced[] = { false, true };
+
+    /*
+     * Every frame changes all the colors and moves the transparent blocks. The last frame repeats
+     * the previous one, so nothing differs from the canvas. Every frame has its own comment
+     * to check the meta data travels with the frame through the encoding ring.
+     */
+    struct sail_image *frames[6];
+    const unsigned frames_count = sizeof(frames) / sizeof(frames[0]);
+
+    for (unsigned i = 0; i < frames_count; i++) {
+        frames[i] = gradient_image(pixel_format, (i + 1 < frames_count) ? i : i - 1, has_alpha(pixel_format));
+
+        char comment[32];
+        snprintf(comment, sizeof(comment), "Frame %u", i);
+
+        munit_assert(sail_alloc_meta_data_node(&frames[i]->meta_data_node) == SAIL_OK);
+        frames[i]->meta_data_node->key        = SAIL_META_DATA_COMMENT;
+        frames[i]->meta_data_node->value_type = SAIL_META_DATA_TYPE_STRING;
+        munit_assert(sail_strdup(comment, &frames[i]->meta_data_node->value_string) == SAIL_OK);
+    }
+
+    for (size_t n = 0; n < sizeof(interlaced) / sizeof(interlaced[0]); n++) {
+        for (size_t d = 0; d < sizeof(ditherings) / sizeof(ditherings[0]); d++) {
+            void *expected_data;
+            size_t expected_size;
+            write_frames(frames, frames_count, ditherings[d], 1, interlaced[n], &expected_data, &expected_size);
+
+            /* Frames encoded in parallel are written in order and don't depend on the threads. */
+            for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); t++) {
+                void *data;
+                size_t size;
+                write_frames(frames, frames_count, ditherings[d], threads[t], interlaced[n], &data, &size);
+
+                munit_assert_size(size, ==, expected_size);
+                munit_assert_memory_equal(size, data, expected_data);
+
+                sail_free(data);
+            }
+
+            if (ditherings[d] == SAIL_DITHERING_NONE) {
+                struct sail_image *decoded[sizeof(frames) / sizeof(frames[0])];
+                read_frames(expected_data, expected_size, decoded, frames_count);
+
+                for (unsigned i = 0; i < frames_count; i++) {
+                    assert_decoded(decoded[i], frames[i], 24);
+
+                    const struct sail_meta_data_node *node = decoded[i]->meta_data_node;
+                    while (node != NULL && node->key != SAIL_META_DATA_COMMENT) {
+                        node = node->next;
+                    }
+
+                    munit_assert_not_null(node);
+                    munit_assert_string_equal(node->value_string, frames[i]->meta_data_node->value_string);
+
+                    sail_destroy_image(decoded[i]);
+                }
+            }
+
+            sail_free(expected_data);
+        }
+    }
+
+    for (unsigned i = 0; i < frames_count; i++) {
+        sail_destroy_image(frames[i]);
+    }
+
+    return MUNIT_OK;
+}
+
+/*
+ * Reading animations with transparency and frames smaller than the screen.
+ */
+
+#define CANVAS_WIDTH  77
+#define CANVAS_HEIGHT 45
+
+/* Clear codes are emitted often enough to keep all the LZW codes 9 bits wide. */
+#define LZW_CLEAR_INTERVAL 250
+
+struct canvas_frame {
+    unsigned left;
+    unsigned top;
+    unsigned width;
+    unsigned height;
+    bool local_map;
+    int transparency_index;
+    /* 1 - leave in place, 2 - restore to background. */
+    unsigned disposal;
+    bool interlaced;
+    unsigned pattern;
+};
+
+/*
+ * 1. Opaque frame covering the whole screen.
+ * 2. Frame with its own color map. Its rectangle is restored to the background (transparent) afterwards.
+ * 3. Frame overlapping the restored rectangle and the screen border.
+ * 4. Tiny interlaced frame.
+ *
+ * The frame widths are not multiples of the SIMD width.
+ */
+static const struct canvas_frame canvas_frames[] = {
+    { 0,  0,  CANVAS_WIDTH, CANVAS_HEIGHT, false, -1, 1, false, 1 },
+    { 5,  7,  37,           19,            true,   3, 2, false, 3 },
+    { 30, 20, 47,           25,            false,  0, 1, false, 5 },
+    { 1,  2,  11,           13,            true,   5, 1, true,  2 },
+};
+
+struct gif_bytes {
+    uint8_t data[32768];
+    size_t size;
+    uint32_t bits;
+    unsigned bits_count;
+};
+
+static void put_byte(struct gif_bytes *gif, unsigned value) {
+    munit_assert_size(gif->size, <, sizeof(gif->data));
+    gif->data[gif->size++] = (uint8_t)value;
+}
+
+static void put_word(struct gif_bytes *gif, unsigned value) {
+    put_byte(gif, value & 0xff);
+    put_byte(gif, value >> 8);
+}
+
+/* LSB-first bit packing as per the spec. */
+static void put_code(struct gif_bytes *lzw, unsigned code) {
+    lzw->bits |= (uint32_t)code << lzw->bits_count;
+    lzw->bits_count += 9;
+
+    while (lzw->bits_count >= 8) {
+        put_byte(lzw, lzw->bits & 0xff);
+        lzw->bits >>= 8;
+        lzw->bits_count -= 8;
+    }
+}
+
+static void canvas_color(bool local_map, unsigned index, uint8_t rgb[3]) {
+    if (local_map) {
+        rgb[0] = (uint8_t)(255 - index * 25);
+        rgb[1] = (uint8_t)(index * 11);
+        rgb[2] = (uint8_t)(128 + index * 9);
+    } else {
+        rgb[0] = (uint8_t)(index * 30 + 10);
+        rgb[1] = (uint8_t)(200 - index * 20);
+        rgb[2] = (uint8_t)(index * 7 + 3);
+    }
+}
+
+static unsigned canvas_index(const struct canvas_frame *frame, unsigned x, unsigned y) {
+    return (x * frame->pattern + y) % 8;
+}
+
+static void put_color_map(struct gif_bytes *gif, bool local_map) {
+    for (unsigned i = 0; i < 8; i++) {
+        uint8_t rgb[3];
+        canvas_color(local_map, i, rgb);
+
+        put_byte(gif, rgb[0]);
+        put_byte(gif, rgb[1]);
+        put_byte(gif, rgb[2]);
+    }
+}
+
+/* Compresses the frame indexes with literal codes only. */
+static void put_image_data(struct gif_bytes *gif, const struct canvas_frame *frame) {
+
+    static const unsigned interlaced_offsets[] = { 0, 4, 2, 1 };
+    static const unsigned interlaced_jumps[]   = { 8, 8, 4, 2 };
+
+    void *ptr;
+    munit_assert(sail_malloc(sizeof(struct gif_bytes), &ptr) == SAIL_OK);
+    struct gif_bytes *lzw = ptr;
+    memset(lzw, 0, sizeof(struct gif_bytes));
+
+    unsigned codes = 0;
+
+    for (unsigned pass = 0; pass < (frame->interlaced ? 4u : 1u); pass++) {
+        const unsigned first = frame->interlaced ? interlaced_offsets[pass] : 0;
+        const unsigned jump  = frame->interlaced ? interlaced_jumps[pass]   : 1;
+
+        for (unsigned y = first; y < frame->height; y += jump) {
+            for (unsigned x = 0; x < frame->width; x++) {
+                if (codes++ % LZW_CLEAR_INTERVAL == 0) {
+                    put_code(lzw, 256);
+                }
+
+                put_code(lzw, canvas_index(frame, x, y));
+            }
+        }
+    }
+
+    put_code(lzw, 257);
+
+    if (lzw->bits_count > 0) {
+        put_byte(lzw, lzw->bits);
+    }
+
+    /* Minimum code size. */
+    put_byte(gif, 8);
+
+    for (size_t offset = 0; offset < lzw->size; offset += 255) {
+        const size_t length = (lzw->size - offset < 255) ? lzw->size - offset : 255;
+
+        put_byte(gif, (unsigned)length);
+
+        for (size_t i = 0; i < length; i++) {
+            put_byte(gif, lzw->data[offset + i]);
+        }
+    }
+
+    put_byte(gif, 0);
+
+    sail_free(lzw);
+}
+
+static void build_canvas_gif(struct gif_bytes *gif) {
+
+    /* Header and the logical screen descriptor with an 8-color global map. */
+    memcpy(gif->data, "GIF89a", 6);
+    gif->size = 6;
+    put_word(gif, CANVAS_WIDTH);
+    put_word(gif, CANVAS_HEIGHT);
+    put_byte(gif, 0x80 | 0x70 | 0x02);
+    put_byte(gif, 0);
+    put_byte(gif, 0);
+    put_color_map(gif, false);
+
+    for (size_t i = 0; i < sizeof(canvas_frames) / sizeof(canvas_frames[0]); i++) {
+        const struct canvas_frame *frame = &canvas_frames[i];
+
+        /* Graphics control extension. */
+        put_byte(gif, 0x21);
+        put_byte(gif, 0xf9);
+        put_byte(gif, 4);
+        put_byte(gif, (frame->disposal << 2) | (frame->transparency_index >= 0 ? 1 : 0));
+        put_word(gif, 10);
+        put_byte(gif, frame->transparency_index >= 0 ? (unsigned)frame->transparency_index : 0);
+        put_byte(gif, 0);
+
+        /* Image descriptor. */
+        put_byte(gif, 0x2c);
+        put_word(gif, frame->left);
+        put_word(gif, frame->top);
+        put_word(gif, frame->width);
+        put_word(gif, frame->height);
+        put_byte(gif, (frame->local_map ? 0x80 | 0x02 : 0) | (frame->interlaced ? 0x40 : 0));
+
+        if (frame->local_map) {
+            put_color_map(gif, true);
+        }
+
+        put_image_data(gif, frame);
+    }
+
+    put_byte(gif, 0x3b);
+}
+
+/* Composes the frame over the canvas the same way as browsers do. */
+static void compose_canvas_frame(uint8_t canvas[CANVAS_HEIGHT][CANVAS_WIDTH][4], size_t index) {
+
+    if (index > 0 && canvas_frames[index - 1].disposal == 2) {
+        const struct canvas_frame *prev = &canvas_frames[index - 1];
+
+        for (unsigned y = prev->top; y < prev->top + prev->height; y++) {
+            memset(canvas[y][prev->left], 0, (size_t)prev->width * 4);
+        }
+    }
+
+    const struct canvas_frame *frame = &canvas_frames[index];
+
+    for (unsigned y = 0; y < frame->height; y++) {
+        for (unsigned x = 0; x < frame->width; x++) {
+            const unsigned color_index = canvas_index(frame, x, y);
+
+            if ((int)color_index == frame->transparency_index) {
+                continue;
+            }
+
+            uint8_t *pixel = canvas[frame->top + y][frame->left + x];
+            canvas_color(frame->local_map, color_index, pixel);
+            pixel[3] = 255;
+        }
+    }
+}
+
+static MunitResult test_read_canvas(const MunitParameter params[], void *user_data) {
+    (void)user_data;
+
+    enum SailPixelFormat pixel_format;
+    munit_assert(sail_pixel_format_from_string(munit_parameters_get(params, "pixel-format"), &pixel_format) == SAIL_OK);
+
+    void *ptr;
+    munit_assert(sail_malloc(sizeof(struct gif_bytes), &ptr) == SAIL_OK);
+    struct gif_bytes *gif = ptr;
+    memset(gif, 0, sizeof(struct gif_bytes));
+    build_canvas_gif(gif);
+
+    const struct sail_codec_info *codec_info;
+    munit_assert(sail_codec_info_from_extension("gif", &codec_info) == SAIL_OK);
+
+    struct sail_read_options *read_options;
+    munit_assert(sail_alloc_read_options_from_features(codec_info->read_features, &read_options) == SAIL_OK);
+    read_options->output_pixel_format = pixel_format;
+
+    void *state;
+    munit_assert(sail_start_reading_mem_with_options(gif->data, gif->size, codec_info, read_options, &state) == SAIL_OK);
+
+    static uint8_t canvas[CANVAS_HEIGHT][CANVAS_WIDTH][4];
+    memset(canvas, 0, sizeof(canvas));
+
+    const bool bgr = pixel_format == SAIL_PIXEL_FORMAT_BPP32_BGRA;
+
+    for (size_t i = 0; i < sizeof(canvas_frames) / sizeof(canvas_frames[0]); i++) {
+        struct sail_image *image;
+        munit_assert(sail_read_next_frame(state, &image) == SAIL_OK);
+
+        munit_assert_uint(image->width,       ==, CANVAS_WIDTH);
+        munit_assert_uint(image->height,      ==, CANVAS_HEIGHT);
+        munit_assert_int(image->pixel_format, ==, pixel_format);
+
+        compose_canvas_frame(canvas, i);
+
+        for (unsigned y = 0; y < CANVAS_HEIGHT; y++) {
+            const uint8_t *scan = (const uint8_t *)image->pixels + (size_t)image->bytes_per_line * y;
+
+            for (unsigned x = 0; x < CANVAS_WIDTH; x++) {
+                const uint8_t *expected = canvas[y][x];
+                const uint8_t *actual   = scan + x * 4;
+
+                munit_assert_uint8(actual[bgr ? 2 : 0], ==, expected[0]);
+                munit_assert_uint8(actual[1],           ==, expected[1]);
+                munit_assert_uint8(actual[bgr ? 0 : 2], ==, expected[2]);
+                munit_assert_uint8(actual[3],           ==, expected[3]);
+            }
+        }
+
+        sail_destroy_image(image);
+    }
+
+    struct sail_image *image;
+    munit_assert(sail_read_next_frame(state, &image) == SAIL_ERROR_NO_MORE_FRAMES);
+
+    munit_assert(sail_stop_reading(state) == SAIL_OK);
+
+    sail_destroy_read_options(read_options);
+    sail_free(gif);
+
+    return MUNIT_OK;
+}
+
+/* All the pixel formats the codec writes. */
+static char *write_pixel_formats[] = {
+    (char *)"BPP24-RGB",
+    (char *)"BPP24-BGR",
+    (char *)"BPP32-RGBA",
+    (char *)"BPP32-BGRA",
+    NULL
+};
+
+static MunitParameterEnum write_params[] = {
+    { (char *)"pixel-format", write_pixel_formats },
+    { NULL, NULL }
+};
+
+/* All the pixel formats the codec reads into. */
+static char *read_pixel_formats[] = {
+    (char *)"BPP32-RGBA",
+    (char *)"BPP32-BGRA",
+    NULL
+};
+
+static MunitParameterEnum read_params[] = {
+    { (char *)"pixel-format", read_pixel_formats },
+    { NULL, NULL }
+};
+
+static MunitTest test_suite_tests[] = {
+    { (char *)"/exact",    test_exact,    NULL, NULL, MUNIT_TEST_OPTION_NONE, write_params },
+    { (char *)"/quantize", test_quantize, NULL, NULL, MUNIT_TEST_OPTION_NONE, write_params },
+
+    { (char *)"/threads", test_threads, NULL, NULL, MUNIT_TEST_OPTION_NONE, write_params },
+
+    { (char *)"/read-canvas", test_read_canvas, NULL, NULL, MUNIT_TEST_OPTION_NONE, read_params },
+
+    { NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL }
+};
+
+static const MunitSuite test_suite = {
+    (char *)"/gif",
+    test_suite_tests,
+    NULL,
+    1,
+    MUNIT_SUITE_OPTION_NONE
+};
+
+int main(int argc, char *argv[MUNIT_ARRAY_PARAM(argc + 1)]) {
+    return munit_suite_main(&test_suite, NULL, argc, argv);
+}
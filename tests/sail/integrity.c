@@ -23,6 +23,8 @@
     SOFTWARE.
 */
 
+#include <stdlib.h>
+
 #include "sail-common.h"
 
 #include "munit.h"
@@ -505,6 +507,10 @@ static MunitResult test_codec_feature_to_string(const MunitParameter params[], v
     TEST_SAIL_CONVERSION(SAIL_CODEC_FEATURE_EXIF,        "EXIF");
     TEST_SAIL_CONVERSION(SAIL_CODEC_FEATURE_INTERLACED,  "INTERLACED");
     TEST_SAIL_CONVERSION(SAIL_CODEC_FEATURE_ICCP,        "ICCP");
+    TEST_SAIL_CONVERSION(SAIL_CODEC_FEATURE_SCALING,     "SCALING");
+    TEST_SAIL_CONVERSION(SAIL_CODEC_FEATURE_MULTI_THREADED, "MULTI-THREADED");
+    TEST_SAIL_CONVERSION(SAIL_CODEC_FEATURE_CROP,        "CROP");
+    TEST_SAIL_CONVERSION(SAIL_CODEC_FEATURE_TILED,       "TILED");
 
 #undef TEST_SAIL_CONVERSION
 
@@ -528,12 +534,54 @@ static MunitResult test_codec_feature_from_string(const MunitParameter params[],
     TEST_SAIL_CONVERSION("EXIF",        SAIL_CODEC_FEATURE_EXIF);
     TEST_SAIL_CONVERSION("INTERLACED",  SAIL_CODEC_FEATURE_INTERLACED);
     TEST_SAIL_CONVERSION("ICCP",        SAIL_CODEC_FEATURE_ICCP);
+    TEST_SAIL_CONVERSION("SCALING",     SAIL_CODEC_FEATURE_SCALING);
+    TEST_SAIL_CONVERSION("MULTI-THREADED", SAIL_CODEC_FEATURE_MULTI_THREADED);
+    TEST_SAIL_CONVERSION("CROP",        SAIL_CODEC_FEATURE_CROP);
+    TEST_SAIL_CONVERSION("TILED",       SAIL_CODEC_FEATURE_TILED);
 
 #undef TEST_SAIL_CONVERSION
 
     return MUNIT_OK;
 }
 
+/*
+ * Allocators.
+ */
+static void* test_malloc(void *context, size_t size) {
+    (void)context;
+    return malloc(size);
+}
+
+static void* test_realloc(void *context, void *ptr, size_t size) {
+    (void)context;
+    return realloc(ptr, size);
+}
+
+static void test_free(void *context, void *ptr) {
+    (void)context;
+    free(ptr);
+}
+
+static MunitResult test_allocator_in_use(const MunitParameter params[], void *user_data) {
+    (void)params;
+    (void)user_data;
+
+    const struct sail_allocator allocator = { test_malloc, test_realloc, test_free, NULL };
+
+    void *ptr;
+    munit_assert(sail_malloc(16, &ptr) == SAIL_OK);
+
+    /* Memory allocated by the current allocator must not be freed by another one. */
+    munit_assert(sail_set_allocator(&allocator) == SAIL_ERROR_ALLOCATOR_IN_USE);
+    munit_assert(sail_set_allocator(NULL) == SAIL_ERROR_ALLOCATOR_IN_USE);
+    munit_assert(sail_set_pixels_allocator(&allocator) == SAIL_ERROR_ALLOCATOR_IN_USE);
+    munit_assert(sail_set_pixels_allocator(NULL) == SAIL_ERROR_ALLOCATOR_IN_USE);
+
+    sail_free(ptr);
+
+    return MUNIT_OK;
+}
+
 static MunitTest test_suite_tests[] = {
     { (char *)"/error-macros", test_error_macros, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
 
@@ -552,6 +600,8 @@ static MunitTest test_suite_tests[] = {
     { (char *)"/codec-feature-to-string",   test_codec_feature_to_string,   NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
     { (char *)"/codec-feature-from-string", test_codec_feature_from_string, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
 
+    { (char *)"/allocator-in-use", test_allocator_in_use, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+
     { NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL }
 };
 
@@ -0,0 +1,364 @@
+/*  This file is part of SAIL (https://github.com/smoked-herring/sail)
+
+    Copyright (c) 2020 Dmitry Baryshev
+
+    The MIT License
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sail-common.h"
+#include "sail.h"
+
+#include "munit.h"
+
+/*
+ * Not a multiple of the SIMD width. Parallel segments hold at least 128 KiB of filtered rows,
+ * so the image is tall enough to get several of them in every pixel format.
+ */
+#define WIDTH  301
+#define HEIGHT 1000
+
+/*
+ * 3x2 RGB image with 16-bit samples. The PNG stream stores them big-endian.
+ */
+static const uint8_t rgb16_png[] = {
+    0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a, 0x00, 0x00, 0x00, 0x0d,
+    0x49, 0x48, 0x44, 0x52, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x02,
+    0x10, 0x02, 0x00, 0x00, 0x00, 0x42, 0x86, 0x2d, 0x0e, 0x00, 0x00, 0x00,
+    0x2d, 0x49, 0x44, 0x41, 0x54, 0x78, 0xda, 0x63, 0x10, 0x32, 0x09, 0xab,
+    0x98, 0xb5, 0x87, 0x81, 0x91, 0x91, 0xe1, 0x3f, 0xc3, 0xbf, 0x3b, 0xbb,
+    0x66, 0x94, 0x85, 0x30, 0x30, 0x30, 0xfc, 0xff, 0xdf, 0x00, 0x22, 0x18,
+    0xf8, 0xf9, 0x97, 0x2e, 0x8d, 0x8a, 0x12, 0x0e, 0x07, 0x00, 0x0d, 0x74,
+    0x0e, 0x64, 0x7d, 0xab, 0xbe, 0xb5, 0x00, 0x00, 0x00, 0x00, 0x49, 0x45,
+    0x4e, 0x44, 0xae, 0x42, 0x60, 0x82,
+};
+
+static const uint16_t rgb16_samples[2][3 * 3] = {
+    { 0x1234, 0x5678, 0x9abc, 0x0001, 0x0100, 0xff00, 0xfedc, 0xba98, 0x7654 },
+    { 0x0000, 0xffff, 0x8000, 0x00ff, 0xff00, 0x0f0f, 0xa5a5, 0x5a5a, 0x1357 },
+};
+
+/*
+ * Helpers.
+ */
+
+/* Allocates a noisy image. Rows are padded to check that the codec honors bytes_per_line. */
+static struct sail_image* noise_image(enum SailPixelFormat pixel_format) {
+
+    struct sail_image *image;
+    munit_assert(sail_alloc_image(&image) == SAIL_OK);
+
+    image->width        = WIDTH;
+    image->height       = HEIGHT;
+    image->pixel_format = pixel_format;
+
+    munit_assert(sail_bytes_per_line(WIDTH, pixel_format, &image->bytes_per_line) == SAIL_OK);
+    image->bytes_per_line += 3;
+
+    munit_assert(sail_malloc_pixels((size_t)image->bytes_per_line * image->height, &image->pixels) == SAIL_OK);
+
+    /* Smooth gradients with noise in the low bits, so the filters have something to do. */
+    for (unsigned y = 0; y < image->height; y++) {
+        uint8_t *row = (uint8_t *)image->pixels + (size_t)y * image->bytes_per_line;
+
+        for (unsigned x = 0; x < image->bytes_per_line; x++) {
+            row[x] = (uint8_t)(x / 3 + y + ((((x * 73856093U) ^ (y * 19349663U)) >> 11) & 7));
+        }
+    }
+
+    if (pixel_format == SAIL_PIXEL_FORMAT_BPP4_INDEXED) {
+        munit_assert(sail_alloc_palette(&image->palette) == SAIL_OK);
+
+        image->palette->pixel_format = SAIL_PIXEL_FORMAT_BPP24_RGB;
+        image->palette->color_count  = 16;
+        munit_assert(sail_malloc(16 * 3, &image->palette->data) == SAIL_OK);
+
+        for (unsigned i = 0; i < 16 * 3; i++) {
+            ((uint8_t *)image->palette->data)[i] = (uint8_t)(i * 5);
+        }
+    }
+
+    return image;
+}
+
+/* Checks that the pixels match row by row. Padding, including unused bits of the last byte, is not compared. */
+static void assert_same_pixels(const struct sail_image *image, const struct sail_image *reference) {
+
+    munit_assert_uint(image->width,       ==, reference->width);
+    munit_assert_uint(image->height,      ==, reference->height);
+    munit_assert_int(image->pixel_format, ==, reference->pixel_format);
+
+    unsigned bits_per_pixel;
+    munit_assert(sail_bits_per_pixel(image->pixel_format, &bits_per_pixel) == SAIL_OK);
+
+    const size_t row_bits = (size_t)image->width * bits_per_pixel;
+    const uint8_t last_mask = (uint8_t)(0xff00 >> (row_bits % 8));
+
+    for (unsigned y = 0; y < image->height; y++) {
+        const uint8_t *row           = (const uint8_t *)image->pixels + (size_t)y * image->bytes_per_line;
+        const uint8_t *reference_row = (const uint8_t *)reference->pixels + (size_t)y * reference->bytes_per_line;
+
+        munit_assert_memory_equal(row_bits / 8, row, reference_row);
+
+        if (row_bits % 8 != 0) {
+            munit_assert_uint8(row[row_bits / 8] & last_mask, ==, reference_row[row_bits / 8] & last_mask);
+        }
+    }
+}
+
+static const struct sail_codec_info* png_codec_info(void) {
+
+    const struct sail_codec_info *codec_info;
+    munit_assert(sail_codec_info_from_extension("png", &codec_info) == SAIL_OK);
+
+    return codec_info;
+}
+
+/* Writes the image into memory. The data must be freed with sail_free(). */
+static void write_image(const struct sail_image *image, const struct sail_write_options *write_options, void **data, size_t *size) {
+
+    void *state;
+    *data = NULL;
+    *size = 0;
+
+    munit_assert(sail_start_writing_growable_mem_with_options(data, size, png_codec_info(), write_options, &state) == SAIL_OK);
+    munit_assert(sail_write_next_frame(state, image) == SAIL_OK);
+    munit_assert(sail_stop_writing(state) == SAIL_OK);
+}
+
+/* Reads the data in the source pixel format and compares it with the reference. */
+static void assert_image(const void *data, size_t size, const struct sail_image *reference) {
+
+    struct sail_read_options *read_options;
+    munit_assert(sail_alloc_read_options_from_features(png_codec_info()->read_features, &read_options) == SAIL_OK);
+    read_options->output_pixel_format = SAIL_PIXEL_FORMAT_SOURCE;
+
+    void *state;
+    munit_assert(sail_start_reading_mem_with_options(data, size, png_codec_info(), read_options, &state) == SAIL_OK);
+
+    struct sail_image *image;
+    munit_assert(sail_read_next_frame(state, &image) == SAIL_OK);
+    assert_same_pixels(image, reference);
+    sail_destroy_image(image);
+
+    munit_assert(sail_stop_reading(state) == SAIL_OK);
+
+    sail_destroy_read_options(read_options);
+}
+
+/*
+ * Parallel encoding.
+ */
+static MunitResult test_write_threads(const MunitParameter params[], void *user_data) {
+    (void)user_data;
+
+    enum SailPixelFormat pixel_format;
+    munit_assert(sail_pixel_format_from_string(munit_parameters_get(params, "pixel-format"), &pixel_format) == SAIL_OK);
+
+    static const enum SailFilter filters[] = {
+        SAIL_FILTER_DEFAULT,
+        SAIL_FILTER_NONE,
+        SAIL_FILTER_SUB,
+        SAIL_FILTER_UP,
+        SAIL_FILTER_AVERAGE,
+        SAIL_FILTER_PAETH,
+        SAIL_FILTER_ADAPTIVE,
+    };
+
+    /* libpng alone, and the parallel encoder with different numbers of threads. */
+    static const unsigned threads[] = { 1, 2, 3, 8 };
+
+    struct sail_image *image = noise_image(pixel_format);
+
+    struct sail_write_options *write_options;
+    munit_assert(sail_alloc_write_options_from_features(png_codec_info()->write_features, &write_options) == SAIL_OK);
+
+    for (unsigned interlaced = 0; interlaced < 2; interlaced++) {
+        for (size_t f = 0; f < sizeof(filters) / sizeof(filters[0]); f++) {
+            /* Parallel output doesn't depend on the number of threads. */
+            void *parallel_data = NULL;
+            size_t parallel_size = 0;
+
+            for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); t++) {
+                write_options->filter  = filters[f];
+                write_options->threads = threads[t];
+
+                if (interlaced) {
+                    write_options->io_options |= SAIL_IO_OPTION_INTERLACED;
+                } else {
+                    write_options->io_options &= ~SAIL_IO_OPTION_INTERLACED;
+                }
+
+                void *data;
+                size_t size;
+                write_image(image, write_options, &data, &size);
+
+                assert_image(data, size, image);
+
+                if (threads[t] == 1) {
+                    sail_free(data);
+                } else if (parallel_data == NULL) {
+                    parallel_data = data;
+                    parallel_size = size;
+                } else {
+                    munit_assert_size(size, ==, parallel_size);
+                    munit_assert_memory_equal(size, data, parallel_data);
+                    sail_free(data);
+                }
+            }
+
+            sail_free(parallel_data);
+        }
+    }
+
+    sail_destroy_write_options(write_options);
+    sail_destroy_image(image);
+
+    return MUNIT_OK;
+}
+
+/*
+ * Byte order.
+ */
+static void read_rgb16(const void *data, size_t size, enum SailPixelFormat output_pixel_format, struct sail_image **image) {
+
+    struct sail_read_options *read_options;
+    munit_assert(sail_alloc_read_options_from_features(png_codec_info()->read_features, &read_options) == SAIL_OK);
+    read_options->output_pixel_format = output_pixel_format;
+
+    void *state;
+    munit_assert(sail_start_reading_mem_with_options(data, size, png_codec_info(), read_options, &state) == SAIL_OK);
+    munit_assert(sail_read_next_frame(state, image) == SAIL_OK);
+    munit_assert(sail_stop_reading(state) == SAIL_OK);
+
+    sail_destroy_read_options(read_options);
+
+    munit_assert_uint((*image)->width,  ==, 3);
+    munit_assert_uint((*image)->height, ==, 2);
+}
+
+/* Checks that 8-bit output keeps the most significant byte of every 16-bit sample. */
+static void assert_rgb8(const struct sail_image *image) {
+
+    munit_assert_int(image->pixel_format, ==, SAIL_PIXEL_FORMAT_BPP24_RGB);
+
+    for (unsigned y = 0; y < 2; y++) {
+        const uint8_t *row = (const uint8_t *)image->pixels + (size_t)y * image->bytes_per_line;
+
+        for (unsigned i = 0; i < 3 * 3; i++) {
+            munit_assert_uint8(row[i], ==, rgb16_samples[y][i] >> 8);
+        }
+    }
+}
+
+static MunitResult test_byte_order(const MunitParameter params[], void *user_data) {
+    (void)params;
+    (void)user_data;
+
+    /* 16-bit samples are read in the host byte order. */
+    struct sail_image *image;
+    read_rgb16(rgb16_png, sizeof(rgb16_png), SAIL_PIXEL_FORMAT_SOURCE, &image);
+    munit_assert_int(image->pixel_format, ==, SAIL_PIXEL_FORMAT_BPP48_RGB);
+
+    for (unsigned y = 0; y < 2; y++) {
+        const uint8_t *row = (const uint8_t *)image->pixels + (size_t)y * image->bytes_per_line;
+
+        for (unsigned i = 0; i < 3 * 3; i++) {
+            uint16_t sample;
+            memcpy(&sample, row + i * sizeof(sample), sizeof(sample));
+
+            munit_assert_uint16(sample, ==, rgb16_samples[y][i]);
+        }
+    }
+
+    struct sail_image *image8;
+    read_rgb16(rgb16_png, sizeof(rgb16_png), SAIL_PIXEL_FORMAT_BPP24_RGB, &image8);
+    assert_rgb8(image8);
+    sail_destroy_image(image8);
+
+    /*
+     * 16-bit samples are written from the host byte order too. Check the stream with 8-bit output,
+     * which takes the first byte of every sample as stored in the file.
+     */
+    static const unsigned threads[] = { 1, 2 };
+
+    struct sail_write_options *write_options;
+    munit_assert(sail_alloc_write_options_from_features(png_codec_info()->write_features, &write_options) == SAIL_OK);
+
+    for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); t++) {
+        write_options->threads = threads[t];
+
+        void *data;
+        size_t size;
+        write_image(image, write_options, &data, &size);
+
+        read_rgb16(data, size, SAIL_PIXEL_FORMAT_BPP24_RGB, &image8);
+        assert_rgb8(image8);
+        sail_destroy_image(image8);
+
+        sail_free(data);
+    }
+
+    sail_destroy_write_options(write_options);
+    sail_destroy_image(image);
+
+    return MUNIT_OK;
+}
+
+/* Pixel formats with different filter distances and sample orders. */
+static char *write_pixel_formats[] = {
+    (char *)"BPP4-INDEXED",
+    (char *)"BPP24-RGB",
+    (char *)"BPP32-RGBA",
+    (char *)"BPP48-RGB",
+    (char *)"BPP64-RGBA",
+    NULL
+};
+
+static MunitParameterEnum write_params[] = {
+    { (char *)"pixel-format", write_pixel_formats },
+    { NULL, NULL }
+};
+
+static MunitTest test_suite_tests[] = {
+    { (char *)"/write-threads", test_write_threads, NULL, NULL, MUNIT_TEST_OPTION_NONE, write_params },
+
+    { (char *)"/byte-order", test_byte_order, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+
+    { NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL }
+};
+
+static const MunitSuite test_suite = {
+    (char *)"/png",
+    test_suite_tests,
+    NULL,
+    1,
+    MUNIT_SUITE_OPTION_NONE
+};
+
+int main(int argc, char *argv[MUNIT_ARRAY_PARAM(argc + 1)]) {
+    return munit_suite_main(&test_suite, NULL, argc, argv);
+}
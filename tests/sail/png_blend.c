@@ -0,0 +1,250 @@
+/*  This file is part of SAIL (https://github.com/smoked-herring/sail)
+
+    Copyright (c) 2020 Dmitry Baryshev
+
+    The MIT License
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "sail-common.h"
+
+#include "helpers.h"
+
+#include "munit.h"
+
+/*
+ * The vector paths blend 4 8-bit or 2 16-bit pixels per iteration and must produce
+ * exactly what the per-pixel scalar "over" produces, tails included.
+ */
+static const unsigned WIDTHS[] = { 1, 2, 3, 5, 7, 9, 13, 31, 33, 1027 };
+
+#define MAX_WIDTH 1027
+
+/* Destination pixels before and after the blended span which must stay untouched. */
+#define DST_OFFSET 3
+#define GUARD      5
+
+/* How the source and the destination alpha is filled. */
+enum alpha_fill {
+    ALPHA_TRANSPARENT,
+    ALPHA_OPAQUE,
+    ALPHA_HALF,
+    ALPHA_MIXED,
+    ALPHA_RANDOM,
+};
+
+static const enum alpha_fill SRC_FILLS[] = { ALPHA_TRANSPARENT, ALPHA_OPAQUE, ALPHA_HALF, ALPHA_MIXED, ALPHA_RANDOM };
+static const enum alpha_fill DST_FILLS[] = { ALPHA_OPAQUE, ALPHA_MIXED, ALPHA_RANDOM };
+
+static uint32_t alpha_value(enum alpha_fill fill, uint32_t max) {
+
+    const uint32_t half = max / 255 * 128;
+
+    switch (fill) {
+        case ALPHA_TRANSPARENT: return 0;
+        case ALPHA_OPAQUE:      return max;
+        case ALPHA_HALF:        return half;
+        case ALPHA_MIXED: {
+            const uint32_t values[] = { 0, max, half };
+            return values[munit_rand_int_range(0, 2)];
+        }
+        case ALPHA_RANDOM:      return munit_rand_uint32() & max;
+    }
+
+    return 0;
+}
+
+static uint32_t load16(const uint8_t *p) {
+
+    uint16_t v;
+    memcpy(&v, p, sizeof(v));
+
+    return v;
+}
+
+static void store16(uint8_t *p, uint32_t v) {
+
+    const uint16_t v16 = (uint16_t)v;
+    memcpy(p, &v16, sizeof(v16));
+}
+
+/* Random row of 4-channel pixels with the alpha channel filled as requested. */
+static void fill_row(uint8_t *row, unsigned width, unsigned bytes_per_channel, unsigned alpha_index, enum alpha_fill fill) {
+
+    munit_rand_memory((size_t)width * 4 * bytes_per_channel, row);
+
+    for (unsigned x = 0; x < width; x++) {
+        uint8_t *alpha = row + (x * 4 + alpha_index) * bytes_per_channel;
+
+        if (bytes_per_channel == 1) {
+            *alpha = (uint8_t)alpha_value(fill, 255);
+        } else {
+            store16(alpha, alpha_value(fill, 65535));
+        }
+    }
+}
+
+/*
+ * Scalar straight alpha "over" with the destination color weighted by its alpha
+ * attenuated by the source coverage.
+ */
+static void reference_over(uint8_t *dst, const uint8_t *src, unsigned width, unsigned bytes_per_channel, unsigned alpha_index) {
+
+    const uint64_t max = bytes_per_channel == 1 ? 255 : 65535;
+
+    for (unsigned x = 0; x < width; x++) {
+        uint64_t s[4];
+        uint64_t d[4];
+
+        for (unsigned i = 0; i < 4; i++) {
+            const size_t index = (x * 4 + i) * bytes_per_channel;
+            s[i] = bytes_per_channel == 1 ? src[index] : load16(src + index);
+            d[i] = bytes_per_channel == 1 ? dst[index] : load16(dst + index);
+        }
+
+        if (s[alpha_index] == 0) {
+            continue;
+        }
+
+        uint64_t r[4];
+
+        if (s[alpha_index] == max) {
+            memcpy(r, s, sizeof(r));
+        } else {
+            const uint64_t src_weight = s[alpha_index] * max;
+            const uint64_t dst_weight = d[alpha_index] * (max - s[alpha_index]);
+            const uint64_t weight     = src_weight + dst_weight;
+
+            for (unsigned i = 0; i < 4; i++) {
+                r[i] = (s[i] * src_weight + d[i] * dst_weight + weight / 2) / weight;
+            }
+
+            r[alpha_index] = (weight + max / 2) / max;
+        }
+
+        for (unsigned i = 0; i < 4; i++) {
+            const size_t index = (x * 4 + i) * bytes_per_channel;
+
+            if (bytes_per_channel == 1) {
+                dst[index] = (uint8_t)r[i];
+            } else {
+                store16(dst + index, (uint32_t)r[i]);
+            }
+        }
+    }
+}
+
+static MunitResult test_blend_over(const MunitParameter params[], void *user_data) {
+    (void)user_data;
+
+    enum SailPixelFormat pixel_format;
+    munit_assert(sail_pixel_format_from_string(munit_parameters_get(params, "pixel-format"), &pixel_format) == SAIL_OK);
+
+    unsigned bits_per_pixel;
+    munit_assert(sail_bits_per_pixel(pixel_format, &bits_per_pixel) == SAIL_OK);
+
+    const unsigned bytes_per_channel = bits_per_pixel / 32;
+    const unsigned bytes_per_pixel   = bits_per_pixel / 8;
+    const unsigned alpha_index       = (pixel_format == SAIL_PIXEL_FORMAT_BPP32_ARGB || pixel_format == SAIL_PIXEL_FORMAT_BPP64_ARGB) ? 0 : 3;
+
+    static uint8_t src[MAX_WIDTH * 8];
+    static uint8_t dst[(DST_OFFSET + MAX_WIDTH + GUARD) * 8];
+    static uint8_t expected[(DST_OFFSET + MAX_WIDTH + GUARD) * 8];
+
+    for (size_t w = 0; w < sizeof(WIDTHS) / sizeof(WIDTHS[0]); w++) {
+        for (size_t sf = 0; sf < sizeof(SRC_FILLS) / sizeof(SRC_FILLS[0]); sf++) {
+            for (size_t df = 0; df < sizeof(DST_FILLS) / sizeof(DST_FILLS[0]); df++) {
+                const unsigned width = WIDTHS[w];
+                const size_t dst_size = (size_t)(DST_OFFSET + width + GUARD) * bytes_per_pixel;
+
+                fill_row(src, width, bytes_per_channel, alpha_index, SRC_FILLS[sf]);
+                fill_row(dst, DST_OFFSET + width + GUARD, bytes_per_channel, alpha_index, DST_FILLS[df]);
+                memcpy(expected, dst, dst_size);
+
+                reference_over(expected + DST_OFFSET * bytes_per_pixel, src, width, bytes_per_channel, alpha_index);
+                munit_assert(png_private_blend_over(dst, DST_OFFSET, src, width, pixel_format) == SAIL_OK);
+
+                if (memcmp(expected, dst, dst_size) != 0) {
+                    munit_errorf("Width %u, source alpha fill %u, destination alpha fill %u", width, (unsigned)SRC_FILLS[sf], (unsigned)DST_FILLS[df]);
+                }
+            }
+        }
+    }
+
+    return MUNIT_OK;
+}
+
+/* Exact results of the 0, 255, and 128 source alpha over opaque and transparent destinations. */
+static MunitResult test_blend_over_values(const MunitParameter params[], void *user_data) {
+    (void)params;
+    (void)user_data;
+
+    const uint8_t src[] = {
+        10, 20, 30, 0,   10, 20, 30, 255, 10, 20, 30, 128, 200, 100, 50, 128, 200, 100, 50, 128,
+    };
+    uint8_t dst[] = {
+        90, 80, 70, 255, 90, 80, 70, 255, 90, 80, 70, 255, 90,  80,  70, 0,   0,   0,   0,  0,
+    };
+    const uint8_t expected[] = {
+        90, 80, 70, 255, 10, 20, 30, 255, 50, 50, 50, 255, 200, 100, 50, 128, 200, 100, 50, 128,
+    };
+
+    munit_assert(png_private_blend_over(dst, 0, src, 5, SAIL_PIXEL_FORMAT_BPP32_RGBA) == SAIL_OK);
+    munit_assert_memory_equal(sizeof(expected), dst, expected);
+
+    return MUNIT_OK;
+}
+
+static char *pixel_formats[] = {
+    (char *)"BPP32-RGBA",
+    (char *)"BPP32-ARGB",
+    (char *)"BPP64-RGBA",
+    (char *)"BPP64-ARGB",
+    NULL
+};
+
+static MunitParameterEnum blend_params[] = {
+    { (char *)"pixel-format", pixel_formats },
+    { NULL, NULL },
+};
+
+static MunitTest test_suite_tests[] = {
+    { (char *)"/blend-over",        test_blend_over,        NULL, NULL, MUNIT_TEST_OPTION_NONE, blend_params },
+    { (char *)"/blend-over-values", test_blend_over_values, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+
+    { NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL }
+};
+
+static const MunitSuite test_suite = {
+    (char *)"/png-blend",
+    test_suite_tests,
+    NULL,
+    1,
+    MUNIT_SUITE_OPTION_NONE
+};
+
+int main(int argc, char *argv[MUNIT_ARRAY_PARAM(argc + 1)]) {
+    return munit_suite_main(&test_suite, NULL, argc, argv);
+}
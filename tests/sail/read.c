@@ -0,0 +1,953 @@
+/*  This file is part of SAIL (https://github.com/smoked-herring/sail)
+
+    Copyright (c) 2020 Dmitry Baryshev
+
+    The MIT License
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sail-common.h"
+#include "sail.h"
+
+#include "munit.h"
+
+/* Not a multiple of the JPEG block and MCU sizes to cover partial blocks at the right and bottom edges. */
+#define WIDTH  77
+#define HEIGHT 53
+
+/*
+ * Pixels allocator. Tracks live pixel buffers to check that pixels are allocated and freed with it.
+ */
+#define MAX_PIXELS_ALLOCATIONS 64
+
+static void *pixels_allocations[MAX_PIXELS_ALLOCATIONS];
+
+/* Returns the slot of the specified pixels or a free slot for NULL. */
+static void** find_pixels_slot(const void *ptr) {
+
+    for (unsigned i = 0; i < MAX_PIXELS_ALLOCATIONS; i++) {
+        if (pixels_allocations[i] == ptr) {
+            return &pixels_allocations[i];
+        }
+    }
+
+    munit_error("Unknown pixels or too many pixel buffers");
+}
+
+static bool is_tracked_pixels(const void *ptr) {
+
+    for (unsigned i = 0; i < MAX_PIXELS_ALLOCATIONS; i++) {
+        if (ptr != NULL && pixels_allocations[i] == ptr) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static unsigned tracked_pixels_count(void) {
+
+    unsigned count = 0;
+
+    for (unsigned i = 0; i < MAX_PIXELS_ALLOCATIONS; i++) {
+        if (pixels_allocations[i] != NULL) {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+static void* pixels_malloc(void *context, size_t size) {
+    (void)context;
+
+    void **slot = find_pixels_slot(NULL);
+    *slot = malloc(size);
+
+    return *slot;
+}
+
+static void* pixels_realloc(void *context, void *ptr, size_t size) {
+    (void)context;
+
+    void **slot = find_pixels_slot(ptr);
+    void *new_ptr = realloc(ptr, size);
+
+    if (new_ptr != NULL) {
+        *slot = new_ptr;
+    }
+
+    return new_ptr;
+}
+
+static void pixels_free(void *context, void *ptr) {
+    (void)context;
+
+    if (ptr != NULL) {
+        *find_pixels_slot(ptr) = NULL;
+    }
+
+    free(ptr);
+}
+
+/*
+ * Helpers.
+ */
+
+/* Allocates an RGB image of the specified size with uninitialized pixels. */
+static struct sail_image* alloc_rgb_image(unsigned width, unsigned height) {
+
+    struct sail_image *image;
+    munit_assert(sail_alloc_image(&image) == SAIL_OK);
+
+    image->width          = width;
+    image->height         = height;
+    image->pixel_format   = SAIL_PIXEL_FORMAT_BPP24_RGB;
+    image->bytes_per_line = image->width * 3;
+
+    munit_assert(sail_malloc_pixels((size_t)image->bytes_per_line * image->height, &image->pixels) == SAIL_OK);
+
+    return image;
+}
+
+/*
+ * Encodes the image with the codec for the specified extension and destroys it. io_options are added
+ * to the default write options. Codecs interlacing by default, like PNG, write interlaced images only
+ * if io_options request it. The data must be freed with sail_free().
+ */
+static void encode_image(const char *extension, struct sail_image *image, int io_options, void **data, size_t *size) {
+
+    const struct sail_codec_info *codec_info;
+    munit_assert(sail_codec_info_from_extension(extension, &codec_info) == SAIL_OK);
+
+    struct sail_write_options *write_options;
+    munit_assert(sail_alloc_write_options_from_features(codec_info->write_features, &write_options) == SAIL_OK);
+    write_options->io_options = (write_options->io_options & ~SAIL_IO_OPTION_INTERLACED) | io_options;
+
+    void *state;
+    *data = NULL;
+    munit_assert(sail_start_writing_growable_mem_with_options(data, size, codec_info, write_options, &state) == SAIL_OK);
+    munit_assert(sail_write_next_frame(state, image) == SAIL_OK);
+    munit_assert(sail_stop_writing(state) == SAIL_OK);
+
+    sail_destroy_write_options(write_options);
+    sail_destroy_image(image);
+}
+
+/*
+ * Encodes a noisy RGB image of the specified size. Noise compresses poorly, so headers take a small part
+ * of the data. See encode_image().
+ */
+static void encode_noise(const char *extension, unsigned width, unsigned height, int io_options, void **data, size_t *size) {
+
+    struct sail_image *image = alloc_rgb_image(width, height);
+
+    for (unsigned y = 0; y < image->height; y++) {
+        uint8_t *pixel = (uint8_t *)image->pixels + y * image->bytes_per_line;
+
+        for (unsigned x = 0; x < image->width; x++, pixel += 3) {
+            const uint32_t hash = (x * 73856093U) ^ (y * 19349663U);
+
+            pixel[0] = (uint8_t)(hash >> 8);
+            pixel[1] = (uint8_t)(hash >> 16);
+            pixel[2] = (uint8_t)(hash >> 24);
+        }
+    }
+
+    encode_image(extension, image, io_options, data, size);
+}
+
+/* Returns true if the codec supports writing with the specified I/O options. */
+static bool can_write(const struct sail_codec_info *codec_info, int io_options) {
+
+    return (io_options & SAIL_IO_OPTION_INTERLACED) == 0 ||
+            (codec_info->write_features->features & SAIL_CODEC_FEATURE_INTERLACED) != 0;
+}
+
+/*
+ * Probe.
+ */
+static MunitResult test_probe(const MunitParameter params[], void *user_data) {
+    (void)user_data;
+
+    const char *extension = munit_parameters_get(params, "extension");
+
+    void *data;
+    size_t size;
+    encode_noise(extension, WIDTH, HEIGHT, 0, &data, &size);
+
+    const struct sail_codec_info *expected_codec_info;
+    munit_assert(sail_codec_info_from_extension(extension, &expected_codec_info) == SAIL_OK);
+
+    struct sail_image *reference;
+    munit_assert(sail_read_mem(data, size, &reference) == SAIL_OK);
+
+    /* The probed properties match the decoded ones. Headers are enough, so cut the image in half. */
+    const size_t sizes[] = { size, size / 2 };
+
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        struct sail_image *image;
+        const struct sail_codec_info *codec_info;
+
+        munit_assert(sail_probe_mem(data, sizes[i], &image, &codec_info) == SAIL_OK);
+
+        munit_assert_ptr_equal(codec_info, expected_codec_info);
+        munit_assert_null(image->pixels);
+        munit_assert_uint(image->width,  ==, reference->width);
+        munit_assert_uint(image->height, ==, reference->height);
+
+        munit_assert_not_null(image->source_image);
+        munit_assert_int(image->source_image->pixel_format, ==, reference->source_image->pixel_format);
+        munit_assert_int(image->source_image->compression,  ==, reference->source_image->compression);
+
+        sail_destroy_image(image);
+    }
+
+    sail_destroy_image(reference);
+    sail_free(data);
+
+    return MUNIT_OK;
+}
+
+/*
+ * Rows.
+ */
+static MunitResult test_rows(const MunitParameter params[], void *user_data) {
+    (void)user_data;
+
+    const char *extension = munit_parameters_get(params, "extension");
+
+    /* Interlaced images are read into an internal buffer first. */
+    static const int io_options[] = { 0, SAIL_IO_OPTION_INTERLACED };
+
+    /* Single rows, bands which don't divide the height, and bands larger than the image. */
+    static const unsigned bands[] = { 1, 7, HEIGHT, HEIGHT + 5 };
+
+    const struct sail_codec_info *codec_info;
+    munit_assert(sail_codec_info_from_extension(extension, &codec_info) == SAIL_OK);
+
+    for (size_t i = 0; i < sizeof(io_options) / sizeof(io_options[0]); i++) {
+        if (!can_write(codec_info, io_options[i])) {
+            continue;
+        }
+
+        void *data;
+        size_t size;
+        encode_noise(extension, WIDTH, HEIGHT, io_options[i], &data, &size);
+
+        struct sail_image *reference;
+        munit_assert(sail_read_mem(data, size, &reference) == SAIL_OK);
+
+        for (size_t b = 0; b < sizeof(bands) / sizeof(bands[0]); b++) {
+            void *state;
+            munit_assert(sail_start_reading_mem(data, size, codec_info, &state) == SAIL_OK);
+
+            struct sail_image *image;
+            munit_assert(sail_start_reading_rows(state, &image) == SAIL_OK);
+
+            munit_assert_null(image->pixels);
+            munit_assert_uint(image->width,          ==, reference->width);
+            munit_assert_uint(image->height,         ==, reference->height);
+            munit_assert_uint(image->bytes_per_line, ==, reference->bytes_per_line);
+            munit_assert_int(image->pixel_format,    ==, reference->pixel_format);
+
+            void *rows;
+            munit_assert(sail_malloc((size_t)bands[b] * image->bytes_per_line, &rows) == SAIL_OK);
+
+            unsigned y = 0;
+
+            for (;;) {
+                unsigned read_rows;
+                munit_assert(sail_read_next_rows(state, rows, bands[b], &read_rows) == SAIL_OK);
+
+                const unsigned left_rows = image->height - y;
+                munit_assert_uint(read_rows, ==, left_rows < bands[b] ? left_rows : bands[b]);
+
+                if (read_rows == 0) {
+                    break;
+                }
+
+                munit_assert_memory_equal((size_t)read_rows * image->bytes_per_line, rows,
+                                          (const uint8_t *)reference->pixels + (size_t)y * reference->bytes_per_line);
+                y += read_rows;
+            }
+
+            munit_assert_uint(y, ==, image->height);
+
+            struct sail_image *next_image;
+            munit_assert(sail_start_reading_rows(state, &next_image) == SAIL_ERROR_NO_MORE_FRAMES);
+
+            sail_free(rows);
+            sail_destroy_image(image);
+            munit_assert(sail_stop_reading(state) == SAIL_OK);
+        }
+
+        sail_destroy_image(reference);
+        sail_free(data);
+    }
+
+    return MUNIT_OK;
+}
+
+/*
+ * Into buffer.
+ */
+static MunitResult test_into_buffer(const MunitParameter params[], void *user_data) {
+    (void)user_data;
+
+    const char *extension = munit_parameters_get(params, "extension");
+
+    static const int io_options[] = { 0, SAIL_IO_OPTION_INTERLACED };
+
+    /* Natural and padded rows. */
+    static const unsigned paddings[] = { 0, 13 };
+
+    const struct sail_codec_info *codec_info;
+    munit_assert(sail_codec_info_from_extension(extension, &codec_info) == SAIL_OK);
+
+    for (size_t i = 0; i < sizeof(io_options) / sizeof(io_options[0]); i++) {
+        if (!can_write(codec_info, io_options[i])) {
+            continue;
+        }
+
+        void *data;
+        size_t size;
+        encode_noise(extension, WIDTH, HEIGHT, io_options[i], &data, &size);
+
+        struct sail_image *reference;
+        munit_assert(sail_read_mem(data, size, &reference) == SAIL_OK);
+
+        for (size_t p = 0; p < sizeof(paddings) / sizeof(paddings[0]); p++) {
+            const unsigned bytes_per_line = reference->bytes_per_line + paddings[p];
+            const unsigned pixels_size = bytes_per_line * reference->height;
+
+            uint8_t *pixels;
+            munit_assert(sail_malloc(pixels_size, (void **)&pixels) == SAIL_OK);
+            memset(pixels, 0xA5, pixels_size);
+
+            void *state;
+            munit_assert(sail_start_reading_mem(data, size, codec_info, &state) == SAIL_OK);
+
+            struct sail_image *image;
+            munit_assert(sail_read_next_frame_into_buffer(state, pixels, pixels_size,
+                                                          paddings[p] == 0 ? 0 : bytes_per_line, &image) == SAIL_OK);
+
+            /* The pixels belong to the caller. */
+            munit_assert_null(image->pixels);
+            munit_assert_uint(image->width,          ==, reference->width);
+            munit_assert_uint(image->height,         ==, reference->height);
+            munit_assert_uint(image->bytes_per_line, ==, bytes_per_line);
+            munit_assert_int(image->pixel_format,    ==, reference->pixel_format);
+
+            for (unsigned y = 0; y < reference->height; y++) {
+                const uint8_t *row = pixels + (size_t)y * bytes_per_line;
+
+                munit_assert_memory_equal(reference->bytes_per_line, row,
+                                          (const uint8_t *)reference->pixels + (size_t)y * reference->bytes_per_line);
+
+                /* The padding is untouched. */
+                for (unsigned x = reference->bytes_per_line; x < bytes_per_line; x++) {
+                    munit_assert_uint8(row[x], ==, 0xA5);
+                }
+            }
+
+            sail_destroy_image(image);
+            munit_assert(sail_stop_reading(state) == SAIL_OK);
+            sail_free(pixels);
+        }
+
+        /* Rows shorter than the frame rows and buffers smaller than the frame are rejected. */
+        {
+            const unsigned pixels_size = reference->bytes_per_line * reference->height;
+
+            void *pixels;
+            munit_assert(sail_malloc(pixels_size, &pixels) == SAIL_OK);
+
+            void *state;
+            struct sail_image *image;
+
+            munit_assert(sail_start_reading_mem(data, size, codec_info, &state) == SAIL_OK);
+            munit_assert(sail_read_next_frame_into_buffer(state, pixels, pixels_size,
+                                                          reference->bytes_per_line - 1, &image) == SAIL_ERROR_INCORRECT_BYTES_PER_LINE);
+            munit_assert(sail_stop_reading(state) == SAIL_OK);
+
+            munit_assert(sail_start_reading_mem(data, size, codec_info, &state) == SAIL_OK);
+            munit_assert(sail_read_next_frame_into_buffer(state, pixels, pixels_size - 1, 0, &image) == SAIL_ERROR_INVALID_ARGUMENT);
+            munit_assert(sail_stop_reading(state) == SAIL_OK);
+
+            sail_free(pixels);
+        }
+
+        sail_destroy_image(reference);
+        sail_free(data);
+    }
+
+    return MUNIT_OK;
+}
+
+/*
+ * Crop.
+ */
+struct crop_rectangle {
+
+    unsigned x, y, width, height;
+};
+
+/* Requested rectangles and the expected rectangles clipped to the image. */
+static const struct {
+    struct crop_rectangle requested;
+    struct crop_rectangle expected;
+} crop_rectangles[] = {
+    /* No cropping. */
+    { { 0,          0,          0,  0  }, { 0,          0,          WIDTH,      HEIGHT      } },
+    /* Inside. */
+    { { 10,         5,          20, 17 }, { 10,         5,          20,         17          } },
+    /* Clipped at the right and bottom edges. */
+    { { WIDTH - 10, HEIGHT - 7, 50, 50 }, { WIDTH - 10, HEIGHT - 7, 10,         7           } },
+    { { 3,          0,          99, 4  }, { 3,          0,          WIDTH - 3,  4           } },
+    /* Up to the right and bottom edges. */
+    { { 30,         20,         0,  0  }, { 30,         20,         WIDTH - 30, HEIGHT - 20 } },
+    /* The last pixel and a single row. */
+    { { WIDTH - 1,  HEIGHT - 1, 1,  1  }, { WIDTH - 1,  HEIGHT - 1, 1,          1           } },
+    { { 0,          17,         0,  1  }, { 0,          17,         WIDTH,      1           } },
+};
+
+static void assert_cropped(const struct sail_image *image, const struct sail_image *reference,
+                           const struct crop_rectangle *expected, const void *pixels) {
+
+    munit_assert_uint(image->width,  ==, expected->width);
+    munit_assert_uint(image->height, ==, expected->height);
+    munit_assert_int(image->pixel_format, ==, reference->pixel_format);
+
+    /* The reference is 32-bit. */
+    for (unsigned y = 0; y < expected->height; y++) {
+        munit_assert_memory_equal((size_t)expected->width * 4,
+                                  (const uint8_t *)pixels + (size_t)y * image->bytes_per_line,
+                                  (const uint8_t *)reference->pixels + (size_t)(expected->y + y) * reference->bytes_per_line + expected->x * 4);
+    }
+}
+
+static MunitResult test_crop_rectangle(const MunitParameter params[], void *user_data) {
+    (void)params;
+    (void)user_data;
+
+    struct sail_read_options *read_options;
+    munit_assert(sail_alloc_read_options(&read_options) == SAIL_OK);
+
+    for (size_t i = 0; i < sizeof(crop_rectangles) / sizeof(crop_rectangles[0]); i++) {
+        read_options->crop_x      = crop_rectangles[i].requested.x;
+        read_options->crop_y      = crop_rectangles[i].requested.y;
+        read_options->crop_width  = crop_rectangles[i].requested.width;
+        read_options->crop_height = crop_rectangles[i].requested.height;
+
+        unsigned x, y, width, height;
+        munit_assert(sail_read_options_crop_rectangle(read_options, WIDTH, HEIGHT, &x, &y, &width, &height) == SAIL_OK);
+
+        munit_assert_uint(x,      ==, crop_rectangles[i].expected.x);
+        munit_assert_uint(y,      ==, crop_rectangles[i].expected.y);
+        munit_assert_uint(width,  ==, crop_rectangles[i].expected.width);
+        munit_assert_uint(height, ==, crop_rectangles[i].expected.height);
+    }
+
+    /* Outside of the image. */
+    unsigned x, y, width, height;
+
+    read_options->crop_x = WIDTH;
+    read_options->crop_y = 0;
+    munit_assert(sail_read_options_crop_rectangle(read_options, WIDTH, HEIGHT, &x, &y, &width, &height) == SAIL_ERROR_INCORRECT_IMAGE_DIMENSIONS);
+
+    read_options->crop_x = 0;
+    read_options->crop_y = HEIGHT;
+    munit_assert(sail_read_options_crop_rectangle(read_options, WIDTH, HEIGHT, &x, &y, &width, &height) == SAIL_ERROR_INCORRECT_IMAGE_DIMENSIONS);
+
+    sail_destroy_read_options(read_options);
+
+    return MUNIT_OK;
+}
+
+static MunitResult test_crop(const MunitParameter params[], void *user_data) {
+    (void)user_data;
+
+    const char *extension = munit_parameters_get(params, "extension");
+
+    /* Interlaced images are cropped pass by pass out of the full rows. */
+    static const int io_options[] = { 0, SAIL_IO_OPTION_INTERLACED };
+
+    const struct sail_codec_info *codec_info;
+    munit_assert(sail_codec_info_from_extension(extension, &codec_info) == SAIL_OK);
+
+    struct sail_read_options *read_options;
+    munit_assert(sail_alloc_read_options_from_features(codec_info->read_features, &read_options) == SAIL_OK);
+
+    for (size_t o = 0; o < sizeof(io_options) / sizeof(io_options[0]); o++) {
+        if (!can_write(codec_info, io_options[o])) {
+            continue;
+        }
+
+        void *data;
+        size_t size;
+        encode_noise(extension, WIDTH, HEIGHT, io_options[o], &data, &size);
+
+        struct sail_image *reference;
+        munit_assert(sail_read_mem(data, size, &reference) == SAIL_OK);
+
+        for (size_t i = 0; i < sizeof(crop_rectangles) / sizeof(crop_rectangles[0]); i++) {
+            const struct crop_rectangle *expected = &crop_rectangles[i].expected;
+
+            read_options->crop_x      = crop_rectangles[i].requested.x;
+            read_options->crop_y      = crop_rectangles[i].requested.y;
+            read_options->crop_width  = crop_rectangles[i].requested.width;
+            read_options->crop_height = crop_rectangles[i].requested.height;
+
+            /* Whole frames. */
+            void *state;
+            munit_assert(sail_start_reading_mem_with_options(data, size, codec_info, read_options, &state) == SAIL_OK);
+
+            struct sail_image *image;
+            munit_assert(sail_read_next_frame(state, &image) == SAIL_OK);
+
+            assert_cropped(image, reference, expected, image->pixels);
+
+            sail_destroy_image(image);
+            munit_assert(sail_stop_reading(state) == SAIL_OK);
+
+            /* Rows. */
+            munit_assert(sail_start_reading_mem_with_options(data, size, codec_info, read_options, &state) == SAIL_OK);
+            munit_assert(sail_start_reading_rows(state, &image) == SAIL_OK);
+
+            void *pixels;
+            munit_assert(sail_malloc((size_t)image->bytes_per_line * image->height, &pixels) == SAIL_OK);
+
+            unsigned y = 0;
+            unsigned read_rows;
+
+            do {
+                munit_assert(sail_read_next_rows(state, (uint8_t *)pixels + (size_t)y * image->bytes_per_line, 5, &read_rows) == SAIL_OK);
+                y += read_rows;
+            } while (read_rows > 0);
+
+            munit_assert_uint(y, ==, expected->height);
+            assert_cropped(image, reference, expected, pixels);
+
+            sail_free(pixels);
+            sail_destroy_image(image);
+            munit_assert(sail_stop_reading(state) == SAIL_OK);
+        }
+
+        /* Outside of the image. Codecs reading headers on start fail to start. */
+        read_options->crop_x      = WIDTH;
+        read_options->crop_y      = 0;
+        read_options->crop_width  = 0;
+        read_options->crop_height = 0;
+
+        void *state;
+        sail_status_t status = sail_start_reading_mem_with_options(data, size, codec_info, read_options, &state);
+
+        if (status == SAIL_OK) {
+            struct sail_image *image;
+            status = sail_read_next_frame(state, &image);
+            munit_assert(sail_stop_reading(state) == SAIL_OK);
+        }
+
+        munit_assert(status == SAIL_ERROR_INCORRECT_IMAGE_DIMENSIONS);
+
+        sail_destroy_image(reference);
+        sail_free(data);
+    }
+
+    sail_destroy_read_options(read_options);
+
+    return MUNIT_OK;
+}
+
+/*
+ * Scaling.
+ */
+
+/* Smooth gradient, so a downscaled pixel is close to the source pixel in the middle of its block. */
+static void gradient_pixel(unsigned x, unsigned y, uint8_t rgb[3]) {
+
+    rgb[0] = (uint8_t)(x * 3);
+    rgb[1] = (uint8_t)(y * 4);
+    rgb[2] = (uint8_t)(255 - x - y);
+}
+
+static MunitResult test_scale(const MunitParameter params[], void *user_data) {
+    (void)params;
+    (void)user_data;
+
+    /* DCT scales rounding the size up, and the smallest scale covering the target size. */
+    static const struct {
+        unsigned target_width;
+        unsigned target_height;
+        unsigned scale;
+    } scales[] = {
+        { (WIDTH + 1) / 2, (HEIGHT + 1) / 2, 2 },
+        { (WIDTH + 3) / 4, (HEIGHT + 3) / 4, 4 },
+        { (WIDTH + 7) / 8, (HEIGHT + 7) / 8, 8 },
+        { 25,              10,               2 },
+        { 0,               HEIGHT / 3,       2 },
+        { WIDTH * 2,       HEIGHT,           1 },
+    };
+
+    struct sail_image *source = alloc_rgb_image(WIDTH, HEIGHT);
+
+    for (unsigned y = 0; y < HEIGHT; y++) {
+        for (unsigned x = 0; x < WIDTH; x++) {
+            gradient_pixel(x, y, (uint8_t *)source->pixels + y * source->bytes_per_line + x * 3);
+        }
+    }
+
+    void *data;
+    size_t size;
+    encode_image("jpg", source, 0, &data, &size);
+
+    const struct sail_codec_info *codec_info;
+    munit_assert(sail_codec_info_from_extension("jpg", &codec_info) == SAIL_OK);
+
+    struct sail_read_options *read_options;
+    munit_assert(sail_alloc_read_options_from_features(codec_info->read_features, &read_options) == SAIL_OK);
+    read_options->output_pixel_format = SAIL_PIXEL_FORMAT_BPP24_RGB;
+
+    for (size_t i = 0; i < sizeof(scales) / sizeof(scales[0]); i++) {
+        const unsigned scale = scales[i].scale;
+
+        read_options->target_width  = scales[i].target_width;
+        read_options->target_height = scales[i].target_height;
+
+        void *state;
+        munit_assert(sail_start_reading_mem_with_options(data, size, codec_info, read_options, &state) == SAIL_OK);
+
+        struct sail_image *image;
+        munit_assert(sail_read_next_frame(state, &image) == SAIL_OK);
+        munit_assert(sail_stop_reading(state) == SAIL_OK);
+
+        munit_assert_uint(image->width,       ==, (WIDTH  + scale - 1) / scale);
+        munit_assert_uint(image->height,      ==, (HEIGHT + scale - 1) / scale);
+        munit_assert_int(image->pixel_format, ==, SAIL_PIXEL_FORMAT_BPP24_RGB);
+
+        /* Every pixel is the average of its block. The last blocks may be partial. */
+        for (unsigned y = 0; y < image->height; y++) {
+            const unsigned block_y = y * scale;
+            const unsigned center_y = (block_y + scale <= HEIGHT) ? block_y * 2 + scale - 1 : block_y + HEIGHT - 1;
+
+            for (unsigned x = 0; x < image->width; x++) {
+                const unsigned block_x = x * scale;
+                const unsigned center_x = (block_x + scale <= WIDTH) ? block_x * 2 + scale - 1 : block_x + WIDTH - 1;
+
+                /* The gradient is linear, so the average is the value in the middle. Coordinates are doubled. */
+                const uint8_t *pixel = (const uint8_t *)image->pixels + (size_t)y * image->bytes_per_line + x * 3;
+                const int middle[3] = {
+                    (int)(center_x * 3) / 2,
+                    (int)(center_y * 4) / 2,
+                    255 - (int)(center_x + center_y) / 2,
+                };
+
+                for (unsigned c = 0; c < 3; c++) {
+                    munit_assert_int(abs(pixel[c] - middle[c]), <=, 12);
+                }
+            }
+        }
+
+        sail_destroy_image(image);
+    }
+
+    sail_destroy_read_options(read_options);
+    sail_free(data);
+
+    return MUNIT_OK;
+}
+
+/*
+ * Reset.
+ */
+static void assert_same_image(const struct sail_image *image, const struct sail_image *reference) {
+
+    munit_assert_uint(image->width,          ==, reference->width);
+    munit_assert_uint(image->height,         ==, reference->height);
+    munit_assert_uint(image->bytes_per_line, ==, reference->bytes_per_line);
+    munit_assert_int(image->pixel_format,    ==, reference->pixel_format);
+
+    munit_assert_memory_equal((size_t)reference->bytes_per_line * reference->height, image->pixels, reference->pixels);
+}
+
+static MunitResult test_reset(const MunitParameter params[], void *user_data) {
+    (void)user_data;
+
+    const char *extension = munit_parameters_get(params, "extension");
+
+    const struct sail_codec_info *codec_info;
+    munit_assert(sail_codec_info_from_extension(extension, &codec_info) == SAIL_OK);
+
+    /* Images of different sizes to make sure nothing of the first image is reused. */
+    void *data1, *data2;
+    size_t size1, size2;
+    encode_noise(extension, WIDTH,     HEIGHT,     0, &data1, &size1);
+    encode_noise(extension, WIDTH + 9, HEIGHT - 4, 0, &data2, &size2);
+
+    struct sail_image *reference1, *reference2;
+    munit_assert(sail_read_mem(data1, size1, &reference1) == SAIL_OK);
+    munit_assert(sail_read_mem(data2, size2, &reference2) == SAIL_OK);
+
+    void *state;
+    struct sail_image *image;
+    munit_assert(sail_start_reading_mem(data1, size1, codec_info, &state) == SAIL_OK);
+
+    /* In the middle of a frame streamed in rows. */
+    munit_assert(sail_start_reading_rows(state, &image) == SAIL_OK);
+
+    void *rows;
+    munit_assert(sail_malloc_pixels((size_t)image->bytes_per_line * image->height, &rows) == SAIL_OK);
+
+    unsigned read_rows;
+    munit_assert(sail_read_next_rows(state, rows, 3, &read_rows) == SAIL_OK);
+    munit_assert_uint(read_rows, ==, 3);
+
+    const sail_status_t status = sail_reset_reading_mem(state, data2, size2);
+
+    if (status == SAIL_ERROR_NOT_IMPLEMENTED) {
+        /* The codec cannot reset. The state must be left untouched. */
+        munit_assert(sail_read_next_rows(state, (uint8_t *)rows + (size_t)3 * image->bytes_per_line,
+                                         image->height - 3, &read_rows) == SAIL_OK);
+        munit_assert_uint(read_rows, ==, image->height - 3);
+
+        image->pixels = rows;
+        assert_same_image(image, reference1);
+    } else {
+        munit_assert(status == SAIL_OK);
+
+        sail_free_pixels(rows);
+        sail_destroy_image(image);
+
+        munit_assert(sail_read_next_frame(state, &image) == SAIL_OK);
+        assert_same_image(image, reference2);
+        sail_destroy_image(image);
+
+        /* After a whole frame. */
+        munit_assert(sail_reset_reading_mem(state, data1, size1) == SAIL_OK);
+
+        munit_assert(sail_read_next_frame(state, &image) == SAIL_OK);
+        assert_same_image(image, reference1);
+        sail_destroy_image(image);
+
+        /* After the end of the file. */
+        munit_assert(sail_read_next_frame(state, &image) == SAIL_ERROR_NO_MORE_FRAMES);
+
+        munit_assert(sail_reset_reading_mem(state, data2, size2) == SAIL_OK);
+
+        munit_assert(sail_read_next_frame(state, &image) == SAIL_OK);
+        assert_same_image(image, reference2);
+        sail_destroy_image(image);
+
+        /* Before reading anything. */
+        munit_assert(sail_reset_reading_mem(state, data1, size1) == SAIL_OK);
+        munit_assert(sail_reset_reading_mem(state, data2, size2) == SAIL_OK);
+
+        munit_assert(sail_read_next_frame(state, &image) == SAIL_OK);
+        assert_same_image(image, reference2);
+    }
+
+    /* Frees the rows if they were attached. */
+    sail_destroy_image(image);
+
+    munit_assert(sail_stop_reading(state) == SAIL_OK);
+
+    sail_destroy_image(reference2);
+    sail_destroy_image(reference1);
+    sail_free(data2);
+    sail_free(data1);
+
+    return MUNIT_OK;
+}
+
+/*
+ * Feed.
+ */
+static MunitResult test_feed(const MunitParameter params[], void *user_data) {
+    (void)user_data;
+
+    const char *extension = munit_parameters_get(params, "extension");
+
+    static const int io_options[] = { 0, SAIL_IO_OPTION_INTERLACED };
+
+    /* Single bytes, chunks smaller and larger than the image headers, and the whole data at once. */
+    static const size_t chunk_sizes[] = { 1, 7, 64, 1000, SIZE_MAX };
+
+    const struct sail_codec_info *codec_info;
+    munit_assert(sail_codec_info_from_extension(extension, &codec_info) == SAIL_OK);
+
+    for (size_t i = 0; i < sizeof(io_options) / sizeof(io_options[0]); i++) {
+        if (!can_write(codec_info, io_options[i])) {
+            continue;
+        }
+
+        void *data;
+        size_t size;
+        encode_noise(extension, WIDTH, HEIGHT, io_options[i], &data, &size);
+
+        struct sail_image *reference;
+        munit_assert(sail_read_mem(data, size, &reference) == SAIL_OK);
+
+        for (size_t c = 0; c < sizeof(chunk_sizes) / sizeof(chunk_sizes[0]); c++) {
+            const unsigned tracked_pixels = tracked_pixels_count();
+
+            void *state;
+            munit_assert(sail_start_feeding(codec_info, NULL, &state) == SAIL_OK);
+
+            const struct sail_image *image = NULL;
+            unsigned valid_rows = 0;
+
+            for (size_t offset = 0; offset < size;) {
+                const size_t chunk_size = size - offset < chunk_sizes[c] ? size - offset : chunk_sizes[c];
+                const unsigned previous_valid_rows = valid_rows;
+
+                munit_assert(sail_feed(state, (const uint8_t *)data + offset, chunk_size, &image, &valid_rows) == SAIL_OK);
+                offset += chunk_size;
+
+                munit_assert_uint(valid_rows, >=, previous_valid_rows);
+
+                if (image != NULL) {
+                    munit_assert_uint(image->width,  ==, reference->width);
+                    munit_assert_uint(image->height, ==, reference->height);
+                    munit_assert_uint(valid_rows, <=, image->height);
+
+                    /* Allocated with the pixels allocator. */
+                    munit_assert_true(is_tracked_pixels(image->pixels));
+                } else {
+                    munit_assert_uint(valid_rows, ==, 0);
+                }
+            }
+
+            munit_assert(sail_feed(state, NULL, 0, &image, &valid_rows) == SAIL_OK);
+
+            munit_assert_not_null(image);
+            munit_assert_uint(valid_rows, ==, reference->height);
+            assert_same_image(image, reference);
+
+            munit_assert(sail_stop_feeding(state) == SAIL_OK);
+
+            /* Freed with the pixels allocator. */
+            munit_assert_uint(tracked_pixels_count(), ==, tracked_pixels);
+        }
+
+        sail_destroy_image(reference);
+        sail_free(data);
+    }
+
+    return MUNIT_OK;
+}
+
+static MunitResult test_feed_truncated(const MunitParameter params[], void *user_data) {
+    (void)user_data;
+
+    const char *extension = munit_parameters_get(params, "extension");
+
+    const struct sail_codec_info *codec_info;
+    munit_assert(sail_codec_info_from_extension(extension, &codec_info) == SAIL_OK);
+
+    void *data;
+    size_t size;
+    encode_noise(extension, WIDTH, HEIGHT, 0, &data, &size);
+
+    struct sail_image *reference;
+    munit_assert(sail_read_mem(data, size, &reference) == SAIL_OK);
+
+    /* Percents of the data, then the end of the data. */
+    static const size_t percents[] = { 50, 75 };
+
+    for (size_t p = 0; p < sizeof(percents) / sizeof(percents[0]); p++) {
+        void *state;
+        munit_assert(sail_start_feeding(codec_info, NULL, &state) == SAIL_OK);
+
+        const struct sail_image *image;
+        unsigned valid_rows;
+
+        munit_assert(sail_feed(state, data, size * percents[p] / 100, &image, &valid_rows) == SAIL_OK);
+        munit_assert(sail_feed(state, NULL, 0, &image, &valid_rows) == SAIL_OK);
+
+        munit_assert_not_null(image);
+        munit_assert_uint(valid_rows, >, 0);
+        munit_assert_uint(valid_rows, <, reference->height);
+
+        /* The valid rows are final. */
+        munit_assert_memory_equal((size_t)valid_rows * reference->bytes_per_line, image->pixels, reference->pixels);
+
+        /* Running out of data after the end is not an error. */
+        munit_assert(sail_feed(state, NULL, 0, &image, &valid_rows) == SAIL_OK);
+
+        munit_assert(sail_stop_feeding(state) == SAIL_OK);
+    }
+
+    sail_destroy_image(reference);
+    sail_free(data);
+
+    return MUNIT_OK;
+}
+
+static char *extensions[] = { (char *)"png", (char *)"jpg", NULL };
+
+static MunitParameterEnum test_params[] = {
+    { (char *)"extension", extensions },
+    { NULL, NULL }
+};
+
+static MunitTest test_suite_tests[] = {
+    { (char *)"/probe",       test_probe,       NULL, NULL, MUNIT_TEST_OPTION_NONE, test_params },
+    { (char *)"/rows",        test_rows,        NULL, NULL, MUNIT_TEST_OPTION_NONE, test_params },
+    { (char *)"/into-buffer", test_into_buffer, NULL, NULL, MUNIT_TEST_OPTION_NONE, test_params },
+
+    { (char *)"/crop-rectangle", test_crop_rectangle, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL        },
+    { (char *)"/crop",           test_crop,           NULL, NULL, MUNIT_TEST_OPTION_NONE, test_params },
+
+    { (char *)"/scale", test_scale, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+
+    { (char *)"/reset", test_reset, NULL, NULL, MUNIT_TEST_OPTION_NONE, test_params },
+
+    { (char *)"/feed",           test_feed,           NULL, NULL, MUNIT_TEST_OPTION_NONE, test_params },
+    { (char *)"/feed-truncated", test_feed_truncated, NULL, NULL, MUNIT_TEST_OPTION_NONE, test_params },
+
+    { NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL }
+};
+
+static const MunitSuite test_suite = {
+    (char *)"/read",
+    test_suite_tests,
+    NULL,
+    1,
+    MUNIT_SUITE_OPTION_NONE
+};
+
+int main(int argc, char *argv[MUNIT_ARRAY_PARAM(argc + 1)]) {
+
+    /* Allocators must be installed before SAIL allocates anything. */
+    const struct sail_allocator pixels_allocator = { pixels_malloc, pixels_realloc, pixels_free, NULL };
+
+    if (sail_set_pixels_allocator(&pixels_allocator) != SAIL_OK) {
+        return EXIT_FAILURE;
+    }
+
+    return munit_suite_main(&test_suite, NULL, argc, argv);
+}
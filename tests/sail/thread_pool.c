@@ -0,0 +1,301 @@
+/*  This file is part of SAIL (https://github.com/smoked-herring/sail)
+
+    Copyright (c) 2020 Dmitry Baryshev
+
+    The MIT License
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#ifdef SAIL_WIN32
+    #include <windows.h>
+#endif
+
+#include "sail-common.h"
+
+#include "munit.h"
+
+#define JOBS 1000
+#define TASKS 100
+
+static const unsigned THREADS[] = { 0, 1, 3, 8 };
+
+static void increment(volatile long *counter) {
+
+#ifdef SAIL_WIN32
+    InterlockedIncrement(counter);
+#else
+    __atomic_fetch_add(counter, 1, __ATOMIC_SEQ_CST);
+#endif
+}
+
+struct run_context {
+    unsigned threads;
+    unsigned executed[JOBS];
+    unsigned workers[JOBS];
+    unsigned failing_job;
+};
+
+static sail_status_t run_job(void *context, unsigned job, unsigned worker) {
+
+    struct run_context *run_context = context;
+
+    run_context->executed[job]++;
+    run_context->workers[job] = worker;
+
+    return (job == run_context->failing_job) ? SAIL_ERROR_UNDERLYING_CODEC : SAIL_OK;
+}
+
+static void reset_run_context(struct run_context *run_context, unsigned threads, unsigned failing_job) {
+
+    run_context->threads     = threads;
+    run_context->failing_job = failing_job;
+
+    for (unsigned i = 0; i < JOBS; i++) {
+        run_context->executed[i] = 0;
+        run_context->workers[i]  = 0;
+    }
+}
+
+/*
+ * Runs.
+ */
+static MunitResult test_run(const MunitParameter params[], void *user_data) {
+    (void)params;
+    (void)user_data;
+
+    static struct run_context run_context;
+
+    for (size_t t = 0; t < sizeof(THREADS) / sizeof(THREADS[0]); t++) {
+        struct sail_thread_pool *pool;
+        munit_assert(sail_alloc_thread_pool(THREADS[t], &pool) == SAIL_OK);
+        munit_assert_uint(sail_thread_pool_threads(pool), ==, THREADS[t]);
+
+        /* The threads are reused by many runs of different sizes. */
+        for (unsigned job_count = 0; job_count <= JOBS; job_count += (job_count < 10) ? 1 : 99) {
+            reset_run_context(&run_context, THREADS[t], JOBS);
+
+            munit_assert(sail_thread_pool_run(pool, job_count, run_job, &run_context) == SAIL_OK);
+
+            for (unsigned i = 0; i < JOBS; i++) {
+                munit_assert_uint(run_context.executed[i], ==, (i < job_count) ? 1 : 0);
+                munit_assert_uint(run_context.workers[i], <=, THREADS[t]);
+            }
+        }
+
+        sail_destroy_thread_pool(pool);
+    }
+
+    return MUNIT_OK;
+}
+
+static MunitResult test_run_failure(const MunitParameter params[], void *user_data) {
+    (void)params;
+    (void)user_data;
+
+    static struct run_context run_context;
+
+    for (size_t t = 0; t < sizeof(THREADS) / sizeof(THREADS[0]); t++) {
+        struct sail_thread_pool *pool;
+        munit_assert(sail_alloc_thread_pool(THREADS[t], &pool) == SAIL_OK);
+
+        reset_run_context(&run_context, THREADS[t], JOBS / 2);
+        munit_assert(sail_thread_pool_run(pool, JOBS, run_job, &run_context) == SAIL_ERROR_UNDERLYING_CODEC);
+
+        /* Jobs are executed at most once, and the failed job stops the others. */
+        unsigned executed = 0;
+
+        for (unsigned i = 0; i < JOBS; i++) {
+            munit_assert_uint(run_context.executed[i], <=, 1);
+            executed += run_context.executed[i];
+        }
+
+        munit_assert_uint(run_context.executed[JOBS / 2], ==, 1);
+        munit_assert_uint(executed, <=, JOBS / 2 + 1 + THREADS[t]);
+
+        /* The pool is usable after a failure. */
+        reset_run_context(&run_context, THREADS[t], JOBS);
+        munit_assert(sail_thread_pool_run(pool, JOBS, run_job, &run_context) == SAIL_OK);
+
+        for (unsigned i = 0; i < JOBS; i++) {
+            munit_assert_uint(run_context.executed[i], ==, 1);
+        }
+
+        sail_destroy_thread_pool(pool);
+    }
+
+    return MUNIT_OK;
+}
+
+/*
+ * Tasks.
+ */
+struct task {
+    unsigned index;
+    unsigned long long sum;
+};
+
+static sail_status_t run_task(void *arg) {
+
+    struct task *task = arg;
+
+    /* Later tasks finish earlier. */
+    const unsigned long long iterations = (unsigned long long)(TASKS - task->index) * 10000;
+
+    task->sum = 0;
+
+    for (unsigned long long i = 0; i < iterations; i++) {
+        task->sum += i ^ task->index;
+    }
+
+    return (task->index % 7 == 3) ? SAIL_ERROR_UNDERLYING_CODEC : SAIL_OK;
+}
+
+static MunitResult test_submit_take(const MunitParameter params[], void *user_data) {
+    (void)params;
+    (void)user_data;
+
+    static struct task tasks[TASKS];
+
+    for (size_t t = 0; t < sizeof(THREADS) / sizeof(THREADS[0]); t++) {
+        struct sail_thread_pool *pool;
+        munit_assert(sail_alloc_thread_pool(THREADS[t], &pool) == SAIL_OK);
+
+        void *task;
+        munit_assert(sail_thread_pool_take(pool, /* wait */ true, &task) == SAIL_OK);
+        munit_assert_null(task);
+
+        /* More tasks than the initial ring capacity. */
+        for (unsigned i = 0; i < TASKS; i++) {
+            tasks[i].index = i;
+            munit_assert(sail_thread_pool_submit(pool, run_task, &tasks[i]) == SAIL_OK);
+        }
+
+        munit_assert_uint(sail_thread_pool_queued(pool), ==, TASKS);
+
+        /* Running jobs is not allowed while tasks are queued. */
+        static struct run_context run_context;
+        reset_run_context(&run_context, THREADS[t], JOBS);
+        munit_assert(sail_thread_pool_run(pool, JOBS, run_job, &run_context) == SAIL_ERROR_INVALID_ARGUMENT);
+
+        /* Tasks are taken back in the order they were submitted. */
+        for (unsigned i = 0; i < TASKS; i++) {
+            const sail_status_t status = sail_thread_pool_take(pool, /* wait */ true, &task);
+
+            munit_assert_ptr_equal(task, &tasks[i]);
+            munit_assert(status == ((i % 7 == 3) ? SAIL_ERROR_UNDERLYING_CODEC : SAIL_OK));
+        }
+
+        munit_assert_uint(sail_thread_pool_queued(pool), ==, 0);
+
+        /* Tasks and jobs share the threads. */
+        munit_assert(sail_thread_pool_run(pool, JOBS, run_job, &run_context) == SAIL_OK);
+
+        /* Not waiting returns finished tasks only. */
+        munit_assert(sail_thread_pool_submit(pool, run_task, &tasks[1]) == SAIL_OK);
+
+        for (;;) {
+            sail_thread_pool_take(pool, /* wait */ false, &task);
+
+            if (task != NULL) {
+                munit_assert_ptr_equal(task, &tasks[1]);
+                break;
+            }
+
+            munit_assert_uint(sail_thread_pool_queued(pool), ==, 1);
+        }
+
+        /* Tasks not taken back are discarded. */
+        munit_assert(sail_thread_pool_submit(pool, run_task, &tasks[2]) == SAIL_OK);
+
+        sail_destroy_thread_pool(pool);
+    }
+
+    return MUNIT_OK;
+}
+
+/*
+ * Hooks.
+ */
+struct hooks_counters {
+    volatile long started;
+    volatile long stopped;
+};
+
+static void thread_started(void *user_data) {
+
+    struct hooks_counters *counters = user_data;
+
+    increment(&counters->started);
+}
+
+static void thread_stopped(void *user_data) {
+
+    struct hooks_counters *counters = user_data;
+
+    increment(&counters->stopped);
+}
+
+static MunitResult test_hooks(const MunitParameter params[], void *user_data) {
+    (void)params;
+    (void)user_data;
+
+    static struct run_context run_context;
+
+    for (size_t t = 0; t < sizeof(THREADS) / sizeof(THREADS[0]); t++) {
+        struct hooks_counters counters = { 0, 0 };
+
+        struct sail_thread_pool *pool;
+        munit_assert(sail_alloc_thread_pool_with_hooks(THREADS[t], thread_started, thread_stopped, &counters, &pool) == SAIL_OK);
+
+        for (unsigned i = 0; i < 10; i++) {
+            reset_run_context(&run_context, THREADS[t], JOBS);
+            munit_assert(sail_thread_pool_run(pool, JOBS, run_job, &run_context) == SAIL_OK);
+        }
+
+        sail_destroy_thread_pool(pool);
+
+        /* Every thread is started and stopped once, no matter how many runs it executed. */
+        munit_assert_long(counters.started, ==, (long)THREADS[t]);
+        munit_assert_long(counters.stopped, ==, (long)THREADS[t]);
+    }
+
+    return MUNIT_OK;
+}
+
+static MunitTest test_suite_tests[] = {
+    { (char *)"/run",         test_run,         NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+    { (char *)"/run-failure", test_run_failure, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+    { (char *)"/submit-take", test_submit_take, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+    { (char *)"/hooks",       test_hooks,       NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+
+    { NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL }
+};
+
+static const MunitSuite test_suite = {
+    (char *)"/thread-pool",
+    test_suite_tests,
+    NULL,
+    1,
+    MUNIT_SUITE_OPTION_NONE
+};
+
+int main(int argc, char *argv[MUNIT_ARRAY_PARAM(argc + 1)]) {
+    return munit_suite_main(&test_suite, NULL, argc, argv);
+}
@@ -0,0 +1,764 @@
+/*  This file is part of SAIL (https://github.com/smoked-herring/sail)
+
+    Copyright (c) 2020 Dmitry Baryshev
+
+    The MIT License
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sail-common.h"
+#include "sail.h"
+
+#include "munit.h"
+
+/* Not a multiple of the tile size to cover partial tiles at the right and bottom edges. */
+#define WIDTH  301
+#define HEIGHT 157
+
+/* Rounded up to 48x80 by the codec. */
+#define TILE_WIDTH  37
+#define TILE_HEIGHT 70
+
+/*
+ * Helpers.
+ */
+
+/*
+ * Allocates a noisy image of the specified pixel format. Rows are padded with the specified number of bytes
+ * to check that codecs honor bytes_per_line. The seed makes different frames differ.
+ */
+static struct sail_image* noise_image(enum SailPixelFormat pixel_format, unsigned width, unsigned height, unsigned padding, unsigned seed) {
+
+    struct sail_image *image;
+    munit_assert(sail_alloc_image(&image) == SAIL_OK);
+
+    image->width        = width;
+    image->height       = height;
+    image->pixel_format = pixel_format;
+
+    munit_assert(sail_bytes_per_line(width, pixel_format, &image->bytes_per_line) == SAIL_OK);
+    image->bytes_per_line += padding;
+
+    munit_assert(sail_malloc_pixels((size_t)image->bytes_per_line * image->height, &image->pixels) == SAIL_OK);
+
+    for (unsigned y = 0; y < image->height; y++) {
+        uint8_t *row = (uint8_t *)image->pixels + (size_t)y * image->bytes_per_line;
+
+        for (unsigned x = 0; x < image->bytes_per_line; x++) {
+            row[x] = (uint8_t)(((x * 73856093U) ^ (y * 19349663U) ^ (seed * 83492791U)) >> 11);
+        }
+    }
+
+    return image;
+}
+
+/* Checks that the pixels match row by row. Padding is not compared. */
+static void assert_same_pixels(const struct sail_image *image, const struct sail_image *reference) {
+
+    munit_assert_uint(image->width,       ==, reference->width);
+    munit_assert_uint(image->height,      ==, reference->height);
+    munit_assert_int(image->pixel_format, ==, reference->pixel_format);
+
+    unsigned bytes_per_line;
+    munit_assert(sail_bytes_per_line(image->width, image->pixel_format, &bytes_per_line) == SAIL_OK);
+
+    for (unsigned y = 0; y < image->height; y++) {
+        munit_assert_memory_equal(bytes_per_line,
+                                  (const uint8_t *)image->pixels + (size_t)y * image->bytes_per_line,
+                                  (const uint8_t *)reference->pixels + (size_t)y * reference->bytes_per_line);
+    }
+}
+
+static const struct sail_codec_info* tiff_codec_info(void) {
+
+    const struct sail_codec_info *codec_info;
+    munit_assert(sail_codec_info_from_extension("tiff", &codec_info) == SAIL_OK);
+
+    return codec_info;
+}
+
+/* Returns true if the codec was built with the specified compression. */
+static bool can_compress(const struct sail_codec_info *codec_info, enum SailCompression compression) {
+
+    for (unsigned i = 0; i < codec_info->write_features->compressions_length; i++) {
+        if (codec_info->write_features->compressions[i] == compression) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*
+ * Writes the frames into the file when the path is not NULL, and into memory otherwise.
+ * The data must be freed with sail_free().
+ */
+static void write_frames(const char *path, struct sail_image **frames, unsigned frames_count, const struct sail_write_options *write_options,
+                            void **data, size_t *size) {
+
+    void *state;
+    *data = NULL;
+    *size = 0;
+
+    if (path != NULL) {
+        munit_assert(sail_start_writing_file_with_options(path, tiff_codec_info(), write_options, &state) == SAIL_OK);
+    } else {
+        munit_assert(sail_start_writing_growable_mem_with_options(data, size, tiff_codec_info(), write_options, &state) == SAIL_OK);
+    }
+
+    for (unsigned i = 0; i < frames_count; i++) {
+        munit_assert(sail_write_next_frame(state, frames[i]) == SAIL_OK);
+    }
+
+    munit_assert(sail_stop_writing(state) == SAIL_OK);
+}
+
+/* Reads the file when the path is not NULL, and the data otherwise. */
+static void start_reading(const char *path, const void *data, size_t size, const struct sail_read_options *read_options, void **state) {
+
+    if (path != NULL) {
+        munit_assert(sail_start_reading_file_with_options(path, tiff_codec_info(), read_options, state) == SAIL_OK);
+    } else {
+        munit_assert(sail_start_reading_mem_with_options(data, size, tiff_codec_info(), read_options, state) == SAIL_OK);
+    }
+}
+
+/* Reads the file or the data with the specified options and checks that it contains exactly the expected frames. */
+static void assert_frames(const char *path, const void *data, size_t size, const struct sail_read_options *read_options,
+                            struct sail_image **expected, unsigned expected_count) {
+
+    void *state;
+    start_reading(path, data, size, read_options, &state);
+
+    for (unsigned i = 0; i < expected_count; i++) {
+        struct sail_image *image;
+        munit_assert(sail_read_next_frame(state, &image) == SAIL_OK);
+
+        assert_same_pixels(image, expected[i]);
+
+        sail_destroy_image(image);
+    }
+
+    struct sail_image *image;
+    munit_assert(sail_read_next_frame(state, &image) == SAIL_ERROR_NO_MORE_FRAMES);
+
+    munit_assert(sail_stop_reading(state) == SAIL_OK);
+}
+
+/* Region of interest checked by the reading tests. Odd offsets shift packed pixels within bytes. */
+#define CROP_X 3
+#define CROP_Y 5
+
+/* Returns the sample of the packed pixel. Packed pixels start at the most significant bit. */
+static unsigned packed_pixel(const uint8_t *row, unsigned x, unsigned bits_per_pixel) {
+
+    const unsigned bit = x * bits_per_pixel;
+
+    return (row[bit / 8] >> (8 - bits_per_pixel - bit % 8)) & ((1U << bits_per_pixel) - 1);
+}
+
+static uint16_t sample16(const uint8_t *pixel, unsigned index) {
+
+    uint16_t sample;
+    memcpy(&sample, pixel + index * 2, sizeof(sample));
+
+    return sample;
+}
+
+/*
+ * Converts the reference pixel into RGBA the way the codec does: gray and indexed samples below 8 bits
+ * are scaled to the full range, 16-bit samples in the host byte order are truncated to their high bytes.
+ */
+static void reference_rgba(const struct sail_image *reference, unsigned x, unsigned y, uint8_t rgba[4]) {
+
+    unsigned bits_per_pixel;
+    munit_assert(sail_bits_per_pixel(reference->pixel_format, &bits_per_pixel) == SAIL_OK);
+
+    const uint8_t *row = (const uint8_t *)reference->pixels + (size_t)y * reference->bytes_per_line;
+    const uint8_t *pixel = row + (size_t)x * bits_per_pixel / 8;
+
+    rgba[3] = 255;
+
+    switch (reference->pixel_format) {
+        case SAIL_PIXEL_FORMAT_BPP1_INDEXED:
+        case SAIL_PIXEL_FORMAT_BPP2_INDEXED:
+        case SAIL_PIXEL_FORMAT_BPP4_INDEXED:
+        case SAIL_PIXEL_FORMAT_BPP8_INDEXED: {
+            const uint8_t *color = (const uint8_t *)reference->palette->data + packed_pixel(row, x, bits_per_pixel) * 3;
+            memcpy(rgba, color, 3);
+            break;
+        }
+        case SAIL_PIXEL_FORMAT_BPP1_GRAYSCALE:
+        case SAIL_PIXEL_FORMAT_BPP2_GRAYSCALE:
+        case SAIL_PIXEL_FORMAT_BPP4_GRAYSCALE:
+        case SAIL_PIXEL_FORMAT_BPP8_GRAYSCALE: {
+            const unsigned max = (1U << bits_per_pixel) - 1;
+            rgba[0] = rgba[1] = rgba[2] = (uint8_t)((packed_pixel(row, x, bits_per_pixel) * 255 + max / 2) / max);
+            break;
+        }
+        case SAIL_PIXEL_FORMAT_BPP16_GRAYSCALE: {
+            rgba[0] = rgba[1] = rgba[2] = (uint8_t)(sample16(pixel, 0) >> 8);
+            break;
+        }
+        case SAIL_PIXEL_FORMAT_BPP16_GRAYSCALE_ALPHA: {
+            rgba[0] = rgba[1] = rgba[2] = pixel[0];
+            rgba[3] = pixel[1];
+            break;
+        }
+        case SAIL_PIXEL_FORMAT_BPP32_GRAYSCALE_ALPHA: {
+            rgba[0] = rgba[1] = rgba[2] = (uint8_t)(sample16(pixel, 0) >> 8);
+            rgba[3] = (uint8_t)(sample16(pixel, 1) >> 8);
+            break;
+        }
+        case SAIL_PIXEL_FORMAT_BPP24_RGB:
+        case SAIL_PIXEL_FORMAT_BPP32_RGBA: {
+            memcpy(rgba, pixel, bits_per_pixel / 8);
+            break;
+        }
+        case SAIL_PIXEL_FORMAT_BPP48_RGB:
+        case SAIL_PIXEL_FORMAT_BPP64_RGBA: {
+            for (unsigned i = 0; i < bits_per_pixel / 16; i++) {
+                rgba[i] = (uint8_t)(sample16(pixel, i) >> 8);
+            }
+            break;
+        }
+        default: {
+            munit_error("Unexpected reference pixel format");
+        }
+    }
+}
+
+/*
+ * Checks rows read with the specified output pixel format. The first row of the pixels is the first_row
+ * image row, and the image starts at x0,y0 in the reference.
+ */
+static void assert_rows(const struct sail_image *image, const void *pixels, unsigned first_row, unsigned rows,
+                        const struct sail_image *reference, unsigned x0, unsigned y0, enum SailPixelFormat output_pixel_format) {
+
+    unsigned bits_per_pixel;
+    munit_assert(sail_bits_per_pixel(reference->pixel_format, &bits_per_pixel) == SAIL_OK);
+
+    for (unsigned y = first_row; y < first_row + rows; y++) {
+        const uint8_t *row = (const uint8_t *)pixels + (size_t)(y - first_row) * image->bytes_per_line;
+        const uint8_t *reference_row = (const uint8_t *)reference->pixels + (size_t)(y0 + y) * reference->bytes_per_line;
+
+        for (unsigned x = 0; x < image->width; x++) {
+            if (output_pixel_format != SAIL_PIXEL_FORMAT_SOURCE) {
+                uint8_t rgba[4];
+                reference_rgba(reference, x0 + x, y0 + y, rgba);
+
+                if (output_pixel_format == SAIL_PIXEL_FORMAT_BPP32_BGRA) {
+                    const uint8_t red = rgba[0];
+                    rgba[0] = rgba[2];
+                    rgba[2] = red;
+                }
+
+                munit_assert_memory_equal(4, row + (size_t)x * 4, rgba);
+            } else if (bits_per_pixel < 8) {
+                munit_assert_uint(packed_pixel(row, x, bits_per_pixel), ==, packed_pixel(reference_row, x0 + x, bits_per_pixel));
+            } else {
+                munit_assert_memory_equal(bits_per_pixel / 8,
+                                          row + (size_t)x * bits_per_pixel / 8,
+                                          reference_row + (size_t)(x0 + x) * bits_per_pixel / 8);
+            }
+        }
+    }
+}
+
+/*
+ * Reads the first frame of the file or the data with every output pixel format: as a whole, in bands of rows,
+ * and cropped in bands of rows. The decoded pixels must match the reference.
+ */
+static void assert_reading(const char *path, const void *data, size_t size, const struct sail_image *reference, unsigned threads) {
+
+    static const enum SailPixelFormat output_pixel_formats[] = {
+        SAIL_PIXEL_FORMAT_SOURCE,
+        SAIL_PIXEL_FORMAT_BPP32_RGBA,
+        SAIL_PIXEL_FORMAT_BPP32_BGRA,
+    };
+
+    /*
+     * The whole frame, bands of rows, and the region of interest. The bands don't divide the strip
+     * and tile heights. Large bands cover whole bands of tiles decoded in parallel.
+     */
+    static const struct {
+        unsigned band;
+        bool crop;
+    } reads[] = {
+        { 0,   false },
+        { 7,   false },
+        { 100, false },
+        { 7,   true  },
+    };
+
+    struct sail_read_options *read_options;
+    munit_assert(sail_alloc_read_options_from_features(tiff_codec_info()->read_features, &read_options) == SAIL_OK);
+    read_options->threads = threads;
+
+    for (size_t i = 0; i < sizeof(output_pixel_formats) / sizeof(output_pixel_formats[0]); i++) {
+        const enum SailPixelFormat output_pixel_format = output_pixel_formats[i];
+        const enum SailPixelFormat expected_pixel_format =
+            (output_pixel_format == SAIL_PIXEL_FORMAT_SOURCE) ? reference->pixel_format : output_pixel_format;
+
+        read_options->output_pixel_format = output_pixel_format;
+
+        for (size_t r = 0; r < sizeof(reads) / sizeof(reads[0]); r++) {
+            const unsigned band = reads[r].band;
+            const bool crop     = reads[r].crop;
+            const unsigned x0   = crop ? CROP_X : 0;
+            const unsigned y0   = crop ? CROP_Y : 0;
+
+            read_options->crop_x      = x0;
+            read_options->crop_y      = y0;
+            read_options->crop_width  = crop ? reference->width / 2  : 0;
+            read_options->crop_height = crop ? reference->height / 2 : 0;
+
+            const unsigned width  = crop ? reference->width / 2  : reference->width;
+            const unsigned height = crop ? reference->height / 2 : reference->height;
+
+            void *state;
+            start_reading(path, data, size, read_options, &state);
+
+            struct sail_image *image;
+
+            if (band == 0) {
+                munit_assert(sail_read_next_frame(state, &image) == SAIL_OK);
+            } else {
+                munit_assert(sail_start_reading_rows(state, &image) == SAIL_OK);
+            }
+
+            munit_assert_uint(image->width,       ==, width);
+            munit_assert_uint(image->height,      ==, height);
+            munit_assert_int(image->pixel_format, ==, expected_pixel_format);
+
+            if (output_pixel_format == SAIL_PIXEL_FORMAT_SOURCE && reference->palette != NULL) {
+                munit_assert_not_null(image->palette);
+                munit_assert_int(image->palette->pixel_format, ==, reference->palette->pixel_format);
+                munit_assert_uint(image->palette->color_count, ==, reference->palette->color_count);
+                munit_assert_memory_equal((size_t)reference->palette->color_count * 3, image->palette->data, reference->palette->data);
+            }
+
+            if (band == 0) {
+                assert_rows(image, image->pixels, 0, image->height, reference, x0, y0, output_pixel_format);
+            } else {
+                void *rows;
+                munit_assert(sail_malloc((size_t)band * image->bytes_per_line, &rows) == SAIL_OK);
+
+                for (unsigned y = 0; y < image->height;) {
+                    unsigned read_rows;
+                    munit_assert(sail_read_next_rows(state, rows, band, &read_rows) == SAIL_OK);
+                    munit_assert_uint(read_rows, >, 0);
+
+                    assert_rows(image, rows, y, read_rows, reference, x0, y0, output_pixel_format);
+                    y += read_rows;
+                }
+
+                sail_free(rows);
+            }
+
+            sail_destroy_image(image);
+            munit_assert(sail_stop_reading(state) == SAIL_OK);
+        }
+    }
+
+    sail_destroy_read_options(read_options);
+}
+
+static void put16(uint8_t *ptr, uint16_t value) {
+
+    ptr[0] = (uint8_t)value;
+    ptr[1] = (uint8_t)(value >> 8);
+}
+
+static void put32(uint8_t *ptr, uint32_t value) {
+
+    put16(ptr, (uint16_t)value);
+    put16(ptr + 2, (uint16_t)(value >> 16));
+}
+
+/* Writes a SHORT or LONG IFD entry with a single value or an offset. */
+static uint8_t* put_entry(uint8_t *ptr, uint16_t tag, uint16_t type, uint32_t count, uint32_t value) {
+
+    put16(ptr, tag);
+    put16(ptr + 2, type);
+    put32(ptr + 4, count);
+    put32(ptr + 8, value);
+
+    return ptr + 12;
+}
+
+/*
+ * Builds a minimal uncompressed little-endian TIFF with a single strip out of the gray or indexed reference,
+ * as SAIL writes neither indexed, packed gray, nor min-is-white images. Min-is-white samples are stored inverted.
+ * The data must be freed with sail_free().
+ */
+static void build_tiff(const struct sail_image *reference, bool min_is_white, void **data, size_t *size) {
+
+    unsigned bits_per_pixel;
+    munit_assert(sail_bits_per_pixel(reference->pixel_format, &bits_per_pixel) == SAIL_OK);
+
+    const bool indexed          = reference->palette != NULL;
+    const unsigned entries      = indexed ? 10 : 9;
+    const unsigned colors       = 1U << bits_per_pixel;
+    const size_t row_size       = ((size_t)reference->width * bits_per_pixel + 7) / 8;
+    const uint32_t color_map    = 8 + 2 + entries * 12 + 4;
+    const uint32_t strip        = color_map + (indexed ? colors * 3 * 2 : 0);
+    const uint32_t strip_size   = (uint32_t)(row_size * reference->height);
+
+    *size = strip + strip_size;
+    munit_assert(sail_malloc(*size, data) == SAIL_OK);
+
+    uint8_t *ptr = *data;
+
+    memcpy(ptr, "II*\0", 4);
+    put32(ptr + 4, 8);
+    put16(ptr + 8, (uint16_t)entries);
+
+    uint8_t *entry = ptr + 10;
+    entry = put_entry(entry, 256, 4, 1, reference->width);
+    entry = put_entry(entry, 257, 4, 1, reference->height);
+    entry = put_entry(entry, 258, 3, 1, bits_per_pixel);
+    entry = put_entry(entry, 259, 3, 1, 1);
+    entry = put_entry(entry, 262, 3, 1, indexed ? 3 : (min_is_white ? 0 : 1));
+    entry = put_entry(entry, 273, 4, 1, strip);
+    entry = put_entry(entry, 277, 3, 1, 1);
+    entry = put_entry(entry, 278, 4, 1, reference->height);
+    entry = put_entry(entry, 279, 4, 1, strip_size);
+
+    /* The color map holds all the reds, then all the greens and blues with 16 bits per value. */
+    if (indexed) {
+        entry = put_entry(entry, 320, 3, colors * 3, color_map);
+
+        for (unsigned channel = 0; channel < 3; channel++) {
+            for (unsigned i = 0; i < colors; i++) {
+                const uint8_t value = ((const uint8_t *)reference->palette->data)[i * 3 + channel];
+                put16(ptr + color_map + (channel * colors + i) * 2, (uint16_t)(value * 257));
+            }
+        }
+    }
+
+    /* No next IFD. */
+    put32(entry, 0);
+
+    for (unsigned y = 0; y < reference->height; y++) {
+        uint8_t *row = ptr + strip + (size_t)y * row_size;
+
+        memcpy(row, (const uint8_t *)reference->pixels + (size_t)y * reference->bytes_per_line, row_size);
+
+        if (min_is_white) {
+            for (size_t i = 0; i < row_size; i++) {
+                row[i] = (uint8_t)~row[i];
+            }
+        }
+    }
+}
+
+/*
+ * Write.
+ */
+static MunitResult test_write(const MunitParameter params[], void *user_data) {
+    (void)user_data;
+
+    enum SailPixelFormat pixel_format;
+    munit_assert(sail_pixel_format_from_string(munit_parameters_get(params, "pixel-format"), &pixel_format) == SAIL_OK);
+
+    /* Lossless compressions. The codec may be built without some of them. */
+    static const enum SailCompression compressions[] = {
+        SAIL_COMPRESSION_NONE,
+        SAIL_COMPRESSION_PACKBITS,
+        SAIL_COMPRESSION_LZW,
+        SAIL_COMPRESSION_DEFLATE,
+        SAIL_COMPRESSION_ADOBE_DEFLATE,
+        SAIL_COMPRESSION_ZSTD,
+        SAIL_COMPRESSION_LZMA,
+    };
+
+    /* SAIL_FILTER_SUB enables the horizontal predictor. */
+    static const enum SailFilter filters[] = { SAIL_FILTER_NONE, SAIL_FILTER_SUB };
+
+    /* Single-threaded and parallel encoding of strips and tiles. */
+    static const unsigned threads[] = { 1, 4 };
+
+    /*
+     * Frames of different sizes make the codec set up strips and tiles again. Parallel strips hold
+     * at least 256 KiB, so the tall frame is needed to get several of them, the last one partial.
+     */
+    struct sail_image *frames[] = {
+        noise_image(pixel_format, WIDTH,         HEIGHT,         0, 1),
+        noise_image(pixel_format, WIDTH / 2 + 3, HEIGHT / 3 + 1, 5, 2),
+        noise_image(pixel_format, WIDTH,         HEIGHT * 6,     3, 3),
+    };
+    const unsigned frames_count = sizeof(frames) / sizeof(frames[0]);
+
+    const struct sail_codec_info *codec_info = tiff_codec_info();
+
+    struct sail_write_options *write_options;
+    munit_assert(sail_alloc_write_options_from_features(codec_info->write_features, &write_options) == SAIL_OK);
+
+    struct sail_read_options *read_options;
+    munit_assert(sail_alloc_read_options_from_features(codec_info->read_features, &read_options) == SAIL_OK);
+    read_options->output_pixel_format = SAIL_PIXEL_FORMAT_SOURCE;
+
+    /*
+     * Strips, tiles, and threads don't depend on the compression. Sweep them with a single one
+     * and check the other compressions with single-threaded strips.
+     */
+    const enum SailCompression sweep_compression =
+        can_compress(codec_info, SAIL_COMPRESSION_DEFLATE) ? SAIL_COMPRESSION_DEFLATE : SAIL_COMPRESSION_NONE;
+
+    for (size_t c = 0; c < sizeof(compressions) / sizeof(compressions[0]); c++) {
+        if (!can_compress(codec_info, compressions[c])) {
+            continue;
+        }
+
+        const bool sweep = compressions[c] == sweep_compression;
+        const unsigned layouts_count = sweep ? 2 : 1;
+        const size_t threads_count = sweep ? sizeof(threads) / sizeof(threads[0]) : 1;
+
+        for (size_t f = 0; f < sizeof(filters) / sizeof(filters[0]); f++) {
+            for (unsigned tiled = 0; tiled < layouts_count; tiled++) {
+                for (size_t t = 0; t < threads_count; t++) {
+                    write_options->compression = compressions[c];
+                    write_options->filter      = filters[f];
+                    write_options->tile_width  = tiled ? TILE_WIDTH  : 0;
+                    write_options->tile_height = tiled ? TILE_HEIGHT : 0;
+                    write_options->threads     = threads[t];
+
+                    void *data;
+                    size_t size;
+                    write_frames(NULL, frames, frames_count, write_options, &data, &size);
+
+                    assert_frames(NULL, data, size, read_options, frames, frames_count);
+
+                    sail_free(data);
+                }
+            }
+        }
+    }
+
+    sail_destroy_read_options(read_options);
+    sail_destroy_write_options(write_options);
+
+    for (unsigned i = 0; i < frames_count; i++) {
+        sail_destroy_image(frames[i]);
+    }
+
+    return MUNIT_OK;
+}
+
+/*
+ * Native reading.
+ */
+static MunitResult test_read(const MunitParameter params[], void *user_data) {
+    (void)user_data;
+
+    enum SailPixelFormat pixel_format;
+    munit_assert(sail_pixel_format_from_string(munit_parameters_get(params, "pixel-format"), &pixel_format) == SAIL_OK);
+
+    struct sail_image *reference = noise_image(pixel_format, WIDTH, HEIGHT, 0, 1);
+
+    struct sail_write_options *write_options;
+    munit_assert(sail_alloc_write_options_from_features(tiff_codec_info()->write_features, &write_options) == SAIL_OK);
+    write_options->compression = SAIL_COMPRESSION_NONE;
+
+    /* Strips and tiles are decoded separately. */
+    for (unsigned tiled = 0; tiled < 2; tiled++) {
+        write_options->tile_width  = tiled ? TILE_WIDTH  : 0;
+        write_options->tile_height = tiled ? TILE_HEIGHT : 0;
+
+        void *data;
+        size_t size;
+        write_frames(NULL, &reference, 1, write_options, &data, &size);
+
+        assert_reading(NULL, data, size, reference, 1);
+
+        sail_free(data);
+    }
+
+    sail_destroy_write_options(write_options);
+    sail_destroy_image(reference);
+
+    return MUNIT_OK;
+}
+
+static MunitResult test_read_packed(const MunitParameter params[], void *user_data) {
+    (void)params;
+    (void)user_data;
+
+    static const struct {
+        enum SailPixelFormat pixel_format;
+        bool indexed;
+        bool min_is_white;
+    } layouts[] = {
+        { SAIL_PIXEL_FORMAT_BPP1_INDEXED,   true,  false },
+        { SAIL_PIXEL_FORMAT_BPP2_INDEXED,   true,  false },
+        { SAIL_PIXEL_FORMAT_BPP4_INDEXED,   true,  false },
+        { SAIL_PIXEL_FORMAT_BPP8_INDEXED,   true,  false },
+        { SAIL_PIXEL_FORMAT_BPP2_GRAYSCALE, false, false },
+        { SAIL_PIXEL_FORMAT_BPP4_GRAYSCALE, false, false },
+        { SAIL_PIXEL_FORMAT_BPP1_GRAYSCALE, false, true  },
+        { SAIL_PIXEL_FORMAT_BPP4_GRAYSCALE, false, true  },
+        { SAIL_PIXEL_FORMAT_BPP8_GRAYSCALE, false, true  },
+    };
+
+    for (size_t i = 0; i < sizeof(layouts) / sizeof(layouts[0]); i++) {
+        struct sail_image *reference = noise_image(layouts[i].pixel_format, WIDTH, HEIGHT, 0, 1);
+
+        /* Noisy colors. */
+        if (layouts[i].indexed) {
+            struct sail_image *colors = noise_image(SAIL_PIXEL_FORMAT_BPP24_RGB, 256, 1, 0, 2);
+
+            munit_assert(sail_alloc_palette(&reference->palette) == SAIL_OK);
+
+            unsigned bits_per_pixel;
+            munit_assert(sail_bits_per_pixel(layouts[i].pixel_format, &bits_per_pixel) == SAIL_OK);
+
+            reference->palette->pixel_format = SAIL_PIXEL_FORMAT_BPP24_RGB;
+            reference->palette->color_count  = 1U << bits_per_pixel;
+
+            munit_assert(sail_malloc((size_t)reference->palette->color_count * 3, &reference->palette->data) == SAIL_OK);
+            memcpy(reference->palette->data, colors->pixels, (size_t)reference->palette->color_count * 3);
+
+            sail_destroy_image(colors);
+        }
+
+        void *data;
+        size_t size;
+        build_tiff(reference, layouts[i].min_is_white, &data, &size);
+
+        assert_reading(NULL, data, size, reference, 1);
+
+        sail_free(data);
+        sail_destroy_image(reference);
+    }
+
+    return MUNIT_OK;
+}
+
+/*
+ * Parallel reading.
+ */
+static MunitResult test_read_threads(const MunitParameter params[], void *user_data) {
+    (void)user_data;
+
+    enum SailPixelFormat pixel_format;
+    munit_assert(sail_pixel_format_from_string(munit_parameters_get(params, "pixel-format"), &pixel_format) == SAIL_OK);
+
+    /* Written next to the test. Files are read through locked handles. */
+    const char *path = "tiff-read-threads.tiff";
+
+    struct sail_image *frames[] = {
+        noise_image(pixel_format, WIDTH,         HEIGHT,         0, 1),
+        noise_image(pixel_format, WIDTH / 2 + 3, HEIGHT / 3 + 1, 5, 2),
+    };
+    const unsigned frames_count = sizeof(frames) / sizeof(frames[0]);
+
+    const struct sail_codec_info *codec_info = tiff_codec_info();
+
+    struct sail_write_options *write_options;
+    munit_assert(sail_alloc_write_options_from_features(codec_info->write_features, &write_options) == SAIL_OK);
+    write_options->compression = can_compress(codec_info, SAIL_COMPRESSION_DEFLATE) ? SAIL_COMPRESSION_DEFLATE : SAIL_COMPRESSION_NONE;
+    write_options->threads     = 4;
+
+    struct sail_read_options *read_options;
+    munit_assert(sail_alloc_read_options_from_features(codec_info->read_features, &read_options) == SAIL_OK);
+    read_options->output_pixel_format = SAIL_PIXEL_FORMAT_SOURCE;
+
+    /* Tiles are decoded in parallel. Strips are decoded by the calling thread regardless of the threads. */
+    for (unsigned tiled = 0; tiled < 2; tiled++) {
+        for (unsigned file = 0; file < 2; file++) {
+            write_options->tile_width  = tiled ? TILE_WIDTH  : 0;
+            write_options->tile_height = tiled ? TILE_HEIGHT : 0;
+
+            void *data;
+            size_t size;
+            write_frames(file ? path : NULL, frames, frames_count, write_options, &data, &size);
+
+            /* Threads are kept between frames. */
+            for (unsigned threads = 2; threads <= 4; threads += 2) {
+                read_options->threads = threads;
+                assert_frames(file ? path : NULL, data, size, read_options, frames, frames_count);
+
+                assert_reading(file ? path : NULL, data, size, frames[0], threads);
+            }
+
+            sail_free(data);
+        }
+    }
+
+    munit_assert_int(remove(path), ==, 0);
+
+    sail_destroy_read_options(read_options);
+    sail_destroy_write_options(write_options);
+
+    for (unsigned i = 0; i < frames_count; i++) {
+        sail_destroy_image(frames[i]);
+    }
+
+    return MUNIT_OK;
+}
+
+/* All the pixel formats the codec writes. */
+static char *write_pixel_formats[] = {
+    (char *)"BPP8-GRAYSCALE",
+    (char *)"BPP16-GRAYSCALE",
+    (char *)"BPP16-GRAYSCALE-ALPHA",
+    (char *)"BPP32-GRAYSCALE-ALPHA",
+    (char *)"BPP24-RGB",
+    (char *)"BPP48-RGB",
+    (char *)"BPP32-RGBA",
+    (char *)"BPP64-RGBA",
+    NULL
+};
+
+static MunitParameterEnum write_params[] = {
+    { (char *)"pixel-format", write_pixel_formats },
+    { NULL, NULL }
+};
+
+static MunitTest test_suite_tests[] = {
+    { (char *)"/write", test_write, NULL, NULL, MUNIT_TEST_OPTION_NONE, write_params },
+
+    { (char *)"/read",        test_read,        NULL, NULL, MUNIT_TEST_OPTION_NONE, write_params },
+    { (char *)"/read-packed", test_read_packed, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL         },
+
+    { (char *)"/read-threads", test_read_threads, NULL, NULL, MUNIT_TEST_OPTION_NONE, write_params },
+
+    { NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL }
+};
+
+static const MunitSuite test_suite = {
+    (char *)"/tiff",
+    test_suite_tests,
+    NULL,
+    1,
+    MUNIT_SUITE_OPTION_NONE
+};
+
+int main(int argc, char *argv[MUNIT_ARRAY_PARAM(argc + 1)]) {
+    return munit_suite_main(&test_suite, NULL, argc, argv);
+}